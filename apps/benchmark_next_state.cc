@@ -0,0 +1,156 @@
+/**
+ * benchmark_next_state.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include <symbolic/pddl.h>
+
+#include <chrono>     // std::chrono
+#include <exception>  // std::runtime_error
+#include <iostream>   // std::cout
+#include <sstream>    // std::stringstream
+#include <string>     // std::stoi, std::string
+#include <utility>    // std::pair
+#include <vector>     // std::vector
+
+namespace {
+
+const size_t kDefaultNumBlocks = 10;
+const size_t kDefaultNumSteps = 10000;
+
+struct Args {
+  std::string filename_domain;
+  size_t num_blocks = kDefaultNumBlocks;
+  size_t num_steps = kDefaultNumSteps;
+};
+
+// NOLINTNEXTLINE(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+Args ParseArgs(int argc, char* argv[]) {
+  Args parsed_args;
+  try {
+    if (argc < 2) {
+      throw std::runtime_error("Incorrect number of arguments.");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    parsed_args.filename_domain = argv[1];
+    int idx = 2;
+    while (idx < argc) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const std::string_view arg(argv[idx]);
+      if (arg == "--blocks" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.num_blocks = std::stoi(argv[idx]);
+      } else if (arg == "--steps" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.num_steps = std::stoi(argv[idx]);
+      } else {
+        throw std::runtime_error("Could not parse arguments.");
+      }
+      idx++;
+    }
+  } catch (const std::runtime_error& e) {
+    std::cout << "Usage:" << std::endl
+              << "\t./benchmark_next_state axioms_domain.pddl [--blocks INT "
+                 "(default "
+              << kDefaultNumBlocks << ")] [--steps INT (default "
+              << kDefaultNumSteps << ")]" << std::endl;
+    throw e;
+  }
+  return parsed_args;
+}
+
+/**
+ * Creates a problem with all blocks stacked in a single tower.
+ */
+std::string CreateTowerProblem(size_t num_blocks) {
+  std::stringstream ss;
+  ss << "(define (problem tower) (:domain axioms) (:objects";
+  for (size_t i = 0; i < num_blocks; i++) {
+    ss << " b" << i;
+  }
+  ss << " - block) (:init (handempty) (clear b" << num_blocks - 1
+     << ") (on b0 table)";
+  for (size_t i = 1; i < num_blocks; i++) {
+    ss << " (on b" << i << " b" << i - 1 << ")";
+  }
+  ss << ") (:goal (on b0 b" << num_blocks - 1 << ")))";
+  return ss.str();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {  // NOLINT(bugprone-exception-escape)
+  Args args = ParseArgs(argc, argv);
+  std::cout << "Domain: " << args.filename_domain << std::endl
+            << "Blocks: " << args.num_blocks << std::endl
+            << "Steps: " << args.num_steps << std::endl
+            << std::endl;
+
+  const symbolic::Pddl pddl(args.filename_domain,
+                            CreateTowerProblem(args.num_blocks));
+
+  // Random walk with a fixed seed, timing only the calls through the public
+  // Pddl interface so that the same benchmark can be built against earlier
+  // versions of the library. Pddl::NextState() and Pddl::IsValidAction() parse
+  // the action call, while Action::Apply() measures the compiled effects and
+  // axiom triggers alone.
+  std::chrono::duration<double> t_next_state(0);
+  std::chrono::duration<double> t_valid(0);
+  std::chrono::duration<double> t_apply(0);
+  symbolic::State state = pddl.initial_state();
+  size_t seed = 1;
+  for (size_t i = 0; i < args.num_steps; i++) {
+    std::vector<
+        std::pair<const symbolic::Action*, std::vector<symbolic::Object>>>
+        actions;
+    for (const symbolic::Action& action : pddl.actions()) {
+      for (std::vector<symbolic::Object>& arguments :
+           pddl.ListValidArguments(state, action)) {
+        actions.emplace_back(&action, std::move(arguments));
+      }
+    }
+    if (actions.empty()) {
+      state = pddl.initial_state();
+      continue;
+    }
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    const symbolic::Action& action = *actions[seed % actions.size()].first;
+    const std::vector<symbolic::Object>& arguments =
+        actions[seed % actions.size()].second;
+    const std::string action_call = action.to_string(arguments);
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    const bool is_valid = pddl.IsValidAction(state, action_call);
+    t_valid += std::chrono::high_resolution_clock::now() - t_start;
+
+    t_start = std::chrono::high_resolution_clock::now();
+    const symbolic::State next_state = pddl.NextState(state, action_call);
+    t_next_state += std::chrono::high_resolution_clock::now() - t_start;
+
+    t_start = std::chrono::high_resolution_clock::now();
+    symbolic::State applied_state = action.Apply(state, arguments);
+    t_apply += std::chrono::high_resolution_clock::now() - t_start;
+
+    if (!is_valid) {
+      throw std::runtime_error(
+          "Pddl::IsValidAction() rejected a valid action.");
+    }
+    if (applied_state != next_state) {
+      throw std::runtime_error("Action::Apply() and Pddl::NextState() differ.");
+    }
+    state = std::move(applied_state);
+  }
+
+  std::cout << "Pddl::NextState(): " << args.num_steps / t_next_state.count()
+            << " steps/s (" << t_next_state.count() << "s)" << std::endl
+            << "Pddl::IsValidAction(): " << args.num_steps / t_valid.count()
+            << " calls/s (" << t_valid.count() << "s)" << std::endl
+            << "Action::Apply(): " << args.num_steps / t_apply.count()
+            << " steps/s (" << t_apply.count() << "s)" << std::endl;
+}
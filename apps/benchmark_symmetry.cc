@@ -0,0 +1,175 @@
+/**
+ * benchmark_symmetry.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include <symbolic/pddl.h>
+#include <symbolic/planning/planner.h>
+#include <symbolic/planning/symmetries.h>
+#include <symbolic/planning/width_search.h>
+
+#include <chrono>     // std::chrono
+#include <exception>  // std::runtime_error
+#include <iostream>   // std::cout
+#include <sstream>    // std::stringstream
+#include <string>     // std::stoi, std::string
+#include <vector>     // std::vector
+
+namespace {
+
+const size_t kDefaultNumPairs = 3;
+const size_t kDefaultDepth = 20;
+
+struct Args {
+  std::string filename_domain;
+  size_t num_pairs = kDefaultNumPairs;
+  size_t depth = kDefaultDepth;
+};
+
+// NOLINTNEXTLINE(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+Args ParseArgs(int argc, char* argv[]) {
+  Args parsed_args;
+  try {
+    if (argc < 2) {
+      throw std::runtime_error("Incorrect number of arguments.");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    parsed_args.filename_domain = argv[1];
+    int idx = 2;
+    while (idx < argc) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const std::string_view arg(argv[idx]);
+      if (arg == "--pairs" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.num_pairs = std::stoi(argv[idx]);
+      } else if (arg == "--depth" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.depth = std::stoi(argv[idx]);
+      } else {
+        throw std::runtime_error("Could not parse arguments.");
+      }
+      idx++;
+    }
+  } catch (const std::runtime_error& e) {
+    std::cout << "Usage:" << std::endl
+              << "\t./benchmark_symmetry blocks_domain.pddl [--pairs INT "
+                 "(default "
+              << kDefaultNumPairs << ")] [--depth INT (default "
+              << kDefaultDepth << ")]" << std::endl;
+    throw e;
+  }
+  return parsed_args;
+}
+
+/**
+ * Creates a problem that stacks all blocks on the table into pairs.
+ *
+ * Every pair of blocks is interchangeable with every other pair.
+ */
+std::string CreatePairsProblem(size_t num_pairs) {
+  std::stringstream ss;
+  ss << "(define (problem pairs) (:domain blocks) (:objects";
+  for (size_t i = 0; i < 2 * num_pairs; i++) {
+    ss << " b" << i;
+  }
+  ss << " - block) (:init";
+  for (size_t i = 0; i < 2 * num_pairs; i++) {
+    ss << " (on b" << i << " table)";
+  }
+  ss << ") (:goal (and";
+  for (size_t i = 0; i < num_pairs; i++) {
+    ss << " (on b" << 2 * i << " b" << 2 * i + 1 << ")";
+  }
+  ss << ")))";
+  return ss.str();
+}
+
+/**
+ * Runs BFWS with the given score until the first plan and prints the plan
+ * length, the number of generated nodes and the runtime.
+ */
+void RunSearch(const std::string& name, const symbolic::Pddl& pddl,
+               const symbolic::Planner& planner,
+               const symbolic::BestFirstWidthSearch<
+                   symbolic::Planner::Node>::ScoreFunction& score,
+               size_t depth, const symbolic::ObjectSymmetries* symmetries) {
+  // The score is evaluated once for every node that is not a duplicate.
+  size_t num_generated = 0;
+  const symbolic::BestFirstWidthSearch<symbolic::Planner::Node> bfws(
+      planner.root(), pddl.state_index(),
+      [&score, &num_generated](const symbolic::Planner::Node& node) {
+        num_generated++;
+        return score(node);
+      },
+      depth, false, symmetries);
+
+  const auto t_start = std::chrono::high_resolution_clock::now();
+  const auto it = bfws.begin();
+  const std::chrono::duration<double> t_search =
+      std::chrono::high_resolution_clock::now() - t_start;
+
+  std::cout << "  " << name << ": ";
+  if (it == bfws.end()) {
+    std::cout << "no plan";
+  } else {
+    std::cout << (*it).size() - 1 << " steps";
+  }
+  std::cout << ", " << num_generated << " nodes (" << t_search.count() << "s)"
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {  // NOLINT(bugprone-exception-escape)
+  Args args = ParseArgs(argc, argv);
+  std::cout << "Domain: " << args.filename_domain << std::endl
+            << "Pairs: " << args.num_pairs << std::endl
+            << "Depth: " << args.depth << std::endl
+            << std::endl;
+
+  const symbolic::Pddl pddl(args.filename_domain,
+                            CreatePairsProblem(args.num_pairs));
+  const symbolic::Planner planner(pddl);
+
+  const auto t_start = std::chrono::high_resolution_clock::now();
+  const symbolic::ObjectSymmetries symmetries(pddl);
+  const std::chrono::duration<double> t_symmetries =
+      std::chrono::high_resolution_clock::now() - t_start;
+  std::cout << "Symmetries: " << symmetries.generators().size()
+            << " generators (" << t_symmetries.count() << "s)" << std::endl
+            << std::endl;
+
+  // Score nodes by the number of unsatisfied goal propositions.
+  std::vector<symbolic::Proposition> goal;
+  for (size_t i = 0; i < args.num_pairs; i++) {
+    goal.emplace_back(pddl, "on(b" + std::to_string(2 * i) + ", b" +
+                                std::to_string(2 * i + 1) + ")");
+  }
+  const auto CountUnsatisfied = [&goal](const symbolic::Planner::Node& node) {
+    double num_unsatisfied = 0.;
+    for (const symbolic::Proposition& prop : goal) {
+      num_unsatisfied += node.state().contains(prop) ? 0. : 1.;
+    }
+    return num_unsatisfied;
+  };
+  const auto Blind = [](const symbolic::Planner::Node& node) { return 0.; };
+
+  for (const symbolic::ObjectSymmetries* ptr_symmetries :
+       {static_cast<const symbolic::ObjectSymmetries*>(nullptr),
+        &symmetries}) {
+    std::cout << (ptr_symmetries == nullptr ? "Without symmetries:"
+                                            : "With symmetries:")
+              << std::endl;
+    RunSearch("BFWS(blind)", pddl, planner, Blind, args.depth,
+              ptr_symmetries);
+    RunSearch("BFWS(#g)", pddl, planner, CountUnsatisfied, args.depth,
+              ptr_symmetries);
+    std::cout << std::endl;
+  }
+}
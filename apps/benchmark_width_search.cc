@@ -0,0 +1,204 @@
+/**
+ * benchmark_width_search.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include <symbolic/pddl.h>
+#include <symbolic/planning/breadth_first_search.h>
+#include <symbolic/planning/causal_graph.h>
+#include <symbolic/planning/landmarks.h>
+#include <symbolic/planning/planner.h>
+#include <symbolic/planning/width_search.h>
+
+#include <chrono>     // std::chrono
+#include <exception>  // std::runtime_error
+#include <iostream>   // std::cout
+#include <sstream>    // std::stringstream
+#include <string>     // std::stoi, std::string
+#include <vector>     // std::vector
+
+namespace {
+
+const size_t kDefaultNumBlocks = 4;
+const size_t kDefaultDepth = 20;
+const double kDefaultTimeout = 60.;
+
+struct Args {
+  std::string filename_domain;
+  size_t num_blocks = kDefaultNumBlocks;
+  size_t depth = kDefaultDepth;
+  double timeout = kDefaultTimeout;
+};
+
+// NOLINTNEXTLINE(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+Args ParseArgs(int argc, char* argv[]) {
+  Args parsed_args;
+  try {
+    if (argc < 2) {
+      throw std::runtime_error("Incorrect number of arguments.");
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    parsed_args.filename_domain = argv[1];
+    int idx = 2;
+    while (idx < argc) {
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const std::string_view arg(argv[idx]);
+      if (arg == "--blocks" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.num_blocks = std::stoi(argv[idx]);
+      } else if (arg == "--depth" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.depth = std::stoi(argv[idx]);
+      } else if (arg == "--timeout" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.timeout = std::stod(argv[idx]);
+      } else {
+        throw std::runtime_error("Could not parse arguments.");
+      }
+      idx++;
+    }
+  } catch (const std::runtime_error& e) {
+    std::cout << "Usage:" << std::endl
+              << "\t./benchmark_width_search blocks_domain.pddl [--blocks INT "
+                 "(default "
+              << kDefaultNumBlocks << ")] [--depth INT (default "
+              << kDefaultDepth << ")] [--timeout SECONDS (default "
+              << kDefaultTimeout << ")]" << std::endl;
+    throw e;
+  }
+  return parsed_args;
+}
+
+/**
+ * Goal of stacking all blocks in a single tower with b0 on top.
+ */
+std::vector<std::string> CreateTowerGoal(size_t num_blocks) {
+  std::vector<std::string> goal;
+  for (size_t i = 0; i + 1 < num_blocks; i++) {
+    goal.push_back("on(b" + std::to_string(i) + ", b" + std::to_string(i + 1) +
+                   ")");
+  }
+  goal.push_back("on(b" + std::to_string(num_blocks - 1) + ", table)");
+  return goal;
+}
+
+/**
+ * Creates a problem that stacks a tower from the given initial state.
+ *
+ * @param is_reversed Start from the reversed tower instead of from all blocks
+ *                    on the table.
+ */
+std::string CreateTowerProblem(size_t num_blocks, bool is_reversed) {
+  std::stringstream ss;
+  ss << "(define (problem tower) (:domain blocks) (:objects";
+  for (size_t i = 0; i < num_blocks; i++) {
+    ss << " b" << i;
+  }
+  ss << " - block) (:init";
+  if (is_reversed) {
+    ss << " (on b0 table)";
+    for (size_t i = 1; i < num_blocks; i++) {
+      ss << " (on b" << i << " b" << i - 1 << ")";
+    }
+  } else {
+    for (size_t i = 0; i < num_blocks; i++) {
+      ss << " (on b" << i << " table)";
+    }
+  }
+  ss << ") (:goal (and";
+  for (size_t i = 0; i + 1 < num_blocks; i++) {
+    ss << " (on b" << i << " b" << i + 1 << ")";
+  }
+  ss << " (on b" << num_blocks - 1 << " table))))";
+  return ss.str();
+}
+
+/**
+ * Runs the search until the first plan and prints its length and runtime.
+ */
+template <typename SearchT>
+void RunSearch(const std::string& name, const SearchT& search) {
+  const auto t_start = std::chrono::high_resolution_clock::now();
+  const auto it = search.begin();
+  const std::chrono::duration<double> t_search =
+      std::chrono::high_resolution_clock::now() - t_start;
+
+  std::cout << "  " << name << ": ";
+  if (it == search.end()) {
+    std::cout << "no plan";
+  } else {
+    std::cout << (*it).size() - 1 << " steps";
+  }
+  std::cout << " (" << t_search.count() << "s)" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {  // NOLINT(bugprone-exception-escape)
+  Args args = ParseArgs(argc, argv);
+  std::cout << "Domain: " << args.filename_domain << std::endl
+            << "Blocks: " << args.num_blocks << std::endl
+            << "Depth: " << args.depth << std::endl
+            << std::endl;
+
+  for (const bool is_reversed : {false, true}) {
+    const symbolic::Pddl pddl(
+        args.filename_domain,
+        CreateTowerProblem(args.num_blocks, is_reversed));
+    const symbolic::Planner planner(pddl);
+    std::cout << (is_reversed ? "Reverse tower:" : "Stack tower:") << std::endl;
+
+    // Score nodes by the number of unsatisfied goal propositions.
+    std::vector<symbolic::Proposition> goal;
+    for (const std::string& str_prop : CreateTowerGoal(args.num_blocks)) {
+      goal.emplace_back(pddl, str_prop);
+    }
+    const auto CountUnsatisfied = [&goal](const symbolic::Planner::Node& node) {
+      double num_unsatisfied = 0.;
+      for (const symbolic::Proposition& prop : goal) {
+        num_unsatisfied += node.state().contains(prop) ? 0. : 1.;
+      }
+      return num_unsatisfied;
+    };
+
+    RunSearch("BFS", symbolic::BreadthFirstSearch<symbolic::Planner::Node>(
+                         planner.root(), args.depth, false,
+                         std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::duration<double>(args.timeout))));
+    for (const size_t width : {1, 2}) {
+      RunSearch("IW(" + std::to_string(width) + ")",
+                symbolic::IteratedWidthSearch<symbolic::Planner::Node>(
+                    planner.root(), pddl.state_index(), width, args.depth));
+    }
+    RunSearch("BFWS(#g)",
+              symbolic::BestFirstWidthSearch<symbolic::Planner::Node>(
+                  planner.root(), pddl.state_index(), CountUnsatisfied,
+                  args.depth));
+
+    symbolic::LandmarkCountHeuristic lm_count(pddl);
+    RunSearch("BFWS(LM-count)",
+              symbolic::BestFirstWidthSearch<symbolic::Planner::Node>(
+                  planner.root(), pddl.state_index(),
+                  [&lm_count](const symbolic::Planner::Node& node) {
+                    return lm_count(node);
+                  },
+                  args.depth));
+
+    symbolic::ContextEnhancedAdditiveHeuristic h_cea(pddl);
+    RunSearch("BFWS(h_cea)",
+              symbolic::BestFirstWidthSearch<symbolic::Planner::Node>(
+                  planner.root(), pddl.state_index(),
+                  [&h_cea](const symbolic::Planner::Node& node) {
+                    return h_cea(node);
+                  },
+                  args.depth));
+    std::cout << std::endl;
+  }
+}
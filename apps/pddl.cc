@@ -9,25 +9,53 @@
 
 #include <symbolic/pddl.h>
 #include <symbolic/planning/a_star.h>
+#include <symbolic/planning/bitstate_search.h>
 #include <symbolic/planning/breadth_first_search.h>
 #include <symbolic/planning/depth_first_search.h>
+#include <symbolic/planning/external_search.h>
+#include <symbolic/planning/parallel_search.h>
 #include <symbolic/planning/planner.h>
+#include <symbolic/planning/portfolio.h>
 
 #include <chrono>    // std::chrono
 #include <iostream>  // std::cout
+#include <optional>  // std::optional
 #include <set>       // std::set
-#include <string>    // std::stoi
+#include <sstream>   // std::stringstream
+#include <string>    // std::getline, std::stoi
 #include <vector>    // std::vector
 
 namespace {
 
 const size_t kDefaultDepth = 5;
+const size_t kDefaultMemory = 1024;
 
 struct Args {
   std::string filename_domain;
   std::string filename_problem;
   size_t depth = kDefaultDepth;
   bool verbose = false;
+
+  // External-memory search.
+  bool external = false;
+  std::string tmpdir;
+
+  // Memory budget in MB, or 0 if not given.
+  size_t memory = 0;
+
+  // Bitstate hashing search.
+  bool bitstate = false;
+  size_t bits = symbolic::BitstateSearch::kDefaultLog2NumBits;
+
+  // Hash-distributed A* with the number of threads, or all hardware threads
+  // if 0.
+  bool hda = false;
+  size_t threads = 0;
+
+  // Portfolio of comma-separated engines with the deadline in seconds, or 0 to
+  // return the first plan. The portfolio has no memory budget unless given.
+  std::string portfolio;
+  double deadline = 0.;
 };
 
 // NOLINTNEXTLINE(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
@@ -52,6 +80,36 @@ Args ParseArgs(int argc, char* argv[]) {
         parsed_args.depth = std::stoi(argv[idx]);
       } else if (arg == "--verbose") {
         parsed_args.verbose = true;
+      } else if (arg == "--external") {
+        parsed_args.external = true;
+      } else if (arg == "--tmpdir" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.tmpdir = argv[idx];
+      } else if (arg == "--memory" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.memory = std::stoi(argv[idx]);
+      } else if (arg == "--bitstate") {
+        parsed_args.bitstate = true;
+      } else if (arg == "--bits" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.bits = std::stoi(argv[idx]);
+      } else if (arg == "--hda") {
+        parsed_args.hda = true;
+      } else if (arg == "--threads" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.threads = std::stoi(argv[idx]);
+      } else if (arg == "--portfolio" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.portfolio = argv[idx];
+      } else if (arg == "--deadline" && idx + 1 < argc) {
+        idx++;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        parsed_args.deadline = std::stod(argv[idx]);
       } else {
         throw std::runtime_error("Could not parse arguments.");
       }
@@ -60,7 +118,14 @@ Args ParseArgs(int argc, char* argv[]) {
   } catch (const std::runtime_error& e) {
     std::cout << "Usage:" << std::endl
               << "\t./pddl domain.pddl problem.pddl [--depth INT (default "
-              << kDefaultDepth << ")] [--verbose]" << std::endl;
+              << kDefaultDepth << ")] [--verbose] [--external [--tmpdir DIR] "
+                                  "[--memory MB (default "
+              << kDefaultMemory << ")]] [--bitstate [--bits LOG2 (default "
+              << symbolic::BitstateSearch::kDefaultLog2NumBits
+              << ")]] [--hda [--threads INT (default all)]] [--portfolio "
+                 "bfs,dfs,iw,bfws [--deadline SEC] [--memory MB (default "
+                 "none)]]"
+              << std::endl;
     throw e;
   }
   return parsed_args;
@@ -78,10 +143,58 @@ int main(int argc, char* argv[]) {  // NOLINT(bugprone-exception-escape)
   const symbolic::Pddl pddl(args.filename_domain, args.filename_problem);
   pddl.IsValid(true);
 
-  symbolic::Planner planner(pddl);
-
   std::cout << "Planning:" << std::endl;
   const auto t_start = std::chrono::high_resolution_clock::now();
+
+  // Search for a shortest plan with the layers spilled to disk or in parallel,
+  // explore approximately without storing states, or race several engines.
+  if (args.external || args.bitstate || args.hda || !args.portfolio.empty()) {
+    std::optional<std::vector<std::string>> plan;
+    if (!args.portfolio.empty()) {
+      symbolic::Portfolio portfolio(pddl, args.memory << 20);
+      std::stringstream ss(args.portfolio);
+      for (std::string engine; std::getline(ss, engine, ',');) {
+        portfolio.Add(engine);
+      }
+      plan = portfolio.Search(
+          args.depth,
+          std::chrono::ceil<std::chrono::milliseconds>(
+              std::chrono::duration<double>(args.deadline)),
+          args.verbose);
+      if (portfolio.is_out_of_memory()) {
+        std::cout << "Portfolio exceeded the memory budget." << std::endl;
+      }
+      if (plan.has_value()) {
+        std::cout << "Portfolio plan found by " << portfolio.winner() << ":"
+                  << std::endl;
+      }
+    } else if (args.hda) {
+      symbolic::HashDistributedAStar hda(pddl, args.threads);
+      plan = hda.Search(args.depth, args.verbose);
+    } else if (args.external) {
+      const size_t memory = args.memory > 0 ? args.memory : kDefaultMemory;
+      symbolic::ExternalBreadthFirstSearch external_bfs(pddl, args.tmpdir,
+                                                        memory << 20);
+      plan = external_bfs.Search(args.depth, args.verbose);
+    } else {
+      symbolic::BitstateSearch bitstate(pddl, args.bits);
+      plan = bitstate.Search(args.depth, true);
+    }
+    if (plan.has_value()) {
+      for (const std::string& action : *plan) {
+        std::cout << action << std::endl;
+      }
+      std::cout << std::endl;
+    }
+    std::cout << "Found " << (plan.has_value() ? 1 : 0) << " plans in "
+              << std::chrono::duration<float>(
+                     std::chrono::high_resolution_clock::now() - t_start)
+                     .count()
+              << "s" << std::endl;
+    return 0;
+  }
+
+  symbolic::Planner planner(pddl);
   symbolic::BreadthFirstSearch bfs(planner.root(), args.depth, args.verbose);
   size_t num_plans = 0;
   for (const std::vector<symbolic::Planner::Node>& plan : bfs) {
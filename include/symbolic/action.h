@@ -20,6 +20,7 @@
 #include "symbolic/object.h"
 #include "symbolic/proposition.h"
 #include "symbolic/state.h"
+#include "symbolic/utils/parameter_binder.h"
 #include "symbolic/utils/parameter_generator.h"
 
 namespace VAL {
@@ -57,6 +58,15 @@ class Action {
     return static_cast<bool>(Apply_(arguments, state));
   }
 
+  /**
+   * Applies the action and records the propositions changed by its effects
+   * and axioms.
+   */
+  bool Apply(const std::vector<Object>& arguments,
+             StateRecorder* state) const {
+    return static_cast<bool>(ApplyRecorded_(arguments, state));
+  }
+
   PartialState Apply(const PartialState& state,
                      const std::vector<Object>& arguments) const;
 
@@ -78,6 +88,11 @@ class Action {
 
   const ParameterGenerator& parameter_generator() const { return param_gen_; }
 
+  /**
+   * Backtracking search over the arguments that satisfy the preconditions.
+   */
+  const ParameterBinder& parameter_binder() const { return param_binder_; }
+
   const Formula& preconditions() const { return Preconditions_; }
 
   const VAL::effect_lists* postconditions() const;
@@ -105,9 +120,12 @@ class Action {
   std::string name_;
   std::vector<Object> parameters_;
   ParameterGenerator param_gen_;
+  ParameterBinder param_binder_;
 
   Formula Preconditions_;
   std::function<int(const std::vector<Object>&, State*)> Apply_;
+  std::function<int(const std::vector<Object>&, StateRecorder*)>
+      ApplyRecorded_;
   std::function<int(const std::vector<Object>&, PartialState*)> ApplyPartial_;
 };
 
@@ -10,8 +10,13 @@
 #ifndef SYMBOLIC_AXIOM_H_
 #define SYMBOLIC_AXIOM_H_
 
+#include <optional>  // std::optional
+#include <utility>   // std::pair
+#include <vector>    // std::vector
+
 #include "symbolic/action.h"
 #include "symbolic/normal_form.h"
+#include "symbolic/utils/thread_local_buffer.h"
 
 namespace symbolic {
 
@@ -63,6 +68,13 @@ class Axiom : public Action {
   PartialState Apply(const PartialState& state) const;
   int Apply(PartialState* state) const;
 
+  /**
+   * Argument combinations for which the axiom context can be satisfied.
+   */
+  const std::vector<std::vector<Object>>& arguments() const {
+    return arguments_;
+  }
+
   /**
    * Predicate used in the axiom context.
    */
@@ -71,16 +83,40 @@ class Axiom : public Action {
   friend std::ostream& operator<<(std::ostream& os, const Axiom& axiom);
 
   /**
-   * Creates a function that takes action_args and returns axiom_args based on
-   * positional indices of the axiom context proposition. If the action_args are
-   * not consistent with the axiom context, returns an empty vector.
+   * Axiom precompiled for an action effect on its context predicate.
+   *
+   * Maps action arguments to axiom arguments by positional indices of the axiom
+   * context proposition.
    */
-  static std::optional<
-      std::function<const std::vector<Object>*(const std::vector<Object>&)>>
-  CreateApplicationFunction(const std::vector<Object>& action_params,
-                            const std::vector<Object>& action_prop_params,
-                            const std::vector<Object>& axiom_params,
-                            const std::vector<Object>& axiom_prop_params);
+  class Trigger {
+   public:
+    /**
+     * Creates a trigger for the action effect, or returns an empty optional if
+     * the effect can never match the axiom context.
+     */
+    static std::optional<Trigger> Create(
+        const Axiom& axiom, const std::vector<Object>& action_params,
+        const std::vector<Object>& action_prop_params);
+
+    const Axiom& axiom() const { return *axiom_; }
+
+    /**
+     * Returns the axiom arguments for the given action arguments, or nullptr if
+     * the action arguments are not consistent with the axiom context.
+     *
+     * The returned arguments are only valid until the next call.
+     */
+    const std::vector<Object>* operator()(
+        const std::vector<Object>& action_args) const;
+
+   private:
+    explicit Trigger(const Axiom& axiom) : axiom_(&axiom) {}
+
+    const Axiom* axiom_;
+    std::vector<std::pair<size_t, size_t>> idx_params_;
+    std::vector<std::pair<size_t, Object>> future_action_args_;
+    ThreadLocalBuffer<std::vector<Object>> axiom_args_;
+  };
 
  private:
   bool IsConsistent(PartialState* state, bool* is_changed) const;
@@ -0,0 +1,109 @@
+/**
+ * axiom_propagator.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_AXIOM_PROPAGATOR_H_
+#define SYMBOLIC_AXIOM_PROPAGATOR_H_
+
+#include <array>          // std::array
+#include <cstdint>        // int8_t, uint32_t
+#include <memory>         // std::shared_ptr
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+#include "symbolic/axiom.h"
+#include "symbolic/proposition.h"
+#include "symbolic/state.h"
+#include "symbolic/utils/thread_local_buffer.h"
+
+namespace symbolic {
+
+class Pddl;
+
+/**
+ * Propagates axioms over partial states with two-watched-literal indexing.
+ *
+ * Every ground axiom implication `context ^ conditions => effect` is compiled
+ * into a clause `!context v !conditions v effect`. Propagation only derives
+ * clause effects, so a partial state is completed exactly as if the axioms
+ * were applied until convergence, but each clause is only revisited when one
+ * of its two watched literals becomes false.
+ */
+class AxiomPropagator {
+ public:
+  AxiomPropagator(const Pddl& pddl,
+                  const std::vector<std::shared_ptr<Axiom>>& axioms);
+
+  /**
+   * Completes the partial state with the propositions implied by the axioms.
+   *
+   * @param state Partial state to update in place.
+   * @param violated_axiom Optional output of the violated axiom, or nullptr if
+   *                       the partial state itself is contradictory.
+   * @returns False if the partial state violates an axiom, in which case the
+   *          state is left unchanged.
+   */
+  bool Propagate(PartialState* state,
+                 const Axiom** violated_axiom = nullptr) const;
+
+  /**
+   * Number of ground propositions appearing in the axiom clauses.
+   */
+  size_t num_propositions() const { return propositions_.size(); }
+
+  /**
+   * Number of ground axiom clauses.
+   */
+  size_t num_clauses() const { return idx_clauses_.size() - 1; }
+
+ private:
+  using Literal = uint32_t;
+
+  /**
+   * Watches and assignment of one thread.
+   *
+   * Propagation moves the watches between literals, so every thread keeps its
+   * own watches while the clauses themselves are shared.
+   */
+  struct Scratch {
+    // Two literals watched by each clause, with the unwatched slot of unit
+    // clauses set to the same literal.
+    std::vector<std::array<Literal, 2>> watched;
+
+    // Clauses watching each literal, notified when the literal becomes false.
+    std::vector<std::vector<uint32_t>> watches;
+
+    // Assignment buffers, reset after every call.
+    std::vector<int8_t> values;
+    std::vector<Literal> trail;
+  };
+
+  Literal GetLiteral(const Proposition& prop, bool is_pos);
+
+  void AddClause(std::vector<Literal>&& premises, Literal conclusion,
+                 const Axiom* axiom);
+
+  // Ground propositions and their indices.
+  std::vector<Proposition> propositions_;
+  std::unordered_map<Proposition, uint32_t> idx_propositions_;
+
+  // Clause literals stored contiguously, with the conclusion first.
+  std::vector<Literal> literals_;
+
+  // Offsets of the clauses in the literals, their conclusions, and the axioms
+  // they were grounded from.
+  std::vector<size_t> idx_clauses_ = {0};
+  std::vector<Literal> conclusions_;
+  std::vector<const Axiom*> axioms_;
+
+  ThreadLocalBuffer<Scratch> scratch_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_AXIOM_PROPAGATOR_H_
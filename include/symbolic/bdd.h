@@ -0,0 +1,254 @@
+/**
+ * bdd.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_BDD_H_
+#define SYMBOLIC_BDD_H_
+
+#include <cstdint>        // uint32_t
+#include <optional>       // std::optional
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+#include "symbolic/formula.h"
+#include "symbolic/normal_form.h"
+#include "symbolic/state.h"
+
+namespace VAL {
+
+class goal;
+
+}  // namespace VAL
+
+namespace symbolic {
+
+class Pddl;
+
+/**
+ * Reduced ordered binary decision diagram (ROBDD) package.
+ *
+ * Nodes are hash-consed in a unique table, so two BDDs represent the same
+ * boolean function if and only if they are the same node. Operations are
+ * memoized in a lossy computed table. Nodes are never freed before the manager
+ * is destroyed.
+ *
+ * Variables are ordered by the proposition indices of the StateIndex. The
+ * manager may hold several copies of every proposition (e.g. current and next
+ * state variables for a transition relation), in which case the copies of a
+ * proposition are interleaved: variable = num_copies * idx_proposition + copy.
+ */
+class BddManager {
+ public:
+  using Node = uint32_t;
+  using Variable = uint32_t;
+
+  static constexpr Node kFalse = 0;
+  static constexpr Node kTrue = 1;
+
+  /**
+   * Creates a manager over the given number of variables, without an
+   * associated state index.
+   */
+  explicit BddManager(size_t num_variables);
+
+  /**
+   * Creates a manager with num_copies variables for each proposition of the
+   * state index.
+   */
+  explicit BddManager(const Pddl& pddl, size_t num_copies = 1);
+
+  size_t num_variables() const { return num_variables_; }
+  size_t num_copies() const { return num_copies_; }
+
+  /**
+   * Number of nodes allocated by the manager, including the terminals.
+   */
+  size_t num_nodes() const { return nodes_.size(); }
+
+  Variable variable(Node f) const { return nodes_[f].var; }
+  Node low(Node f) const { return nodes_[f].low; }
+  Node high(Node f) const { return nodes_[f].high; }
+  bool IsTerminal(Node f) const { return f <= kTrue; }
+
+  /**
+   * Variable for the given copy of the proposition.
+   */
+  Variable GetVariable(size_t idx_proposition, size_t copy = 0) const {
+    return static_cast<Variable>(num_copies_ * idx_proposition + copy);
+  }
+
+  Node Var(Variable var);
+  Node NotVar(Variable var);
+
+  Node Not(Node f) { return Ite(f, kFalse, kTrue); }
+  Node And(Node f, Node g) { return Ite(f, g, kFalse); }
+  Node Or(Node f, Node g) { return Ite(f, kTrue, g); }
+  Node Xor(Node f, Node g) { return Ite(f, Not(g), g); }
+  Node Implies(Node f, Node g) { return Ite(f, g, kTrue); }
+
+  /**
+   * If-then-else: (f & g) | (!f & h).
+   */
+  Node Ite(Node f, Node g, Node h);
+
+  /**
+   * Conjunction of the positive literals of the given variables, used to
+   * specify variable sets for quantification.
+   */
+  Node Cube(const std::vector<Variable>& vars);
+
+  /**
+   * Existentially quantifies the variables in the positive cube.
+   */
+  Node Exists(Node f, Node cube);
+
+  /**
+   * Relational product: Exists(And(f, g), cube) without building the
+   * intermediate conjunction.
+   */
+  Node AndExists(Node f, Node g, Node cube);
+
+  /**
+   * Renames variable v to map[v]. The map must be injective on the support of
+   * f.
+   */
+  Node Rename(Node f, const std::vector<Variable>& map);
+
+  /**
+   * Simultaneously substitutes each variable in the map with its BDD.
+   * Variables not in the map are kept.
+   */
+  Node Compose(Node f, const std::unordered_map<Variable, Node>& substitution);
+
+  /**
+   * Number of satisfying assignments over all variables of the manager.
+   */
+  double SatCount(Node f) const;
+
+  /**
+   * Number of nodes reachable from f, including the terminals.
+   */
+  size_t Size(Node f) const;
+
+  /**
+   * Creates a BDD from the ground formula.
+   */
+  Node Create(const Pddl& pddl, const VAL::goal* symbol,
+              const std::vector<Object>& parameters,
+              const std::vector<Object>& arguments, size_t copy = 0);
+
+  Node Create(const Pddl& pddl, const Formula& formula,
+              const std::vector<Object>& parameters,
+              const std::vector<Object>& arguments, size_t copy = 0) {
+    return Create(pddl, formula.symbol(), parameters, arguments, copy);
+  }
+
+  /**
+   * Creates a BDD from a formula in disjunctive normal form.
+   */
+  Node Create(const DisjunctiveFormula& dnf, size_t copy = 0);
+
+  Node Create(const std::optional<DisjunctiveFormula>& dnf, size_t copy = 0) {
+    return dnf.has_value() ? Create(*dnf, copy) : kFalse;
+  }
+
+  /**
+   * Creates the conjunction of the literals in the partial state.
+   */
+  Node Create(const PartialState& conj, size_t copy = 0);
+
+  /**
+   * Creates the BDD of a single complete state, where propositions not in the
+   * state are false.
+   */
+  Node CreateState(const State& state, size_t copy = 0);
+
+  /**
+   * Converts the BDD into disjunctive normal form with one conjunction per
+   * path to the true terminal. Returns an empty optional if the BDD is false.
+   * Only variables of the given copy are read, so the other copies are
+   * existentially quantified.
+   */
+  std::optional<DisjunctiveFormula> GetDisjunctiveFormula(
+      Node f, size_t copy = 0) const;
+
+  /**
+   * Returns a complete state satisfying the BDD, with unconstrained
+   * propositions set to false. Only variables of the given copy are read.
+   */
+  std::optional<State> PickState(Node f, size_t copy = 0) const;
+
+ private:
+  struct NodeData {
+    Variable var;
+    Node low;
+    Node high;
+  };
+
+  struct NodeHash {
+    size_t operator()(const NodeData& node) const;
+  };
+
+  struct NodeEqual {
+    bool operator()(const NodeData& lhs, const NodeData& rhs) const {
+      return lhs.var == rhs.var && lhs.low == rhs.low && lhs.high == rhs.high;
+    }
+  };
+
+  enum class Op : uint32_t { kIte, kExists, kAndExists };
+
+  struct CacheEntry {
+    Op op = Op::kIte;
+    Node f = kInvalidNode;
+    Node g = kInvalidNode;
+    Node h = kInvalidNode;
+    Node result = kInvalidNode;
+  };
+
+  /**
+   * Returns the unique node (var, low, high).
+   */
+  Node MakeNode(Variable var, Node low, Node high);
+
+  Variable TopVariable(Node f) const {
+    return IsTerminal(f) ? kTerminalVariable : nodes_[f].var;
+  }
+
+  Node Cofactor(Node f, Variable var, bool value) const {
+    if (TopVariable(f) != var) return f;
+    return value ? nodes_[f].high : nodes_[f].low;
+  }
+
+  std::optional<Node> FindCached(Op op, Node f, Node g, Node h) const;
+
+  void Cache(Op op, Node f, Node g, Node h, Node result);
+
+  size_t CacheIndex(Op op, Node f, Node g, Node h) const;
+
+  /**
+   * Creates the BDD of a ground proposition, evaluating = and type predicates.
+   */
+  Node CreateProposition(const Pddl& pddl, const Proposition& prop,
+                         size_t copy);
+
+  static constexpr Variable kTerminalVariable = UINT32_MAX;
+  static constexpr Node kInvalidNode = UINT32_MAX;
+  static constexpr size_t kCacheSize = size_t{1} << 18;
+
+  const Pddl* pddl_ = nullptr;
+  size_t num_variables_;
+  size_t num_copies_ = 1;
+
+  std::vector<NodeData> nodes_;
+  std::unordered_map<NodeData, Node, NodeHash, NodeEqual> unique_table_;
+  std::vector<CacheEntry> computed_table_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_BDD_H_
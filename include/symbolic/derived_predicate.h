@@ -10,6 +10,10 @@
 #ifndef SYMBOLIC_DERIVED_PREDICATE_H_
 #define SYMBOLIC_DERIVED_PREDICATE_H_
 
+#include <optional>  // std::optional
+#include <string>    // std::string
+#include <vector>    // std::vector
+
 #include "symbolic/action.h"
 
 namespace VAL {
@@ -22,12 +26,67 @@ namespace symbolic {
 
 class DerivedPredicate : public Action {
  public:
+  /**
+   * Occurrence of a predicate inside the body of a derived predicate.
+   */
+  struct BodyAtom {
+    std::string name;
+
+    /**
+     * Whether the atom appears under an even number of negations.
+     */
+    bool is_pos = true;
+
+    /**
+     * Index of the head parameter bound to each argument of the atom, or -1
+     * if the argument is a constant or a quantified variable.
+     */
+    std::vector<int> idx_params;
+
+    /**
+     * Constant value of each argument of the atom, if any.
+     */
+    std::vector<std::optional<Object>> constants;
+  };
+
+  /**
+   * Strongly connected component of the derived predicate dependency graph.
+   *
+   * Strata are ordered so that every stratum only depends on itself and on
+   * the strata before it.
+   */
+  struct Stratum {
+    /**
+     * Indices of the derived predicates in this stratum.
+     */
+    std::vector<size_t> predicates;
+
+    /**
+     * Whether a predicate in this stratum depends on the stratum itself.
+     */
+    bool is_recursive = false;
+
+    /**
+     * Whether the stratum is free of recursion through negation. Unstratified
+     * components fall back to naive fixpoint iteration.
+     */
+    bool is_stratified = true;
+  };
+
   DerivedPredicate(const Pddl& pddl, const VAL::derivation_rule* symbol);
 
   const VAL::derivation_rule* symbol() const { return symbol_; }
 
   const VAL::effect_lists* postconditions() const = delete;
 
+  /**
+   * Predicate atoms appearing in the body of the derived predicate.
+   */
+  const std::vector<BodyAtom>& body_atoms() const { return body_atoms_; }
+
+  /**
+   * Iterate over all argument combinations until the predicate converges.
+   */
   bool Apply(State* state) const;
 
   State Apply(const State& state, const std::vector<Object>& arguments) const = delete;
@@ -38,8 +97,67 @@ class DerivedPredicate : public Action {
 
   static bool Apply(const std::vector<DerivedPredicate>& predicates, State* state);
 
+  /**
+   * Apply the derived predicates stratum by stratum.
+   *
+   * Non-recursive strata are evaluated in a single pass. Recursive strata are
+   * evaluated semi-naively: after the first pass, only the bindings that can
+   * be affected by newly derived atoms are re-evaluated.
+   *
+   * @param predicates Derived predicates.
+   * @param strata Strata computed with DerivedPredicate::Stratify().
+   * @param state State to update in place.
+   * @returns Whether the state has changed.
+   */
+  static bool Apply(const std::vector<DerivedPredicate>& predicates,
+                    const std::vector<Stratum>& strata, State* state);
+
+  /**
+   * Incrementally update the derived predicates after applying an action.
+   *
+   * Only bindings affected by the changes between the previous and current
+   * states are re-evaluated. Recursive strata are maintained with
+   * delete-and-rederive.
+   *
+   * @param predicates Derived predicates.
+   * @param strata Strata computed with DerivedPredicate::Stratify().
+   * @param prev_state State before the action, with up-to-date derived
+   *                   predicates.
+   * @param state State after the action, to update in place.
+   * @returns Whether any derived predicate has changed.
+   */
+  static bool Update(const std::vector<DerivedPredicate>& predicates,
+                     const std::vector<Stratum>& strata,
+                     const State& prev_state, State* state);
+
+  /**
+   * Incrementally update the derived predicates from the net changes of an
+   * action, recorded with a StateRecorder, without diffing whole states.
+   *
+   * @param predicates Derived predicates.
+   * @param strata Strata computed with DerivedPredicate::Stratify().
+   * @param added Propositions added by the action.
+   * @param deleted Propositions deleted by the action.
+   * @param state State after the action, to update in place.
+   * @returns Whether any derived predicate has changed.
+   */
+  static bool Update(const std::vector<DerivedPredicate>& predicates,
+                     const std::vector<Stratum>& strata, const State& added,
+                     const State& deleted, State* state);
+
+  /**
+   * Stratify the derived predicates by their dependency graph.
+   *
+   * @param predicates Derived predicates.
+   * @returns Strata in evaluation order.
+   */
+  static std::vector<Stratum> Stratify(
+      const std::vector<DerivedPredicate>& predicates);
+
  private:
   const VAL::derivation_rule* symbol_;
+  std::vector<BodyAtom> body_atoms_;
+  size_t predicate_hash_ = 0;
 };
 
 }  // namespace symbolic
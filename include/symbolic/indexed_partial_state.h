@@ -0,0 +1,181 @@
+/**
+ * indexed_partial_state.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_INDEXED_PARTIAL_STATE_H_
+#define SYMBOLIC_INDEXED_PARTIAL_STATE_H_
+
+#include <cstdint>   // uint32_t, uint64_t
+#include <optional>  // std::optional
+#include <vector>    // std::vector
+
+#include "symbolic/normal_form.h"
+#include "symbolic/state.h"
+
+namespace symbolic {
+
+/**
+ * Partial state packed into positive and negative bit vectors over the
+ * propositions of a StateIndex.
+ */
+class IndexedPartialState {
+ public:
+  using Word = uint64_t;
+  static constexpr size_t kBitsPerWord = 64;
+
+  IndexedPartialState() = default;
+
+  /**
+   * Creates an empty partial state over the given number of propositions.
+   */
+  explicit IndexedPartialState(size_t size)
+      : pos_(NumWords(size), 0), neg_(NumWords(size), 0), size_(size) {}
+
+  IndexedPartialState(const StateIndex& state_index, const PartialState& state);
+
+  /**
+   * Creates a partial state from packed words.
+   *
+   * Throws std::invalid_argument if the number of words does not match the
+   * size, if bits are set past the size, or if a proposition is both positive
+   * and negative.
+   */
+  IndexedPartialState(std::vector<Word>&& pos, std::vector<Word>&& neg,
+                      size_t size);
+
+  /**
+   * Converts the packed partial state back into a partial state.
+   */
+  PartialState GetPartialState(const StateIndex& state_index) const;
+
+  const std::vector<Word>& pos() const { return pos_; }
+  const std::vector<Word>& neg() const { return neg_; }
+
+  /**
+   * Number of propositions in the state index.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * Returns the value of the proposition, or an empty optional if unknown.
+   */
+  std::optional<bool> at(size_t idx_proposition) const {
+    const Word mask = Mask(idx_proposition);
+    const size_t idx_word = idx_proposition / kBitsPerWord;
+    if (pos_[idx_word] & mask) return true;
+    if (neg_[idx_word] & mask) return false;
+    return {};
+  }
+
+  /**
+   * Sets the proposition to true.
+   *
+   * If the proposition is negated, returns 2. If the proposition is simply
+   * inserted, returns 1. If the proposition already exists, returns 0.
+   */
+  int insert(size_t idx_proposition) {
+    return Set(idx_proposition, &pos_, &neg_);
+  }
+
+  /**
+   * Sets the proposition to false.
+   *
+   * If the proposition is negated, returns 2. If the proposition is simply
+   * inserted, returns 1. If the proposition already exists, returns 0.
+   */
+  int erase(size_t idx_proposition) {
+    return Set(idx_proposition, &neg_, &pos_);
+  }
+
+  /**
+   * Ensure positive and negative bit vectors don't overlap.
+   */
+  bool IsConsistent() const;
+
+  friend bool operator==(const IndexedPartialState& lhs,
+                         const IndexedPartialState& rhs) {
+    return lhs.pos_ == rhs.pos_ && lhs.neg_ == rhs.neg_;
+  }
+  friend bool operator!=(const IndexedPartialState& lhs,
+                         const IndexedPartialState& rhs) {
+    return !(lhs == rhs);
+  }
+
+  static size_t NumWords(size_t size) {
+    return (size + kBitsPerWord - 1) / kBitsPerWord;
+  }
+
+ private:
+  static Word Mask(size_t idx_proposition) {
+    return Word{1} << (idx_proposition % kBitsPerWord);
+  }
+
+  static int Set(size_t idx_proposition, std::vector<Word>* set,
+                 std::vector<Word>* unset) {
+    const Word mask = Mask(idx_proposition);
+    const size_t idx_word = idx_proposition / kBitsPerWord;
+    const int was_negated = static_cast<int>(((*unset)[idx_word] & mask) != 0);
+    const int was_set = static_cast<int>(((*set)[idx_word] & mask) == 0);
+    (*unset)[idx_word] &= ~mask;
+    (*set)[idx_word] |= mask;
+    return was_negated + was_set;
+  }
+
+  std::vector<Word> pos_;
+  std::vector<Word> neg_;
+  size_t size_ = 0;
+};
+
+/**
+ * Ground formula compiled into bit masks for three-valued (Kleene) evaluation
+ * over packed partial states.
+ *
+ * The formula is stored in disjunctive normal form. Each conjunction is a
+ * sparse list of word masks, so evaluation checks 64 propositions per word
+ * operation.
+ */
+class IndexedFormula {
+ public:
+  IndexedFormula(const StateIndex& state_index, const DisjunctiveFormula& dnf);
+
+  /**
+   * Compiles the formula grounded with the given arguments.
+   */
+  IndexedFormula(const Pddl& pddl, const Formula& formula,
+                 const std::vector<Object>& parameters,
+                 const std::vector<Object>& arguments);
+
+  /**
+   * Evaluates the formula with Kleene logic.
+   *
+   * @param state Packed partial state.
+   * @returns True or false if the formula is determined by the partial state,
+   *          or an empty optional if it is unknown.
+   */
+  std::optional<bool> operator()(const IndexedPartialState& state) const;
+
+ private:
+  void Compile(const StateIndex& state_index, const DisjunctiveFormula& dnf);
+
+  struct Mask {
+    uint32_t idx_word;
+    IndexedPartialState::Word pos;
+    IndexedPartialState::Word neg;
+  };
+
+  // Conjunction i consists of masks [idx_conjunctions_[i], [i+1]).
+  std::vector<Mask> masks_;
+  std::vector<size_t> idx_conjunctions_ = {0};
+
+  // Whether the formula is trivially false (the DNF could not be created).
+  bool is_false_ = false;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_INDEXED_PARTIAL_STATE_H_
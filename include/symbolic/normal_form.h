@@ -10,15 +10,20 @@
 #ifndef SYMBOLIC_NORMAL_FORM_H_
 #define SYMBOLIC_NORMAL_FORM_H_
 
-#include <functional>  // std::function
-#include <ostream>     // std::ostream
-#include <set>         // std::set
-#include <utility>     // std::pair
-#include <vector>      // std::vector
+#include <functional>     // std::function
+#include <mutex>          // std::mutex
+#include <optional>       // std::optional
+#include <ostream>        // std::ostream
+#include <set>            // std::set
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+#include <utility>        // std::pair
+#include <vector>         // std::vector
 
 #include "symbolic/action.h"
 #include "symbolic/formula.h"
 #include "symbolic/state.h"
+#include "symbolic/utils/lru_cache.h"
 
 namespace symbolic {
 
@@ -133,6 +138,81 @@ struct ConjunctiveFormula {
   std::vector<Disjunction> disjunctions;
 };
 
+/**
+ * Cache of normalized action pre/post conditions.
+ *
+ * The conditions of each action are normalized once with the action parameters
+ * as placeholders. Ground conditions are instantiated by substituting the
+ * arguments into these lifted formulas, and the most recently used ground
+ * results are kept in an LRU cache keyed by the action call.
+ */
+class NormalFormCache {
+ public:
+  using Conditions = std::pair<std::optional<DisjunctiveFormula>,
+                               std::optional<DisjunctiveFormula>>;
+
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit NormalFormCache(size_t capacity = kDefaultCapacity)
+      : ground_conditions_(capacity), ground_conditions_axioms_(capacity) {}
+
+  /**
+   * Normalize the pre/post conditions of the given action.
+   *
+   * @param pddl Pddl object.
+   * @param action_call Action call string.
+   * @param apply_axioms Whether to apply the axioms to the pre/post conditions.
+   * @return Pair of normalized pre/post conditions, each of which is empty if
+   *         the condition is invalid.
+   */
+  Conditions NormalizeConditions(const Pddl& pddl,
+                                 const std::string& action_call,
+                                 bool apply_axioms);
+
+ private:
+  struct LiftedProposition {
+    std::string name;
+    std::vector<Object> arguments;
+
+    // Index of the action parameter for each argument, or -1 for constants.
+    std::vector<int> idx_parameters;
+  };
+
+  struct LiftedConjunction {
+    std::vector<LiftedProposition> pos;
+    std::vector<LiftedProposition> neg;
+  };
+
+  // Empty if the formula is always false.
+  using LiftedFormula = std::optional<std::vector<LiftedConjunction>>;
+
+  struct LiftedAction {
+    size_t idx_action;
+
+    // Whether the conditions could be lifted. Otherwise they are normalized
+    // separately for every action call.
+    bool is_lifted = true;
+
+    LiftedFormula pre;
+    LiftedFormula post;
+  };
+
+  const LiftedAction& GetLiftedAction(const Pddl& pddl,
+                                      const std::string& name_action);
+
+  static LiftedFormula Lift(const std::vector<Object>& parameters,
+                            std::optional<DisjunctiveFormula>&& dnf);
+
+  static std::optional<DisjunctiveFormula> Instantiate(
+      const Pddl& pddl, const LiftedFormula& formula,
+      const std::vector<Object>& arguments);
+
+  std::unordered_map<std::string, LiftedAction> lifted_actions_;
+  LruCache<std::string, Conditions> ground_conditions_;
+  LruCache<std::string, Conditions> ground_conditions_axioms_;
+  std::mutex mtx_;
+};
+
 // bool Simplify(DisjunctiveFormula* dnf);
 
 // DisjunctiveFormula Disjoin(std::vector<DisjunctiveFormula>&& dnfs);
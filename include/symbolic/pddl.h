@@ -20,6 +20,7 @@
 
 #include "symbolic/action.h"
 #include "symbolic/axiom.h"
+#include "symbolic/axiom_propagator.h"
 #include "symbolic/derived_predicate.h"
 #include "symbolic/formula.h"
 #include "symbolic/object.h"
@@ -34,14 +35,14 @@ class analysis;
 
 namespace symbolic {
 
+class NormalFormCache;
+
 /**
  * Main class for manipulating the pddl specification.
  */
 class Pddl {
  public:
   using ObjectTypeMap = std::unordered_map<std::string, std::vector<Object>>;
-  using AxiomContextMap =
-      std::unordered_map<std::string, std::vector<std::weak_ptr<Axiom>>>;
 
   /**
    * Parse the pddl specification from the domain and problem files.
@@ -78,8 +79,8 @@ class Pddl {
   /**
    * Apply an action to the given state.
    *
-   * The action's preconditions are not checked. The resulting state includes
-   * derived predicates.
+   * The action's preconditions are not checked. The derived predicates of the
+   * resulting state are recomputed from scratch.
    *
    * @param state Current state.
    * @param action_call Action call in the form of `"action(obj_a, obj_b)"`.
@@ -92,8 +93,9 @@ class Pddl {
   /**
    * Execute a sequence of actions from the given state.
    *
-   * The action preconditionss are not checked. The resulting state includes
-   * derived predicates.
+   * The action preconditionss are not checked. The derived predicates are
+   * recomputed from scratch after the first action and then updated
+   * incrementally.
    *
    * @param state Current state.
    * @param action_call Action calls in the form of `"action(obj_a, obj_b)"`.
@@ -121,6 +123,9 @@ class Pddl {
   /**
    * Applies the axioms to the given partial state.
    *
+   * Axioms are propagated with AxiomPropagator, so the cost is proportional
+   * to the number of propositions affected by the partial state.
+   *
    * @param state Current partial state.
    * @returns Partial state with axioms applied.
    *
@@ -237,18 +242,40 @@ class Pddl {
   const std::vector<std::shared_ptr<Axiom>>& axioms() const { return axioms_; }
 
   /**
-   * Map from context predicate name to vector of axioms.
+   * Axioms whose context predicate is triggered when the given predicate
+   * becomes true (is_pos) or false (!is_pos).
+   *
+   * Axioms are indexed by predicate id and sign. The returned pointers remain
+   * valid for the lifetime of the axioms.
    */
-  const AxiomContextMap& axiom_map() const { return axiom_map_; }
+  const std::vector<const Axiom*>& axiom_triggers(
+      const std::string& name_predicate, bool is_pos) const;
+
+  /**
+   * Watched-literal propagator over the ground axioms, used for partial states.
+   */
+  const AxiomPropagator& axiom_propagator() const { return *axiom_propagator_; }
 
   const std::vector<DerivedPredicate>& derived_predicates() const {
     return derived_predicates_;
   }
 
+  /**
+   * Derived predicate strata in evaluation order.
+   */
+  const std::vector<DerivedPredicate::Stratum>& derived_strata() const {
+    return derived_strata_;
+  }
+
   const StateIndex& state_index() const { return state_index_; }
 
   const Formula& goal() const { return goal_; }
 
+  /**
+   * Cache of normalized action conditions, shared by copies of this object.
+   */
+  NormalFormCache& normal_form_cache() const { return *normal_form_cache_; }
+
  private:
   std::shared_ptr<VAL::analysis> analysis_;
   std::string domain_pddl_;
@@ -258,17 +285,22 @@ class Pddl {
   std::vector<Object> objects_;
   ObjectTypeMap object_map_;
 
-  AxiomContextMap axiom_map_;
+  // Axioms indexed by 2 * predicate id + is_pos.
+  std::vector<std::vector<const Axiom*>> axiom_triggers_;
   std::vector<Action> actions_;
   std::vector<std::shared_ptr<Axiom>> axioms_;
+  std::shared_ptr<const AxiomPropagator> axiom_propagator_;
 
   std::vector<Predicate> predicates_;
   std::vector<DerivedPredicate> derived_predicates_;
+  std::vector<DerivedPredicate::Stratum> derived_strata_;
 
   StateIndex state_index_;
 
   State initial_state_;
   Formula goal_;
+
+  std::shared_ptr<NormalFormCache> normal_form_cache_;
 };
 
 std::set<std::string> Stringify(const State& state);
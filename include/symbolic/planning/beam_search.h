@@ -0,0 +1,432 @@
+/**
+ * beam_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_BEAM_SEARCH_H_
+#define SYMBOLIC_PLANNING_BEAM_SEARCH_H_
+
+#include <algorithm>   // std::max, std::min, std::push_heap, std::sort_heap
+#include <cstddef>     // ptrdiff_t
+#include <functional>  // std::function
+#include <iostream>    // std::cout
+#include <iterator>    // std::input_iterator_tag
+#include <limits>      // std::numeric_limits
+#include <utility>     // std::move, std::pair
+#include <vector>      // std::vector
+
+namespace symbolic {
+
+/**
+ * Layered search that keeps only the beam_width best nodes of every layer.
+ *
+ * Nodes are ranked by the score function, where lower scores are better (e.g.
+ * a heuristic estimate of the distance to the goal). Memory is bounded by
+ * beam_width nodes per layer, and the layer buffers are allocated once. The
+ * search is incomplete: goals outside the beam are never found.
+ *
+ * Iterates over the plans to the goal nodes in the order they are reached.
+ */
+template <typename NodeT>
+class BeamSearch {
+ public:
+  using ScoreFunction = std::function<double(const NodeT&)>;
+
+  class iterator;
+
+  BeamSearch(const NodeT& root, const ScoreFunction& score, size_t beam_width,
+             size_t max_depth, bool verbose = false)
+      : root_(root),
+        score_(score),
+        beam_width_(std::max<size_t>(beam_width, 1)),
+        max_depth_(max_depth),
+        verbose_(verbose) {}
+
+  iterator begin() const {
+    iterator it(this);
+    return ++it;
+  }
+  iterator end() const { return iterator(); }
+
+ private:
+  const NodeT& root_;
+  const ScoreFunction score_;
+  const size_t beam_width_;
+  const size_t max_depth_;
+  const bool verbose_;
+};
+
+/**
+ * Complete variant of beam search that backtracks over the beam layers.
+ *
+ * Each layer records the range of child ranks it admitted from the previous
+ * layer. When a layer cannot be extended, the search backtracks to the
+ * deepest layer with unexplored children and replaces it with the next
+ * beam_width children in rank order. After a plan is found, only shorter
+ * plans are sought, so the plans are yielded with strictly decreasing length
+ * and the last plan is a shortest plan within max_depth.
+ *
+ * R. Zhou and E. A. Hansen. Beam-stack search: Integrating backtracking with
+ * beam search. ICAPS 2005.
+ */
+template <typename NodeT>
+class BeamStackSearch {
+ public:
+  using ScoreFunction = std::function<double(const NodeT&)>;
+
+  class iterator;
+
+  BeamStackSearch(const NodeT& root, const ScoreFunction& score,
+                  size_t beam_width, size_t max_depth, bool verbose = false)
+      : root_(root),
+        score_(score),
+        beam_width_(std::max<size_t>(beam_width, 1)),
+        max_depth_(max_depth),
+        verbose_(verbose) {}
+
+  iterator begin() const {
+    iterator it(this);
+    return ++it;
+  }
+  iterator end() const { return iterator(); }
+
+ private:
+  const NodeT& root_;
+  const ScoreFunction score_;
+  const size_t beam_width_;
+  const size_t max_depth_;
+  const bool verbose_;
+};
+
+namespace beam_search {
+
+/**
+ * Rank of a child among all children of a layer: its score, with ties broken
+ * by generation order so that regenerating a layer reproduces the ranks.
+ */
+using Rank = std::pair<double, size_t>;
+
+inline Rank MinRank() {
+  return {-std::numeric_limits<double>::infinity(), 0};
+}
+
+inline Rank MaxRank() {
+  return {std::numeric_limits<double>::infinity(),
+          std::numeric_limits<size_t>::max()};
+}
+
+template <typename NodeT>
+struct Item {
+  NodeT node;
+  Rank rank;
+  size_t idx_parent;
+};
+
+/**
+ * Generates the children of the non-goal nodes in the layer with rank in
+ * [min_rank, max_rank) and keeps the best beam_width of them in the next
+ * layer, sorted by rank.
+ *
+ * Children are selected online into a max-heap of at most beam_width
+ * candidates, so the children of the whole layer are never buffered.
+ *
+ * @returns The rank of the best excluded child, or MaxRank() if all children
+ *          in the range fit in the beam.
+ */
+template <typename NodeT, typename ScoreT>
+Rank ExpandLayer(const std::vector<Item<NodeT>>& layer, const ScoreT& score,
+                 size_t beam_width, const Rank& min_rank, const Rank& max_rank,
+                 std::vector<Item<NodeT>>* candidates,
+                 std::vector<Item<NodeT>>* next_layer) {
+  const auto CompareRank = [](const Item<NodeT>& lhs, const Item<NodeT>& rhs) {
+    return lhs.rank < rhs.rank;
+  };
+
+  candidates->clear();
+  Rank excluded = MaxRank();
+  size_t idx_child = 0;
+  for (size_t i = 0; i < layer.size(); i++) {
+    if (layer[i].node) continue;
+    for (const NodeT& child : layer[i].node) {
+      const Rank rank(score(child), idx_child++);
+      if (rank < min_rank || !(rank < max_rank)) continue;
+
+      if (candidates->size() < beam_width) {
+        candidates->push_back({child, rank, i});
+        std::push_heap(candidates->begin(), candidates->end(), CompareRank);
+        continue;
+      }
+
+      // Replace the worst candidate if the child ranks better.
+      if (!(rank < candidates->front().rank)) {
+        excluded = std::min(excluded, rank);
+        continue;
+      }
+      std::pop_heap(candidates->begin(), candidates->end(), CompareRank);
+      excluded = std::min(excluded, candidates->back().rank);
+      candidates->back() = {child, rank, i};
+      std::push_heap(candidates->begin(), candidates->end(), CompareRank);
+    }
+  }
+  std::sort_heap(candidates->begin(), candidates->end(), CompareRank);
+
+  next_layer->clear();
+  for (Item<NodeT>& item : *candidates) next_layer->push_back(std::move(item));
+  return excluded;
+}
+
+/**
+ * Reconstructs the plan to the given item of the last layer.
+ */
+template <typename NodeT>
+void ExtractPlan(const std::vector<std::vector<Item<NodeT>>>& layers,
+                 size_t num_layers, size_t idx_item,
+                 std::vector<NodeT>* plan) {
+  plan->resize(num_layers);
+  for (size_t i = num_layers; i-- > 0;) {
+    const Item<NodeT>& item = layers[i][idx_item];
+    (*plan)[i] = item.node;
+    idx_item = item.idx_parent;
+  }
+}
+
+}  // namespace beam_search
+
+template <typename NodeT>
+class BeamSearch<NodeT>::iterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::vector<NodeT>;
+  using difference_type = ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  iterator() = default;
+  explicit iterator(const BeamSearch<NodeT>* beam) : beam_(beam) {
+    // Preallocate the layer buffers.
+    layers_.resize(beam_->max_depth_ + 1);
+    for (std::vector<Item>& layer : layers_) {
+      layer.reserve(beam_->beam_width_);
+    }
+    candidates_.reserve(beam_->beam_width_);
+    layers_[0].push_back({beam_->root_, beam_search::MinRank(), 0});
+    num_layers_ = 1;
+  }
+
+  iterator& operator++();
+
+  bool operator==(const iterator& other) const {
+    return IsFinished() && other.IsFinished();
+  }
+
+  bool operator!=(const iterator& other) const { return !(*this == other); }
+
+  reference operator*() const { return plan_; }
+
+ private:
+  using Item = beam_search::Item<NodeT>;
+
+  bool IsFinished() const { return num_layers_ == 0; }
+
+  const BeamSearch<NodeT>* beam_ = nullptr;
+
+  std::vector<std::vector<Item>> layers_;
+  std::vector<Item> candidates_;
+  size_t num_layers_ = 0;
+
+  // Index of the next item in the last layer to check for the goal.
+  size_t idx_item_ = 0;
+
+  std::vector<NodeT> plan_;
+};
+
+template <typename NodeT>
+typename BeamSearch<NodeT>::iterator&
+BeamSearch<NodeT>::iterator::operator++() {
+  while (num_layers_ > 0) {
+    // Return the plans to the goal nodes of the last layer.
+    const std::vector<Item>& layer = layers_[num_layers_ - 1];
+    while (idx_item_ < layer.size()) {
+      if (layer[idx_item_].node) {
+        beam_search::ExtractPlan(layers_, num_layers_, idx_item_++, &plan_);
+        if (beam_->verbose_) {
+          std::cout << "Goal state reached: " << plan_.back() << std::endl;
+        }
+        return *this;
+      }
+      idx_item_++;
+    }
+
+    // Expand the next layer.
+    if (num_layers_ > beam_->max_depth_) {
+      num_layers_ = 0;
+      break;
+    }
+    beam_search::ExpandLayer(layer, beam_->score_, beam_->beam_width_,
+                             beam_search::MinRank(), beam_search::MaxRank(),
+                             &candidates_, &layers_[num_layers_]);
+    if (layers_[num_layers_].empty()) {
+      num_layers_ = 0;
+      break;
+    }
+    num_layers_++;
+    idx_item_ = 0;
+
+    if (beam_->verbose_) {
+      std::cout << "Beam search depth: " << num_layers_ - 1 << std::endl;
+    }
+  }
+  plan_.clear();
+  return *this;
+}
+
+template <typename NodeT>
+class BeamStackSearch<NodeT>::iterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::vector<NodeT>;
+  using difference_type = ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  iterator() = default;
+  explicit iterator(const BeamStackSearch<NodeT>* beam)
+      : beam_(beam), max_num_layers_(beam->max_depth_ + 2) {
+    // Preallocate the layer buffers.
+    layers_.resize(beam_->max_depth_ + 1);
+    for (std::vector<Item>& layer : layers_) {
+      layer.reserve(beam_->beam_width_);
+    }
+    candidates_.reserve(beam_->beam_width_);
+    ranges_.resize(beam_->max_depth_ + 1);
+    layers_[0].push_back({beam_->root_, beam_search::MinRank(), 0});
+    num_layers_ = 1;
+  }
+
+  iterator& operator++();
+
+  bool operator==(const iterator& other) const {
+    return IsFinished() && other.IsFinished();
+  }
+
+  bool operator!=(const iterator& other) const { return !(*this == other); }
+
+  reference operator*() const { return plan_; }
+
+ private:
+  using Item = beam_search::Item<NodeT>;
+  using Rank = beam_search::Rank;
+
+  bool IsFinished() const { return num_layers_ == 0; }
+
+  /**
+   * Checks the last layer for a goal node and, if found, sets the plan and
+   * bounds the search to shorter plans.
+   */
+  bool FindGoal();
+
+  /**
+   * Backtracks to the deepest layer with unexplored children and replaces it
+   * with the next children in rank order.
+   */
+  void Backtrack();
+
+  const BeamStackSearch<NodeT>* beam_ = nullptr;
+
+  // Layers on the beam stack, and the range [min_rank, excluded_rank) of
+  // child ranks admitted by each layer.
+  std::vector<std::vector<Item>> layers_;
+  std::vector<std::pair<Rank, Rank>> ranges_;
+  std::vector<Item> candidates_;
+  size_t num_layers_ = 0;
+
+  // Plans must have fewer layers than this bound.
+  size_t max_num_layers_ = 0;
+
+  // Whether the last layer has been checked for the goal.
+  bool is_checked_ = false;
+
+  std::vector<NodeT> plan_;
+};
+
+template <typename NodeT>
+bool BeamStackSearch<NodeT>::iterator::FindGoal() {
+  const std::vector<Item>& layer = layers_[num_layers_ - 1];
+  for (size_t i = 0; i < layer.size(); i++) {
+    if (!layer[i].node) continue;
+
+    beam_search::ExtractPlan(layers_, num_layers_, i, &plan_);
+    max_num_layers_ = num_layers_;
+    if (beam_->verbose_) {
+      std::cout << "Goal state reached at depth " << num_layers_ - 1 << ": "
+                << plan_.back() << std::endl;
+    }
+    return true;
+  }
+  return false;
+}
+
+template <typename NodeT>
+void BeamStackSearch<NodeT>::iterator::Backtrack() {
+  while (num_layers_ > 1) {
+    const size_t idx_layer = num_layers_ - 1;
+    const Rank excluded = ranges_[idx_layer].second;
+    if (idx_layer >= max_num_layers_ - 1 ||
+        excluded == beam_search::MaxRank()) {
+      // Layer has no unexplored siblings within the bound.
+      num_layers_--;
+      continue;
+    }
+
+    // Shift the layer to the next children in rank order.
+    ranges_[idx_layer].first = excluded;
+    ranges_[idx_layer].second = beam_search::ExpandLayer(
+        layers_[idx_layer - 1], beam_->score_, beam_->beam_width_, excluded,
+        beam_search::MaxRank(), &candidates_, &layers_[idx_layer]);
+    if (beam_->verbose_) {
+      std::cout << "Beam-stack search backtracked to depth " << idx_layer
+                << std::endl;
+    }
+    return;
+  }
+  num_layers_ = 0;
+}
+
+template <typename NodeT>
+typename BeamStackSearch<NodeT>::iterator&
+BeamStackSearch<NodeT>::iterator::operator++() {
+  while (num_layers_ > 0) {
+    if (!is_checked_) {
+      is_checked_ = true;
+      if (FindGoal()) return *this;
+    }
+
+    // Extend the beam stack by one layer if shorter plans may exist.
+    if (num_layers_ + 1 < max_num_layers_) {
+      std::vector<Item>& next_layer = layers_[num_layers_];
+      const Rank excluded = beam_search::ExpandLayer(
+          layers_[num_layers_ - 1], beam_->score_, beam_->beam_width_,
+          beam_search::MinRank(), beam_search::MaxRank(), &candidates_,
+          &next_layer);
+      if (!next_layer.empty()) {
+        ranges_[num_layers_] = {beam_search::MinRank(), excluded};
+        num_layers_++;
+        is_checked_ = false;
+        continue;
+      }
+    }
+
+    Backtrack();
+    is_checked_ = false;
+  }
+  plan_.clear();
+  return *this;
+}
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_BEAM_SEARCH_H_
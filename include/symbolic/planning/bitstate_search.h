@@ -0,0 +1,119 @@
+/**
+ * bitstate_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_BITSTATE_SEARCH_H_
+#define SYMBOLIC_PLANNING_BITSTATE_SEARCH_H_
+
+#include <cstdint>   // uint64_t
+#include <limits>    // std::numeric_limits
+#include <optional>  // std::optional
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "symbolic/pddl.h"
+
+namespace symbolic {
+
+/**
+ * Depth-first search with bitstate hashing (supertrace).
+ *
+ * Instead of storing visited states, each state sets k bits of a large bit
+ * array chosen by double hashing, and a state is considered visited if all of
+ * its bits are set. The two hashes are the state hash and an independent hash
+ * of the state atoms, so that states whose 64-bit hashes collide still set
+ * different bits. Only the nodes on the current path are
+ * kept in memory. Hash collisions make the search skip some unvisited states,
+ * as does reaching a state first at a greater depth than on a later path, so
+ * the exploration is approximate.
+ *
+ * A new state is omitted with probability f^k, where f is the fraction of set
+ * bits. Since every stored state was found after an expected 1 / (1 - f^k)
+ * lookups of new states, the number of omitted states is estimated by summing
+ * f^k / (1 - f^k) over the stored states.
+ *
+ * G. J. Holzmann. An analysis of bitstate hashing. Formal Methods in System
+ * Design, 1998.
+ */
+class BitstateSearch {
+ public:
+  static constexpr size_t kDefaultLog2NumBits = 27;
+  static constexpr size_t kDefaultNumHashes = 3;
+
+  struct Statistics {
+    // Number of states inserted into the bit array.
+    size_t num_stored = 0;
+
+    // Number of generated states whose bits were all set.
+    size_t num_matched = 0;
+
+    // Fraction of set bits.
+    double fill_ratio = 0.;
+
+    // Probability that a new state is omitted at the end of the search.
+    double omission_probability = 0.;
+
+    // Estimated number of omitted states and the fraction of reached states
+    // that were stored.
+    double expected_omissions = 0.;
+    double coverage = 1.;
+  };
+
+  /**
+   * @param pddl Pddl instance.
+   * @param log2_num_bits Base 2 logarithm of the size of the bit array.
+   * @param num_hashes Number of bits set per state.
+   */
+  explicit BitstateSearch(const Pddl& pddl,
+                          size_t log2_num_bits = kDefaultLog2NumBits,
+                          size_t num_hashes = kDefaultNumHashes);
+
+  /**
+   * Searches for a plan from the initial state.
+   *
+   * @param max_depth Maximum plan length.
+   * @param verbose Print the statistics at the end of the search.
+   * @returns Sequence of action calls, or an empty optional if no plan was
+   *          found within the maximum depth.
+   */
+  std::optional<std::vector<std::string>> Search(
+      size_t max_depth = std::numeric_limits<size_t>::max(),
+      bool verbose = false);
+
+  /**
+   * Statistics of the last search.
+   */
+  const Statistics& statistics() const { return statistics_; }
+
+  size_t num_bits() const { return bits_.size() * 64; }
+
+  size_t num_hashes() const { return num_hashes_; }
+
+ private:
+  /**
+   * Sets the bits of the state.
+   *
+   * @returns Whether some bit was not yet set.
+   */
+  bool Insert(const State& state, size_t hash);
+
+  const Pddl& pddl_;
+  size_t num_hashes_;
+  uint64_t mask_;
+  std::vector<uint64_t> bits_;
+
+  size_t num_set_ = 0;
+  Statistics statistics_;
+
+  // Buffer for the atoms of the current state.
+  std::vector<size_t> atoms_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_BITSTATE_SEARCH_H_
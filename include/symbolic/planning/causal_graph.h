@@ -0,0 +1,240 @@
+/**
+ * causal_graph.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_CAUSAL_GRAPH_H_
+#define SYMBOLIC_PLANNING_CAUSAL_GRAPH_H_
+
+#include <cstdint>  // uint16_t
+#include <memory>   // std::unique_ptr
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+#include "symbolic/planning/finite_domain.h"
+#include "symbolic/planning/grounded_task.h"
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Variable and value.
+ */
+struct Fact {
+  size_t var;
+  size_t value;
+};
+
+/**
+ * Causal graph of the task under a finite-domain encoding.
+ *
+ * The operators are translated into finite-domain operators with sorted
+ * preconditions and effects. Atoms of derived predicates are dropped from the
+ * preconditions and the goal, as are negative conditions on variables that are
+ * not binary. Deleting an atom sets its variable to `none()` if the variable is
+ * binary or the atom is a precondition.
+ *
+ * There is an arc from variable u to variable v if some operator with an
+ * effect on v has a precondition or another effect on u.
+ */
+class CausalGraph {
+ public:
+  struct Operator {
+    // Index of the grounded operator.
+    size_t idx_operator;
+
+    std::vector<Fact> pre;
+    std::vector<Fact> eff;
+  };
+
+  CausalGraph(const GroundedTask& task, const FiniteDomainEncoding& encoding);
+
+  const FiniteDomainEncoding& encoding() const { return encoding_; }
+
+  size_t num_variables() const { return successors_.size(); }
+
+  const std::vector<Operator>& operators() const { return operators_; }
+
+  const std::vector<Fact>& goal() const { return goal_; }
+
+  /**
+   * Whether every goal atom is reachable in the delete relaxation.
+   */
+  bool is_solvable() const { return is_solvable_; }
+
+  /**
+   * Sorted variables that each variable influences and is influenced by.
+   */
+  const std::vector<size_t>& successors(size_t var) const {
+    return successors_[var];
+  }
+  const std::vector<size_t>& predecessors(size_t var) const {
+    return predecessors_[var];
+  }
+
+ private:
+  const FiniteDomainEncoding& encoding_;
+  std::vector<Operator> operators_;
+  std::vector<Fact> goal_;
+  bool is_solvable_ = true;
+
+  std::vector<std::vector<size_t>> successors_;
+  std::vector<std::vector<size_t>> predecessors_;
+};
+
+/**
+ * Domain transition graph of one variable.
+ *
+ * Each transition changes the variable from one value to another with the
+ * preconditions of the operator on the other variables as conditions. An
+ * operator without a precondition on the variable yields a transition from
+ * every other value.
+ */
+class DomainTransitionGraph {
+ public:
+  static constexpr uint16_t kInfinity = UINT16_MAX;
+
+  struct Transition {
+    size_t source;
+    size_t target;
+
+    // Index of the operator in the causal graph.
+    size_t idx_operator;
+
+    // Preconditions and other effects of the operator.
+    std::vector<Fact> conditions;
+    std::vector<Fact> side_effects;
+  };
+
+  DomainTransitionGraph(const CausalGraph& causal_graph, size_t var);
+
+  size_t var() const { return var_; }
+
+  size_t domain_size() const { return transitions_from_.size(); }
+
+  const std::vector<Transition>& transitions() const { return transitions_; }
+
+  /**
+   * Indices of the transitions from each value.
+   */
+  const std::vector<size_t>& transitions_from(size_t value) const {
+    return transitions_from_[value];
+  }
+
+  /**
+   * Number of transitions on the shortest path between two values, ignoring
+   * the conditions, or kInfinity if the target is unreachable.
+   */
+  uint16_t distance(size_t source, size_t target) const {
+    return distances_[source * domain_size() + target];
+  }
+
+ private:
+  size_t var_;
+  std::vector<Transition> transitions_;
+  std::vector<std::vector<size_t>> transitions_from_;
+
+  // Shortest path lengths indexed by source and target.
+  std::vector<uint16_t> distances_;
+};
+
+/**
+ * Context-enhanced additive heuristic.
+ *
+ * Estimates the cost of changing each variable from one value to another by
+ * a Dijkstra search in its domain transition graph, in which the conditions
+ * of each transition are costed recursively from the values that the parent
+ * variables take in the context of the source value. The local searches of
+ * all variables share a single priority queue, so cycles in the causal graph
+ * are handled without recursion. The context of a value is the context of its
+ * predecessor updated with the conditions and side effects of the transition
+ * that reached it.
+ *
+ * Local problems are allocated once per variable and start value and reset
+ * between evaluations, and the domain transition graph distances prune
+ * conditions that can never be reached.
+ *
+ * M. Helmert and H. Geffner. Unifying the causal graph and additive heuristics.
+ * ICAPS 2008.
+ */
+class ContextEnhancedAdditiveHeuristic {
+ public:
+  explicit ContextEnhancedAdditiveHeuristic(const Pddl& pddl);
+
+  ~ContextEnhancedAdditiveHeuristic();
+
+  const GroundedTask& task() const { return task_; }
+
+  const FiniteDomainEncoding& encoding() const { return encoding_; }
+
+  const CausalGraph& causal_graph() const { return causal_graph_; }
+
+  const DomainTransitionGraph& domain_transition_graph(size_t var) const {
+    return dtgs_[var];
+  }
+
+  /**
+   * Evaluates the heuristic in the packed state.
+   *
+   * @returns Goal distance estimate, or infinity if the goal is unreachable.
+   */
+  double Evaluate(const FiniteDomainEncoding::PackedState& state);
+
+  double Evaluate(const State& state) {
+    task_.pddl().state_index().GetPropositionIndices(state, &atoms_);
+    encoding_.Encode(atoms_, &packed_state_);
+    return Evaluate(packed_state_);
+  }
+
+  double operator()(const Planner::Node& node) {
+    return Evaluate(node.state());
+  }
+
+ private:
+  struct LocalProblem;
+  struct LocalTransition;
+
+  /**
+   * Returns the local problem of the variable from the start value, resetting
+   * it for the current evaluation.
+   */
+  LocalProblem& GetLocalProblem(size_t var, size_t value);
+
+  void Push(int cost, LocalProblem* problem, size_t value);
+
+  void Expand(LocalProblem* problem, size_t value);
+
+  void Watch(LocalTransition* transition, const Fact& condition,
+             size_t context_value);
+
+  void Reach(LocalTransition* transition);
+
+  GroundedTask task_;
+  FiniteDomainEncoding encoding_;
+  CausalGraph causal_graph_;
+  std::vector<DomainTransitionGraph> dtgs_;
+
+  // Pseudo-transition to the goal, evaluated as a variable after the others.
+  DomainTransitionGraph::Transition goal_transition_;
+
+  // Sorted variables in the context of each variable and of the goal.
+  std::vector<std::vector<size_t>> context_vars_;
+
+  // Local problems indexed by variable and start value.
+  std::vector<std::vector<std::unique_ptr<LocalProblem>>> problems_;
+
+  // Scratch buffers reused across evaluations.
+  size_t idx_evaluation_ = 0;
+  const FiniteDomainEncoding::PackedState* state_ = nullptr;
+  std::vector<size_t> atoms_;
+  FiniteDomainEncoding::PackedState packed_state_;
+  std::vector<std::pair<int, std::pair<LocalProblem*, size_t>>> queue_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_CAUSAL_GRAPH_H_
@@ -0,0 +1,135 @@
+/**
+ * external_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_EXTERNAL_SEARCH_H_
+#define SYMBOLIC_PLANNING_EXTERNAL_SEARCH_H_
+
+#include <cstdint>   // uint64_t
+#include <limits>    // std::numeric_limits
+#include <optional>  // std::optional
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "symbolic/pddl.h"
+
+namespace symbolic {
+
+/**
+ * External-memory breadth-first search with delayed duplicate detection.
+ *
+ * States are stored as fixed-size bit vectors over the StateIndex atoms in
+ * sorted layer files, so only the sorting buffer and the file buffers are
+ * kept in memory. Each layer is streamed from disk and expanded, and the
+ * children are sorted in runs that fill the memory budget. The runs are then
+ * merged with k-way merges, in several passes if there are more runs than the
+ * file buffers that fit in the budget. The last merge drops duplicates within
+ * the new layer and against a sorted closed list of every previous layer,
+ * which is needed because action graphs are directed.
+ *
+ * A plan is extracted by streaming the layers backwards and regenerating the
+ * children of each state until the next state on the path is found.
+ *
+ * R. E. Korf. Best-first frontier search with delayed duplicate detection.
+ * AAAI 2004.
+ */
+class ExternalBreadthFirstSearch {
+ public:
+  static constexpr size_t kDefaultMemoryBudget = size_t{1} << 30;
+
+  /**
+   * @param pddl Pddl instance.
+   * @param directory Directory for the temporary layer files, or the system
+   *                  temporary directory if empty.
+   * @param memory_budget Size of the sorting buffer in bytes, which also bounds
+   *                      the file buffers open during a merge.
+   */
+  explicit ExternalBreadthFirstSearch(
+      const Pddl& pddl, const std::string& directory = "",
+      size_t memory_budget = kDefaultMemoryBudget);
+
+  ~ExternalBreadthFirstSearch();
+
+  ExternalBreadthFirstSearch(const ExternalBreadthFirstSearch&) = delete;
+  ExternalBreadthFirstSearch& operator=(const ExternalBreadthFirstSearch&) =
+      delete;
+
+  /**
+   * Searches for a shortest plan from the initial state.
+   *
+   * @param max_depth Maximum plan length.
+   * @param verbose Print the size of every layer.
+   * @returns Sequence of action calls, or an empty optional if no plan exists
+   *          within the maximum depth.
+   */
+  std::optional<std::vector<std::string>> Search(
+      size_t max_depth = std::numeric_limits<size_t>::max(),
+      bool verbose = false);
+
+  /**
+   * Number of states in each layer of the last search.
+   */
+  const std::vector<size_t>& layer_sizes() const { return layer_sizes_; }
+
+  /**
+   * Directory of the layer files, removed on destruction.
+   */
+  const std::string& directory() const { return directory_; }
+
+ private:
+  std::string LayerPath(size_t depth) const;
+
+  std::string RunPath(size_t idx_run) const;
+
+  std::string ClosedPath() const;
+
+  std::string MergePath() const;
+
+  void Encode(const State& state, uint64_t* record) const;
+
+  State Decode(const uint64_t* record) const;
+
+  /**
+   * Sorts the records in the buffer and writes the unique ones to a run file.
+   */
+  void WriteRun(std::vector<uint64_t>* buffer, size_t idx_run) const;
+
+  /**
+   * Merges the sorted files into one without duplicates, skipping the states
+   * of the closed list if given, and returns the number of states written.
+   */
+  size_t Merge(const std::vector<std::string>& paths,
+               const std::string& path_output,
+               const std::string& path_closed = "") const;
+
+  /**
+   * Merges the runs into the next layer without the states of the previous
+   * layers, adds the layer to the closed list, and returns its size.
+   */
+  size_t MergeRuns(size_t num_runs, size_t depth) const;
+
+  std::vector<std::string> ExtractPlan(size_t depth,
+                                       std::vector<uint64_t> record) const;
+
+  void RemoveFiles() const;
+
+  const Pddl& pddl_;
+  std::string directory_;
+  size_t num_words_;
+  size_t buffer_size_;
+  size_t io_buffer_size_;
+
+  // Maximum number of runs merged at once.
+  size_t max_fan_in_;
+
+  std::vector<size_t> layer_sizes_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_EXTERNAL_SEARCH_H_
@@ -0,0 +1,171 @@
+/**
+ * finite_domain.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_FINITE_DOMAIN_H_
+#define SYMBOLIC_PLANNING_FINITE_DOMAIN_H_
+
+#include <cstdint>  // uint8_t, uint64_t
+#include <vector>   // std::vector
+
+#include "symbolic/planning/grounded_task.h"
+
+namespace symbolic {
+
+/**
+ * Set of atoms of which at most one is true in every reachable state.
+ */
+struct MutexGroup {
+  // Sorted atom indices.
+  std::vector<size_t> atoms;
+
+  // Whether exactly one of the atoms is true in every reachable state.
+  bool is_exactly_one;
+};
+
+/**
+ * Synthesizes mutex groups that are invariant under the grounded operators.
+ *
+ * Candidate invariants are schematic: each is a set of predicates with a
+ * choice of fixed argument positions, and its instances are the groups of
+ * atoms that share the same fixed arguments. An instance is invariant if at
+ * most one of its atoms holds initially and every operator that adds one of
+ * its atoms also makes the others false. Candidates that fail are refined by
+ * adding the predicates that the offending operators delete. Axioms whose
+ * context implies that another atom is false seed additional candidates.
+ *
+ * Only operators and atoms that are reachable in the delete relaxation are
+ * considered, and the returned groups contain only fluent atoms.
+ *
+ * M. Helmert. Concise finite-domain representations for PDDL planning tasks.
+ * AIJ 2009.
+ */
+std::vector<MutexGroup> FindMutexGroups(const GroundedTask& task);
+
+/**
+ * Finite-domain (SAS+) encoding of the states of a task.
+ *
+ * The fluent atoms are partitioned greedily into variables by the largest
+ * remaining mutex group, and the atoms left over become binary variables. The
+ * value of a variable is the index of its true atom, or the extra value
+ * `none()` if the variable was not built from an exactly-one group and none of
+ * its atoms is true. Variables are packed into 64-bit words with the minimum
+ * number of bits per variable, without straddling words.
+ *
+ * Static atoms are restored and derived predicates are recomputed when
+ * decoding a state.
+ */
+class FiniteDomainEncoding {
+ public:
+  using PackedState = std::vector<uint64_t>;
+
+  struct Variable {
+    // Atom of each value.
+    std::vector<size_t> atoms;
+
+    // Whether the variable has a value for none of its atoms.
+    bool has_none;
+
+    // Location of the variable in the packed state.
+    size_t idx_word;
+    uint8_t shift;
+    uint64_t mask;
+
+    size_t domain_size() const { return atoms.size() + (has_none ? 1 : 0); }
+
+    size_t none() const { return atoms.size(); }
+  };
+
+  /**
+   * Hash function of packed states.
+   */
+  struct Hash {
+    size_t operator()(const PackedState& state) const;
+  };
+
+  explicit FiniteDomainEncoding(const GroundedTask& task);
+
+  /**
+   * Builds the encoding from the given mutex groups.
+   */
+  FiniteDomainEncoding(const GroundedTask& task,
+                       const std::vector<MutexGroup>& mutex_groups);
+
+  const std::vector<Variable>& variables() const { return variables_; }
+
+  size_t num_variables() const { return variables_.size(); }
+
+  /**
+   * Number of 64-bit words of a packed state.
+   */
+  size_t num_words() const { return num_words_; }
+
+  /**
+   * Atoms that are true in every reachable state.
+   */
+  const std::vector<size_t>& static_atoms() const { return static_atoms_; }
+
+  /**
+   * Variable of each atom, or -1 if the atom is not fluent.
+   */
+  const std::vector<int>& idx_variables() const { return idx_variables_; }
+
+  /**
+   * Value of each atom in its variable.
+   */
+  const std::vector<size_t>& values() const { return values_; }
+
+  size_t Get(const PackedState& state, size_t idx_variable) const {
+    const Variable& var = variables_[idx_variable];
+    return (state[var.idx_word] >> var.shift) & var.mask;
+  }
+
+  void Set(size_t idx_variable, size_t value, PackedState* state) const {
+    const Variable& var = variables_[idx_variable];
+    uint64_t& word = (*state)[var.idx_word];
+    word = (word & ~(var.mask << var.shift)) |
+           (static_cast<uint64_t>(value) << var.shift);
+  }
+
+  /**
+   * Encodes the state, ignoring static and derived atoms.
+   */
+  PackedState Encode(const State& state) const;
+
+  /**
+   * Encodes the sorted atoms of a state.
+   */
+  PackedState Encode(const std::vector<size_t>& atoms) const;
+
+  /**
+   * Encodes the sorted atoms of a state into the given packed state, reusing
+   * its storage.
+   */
+  void Encode(const std::vector<size_t>& atoms, PackedState* state) const;
+
+  /**
+   * Decodes the state, including its static and derived atoms.
+   */
+  State Decode(const PackedState& state) const;
+
+ private:
+  const Pddl* pddl_;
+  std::vector<Variable> variables_;
+  size_t num_words_ = 0;
+
+  std::vector<size_t> static_atoms_;
+  std::vector<int> idx_variables_;
+  std::vector<size_t> values_;
+
+  // Atoms that can never be true, which cannot be encoded.
+  std::vector<bool> is_unreachable_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_FINITE_DOMAIN_H_
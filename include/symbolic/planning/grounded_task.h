@@ -0,0 +1,91 @@
+/**
+ * grounded_task.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_GROUNDED_TASK_H_
+#define SYMBOLIC_PLANNING_GROUNDED_TASK_H_
+
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "symbolic/pddl.h"
+
+namespace symbolic {
+
+/**
+ * Grounded STRIPS view of a Pddl instance over StateIndex atoms.
+ *
+ * Every valid action call becomes one operator per conjunction of its
+ * normalized preconditions. Derived predicates become rules that derive their
+ * head atom from one conjunction of their normalized body. Axioms are not
+ * compiled into the task.
+ */
+class GroundedTask {
+ public:
+  struct Operator {
+    size_t idx_action;
+
+    // Index of the arguments in the action's parameter generator.
+    size_t idx_arguments;
+
+    // Sorted atom indices.
+    std::vector<size_t> pre_pos;
+    std::vector<size_t> pre_neg;
+    std::vector<size_t> add;
+    std::vector<size_t> del;
+  };
+
+  struct Rule {
+    size_t head;
+
+    // Sorted atom indices.
+    std::vector<size_t> pos;
+    std::vector<size_t> neg;
+  };
+
+  explicit GroundedTask(const Pddl& pddl);
+
+  const Pddl& pddl() const { return pddl_; }
+
+  size_t num_atoms() const { return num_atoms_; }
+
+  const std::vector<Operator>& operators() const { return operators_; }
+
+  const std::vector<Rule>& rules() const { return rules_; }
+
+  /**
+   * Sorted atoms of the initial state.
+   */
+  const std::vector<size_t>& initial_state() const { return initial_state_; }
+
+  /**
+   * Sorted atoms that must be true and false in the goal.
+   */
+  const std::vector<size_t>& goal_pos() const { return goal_pos_; }
+  const std::vector<size_t>& goal_neg() const { return goal_neg_; }
+
+  /**
+   * Action call of the operator.
+   */
+  std::string action(const Operator& op) const;
+
+ private:
+  const Pddl& pddl_;
+  size_t num_atoms_ = 0;
+
+  std::vector<Operator> operators_;
+  std::vector<Rule> rules_;
+
+  std::vector<size_t> initial_state_;
+  std::vector<size_t> goal_pos_;
+  std::vector<size_t> goal_neg_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_GROUNDED_TASK_H_
@@ -0,0 +1,143 @@
+/**
+ * landmarks.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_LANDMARKS_H_
+#define SYMBOLIC_PLANNING_LANDMARKS_H_
+
+#include <cstdint>  // uint64_t
+#include <vector>   // std::vector
+
+#include "symbolic/planning/grounded_task.h"
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Fact landmarks of the delete relaxation with their orderings.
+ *
+ * Landmarks are computed with the h^m landmark propagation for m = 1: the
+ * landmarks of an atom are the atom itself plus the intersection, over its
+ * relaxed achievers, of the union of the landmarks of their preconditions.
+ * Negative preconditions are ignored, and derived predicates are treated as
+ * zero-cost achievers of their head.
+ *
+ * E. Keyder, S. Richter, and M. Helmert. Sound and complete landmarks for
+ * and/or graphs. ECAI 2010.
+ */
+class LandmarkGraph {
+ public:
+  explicit LandmarkGraph(const GroundedTask& task);
+
+  size_t size() const { return atoms_.size(); }
+
+  /**
+   * Whether every goal atom is reachable in the delete relaxation.
+   */
+  bool is_solvable() const { return is_solvable_; }
+
+  /**
+   * Atom of each landmark, sorted.
+   */
+  const std::vector<size_t>& atoms() const { return atoms_; }
+
+  /**
+   * Index of the landmark for each atom, or -1 if the atom is not a landmark.
+   */
+  const std::vector<int>& idx_landmarks() const { return idx_landmarks_; }
+
+  /**
+   * Whether each landmark is a goal atom.
+   */
+  const std::vector<bool>& is_goal() const { return is_goal_; }
+
+  /**
+   * Landmarks that must be achieved before each landmark.
+   */
+  const std::vector<std::vector<size_t>>& natural_orderings() const {
+    return natural_orderings_;
+  }
+
+  /**
+   * Landmarks that must hold right before each landmark is first achieved.
+   */
+  const std::vector<std::vector<size_t>>& greedy_necessary_orderings() const {
+    return greedy_necessary_orderings_;
+  }
+
+ private:
+  bool is_solvable_ = true;
+  std::vector<size_t> atoms_;
+  std::vector<int> idx_landmarks_;
+  std::vector<bool> is_goal_;
+  std::vector<std::vector<size_t>> natural_orderings_;
+  std::vector<std::vector<size_t>> greedy_necessary_orderings_;
+};
+
+/**
+ * LM-count heuristic.
+ *
+ * Counts the landmarks that have not been accepted on the path to a node, plus
+ * the accepted landmarks that are required again: goals that are false, and
+ * greedy-necessary predecessors of unaccepted landmarks that are false. The
+ * set of accepted landmarks is a bitset propagated along the search edges.
+ *
+ * S. Richter and M. Westphal. The LAMA planner: Guiding cost-based anytime
+ * planning with landmarks. JAIR 2010.
+ */
+class LandmarkCountHeuristic {
+ public:
+  using Status = std::vector<uint64_t>;
+
+  explicit LandmarkCountHeuristic(const Pddl& pddl);
+
+  const GroundedTask& task() const { return task_; }
+
+  const LandmarkGraph& graph() const { return graph_; }
+
+  /**
+   * Accepted landmarks at the root of the search.
+   */
+  Status InitialStatus(const State& state) const;
+
+  /**
+   * Accepts the landmarks that are true in the state reached along an edge.
+   */
+  void Progress(const Status& parent, const State& state,
+                Status* status) const;
+
+  /**
+   * Evaluates the heuristic in a state with the given accepted landmarks.
+   *
+   * @returns Landmark count, or infinity if the goal is unreachable.
+   */
+  double Evaluate(const Status& status, const State& state) const;
+
+  /**
+   * Evaluates the heuristic at a search node, accepting the landmarks along the
+   * path of parents kept by the node. No status is stored between calls, so
+   * this can be used as the score function of concurrent search engines.
+   */
+  double operator()(const Planner::Node& node) const;
+
+ private:
+  /**
+   * Sets the bits of the landmarks that are true in the state.
+   */
+  void GetTrueLandmarks(const State& state, Status* is_true) const;
+
+  GroundedTask task_;
+  LandmarkGraph graph_;
+
+  // Landmarks ordered greedy-necessarily after each landmark.
+  std::vector<std::vector<size_t>> greedy_necessary_successors_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_LANDMARKS_H_
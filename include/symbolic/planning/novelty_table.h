@@ -0,0 +1,67 @@
+/**
+ * novelty_table.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_NOVELTY_TABLE_H_
+#define SYMBOLIC_PLANNING_NOVELTY_TABLE_H_
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint64_t
+#include <vector>   // std::vector
+
+namespace symbolic {
+
+/**
+ * Record of the atom tuples seen so far in a width-based search.
+ *
+ * Atoms are StateIndex proposition indices. Single atoms are stored in a bit
+ * array, and atom pairs in a packed bit array over the lower triangle of the
+ * pair matrix, so a width-2 table over n atoms costs n^2 / 2 bits.
+ */
+class NoveltyTable {
+ public:
+  NoveltyTable() = default;
+
+  /**
+   * @param num_atoms Number of atoms (StateIndex::size()).
+   * @param width Maximum tuple size tracked, either 1 or 2.
+   */
+  NoveltyTable(size_t num_atoms, size_t width);
+
+  size_t width() const { return width_; }
+
+  /**
+   * Computes the novelty of the state with the given atoms and records its
+   * tuples.
+   *
+   * @param atoms Sorted atom indices of the state.
+   * @returns Size of the smallest tuple not seen before, or width() + 1 if the
+   *          state is not novel.
+   */
+  size_t Insert(const std::vector<size_t>& atoms);
+
+ private:
+  static size_t PairIndex(size_t i, size_t j) { return j * (j - 1) / 2 + i; }
+
+  // Sets the bit and returns whether it was previously unset.
+  static bool TestAndSet(std::vector<uint64_t>& bits, size_t idx) {
+    uint64_t& word = bits[idx / 64];
+    const uint64_t mask = uint64_t{1} << (idx % 64);
+    const bool is_new = (word & mask) == 0;
+    word |= mask;
+    return is_new;
+  }
+
+  size_t width_ = 0;
+  std::vector<uint64_t> singles_;
+  std::vector<uint64_t> pairs_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_NOVELTY_TABLE_H_
@@ -0,0 +1,109 @@
+/**
+ * parallel_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_PARALLEL_SEARCH_H_
+#define SYMBOLIC_PLANNING_PARALLEL_SEARCH_H_
+
+#include <cstdint>     // uint64_t
+#include <functional>  // std::function
+#include <limits>      // std::numeric_limits
+#include <optional>    // std::optional
+#include <string>      // std::string
+#include <vector>      // std::vector
+
+#include "symbolic/planning/finite_domain.h"
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Hash-distributed A* (HDA*) over worker threads.
+ *
+ * Every state is owned by the worker selected by its Zobrist hash, the XOR of
+ * random keys of its StateIndex atoms. Each worker has its own open and closed
+ * lists, evaluates the heuristic of the nodes it owns, and sends generated
+ * nodes owned by other workers through their lock-free multi-producer inboxes.
+ * Nodes reached with a lower cost are reopened. The closed lists are keyed by
+ * the packed finite-domain encoding of the states, which takes a few words per
+ * state instead of a set of propositions.
+ *
+ * Goals are tested on expansion and improve a shared incumbent plan. A worker
+ * is idle once its open list holds no node with f lower than the incumbent
+ * cost. The search terminates when every worker is idle and every sent node
+ * has been received, which proves the incumbent optimal for an admissible
+ * heuristic. Workers mark themselves busy before acknowledging received
+ * nodes, so reading the acknowledgements before the idle flags and the sends
+ * after them detects termination without a global lock.
+ *
+ * A. Kishimoto, A. Fukunaga, and A. Botea. Evaluation of a simple, scalable,
+ * parallel best-first search strategy. Artificial Intelligence, 2013.
+ */
+class HashDistributedAStar {
+ public:
+  using Heuristic = std::function<double(const Planner::Node&)>;
+
+  /**
+   * Creates the heuristic of one worker, since heuristics may keep scratch
+   * buffers that cannot be shared across threads.
+   */
+  using HeuristicFactory = std::function<Heuristic()>;
+
+  /**
+   * @param pddl Pddl instance.
+   * @param num_threads Number of workers, or the number of hardware threads
+   *                    if 0.
+   * @param heuristic Factory of the heuristic, or the blind heuristic if
+   *                  empty.
+   */
+  explicit HashDistributedAStar(const Pddl& pddl, size_t num_threads = 0,
+                                HeuristicFactory heuristic = nullptr);
+
+  /**
+   * Searches for an optimal plan from the initial state.
+   *
+   * @param max_depth Maximum plan length.
+   * @param verbose Print the statistics of every worker.
+   * @returns Sequence of action calls, or an empty optional if no plan exists
+   *          within the maximum depth.
+   */
+  std::optional<std::vector<std::string>> Search(
+      size_t max_depth = std::numeric_limits<size_t>::max(),
+      bool verbose = false);
+
+  size_t num_threads() const { return num_threads_; }
+
+  /**
+   * Number of nodes expanded and sent to other workers in the last search.
+   */
+  size_t num_expanded() const { return num_expanded_; }
+  size_t num_sent() const { return num_sent_; }
+
+  /**
+   * Zobrist hash of the state.
+   */
+  uint64_t Hash(const State& state) const;
+
+ private:
+  class Worker;
+
+  const Pddl& pddl_;
+  size_t num_threads_;
+  HeuristicFactory heuristic_;
+  FiniteDomainEncoding encoding_;
+
+  // Random key of each StateIndex atom.
+  std::vector<uint64_t> keys_;
+
+  size_t num_expanded_ = 0;
+  size_t num_sent_ = 0;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_PARALLEL_SEARCH_H_
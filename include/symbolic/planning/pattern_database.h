@@ -0,0 +1,141 @@
+/**
+ * pattern_database.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_PATTERN_DATABASE_H_
+#define SYMBOLIC_PLANNING_PATTERN_DATABASE_H_
+
+#include <cstdint>  // uint8_t, uint32_t
+#include <memory>   // std::shared_ptr
+#include <string>   // std::string
+#include <utility>  // std::pair
+#include <vector>   // std::vector
+
+#include "symbolic/planning/grounded_task.h"
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Canonical combination of projection pattern databases.
+ *
+ * A pattern is a set of atoms that actions add or delete. The PDB of a
+ * pattern stores the goal distance of every abstract state of the projection
+ * onto the pattern, computed by backward breadth-first search. Abstract states
+ * are ranked by the perfect hash that reads the pattern atoms as the bits of
+ * an integer, so each PDB is a dense table of 2^k one-byte distances.
+ *
+ * The heuristic value is the maximum over the maximal sets of additive
+ * patterns, in which no action affects two patterns, of the sum of their
+ * distances.
+ *
+ * Tables can be saved to a file and mapped back into memory read-only, so
+ * that several processes share one copy.
+ *
+ * S. Edelkamp. Planning with pattern databases. ECP 2001.
+ * P. Haslum, A. Botea, M. Helmert, B. Bonet, and S. Koenig. Domain-independent
+ * construction of pattern database heuristics for cost-optimal planning. AAAI
+ * 2007.
+ */
+class PatternDatabaseHeuristic {
+ public:
+  static constexpr uint8_t kInfinity = 255;
+  static constexpr size_t kMaxPatternSize = 24;
+
+  /**
+   * Builds the PDBs for the given patterns of StateIndex atoms. Atoms that no
+   * action affects are dropped from the patterns.
+   */
+  PatternDatabaseHeuristic(const Pddl& pddl,
+                           const std::vector<std::vector<size_t>>& patterns);
+
+  /**
+   * Builds the PDBs for patterns generated by GeneratePatterns().
+   */
+  PatternDatabaseHeuristic(const Pddl& pddl, size_t max_pattern_size);
+
+  PatternDatabaseHeuristic(const PatternDatabaseHeuristic&) = delete;
+  PatternDatabaseHeuristic& operator=(const PatternDatabaseHeuristic&) = delete;
+  PatternDatabaseHeuristic(PatternDatabaseHeuristic&&) = default;
+  PatternDatabaseHeuristic& operator=(PatternDatabaseHeuristic&&) = delete;
+
+  /**
+   * Maps the PDBs saved in the file read-only into memory.
+   */
+  static PatternDatabaseHeuristic Load(const Pddl& pddl,
+                                       const std::string& filename);
+
+  /**
+   * Saves the PDBs to a file that can be loaded with Load().
+   */
+  void Save(const std::string& filename) const;
+
+  /**
+   * Generates a singleton pattern for each goal atom, along with the goal atom
+   * extended backward along the preconditions of its achievers up to the given
+   * size.
+   */
+  static std::vector<std::vector<size_t>> GeneratePatterns(
+      const GroundedTask& task, size_t max_pattern_size);
+
+  const Pddl& pddl() const { return *pddl_; }
+
+  size_t num_patterns() const { return patterns_.size(); }
+
+  const std::vector<size_t>& pattern(size_t idx_pattern) const {
+    return patterns_[idx_pattern].atoms;
+  }
+
+  /**
+   * Maximal sets of additive patterns.
+   */
+  const std::vector<std::vector<size_t>>& additive_subsets() const {
+    return additive_subsets_;
+  }
+
+  /**
+   * Evaluates the heuristic in the state.
+   *
+   * @returns Goal distance estimate, or infinity if the state is a dead end.
+   */
+  double Evaluate(const State& state) const;
+
+  double operator()(const Planner::Node& node) const {
+    return Evaluate(node.state());
+  }
+
+ private:
+  struct Pattern {
+    std::vector<size_t> atoms;
+
+    // Goal distances indexed by the abstract state rank.
+    const uint8_t* distances;
+  };
+
+  explicit PatternDatabaseHeuristic(const Pddl& pddl) : pddl_(&pddl) {}
+
+  /**
+   * Indexes the bit of each pattern atom for ranking states.
+   */
+  void IndexAtoms();
+
+  const Pddl* pddl_;
+  std::vector<Pattern> patterns_;
+  std::vector<std::vector<size_t>> additive_subsets_;
+
+  // Pattern index and bit of each atom.
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> atom_bits_;
+
+  // Storage of the tables, either built in memory or mapped from a file.
+  std::vector<uint8_t> tables_;
+  std::shared_ptr<const void> mapping_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_PATTERN_DATABASE_H_
@@ -10,32 +10,59 @@
 #ifndef SYMBOLIC_PLANNING_PLANNER_H_
 #define SYMBOLIC_PLANNING_PLANNER_H_
 
+#include <atomic>      // std::atomic
+#include <cstdint>     // uint64_t
 #include <functional>  // std::hash
 #include <iostream>    // std::ostream
 #include <memory>      // std::shared_ptr
+#include <optional>    // std::optional
+#include <string>      // std::string
+#include <vector>      // std::vector
 
 #include "symbolic/pddl.h"
 
 namespace symbolic {
 
+class StubbornSets;
+
 class Planner {
  public:
   class Node {
     struct NodeImpl;
+    struct RootImpl;
 
    public:
     class iterator;
     class reverse_iterator;
 
     Node() = default;
-    Node(const Pddl& pddl, const State& state, size_t depth = 0);
-    Node(const Node& parent, const Node& sibling, State&& state,
-         std::string&& action);
-
-    const std::string& action() const;
+    /**
+     * Root node. Successors are pruned with the stubborn sets if given, and
+     * nodes have no children once the stop flag is set.
+     */
+    Node(const Pddl& pddl, const State& state, size_t depth = 0,
+         const StubbornSets* stubborn_sets = nullptr,
+         const std::atomic<bool>* stop = nullptr);
+    Node(const Node& parent, State&& state, size_t idx_action,
+         size_t idx_arguments);
+
+    /**
+     * Action call that generated this node, rendered on request.
+     */
+    std::string action() const;
     const State& state() const;
     size_t depth() const;
 
+    /**
+     * Node that generated this node, or empty for the root.
+     */
+    std::optional<Node> parent() const;
+
+    /**
+     * Hash of the state, computed once when the node is created.
+     */
+    size_t hash() const;
+
     // Iterate over children
     iterator begin() const;
     iterator end() const;
@@ -77,7 +104,24 @@ class Planner {
    * @seepython{symbolic.Planner,__init__}
    */
   Planner(const Pddl& pddl, const State& state)
-      : root_(pddl, pddl.ConsistentState(state)) {}
+      : Planner(pddl, state, nullptr) {}
+
+  /**
+   * Planner class that prunes the successors of each node with strong
+   * stubborn sets.
+   *
+   * @param pddl Pddl instance.
+   * @param state State from which to search.
+   * @param stubborn_sets Stubborn sets that must outlive the planner, or
+   *                      nullptr to disable pruning.
+   * @param stop Flag that cancels searches cooperatively by leaving nodes
+   *             without children once set, or nullptr.
+   */
+  Planner(const Pddl& pddl, const State& state,
+          const StubbornSets* stubborn_sets,
+          const std::atomic<bool>* stop = nullptr)
+      : root_(pddl, pddl.DerivedState(pddl.ConsistentState(state)), 0,
+              stubborn_sets, stop) {}
 
   const Node& root() const { return root_; }
 
@@ -102,13 +146,41 @@ class Planner::Node::iterator {
   reference operator*() const { return child_; }
 
  private:
+  /**
+   * Finds the next (or previous, if reversed) valid arguments of the current
+   * action in the parent state, starting from idx_arguments_.
+   *
+   * @returns Whether valid arguments were found.
+   */
+  bool FindArguments(bool is_reverse);
+
+  /**
+   * Sets the child from the current action and arguments.
+   *
+   * @returns Whether the child state hasn't been previously visited.
+   */
+  bool UpdateChild();
+
+  /**
+   * End iterator, which skips listing the arguments.
+   */
+  iterator(const Node& parent, std::vector<Action>::const_iterator it_action);
+
   const Pddl& pddl_;
 
   const Node& parent_;
   Node child_;
 
   std::vector<Action>::const_iterator it_action_;
-  ParameterGenerator::const_iterator it_param_;
+
+  // Stubborn set of the parent state, if pruning is enabled.
+  const StubbornSets* stubborn_sets_;
+  std::vector<uint64_t> stubborn_;
+
+  // Current arguments, found lazily by the parameter binder, along with their
+  // index in the action's parameter generator.
+  std::vector<Object> arguments_;
+  size_t idx_arguments_ = 0;
 
   friend class Node;
 };
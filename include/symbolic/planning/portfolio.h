@@ -0,0 +1,114 @@
+/**
+ * portfolio.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_PORTFOLIO_H_
+#define SYMBOLIC_PLANNING_PORTFOLIO_H_
+
+#include <chrono>      // std::chrono
+#include <functional>  // std::function
+#include <limits>      // std::numeric_limits
+#include <optional>    // std::optional
+#include <string>      // std::string
+#include <utility>     // std::pair
+#include <vector>      // std::vector
+
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Portfolio of search engines run concurrently on the same Pddl.
+ *
+ * Every engine runs in its own thread from the root of its own planner. All
+ * planners share one stop flag, which leaves every node without children once
+ * set, so the engines drain their open lists and return cooperatively.
+ *
+ * Without a deadline, the first plan found stops the other engines. With a
+ * deadline, the engines run until they all return or the deadline passes, and
+ * the shortest plan is returned. The engines are also stopped once the
+ * resident memory of the process exceeds the memory budget.
+ */
+class Portfolio {
+ public:
+  using Plan = std::vector<std::string>;
+
+  /**
+   * Search engine that returns a plan from the root within the maximum depth,
+   * or an empty optional.
+   */
+  using Engine =
+      std::function<std::optional<Plan>(const Planner::Node& root,
+                                        size_t max_depth)>;
+
+  /**
+   * @param pddl Pddl instance.
+   * @param memory_budget Maximum resident memory of the process in bytes, or 0
+   *                      for no limit.
+   */
+  explicit Portfolio(const Pddl& pddl, size_t memory_budget = 0)
+      : pddl_(pddl), memory_budget_(memory_budget) {}
+
+  /**
+   * Names of the built-in engines: breadth-first search, depth-first search,
+   * IW(2), and BFWS(2) with the blind heuristic.
+   */
+  static const std::vector<std::string>& BuiltinEngines();
+
+  /**
+   * Adds a built-in engine.
+   */
+  void Add(const std::string& name);
+
+  /**
+   * Adds a custom engine, which must only expand nodes through the given root
+   * to be stopped.
+   */
+  void Add(const std::string& name, Engine engine);
+
+  /**
+   * Runs all the engines.
+   *
+   * @param max_depth Maximum plan length.
+   * @param deadline Time until the engines are stopped, or 0 to return the
+   *                 first plan.
+   * @param verbose Print the result of every engine.
+   * @returns Sequence of action calls, or an empty optional if no engine found
+   *          a plan.
+   */
+  std::optional<Plan> Search(
+      size_t max_depth = std::numeric_limits<size_t>::max(),
+      std::chrono::milliseconds deadline = std::chrono::milliseconds(0),
+      bool verbose = false);
+
+  size_t num_engines() const { return engines_.size(); }
+
+  /**
+   * Name of the engine that found the plan of the last search, or empty if no
+   * plan was found.
+   */
+  const std::string& winner() const { return winner_; }
+
+  /**
+   * Whether the last search was stopped by the memory budget.
+   */
+  bool is_out_of_memory() const { return is_out_of_memory_; }
+
+ private:
+  const Pddl& pddl_;
+  const size_t memory_budget_;
+
+  std::vector<std::pair<std::string, Engine>> engines_;
+
+  std::string winner_;
+  bool is_out_of_memory_ = false;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_PORTFOLIO_H_
@@ -0,0 +1,128 @@
+/**
+ * stubborn_sets.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_STUBBORN_SETS_H_
+#define SYMBOLIC_PLANNING_STUBBORN_SETS_H_
+
+#include <atomic>   // std::atomic
+#include <cstdint>  // uint64_t
+#include <vector>   // std::vector
+
+#include "symbolic/planning/grounded_task.h"
+#include "symbolic/planning/planner.h"
+
+namespace symbolic {
+
+/**
+ * Strong stubborn set pruning of the successors of Planner::Node.
+ *
+ * In every non-goal state, a strong stubborn set contains the achievers of an
+ * unsatisfied goal atom, an achiever set of an unsatisfied precondition of
+ * every inapplicable operator in the set, and every operator that interferes
+ * with an applicable operator in the set. Expanding only the applicable
+ * operators of the set preserves the optimal plans, and prunes the
+ * interleavings of commuting operators.
+ *
+ * Two operators interfere if one disables the other or their effects
+ * conflict. Preconditions on derived atoms are treated as reading every atom
+ * their rules depend on, so any operator that changes one of those atoms
+ * disables and achieves the derived precondition. The interference relation
+ * is precomputed as a bit matrix over the grounded operators, so computing a
+ * stubborn set only ORs matrix rows into the set.
+ *
+ * To enable the pruning, pass the stubborn sets to the Planner, which must not
+ * outlive them. The task must not have conditional effects.
+ *
+ * M. Wehrle and M. Helmert. Efficient stubborn sets: Generalized algorithms
+ * and selection strategies. ICAPS 2014.
+ */
+class StubbornSets {
+ public:
+  using Bitset = std::vector<uint64_t>;
+
+  explicit StubbornSets(const Pddl& pddl);
+
+  const GroundedTask& task() const { return task_; }
+
+  /**
+   * Computes a strong stubborn set of operators in the state. In goal states,
+   * the set contains all operators.
+   *
+   * @param state Current state.
+   * @param stubborn Output bitset over the grounded operators.
+   */
+  void Compute(const State& state, Bitset* stubborn) const;
+
+  /**
+   * Whether an operator of the action call is in the stubborn set.
+   */
+  bool Contains(const Bitset& stubborn, size_t idx_action,
+                size_t idx_arguments) const;
+
+  /**
+   * Whether the two grounded operators interfere.
+   */
+  bool Interferes(size_t idx_op, size_t idx_other) const;
+
+  /**
+   * Number of nodes expanded with pruning.
+   */
+  size_t num_expanded() const {
+    return num_expanded_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Number of applicable action calls that were kept and pruned.
+   */
+  size_t num_generated() const {
+    return num_generated_.load(std::memory_order_relaxed);
+  }
+  size_t num_pruned() const {
+    return num_pruned_.load(std::memory_order_relaxed);
+  }
+
+  void ResetStatistics() {
+    num_expanded_.store(0, std::memory_order_relaxed);
+    num_generated_.store(0, std::memory_order_relaxed);
+    num_pruned_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  /**
+   * Returns the unsatisfied fact with the fewest achievers, or nullptr if all
+   * facts are satisfied.
+   */
+  const std::vector<size_t>* FindAchievers(const std::vector<size_t>& pos,
+                                           const std::vector<size_t>& neg,
+                                           const Bitset& is_true) const;
+
+  GroundedTask task_;
+  size_t num_words_ = 0;
+
+  // Operators that make each atom true and false.
+  std::vector<std::vector<size_t>> achievers_pos_;
+  std::vector<std::vector<size_t>> achievers_neg_;
+
+  // Interference bit matrix with one row per operator.
+  std::vector<uint64_t> interference_;
+
+  // Index of the first operator of each action call, by action.
+  std::vector<std::vector<size_t>> idx_operators_;
+
+  // Statistics updated by planners expanding nodes from multiple threads.
+  mutable std::atomic<size_t> num_expanded_{0};
+  mutable std::atomic<size_t> num_generated_{0};
+  mutable std::atomic<size_t> num_pruned_{0};
+
+  friend class Planner::Node::iterator;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_STUBBORN_SETS_H_
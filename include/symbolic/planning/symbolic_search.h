@@ -0,0 +1,134 @@
+/**
+ * symbolic_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_SYMBOLIC_SEARCH_H_
+#define SYMBOLIC_PLANNING_SYMBOLIC_SEARCH_H_
+
+#include <limits>         // std::numeric_limits
+#include <optional>       // std::optional
+#include <string>         // std::string
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+#include "symbolic/bdd.h"
+#include "symbolic/pddl.h"
+
+namespace VAL {
+
+class effect_lists;
+
+}  // namespace VAL
+
+namespace symbolic {
+
+/**
+ * Breadth-first search over sets of states represented as BDDs.
+ *
+ * Every ground action is compiled into a transition relation over current and
+ * next state variables. Each BFS layer is the image of the previous layer
+ * minus the states reached so far, so whole layers are expanded at once. A
+ * plan is extracted by backtracking from a goal state through the stored
+ * layers.
+ *
+ * Effects are applied in the same order as Action::Apply(), with effect
+ * conditions evaluated on the partially updated state. Derived predicates are
+ * expressed as functions of the basic propositions. Axioms are not supported.
+ */
+class SymbolicSearch {
+ public:
+  using Node = BddManager::Node;
+
+  explicit SymbolicSearch(const Pddl& pddl);
+
+  /**
+   * Searches for a shortest plan from the initial state.
+   *
+   * @param max_depth Maximum plan length.
+   * @param verbose Print the size of every layer.
+   * @returns Sequence of action calls, or an empty optional if no plan exists
+   *          within the maximum depth.
+   */
+  std::optional<std::vector<std::string>> Search(
+      size_t max_depth = std::numeric_limits<size_t>::max(),
+      bool verbose = false);
+
+  /**
+   * BFS layers of the last search. Layer i contains the states first reached
+   * after i actions.
+   */
+  const std::vector<Node>& layers() const { return layers_; }
+
+  /**
+   * Number of states in the given set, counted over the basic propositions.
+   */
+  double CountStates(Node states) const;
+
+  BddManager& bdd() { return bdd_; }
+
+ private:
+  struct GroundAction {
+    size_t idx_action;
+    std::vector<Object> arguments;
+    Node transition;
+  };
+
+  /**
+   * Creates the formula over the current state, with derived predicates
+   * substituted by their definitions.
+   */
+  Node CreateFormula(const Formula& formula,
+                     const std::vector<Object>& parameters,
+                     const std::vector<Object>& arguments);
+
+  /**
+   * Creates the set containing the state restricted to basic propositions.
+   */
+  Node CreateState(const State& state, size_t copy);
+
+  void CreateDerivedPredicates();
+
+  void CreateTransition(size_t idx_action, const std::vector<Object>& arguments);
+
+  /**
+   * Applies the effects to the next values of the propositions, where the
+   * guard is the condition under which the effects are applied.
+   */
+  void ApplyEffects(const VAL::effect_lists* effects,
+                    const std::vector<Object>& parameters,
+                    const std::vector<Object>& arguments, Node guard,
+                    std::vector<Node>* values);
+
+  /**
+   * Image of the states under all actions.
+   */
+  Node Image(Node states);
+
+  std::vector<std::string> ExtractPlan(Node goal_states);
+
+  const Pddl& pddl_;
+  BddManager bdd_;
+
+  // Whether each proposition is derived, and the definitions of the derived
+  // propositions as variable substitutions over the current state.
+  std::vector<bool> is_derived_;
+  std::unordered_map<BddManager::Variable, Node> derived_;
+
+  std::vector<GroundAction> actions_;
+  Node goal_;
+
+  Node cube_current_;
+  Node cube_next_;
+  std::vector<BddManager::Variable> next_to_current_;
+
+  std::vector<Node> layers_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_SYMBOLIC_SEARCH_H_
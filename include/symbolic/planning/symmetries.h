@@ -0,0 +1,128 @@
+/**
+ * symmetries.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_SYMMETRIES_H_
+#define SYMBOLIC_PLANNING_SYMMETRIES_H_
+
+#include <vector>  // std::vector
+
+#include "symbolic/pddl.h"
+#include "symbolic/state.h"
+
+namespace symbolic {
+
+/**
+ * Undirected graph with colored vertices.
+ */
+class ColoredGraph {
+ public:
+  using Permutation = std::vector<size_t>;
+
+  /**
+   * Adds a vertex with the given color and returns its index.
+   */
+  size_t AddVertex(size_t color);
+
+  void AddEdge(size_t u, size_t v);
+
+  size_t num_vertices() const { return colors_.size(); }
+
+  size_t color(size_t v) const { return colors_[v]; }
+
+  /**
+   * Whether the permutation preserves the vertex colors and the edges.
+   */
+  bool IsAutomorphism(const Permutation& perm) const;
+
+  /**
+   * Finds generators of a subgroup of the color-preserving automorphisms.
+   *
+   * The search individualizes the first vertex of the first non-singleton cell
+   * of the equitable partition until the partition is discrete. At each level
+   * of this path, from the deepest up, every other vertex of the cell that is
+   * not yet in the orbit of the chosen vertex is individualized instead,
+   * followed by the leftmost path to a discrete partition. Matching the two
+   * leaves yields a candidate permutation, which is kept if it is an
+   * automorphism. Unlike a full search, subtrees are not backtracked, so the
+   * generated group may be a proper subgroup, but every generator is a true
+   * automorphism.
+   */
+  std::vector<Permutation> FindAutomorphisms() const;
+
+ private:
+  std::vector<size_t> colors_;
+
+  // Sorted neighbors of each vertex.
+  std::vector<std::vector<size_t>> neighbors_;
+};
+
+/**
+ * Object symmetries of the problem description.
+ *
+ * The problem is encoded as a colored graph with one vertex per object, init
+ * atom and goal literal, where atoms are connected to their arguments through
+ * vertices colored by argument position. Objects are colored by type, and
+ * constants of the domain get unique colors, so automorphisms of the graph
+ * permute interchangeable objects while preserving the initial state, the goal
+ * and the actions. Permuting the objects of a reachable state therefore yields
+ * a state with equivalent plans.
+ *
+ * States are canonicalized by greedily applying the generators while the
+ * sorted StateIndex atoms of the state decrease lexicographically. Symmetric
+ * states do not always reach the same canonical state, but duplicate detection
+ * over canonical states never merges states that are not symmetric.
+ *
+ * N. Pochter, A. Zohar, and J. S. Rosenschein. Exploiting problem symmetries
+ * in state-based planners. AAAI 2011.
+ */
+class ObjectSymmetries {
+ public:
+  using Permutation = ColoredGraph::Permutation;
+
+  explicit ObjectSymmetries(const Pddl& pddl);
+
+  const Pddl& pddl() const { return pddl_; }
+
+  /**
+   * Generators as permutations of the indices of Pddl::objects().
+   */
+  const std::vector<Permutation>& generators() const { return generators_; }
+
+  /**
+   * Generators as permutations of the StateIndex atoms.
+   */
+  const std::vector<Permutation>& atom_generators() const {
+    return atom_generators_;
+  }
+
+  /**
+   * Orbit of each object, identified by the smallest object index in it.
+   */
+  const std::vector<size_t>& orbits() const { return orbits_; }
+
+  /**
+   * Canonicalizes the sorted StateIndex atoms in place.
+   */
+  void Canonicalize(std::vector<size_t>* atoms) const;
+
+  /**
+   * Returns the canonical state symmetric to the given state.
+   */
+  State Canonicalize(const State& state) const;
+
+ private:
+  const Pddl& pddl_;
+  std::vector<Permutation> generators_;
+  std::vector<Permutation> atom_generators_;
+  std::vector<size_t> orbits_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_SYMMETRIES_H_
@@ -0,0 +1,367 @@
+/**
+ * width_search.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_PLANNING_WIDTH_SEARCH_H_
+#define SYMBOLIC_PLANNING_WIDTH_SEARCH_H_
+
+#include <cmath>          // std::round
+#include <cstddef>        // ptrdiff_t
+#include <functional>     // std::function, std::greater
+#include <iostream>       // std::cout
+#include <iterator>       // std::input_iterator_tag
+#include <queue>          // std::priority_queue, std::queue
+#include <tuple>          // std::tie
+#include <unordered_map>  // std::unordered_map
+#include <unordered_set>  // std::unordered_set
+#include <vector>         // std::vector
+
+#include "symbolic/planning/novelty_table.h"
+#include "symbolic/planning/symmetries.h"
+#include "symbolic/state.h"
+
+namespace symbolic {
+
+/**
+ * Breadth-first search that prunes every generated node that is not novel.
+ *
+ * A node is novel if its state makes some tuple of at most width atoms true
+ * for the first time in the search. Atoms are StateIndex proposition indices,
+ * so NodeT must provide state(). IW(1) and IW(2) expand at most n and n^2
+ * nodes for n atoms, and solve problems whose goals have width at most 1 and
+ * 2, respectively.
+ *
+ * N. Lipovetzky and H. Geffner. Width and serialization of classical planning
+ * problems. ECAI 2012.
+ */
+template <typename NodeT>
+class IteratedWidthSearch {
+ public:
+  class iterator;
+
+  IteratedWidthSearch(const NodeT& root, const StateIndex& state_index,
+                      size_t width, size_t max_depth, bool verbose = false)
+      : root_(root),
+        state_index_(state_index),
+        width_(width),
+        max_depth_(max_depth),
+        verbose_(verbose) {}
+
+  iterator begin() const {
+    iterator it(this);
+    return ++it;
+  }
+  iterator end() const { return iterator(); }
+
+ private:
+  const NodeT& root_;
+  const StateIndex& state_index_;
+  const size_t width_;
+  const size_t max_depth_;
+  const bool verbose_;
+};
+
+/**
+ * Best-first width search BFWS(w, f).
+ *
+ * Nodes are expanded in order of their novelty, breaking ties by the score
+ * function f, where lower scores are better. The novelty of a node is
+ * measured only against the nodes with the same score, with up to width 2.
+ * Each partition holds an n^2 / 2 bit novelty table over n atoms, so scores
+ * are rounded to the nearest integer, and the scores after the first
+ * kMaxPartitions share the last partition.
+ * Nodes that are not novel are kept behind the novel ones, and duplicate
+ * states are skipped, so the search is complete within max_depth.
+ *
+ * If object symmetries are given, states are canonicalized before duplicate
+ * detection, so states that only differ by a permutation of interchangeable
+ * objects are generated once.
+ *
+ * N. Lipovetzky and H. Geffner. Best-first width search: Exploration and
+ * exploitation in classical planning. AAAI 2017.
+ */
+template <typename NodeT>
+class BestFirstWidthSearch {
+ public:
+  using ScoreFunction = std::function<double(const NodeT&)>;
+
+  class iterator;
+
+  BestFirstWidthSearch(const NodeT& root, const StateIndex& state_index,
+                       const ScoreFunction& score, size_t max_depth,
+                       bool verbose = false,
+                       const ObjectSymmetries* symmetries = nullptr)
+      : root_(root),
+        state_index_(state_index),
+        score_(score),
+        max_depth_(max_depth),
+        verbose_(verbose),
+        symmetries_(symmetries) {}
+
+  iterator begin() const {
+    iterator it(this);
+    return ++it;
+  }
+  iterator end() const { return iterator(); }
+
+ private:
+  static constexpr size_t kWidth = 2;
+  static constexpr size_t kMaxPartitions = 16;
+
+  const NodeT& root_;
+  const StateIndex& state_index_;
+  const ScoreFunction score_;
+  const size_t max_depth_;
+  const bool verbose_;
+  const ObjectSymmetries* symmetries_;
+};
+
+namespace width_search {
+
+/**
+ * Generated node with the index of its parent in the search tree.
+ */
+template <typename NodeT>
+struct Entry {
+  NodeT node;
+  size_t idx_parent;
+  size_t depth;
+};
+
+/**
+ * Reconstructs the plan to the given entry.
+ */
+template <typename NodeT>
+void ExtractPlan(const std::vector<Entry<NodeT>>& entries, size_t idx_entry,
+                 std::vector<NodeT>* plan) {
+  plan->resize(entries[idx_entry].depth + 1);
+  for (size_t i = plan->size(); i-- > 0;) {
+    const Entry<NodeT>& entry = entries[idx_entry];
+    (*plan)[i] = entry.node;
+    idx_entry = entry.idx_parent;
+  }
+}
+
+}  // namespace width_search
+
+template <typename NodeT>
+class IteratedWidthSearch<NodeT>::iterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::vector<NodeT>;
+  using difference_type = ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  iterator() = default;
+  explicit iterator(const IteratedWidthSearch<NodeT>* iw)
+      : iw_(iw), novelty_(iw->state_index_.size(), iw->width_) {
+    iw_->state_index_.GetPropositionIndices(iw_->root_.state(), &atoms_);
+    novelty_.Insert(atoms_);
+    entries_.push_back({iw_->root_, 0, 0});
+    queue_.push(0);
+  }
+
+  iterator& operator++();
+
+  bool operator==(const iterator& other) const {
+    return IsFinished() && other.IsFinished();
+  }
+
+  bool operator!=(const iterator& other) const { return !(*this == other); }
+
+  reference operator*() const { return plan_; }
+
+ private:
+  using Entry = width_search::Entry<NodeT>;
+
+  bool IsFinished() const { return queue_.empty() && plan_.empty(); }
+
+  const IteratedWidthSearch<NodeT>* iw_ = nullptr;
+
+  NoveltyTable novelty_;
+  std::vector<Entry> entries_;
+  std::queue<size_t> queue_;
+
+  // Buffer for the atoms of the current child.
+  std::vector<size_t> atoms_;
+
+  std::vector<NodeT> plan_;
+};
+
+template <typename NodeT>
+typename IteratedWidthSearch<NodeT>::iterator&
+IteratedWidthSearch<NodeT>::iterator::operator++() {
+  while (!queue_.empty()) {
+    const size_t idx_entry = queue_.front();
+    queue_.pop();
+
+    // Return if node evaluates to true
+    if (entries_[idx_entry].node) {
+      width_search::ExtractPlan(entries_, idx_entry, &plan_);
+      if (iw_->verbose_) {
+        std::cout << "Goal state reached: " << plan_.back() << std::endl;
+      }
+      return *this;
+    }
+
+    // Skip children if max depth has been reached
+    const size_t depth = entries_[idx_entry].depth;
+    if (depth >= iw_->max_depth_) continue;
+
+    // Prune children that are not novel. Copy the node since pushing children
+    // may reallocate the entries.
+    const NodeT node = entries_[idx_entry].node;
+    for (const NodeT& child : node) {
+      iw_->state_index_.GetPropositionIndices(child.state(), &atoms_);
+      if (novelty_.Insert(atoms_) > iw_->width_) continue;
+
+      queue_.push(entries_.size());
+      entries_.push_back({child, idx_entry, depth + 1});
+    }
+
+    if (iw_->verbose_) {
+      std::cout << "IW(" << iw_->width_ << ") expanded: " << entries_.size()
+                << " generated" << std::endl;
+    }
+  }
+  plan_.clear();
+  return *this;
+}
+
+template <typename NodeT>
+class BestFirstWidthSearch<NodeT>::iterator {
+ public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::vector<NodeT>;
+  using difference_type = ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+
+  iterator() = default;
+  explicit iterator(const BestFirstWidthSearch<NodeT>* bfws) : bfws_(bfws) {
+    Push(bfws_->root_, 0, 0);
+  }
+
+  iterator& operator++();
+
+  bool operator==(const iterator& other) const {
+    return IsFinished() && other.IsFinished();
+  }
+
+  bool operator!=(const iterator& other) const { return !(*this == other); }
+
+  reference operator*() const { return plan_; }
+
+ private:
+  using Entry = width_search::Entry<NodeT>;
+
+  struct QueueItem {
+    size_t novelty;
+    double score;
+    size_t idx_entry;
+
+    bool operator>(const QueueItem& rhs) const {
+      return std::tie(novelty, score, idx_entry) >
+             std::tie(rhs.novelty, rhs.score, rhs.idx_entry);
+    }
+  };
+
+  bool IsFinished() const { return queue_.empty() && plan_.empty(); }
+
+  /**
+   * Adds the node to the open list unless its state, or a symmetric state, was
+   * already generated.
+   */
+  void Push(const NodeT& node, size_t idx_parent, size_t depth);
+
+  const BestFirstWidthSearch<NodeT>* bfws_ = nullptr;
+
+  // Novelty tables partitioned by rounded score.
+  std::vector<NoveltyTable> novelty_;
+  std::unordered_map<double, size_t> idx_partitions_;
+
+  std::unordered_set<NodeT> generated_;
+
+  // Canonical states generated with symmetry reduction.
+  std::unordered_set<State> canonical_;
+  std::vector<Entry> entries_;
+  std::priority_queue<QueueItem, std::vector<QueueItem>,
+                      std::greater<QueueItem>>
+      queue_;
+
+  // Buffer for the atoms of the current child.
+  std::vector<size_t> atoms_;
+
+  std::vector<NodeT> plan_;
+};
+
+template <typename NodeT>
+void BestFirstWidthSearch<NodeT>::iterator::Push(const NodeT& node,
+                                                 size_t idx_parent,
+                                                 size_t depth) {
+  if (bfws_->symmetries_ != nullptr) {
+    const State canonical = bfws_->symmetries_->Canonicalize(node.state());
+    if (!canonical_.insert(canonical).second) return;
+  } else if (!generated_.insert(node).second) {
+    return;
+  }
+
+  const double score = bfws_->score_(node);
+  auto it = idx_partitions_.find(std::round(score));
+  if (it == idx_partitions_.end()) {
+    if (novelty_.size() < kMaxPartitions) {
+      novelty_.emplace_back(bfws_->state_index_.size(), kWidth);
+    }
+    it = idx_partitions_.emplace(std::round(score), novelty_.size() - 1).first;
+  }
+  bfws_->state_index_.GetPropositionIndices(node.state(), &atoms_);
+  const size_t novelty = novelty_[it->second].Insert(atoms_);
+
+  queue_.push({novelty, score, entries_.size()});
+  entries_.push_back({node, idx_parent, depth});
+}
+
+template <typename NodeT>
+typename BestFirstWidthSearch<NodeT>::iterator&
+BestFirstWidthSearch<NodeT>::iterator::operator++() {
+  while (!queue_.empty()) {
+    const QueueItem top = queue_.top();
+    queue_.pop();
+
+    // Return if node evaluates to true
+    if (entries_[top.idx_entry].node) {
+      width_search::ExtractPlan(entries_, top.idx_entry, &plan_);
+      if (bfws_->verbose_) {
+        std::cout << "Goal state reached: " << plan_.back() << std::endl;
+      }
+      return *this;
+    }
+
+    // Skip children if max depth has been reached
+    const size_t depth = entries_[top.idx_entry].depth;
+    if (depth >= bfws_->max_depth_) continue;
+
+    if (bfws_->verbose_) {
+      std::cout << "BFWS expanding: novelty " << top.novelty << ", score "
+                << top.score << ", depth " << depth << std::endl;
+    }
+
+    // Copy the node since pushing children may reallocate the entries.
+    const NodeT node = entries_[top.idx_entry].node;
+    for (const NodeT& child : node) {
+      Push(child, top.idx_entry, depth + 1);
+    }
+  }
+  plan_.clear();
+  return *this;
+}
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_PLANNING_WIDTH_SEARCH_H_
@@ -123,6 +123,53 @@ bool State::insert(InputIt first, InputIt last) {
   return is_changed;
 }
 
+/**
+ * State wrapper that records the net propositions added and deleted through
+ * it, so that the changes of an action can be used without diffing states.
+ */
+class StateRecorder {
+ public:
+  explicit StateRecorder(State* state) : state_(state) {}
+
+  bool contains(const PropositionBase& prop) const {
+    return state_->contains(prop);
+  }
+
+  bool insert(const PropositionBase& prop) {
+    if (!state_->insert(prop)) return false;
+    Record(prop, added_, deleted_);
+    return true;
+  }
+
+  bool erase(const PropositionBase& prop) {
+    if (!state_->erase(prop)) return false;
+    Record(prop, deleted_, added_);
+    return true;
+  }
+
+  operator const State&() const { return *state_; }
+
+  /**
+   * Propositions that were not in the state before recording.
+   */
+  const State& added() const { return added_; }
+
+  /**
+   * Propositions that were in the state before recording.
+   */
+  const State& deleted() const { return deleted_; }
+
+ private:
+  static void Record(const PropositionBase& prop, State& same,
+                     State& opposite) {
+    if (!opposite.erase(prop)) same.insert(prop);
+  }
+
+  State* state_;
+  State added_;
+  State deleted_;
+};
+
 class PartialState {
  public:
   class UnknownEvaluation : public std::exception {
@@ -247,6 +294,19 @@ class StateIndex {
    */
   size_t GetPropositionIndex(const Proposition& prop) const;
 
+  /**
+   * Get the index of a predicate.
+   *
+   * @param name_predicate Predicate name.
+   * @return Predicate index, or -1 if the predicate does not exist.
+   */
+  int GetPredicateIndex(const std::string& name_predicate) const;
+
+  /**
+   * Number of indexed predicates.
+   */
+  size_t num_predicates() const;
+
   /**
    * Convert the indexed state to a full state.
    *
@@ -263,6 +323,18 @@ class StateIndex {
    */
   IndexedState GetIndexedState(const State& state) const;
 
+  /**
+   * Get the sorted indices of the propositions in the state.
+   *
+   * Unlike GetPropositionIndex(), this bypasses the string-keyed cache, which
+   * makes it suitable for converting many distinct states during search.
+   *
+   * @param state State.
+   * @param idx_propositions Output buffer of proposition indices.
+   */
+  void GetPropositionIndices(const State& state,
+                             std::vector<size_t>* idx_propositions) const;
+
   /**
    * Size of indexed state (total number of propositions).
    */
@@ -17,7 +17,8 @@
 #include <iterator>     // std::random_access_iterator_tag, std::iterator_traits
 #include <sstream>      // std::stringstream
 #include <string>       // std::to_string
-#include <type_traits>  // std::conditional_t, std::is_const
+#include <type_traits>  // std::conditional_t, std::is_const, std::remove_const_t
+#include <utility>      // std::forward
 #include <vector>       // std::vector
 
 namespace symbolic {
@@ -132,6 +133,81 @@ class CombinationGenerator {
     return *(begin() + i);
   }
 
+  /**
+   * Number of options, i.e. the length of each combination.
+   */
+  size_t num_slots() const { return options_.size(); }
+
+  /**
+   * Number of elements of the option in the given slot.
+   */
+  size_t option_size(size_t slot) const { return options_[slot]->size(); }
+
+  /**
+   * Number of combinations spanned by each position of the option in the given
+   * slot, i.e. the stride of the slot in the combination index.
+   */
+  size_t group_size(size_t slot) const { return size_groups_[slot]; }
+
+  /**
+   * Element at the given position of the option in the given slot.
+   */
+  const typename iterator::ValueT& option(size_t slot, size_t pos) const {
+    return (*options_[slot])[pos];
+  }
+
+  /**
+   * Iterates over the combinations as tuples of positions into the options,
+   * incrementing positions from right to left without materializing the
+   * elements. The callback takes the positions and returns false to stop the
+   * iteration early.
+   *
+   * @returns Whether the iteration ran to completion.
+   */
+  template <typename F>
+  bool ForEachIndex(F&& f) const {
+    std::vector<size_t> indices(options_.size());
+    return Iterate(&indices, [](size_t, size_t) {}, std::forward<F>(f));
+  }
+
+  /**
+   * Iterates over the combinations by writing them directly into the slots
+   * [offset, offset + num_options) of the given buffer. Only slots whose
+   * position changes are rewritten, so no combination is copied. The callback
+   * takes the buffer and returns false to stop the iteration early.
+   *
+   * @returns Whether the iteration ran to completion.
+   */
+  template <typename F>
+  bool ForEachInPlace(
+      std::vector<std::remove_const_t<typename iterator::ValueT>>* buffer,
+      size_t offset, F&& f) const {
+    assert(buffer->size() >= offset + options_.size());
+    std::vector<size_t> indices(options_.size());
+    return Iterate(
+        &indices,
+        [this, buffer, offset](size_t slot, size_t pos) {
+          (*buffer)[offset + slot] = option(slot, pos);
+        },
+        [buffer, &f](const std::vector<size_t>&) { return f(*buffer); });
+  }
+
+  /**
+   * Writes the combination at the given index into the slots
+   * [offset, offset + num_options) of the given buffer. Unlike operator[], the
+   * index is not limited to the range of int.
+   */
+  void GetInPlace(
+      size_t idx,
+      std::vector<std::remove_const_t<typename iterator::ValueT>>* buffer,
+      size_t offset) const {
+    assert(idx < size_ && buffer->size() >= offset + options_.size());
+    for (size_t i = 0; i < options_.size(); i++) {
+      (*buffer)[offset + i] = option(i, idx / size_groups_[i]);
+      idx %= size_groups_[i];
+    }
+  }
+
   /**
    * Get index of given combination.
    */
@@ -198,6 +274,37 @@ class CombinationGenerator {
     return options.front()->size() * size_groups.front();
   }
 
+  /**
+   * Increments the positions like an odometer, calling set_slot(slot, pos)
+   * for every position that changes and f(indices) for every combination.
+   */
+  template <typename IndicesT, typename SetSlotT, typename F>
+  bool Iterate(IndicesT* indices, SetSlotT&& set_slot, F&& f) const {
+    if (empty()) return true;
+
+    const size_t num_options = options_.size();
+    for (size_t i = 0; i < num_options; i++) {
+      (*indices)[i] = 0;
+      set_slot(i, 0);
+    }
+
+    while (f(static_cast<const IndicesT&>(*indices))) {
+      // Increment the rightmost slot and carry over to the left
+      size_t i = num_options;
+      while (i > 0) {
+        i--;
+        if (++(*indices)[i] < options_[i]->size()) {
+          set_slot(i, (*indices)[i]);
+          break;
+        }
+        (*indices)[i] = 0;
+        set_slot(i, 0);
+        if (i == 0) return true;
+      }
+    }
+    return false;
+  }
+
   std::vector<ContainerT*> options_;
   std::vector<size_t> size_groups_;
   size_t size_ = 0;
@@ -0,0 +1,82 @@
+/**
+ * lru_cache.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_UTILS_LRU_CACHE_H_
+#define SYMBOLIC_UTILS_LRU_CACHE_H_
+
+#include <list>           // std::list
+#include <unordered_map>  // std::unordered_map
+#include <utility>        // std::move, std::pair
+
+namespace symbolic {
+
+/**
+ * Fixed-capacity cache that evicts the least recently used entry.
+ */
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  /**
+   * Creates a cache with the given capacity. A capacity of 0 is unbounded.
+   */
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * Finds the value for the given key and marks it as most recently used.
+   *
+   * @returns Pointer to the value, or nullptr if the key is not cached. The
+   *          pointer is invalidated once the entry is evicted.
+   */
+  const Value* find(const Key& key) {
+    const auto it = idx_entries_.find(key);
+    if (it == idx_entries_.end()) return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  /**
+   * Inserts or replaces the value for the given key, evicting the least
+   * recently used entry if the cache is full.
+   */
+  const Value& insert(const Key& key, Value&& value) {
+    const auto it = idx_entries_.find(key);
+    if (it != idx_entries_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+
+    if (capacity_ > 0 && entries_.size() >= capacity_) {
+      idx_entries_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    idx_entries_.emplace(key, entries_.begin());
+    return entries_.front().second;
+  }
+
+  void clear() {
+    idx_entries_.clear();
+    entries_.clear();
+  }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  size_t capacity_;
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator> idx_entries_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_UTILS_LRU_CACHE_H_
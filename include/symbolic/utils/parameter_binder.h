@@ -0,0 +1,243 @@
+/**
+ * parameter_binder.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_UTILS_PARAMETER_BINDER_H_
+#define SYMBOLIC_UTILS_PARAMETER_BINDER_H_
+
+#include <type_traits>  // std::is_invocable_v
+#include <vector>       // std::vector
+
+#include "symbolic/formula.h"
+#include "symbolic/object.h"
+#include "symbolic/state.h"
+#include "symbolic/utils/parameter_generator.h"
+
+namespace VAL {
+
+class goal;
+
+}  // namespace VAL
+
+namespace symbolic {
+
+class Pddl;
+
+/**
+ * Backtracking search over the parameter bindings that satisfy a condition.
+ *
+ * The condition is split into conjuncts, and each conjunct is checked as soon
+ * as the last parameter it references is bound, cheapest conjuncts first. When
+ * a prefix of the parameters fails a conjunct, all bindings of the remaining
+ * parameters are skipped.
+ *
+ * Bindings are visited in the same order as the ParameterGenerator.
+ */
+class ParameterBinder {
+ public:
+  ParameterBinder() = default;
+
+  /**
+   * @param pddl Pddl instance.
+   * @param symbol Condition to satisfy.
+   * @param parameters Parameters of the condition.
+   * @param num_bound Number of leading parameters bound by the caller.
+   * @param is_negated Search for bindings that violate the condition instead.
+   */
+  ParameterBinder(const Pddl& pddl, const VAL::goal* symbol,
+                  const std::vector<Object>& parameters, size_t num_bound = 0,
+                  bool is_negated = false);
+
+  size_t num_parameters() const { return num_bound_ + param_gen_.num_slots(); }
+
+  size_t num_conjuncts() const { return conjuncts_.size(); }
+
+  /**
+   * Number of bindings of the free parameters, satisfying or not.
+   */
+  size_t size() const { return param_gen_.size(); }
+
+  /**
+   * Calls f(arguments) for every binding that satisfies the condition.
+   *
+   * @param state State in which to evaluate the condition.
+   * @param arguments Buffer of size num_parameters() with the bound arguments
+   *                  filled in. The remaining slots are overwritten.
+   * @param f Callback f(arguments) or f(arguments, idx), where idx is the
+   *          index of the binding in the ParameterGenerator of the free
+   *          parameters. Returns false to stop the search.
+   * @returns Whether the search ran to completion.
+   */
+  template <typename F>
+  bool ForEach(const State& state, std::vector<Object>* arguments,
+               F&& f) const {
+    return ForEachChecked(
+        [&state](const Formula& P, bool is_negated,
+                 const std::vector<Object>& args) {
+          return P(state, args) != is_negated;
+        },
+        arguments, f);
+  }
+
+  /**
+   * Finds the first binding at or after the given index that satisfies the
+   * condition, so that the bindings can be visited one at a time.
+   *
+   * @param state State in which to evaluate the condition.
+   * @param idx_begin Index of the first binding to consider.
+   * @param arguments Buffer as in ForEach(), set to the binding found.
+   * @returns Index of the binding, or size() if there is none.
+   */
+  size_t FindNext(const State& state, size_t idx_begin,
+                  std::vector<Object>* arguments) const {
+    return Find(state, idx_begin, size(), false, arguments);
+  }
+
+  /**
+   * Finds the last binding before the given index that satisfies the
+   * condition.
+   *
+   * @returns Index of the binding, or size() if there is none.
+   */
+  size_t FindPrev(const State& state, size_t idx_end,
+                  std::vector<Object>* arguments) const {
+    return Find(state, 0, idx_end, true, arguments);
+  }
+
+  /**
+   * Calls f(arguments) for every binding that passes the given check on each
+   * conjunct. The check is called as check(P, is_negated, arguments), where
+   * the conjunct holds if P(arguments) != is_negated.
+   */
+  template <typename CheckT, typename F>
+  bool ForEachChecked(CheckT&& check, std::vector<Object>* arguments,
+                      F&& f) const {
+    if (param_gen_.empty()) return true;
+
+    // Fill in the free slots so that they always hold valid objects.
+    for (size_t i = 0; i < param_gen_.num_slots(); i++) {
+      (*arguments)[num_bound_ + i] = param_gen_.option(i, 0);
+    }
+
+    if (!Check(num_bound_, check, *arguments)) return true;
+    return Bind(num_bound_, 0, check, arguments, f);
+  }
+
+ private:
+  struct Conjunct {
+    Formula P;
+    bool is_negated;
+
+    // Number of parameters that must be bound before the check.
+    size_t num_required;
+
+    // Rough evaluation cost used to order conjuncts at the same depth.
+    size_t cost;
+  };
+
+  template <typename CheckT>
+  bool Check(size_t num_required, CheckT& check,
+             const std::vector<Object>& arguments) const {
+    for (size_t i = idx_conjuncts_[num_required];
+         i < idx_conjuncts_[num_required + 1]; i++) {
+      const Conjunct& conjunct = conjuncts_[i];
+      if (!check(conjunct.P, conjunct.is_negated, arguments)) return false;
+    }
+    return true;
+  }
+
+  template <typename CheckT, typename F>
+  bool Bind(size_t idx_param, size_t idx_binding, CheckT& check,
+            std::vector<Object>* arguments, F& f) const {
+    if (idx_param == num_parameters()) {
+      if constexpr (std::is_invocable_v<F&, const std::vector<Object>&,
+                                        size_t>) {
+        return f(static_cast<const std::vector<Object>&>(*arguments),
+                 idx_binding);
+      } else {
+        return f(static_cast<const std::vector<Object>&>(*arguments));
+      }
+    }
+
+    // The binding index is a mixed-radix number with the first free
+    // parameter as the most significant digit.
+    const size_t slot = idx_param - num_bound_;
+    const size_t num_options = param_gen_.option_size(slot);
+    for (size_t i = 0; i < num_options; i++) {
+      (*arguments)[idx_param] = param_gen_.option(slot, i);
+      if (!Check(idx_param + 1, check, *arguments)) continue;
+      if (!Bind(idx_param + 1, num_options * idx_binding + i, check, arguments,
+                f)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t Find(const State& state, size_t idx_begin, size_t idx_end,
+              bool is_reverse, std::vector<Object>* arguments) const {
+    if (idx_begin >= idx_end) return size();
+
+    auto check = [&state](const Formula& P, bool is_negated,
+                          const std::vector<Object>& args) {
+      return P(state, args) != is_negated;
+    };
+    for (size_t i = 0; i < param_gen_.num_slots(); i++) {
+      (*arguments)[num_bound_ + i] = param_gen_.option(i, 0);
+    }
+
+    if (!Check(num_bound_, check, *arguments)) return size();
+    return Seek(num_bound_, 0, idx_begin, idx_end, is_reverse, check,
+                arguments);
+  }
+
+  /**
+   * Binds the remaining parameters to the first (or last) satisfying binding
+   * with index in [idx_begin, idx_end), where idx_binding is the index of the
+   * first binding with the current prefix.
+   */
+  template <typename CheckT>
+  size_t Seek(size_t idx_param, size_t idx_binding, size_t idx_begin,
+              size_t idx_end, bool is_reverse, CheckT& check,
+              std::vector<Object>* arguments) const {
+    if (idx_param == num_parameters()) return idx_binding;
+
+    // Each option spans a contiguous range of binding indices, so options
+    // outside the range are skipped without checking them.
+    const size_t slot = idx_param - num_bound_;
+    const size_t num_options = param_gen_.option_size(slot);
+    const size_t group_size = param_gen_.group_size(slot);
+    for (size_t j = 0; j < num_options; j++) {
+      const size_t i = is_reverse ? num_options - 1 - j : j;
+      const size_t idx_option = idx_binding + i * group_size;
+      if (idx_option + group_size <= idx_begin || idx_option >= idx_end) {
+        continue;
+      }
+
+      (*arguments)[idx_param] = param_gen_.option(slot, i);
+      if (!Check(idx_param + 1, check, *arguments)) continue;
+      const size_t idx = Seek(idx_param + 1, idx_option, idx_begin, idx_end,
+                              is_reverse, check, arguments);
+      if (idx != size()) return idx;
+    }
+    return size();
+  }
+
+  size_t num_bound_ = 0;
+  ParameterGenerator param_gen_;
+
+  // Conjuncts sorted by the number of required parameters, where the
+  // conjuncts requiring i parameters are in [idx_conjuncts_[i],
+  // idx_conjuncts_[i + 1]).
+  std::vector<Conjunct> conjuncts_;
+  std::vector<size_t> idx_conjuncts_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_UTILS_PARAMETER_BINDER_H_
@@ -0,0 +1,103 @@
+/**
+ * thread_local_buffer.h
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#ifndef SYMBOLIC_UTILS_THREAD_LOCAL_BUFFER_H_
+#define SYMBOLIC_UTILS_THREAD_LOCAL_BUFFER_H_
+
+#include <cassert>  // assert
+#include <cstdint>  // uint64_t
+#include <deque>    // std::deque
+#include <memory>   // std::make_shared, std::shared_ptr
+#include <utility>  // std::move
+
+namespace symbolic {
+
+/**
+ * Index of a per-thread copy, reused after the slot is destroyed, along with a
+ * unique id to detect copies left behind by a destroyed slot.
+ */
+class ThreadLocalSlot {
+ public:
+  ThreadLocalSlot();
+  ~ThreadLocalSlot();
+
+  ThreadLocalSlot(const ThreadLocalSlot&) = delete;
+  ThreadLocalSlot& operator=(const ThreadLocalSlot&) = delete;
+
+  size_t idx() const { return idx_; }
+  uint64_t serial() const { return serial_; }
+
+ private:
+  const size_t idx_;
+  const uint64_t serial_;
+};
+
+/**
+ * Scratch buffer with a separate copy for every thread.
+ *
+ * Precompiled formulas, effects, and propagators write into scratch buffers to
+ * avoid allocating them on every evaluation. Sharing one buffer would race
+ * when a const Pddl is evaluated from multiple threads, so each thread gets its
+ * own copy, initialized with the initial value on first use. Copies of the
+ * buffer share the same per-thread copy.
+ */
+template <typename T>
+class ThreadLocalBuffer {
+ public:
+  /**
+   * Creates an empty buffer, which must be assigned before it is used.
+   */
+  ThreadLocalBuffer() = default;
+
+  explicit ThreadLocalBuffer(T initial)
+      : slot_(std::make_shared<const Slot>(std::move(initial))) {}
+
+  /**
+   * Returns the copy of the calling thread, valid until the buffer is
+   * destroyed.
+   */
+  T& get() const {
+    assert(slot_ != nullptr);
+
+    // Growing a deque does not move its elements, so copies returned earlier
+    // stay valid.
+    thread_local std::deque<Copy> copies;
+    if (slot_->idx() >= copies.size()) copies.resize(slot_->idx() + 1);
+
+    Copy& copy = copies[slot_->idx()];
+    if (copy.serial != slot_->serial()) {
+      copy.serial = slot_->serial();
+      copy.value = slot_->initial;
+    }
+    return copy.value;
+  }
+
+  const T& initial() const {
+    assert(slot_ != nullptr);
+    return slot_->initial;
+  }
+
+ private:
+  struct Slot : public ThreadLocalSlot {
+    explicit Slot(T&& initial) : initial(std::move(initial)) {}
+
+    const T initial;
+  };
+
+  struct Copy {
+    uint64_t serial = 0;
+    T value;
+  };
+
+  std::shared_ptr<const Slot> slot_;
+};
+
+}  // namespace symbolic
+
+#endif  // SYMBOLIC_UTILS_THREAD_LOCAL_BUFFER_H_
@@ -28,8 +28,8 @@ using ::symbolic::ParameterGenerator;
 using ::symbolic::Pddl;
 using ::symbolic::Proposition;
 using ::symbolic::PropositionRef;
-using ::symbolic::SignedProposition;
 using ::symbolic::State;
+using ::symbolic::StateRecorder;
 
 template <typename T>
 using EffectsFunction = std::function<int(const std::vector<Object>&, T*)>;
@@ -37,9 +37,6 @@ using EffectsFunction = std::function<int(const std::vector<Object>&, T*)>;
 using ApplicationFunction =
     std::function<const std::vector<Object>&(const std::vector<Object>&)>;
 
-using AxiomApplicationFunction =
-    std::function<const std::vector<Object>*(const std::vector<Object>&)>;
-
 template <typename T>
 EffectsFunction<T> CreateEffectsFunction(const Pddl& pddl,
                                          const VAL::effect_lists* effects,
@@ -57,20 +54,20 @@ EffectsFunction<T> CreateForall(const Pddl& pddl,
   EffectsFunction<T> ForallEffects =
       CreateEffectsFunction<T>(pddl, effect->getEffects(), forall_params);
 
-  return [gen = ParameterGenerator(pddl, types),
+  return [gen = ParameterGenerator(pddl, types), num_forall = types.size(),
           ForallEffects = std::move(ForallEffects)](
              const std::vector<Object>& arguments, T* state) -> int {
-    // Loop over forall arguments
+    // Loop over forall arguments written in place after the outer arguments
+    std::vector<Object> forall_args = arguments;
+    forall_args.resize(arguments.size() + num_forall);
     int is_state_changed = 0;
-    for (const std::vector<Object>& forall_objs : gen) {
-      // Create forall arguments
-      std::vector<Object> forall_args = arguments;
-      forall_args.insert(forall_args.end(), forall_objs.begin(),
-                         forall_objs.end());
-
-      is_state_changed =
-          std::max(is_state_changed, ForallEffects(forall_args, state));
-    }
+    gen.ForEachInPlace(&forall_args, arguments.size(),
+                       [&ForallEffects, &is_state_changed,
+                        state](const std::vector<Object>& args) {
+                         is_state_changed = std::max(is_state_changed,
+                                                     ForallEffects(args, state));
+                         return true;
+                       });
     return is_state_changed;
   };
 }
@@ -119,21 +116,13 @@ EffectsFunction<T> CreateAdd(const Pddl& pddl, const VAL::simple_effect* effect,
   }
 
   // Prepare axioms.
-  const std::string axiom_context =
-      SignedProposition::Sign(true) + name_predicate;
-  std::vector<std::pair<std::weak_ptr<Axiom>, AxiomApplicationFunction>> axioms;
-  if (pddl.axiom_map().count(axiom_context) > 0) {
-    for (const std::weak_ptr<Axiom>& ptr_axiom :
-         pddl.axiom_map().at(axiom_context)) {
-      const std::shared_ptr<Axiom> axiom = ptr_axiom.lock();
-      std::optional<AxiomApplicationFunction> AxiomApply =
-          Axiom::CreateApplicationFunction(parameters, effect_params,
-                                           axiom->parameters(),
-                                           axiom->context().arguments());
-      if (!AxiomApply.has_value()) continue;
-
-      axioms.emplace_back(axiom, std::move(*AxiomApply));
-    }
+  std::vector<Axiom::Trigger> axioms;
+  for (const Axiom* axiom : pddl.axiom_triggers(name_predicate, true)) {
+    std::optional<Axiom::Trigger> trigger =
+        Axiom::Trigger::Create(*axiom, parameters, effect_params);
+    if (!trigger.has_value()) continue;
+
+    axioms.push_back(std::move(*trigger));
   }
 
   // Add normal predicate
@@ -147,10 +136,9 @@ EffectsFunction<T> CreateAdd(const Pddl& pddl, const VAL::simple_effect* effect,
     if (status == 0) return status;
 
     // Apply axioms.
-    for (const auto& axiom_apply : axioms) {
-      const Axiom& axiom = *axiom_apply.first.lock();
-      const AxiomApplicationFunction& AxiomApply = axiom_apply.second;
-      const std::vector<Object>* axiom_args = AxiomApply(arguments);
+    for (const Axiom::Trigger& trigger : axioms) {
+      const Axiom& axiom = trigger.axiom();
+      const std::vector<Object>* axiom_args = trigger(arguments);
 
       // std::cout << axiom << std::endl;
       if (axiom_args == nullptr) continue;
@@ -208,21 +196,13 @@ EffectsFunction<T> CreateDel(const Pddl& pddl, const VAL::simple_effect* effect,
   }
 
   // Prepare axioms.
-  const std::string axiom_context =
-      SignedProposition::Sign(false) + name_predicate;
-  std::vector<std::pair<std::weak_ptr<Axiom>, AxiomApplicationFunction>> axioms;
-  if (pddl.axiom_map().count(axiom_context) > 0) {
-    for (const std::weak_ptr<Axiom>& ptr_axiom :
-         pddl.axiom_map().at(axiom_context)) {
-      const std::shared_ptr<Axiom> axiom = ptr_axiom.lock();
-      std::optional<AxiomApplicationFunction> AxiomApply =
-          Axiom::CreateApplicationFunction(parameters, effect_params,
-                                           axiom->parameters(),
-                                           axiom->context().arguments());
-      if (!AxiomApply.has_value()) continue;
-
-      axioms.emplace_back(axiom, std::move(*AxiomApply));
-    }
+  std::vector<Axiom::Trigger> axioms;
+  for (const Axiom* axiom : pddl.axiom_triggers(name_predicate, false)) {
+    std::optional<Axiom::Trigger> trigger =
+        Axiom::Trigger::Create(*axiom, parameters, effect_params);
+    if (!trigger.has_value()) continue;
+
+    axioms.push_back(std::move(*trigger));
   }
 
   // Remove normal predicate
@@ -236,10 +216,9 @@ EffectsFunction<T> CreateDel(const Pddl& pddl, const VAL::simple_effect* effect,
     if (status == 0) return status;
 
     // Apply axioms.
-    for (const auto& axiom_apply : axioms) {
-      const Axiom& axiom = *axiom_apply.first.lock();
-      const AxiomApplicationFunction& AxiomApply = axiom_apply.second;
-      const std::vector<Object>* axiom_args = AxiomApply(arguments);
+    for (const Axiom::Trigger& trigger : axioms) {
+      const Axiom& axiom = trigger.axiom();
+      const std::vector<Object>* axiom_args = trigger(arguments);
 
       // std::cout << axiom << std::endl;
       if (axiom_args == nullptr) continue;
@@ -334,8 +313,11 @@ Action::Action(const Pddl& pddl, const VAL::operator_* symbol)
       name_(symbol_->name->getNameRef()),
       parameters_(Object::CreateList(pddl, symbol_->parameters)),
       param_gen_(pddl, parameters_),
+      param_binder_(pddl, symbol_->precondition, parameters_),
       Preconditions_(pddl, symbol_->precondition, parameters_),
       Apply_(CreateEffectsFunction<State>(pddl, symbol_->effects, parameters_)),
+      ApplyRecorded_(CreateEffectsFunction<StateRecorder>(
+          pddl, symbol_->effects, parameters_)),
       ApplyPartial_(CreateEffectsFunction<PartialState>(pddl, symbol_->effects,
                                                         parameters_)) {}
 
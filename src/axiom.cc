@@ -11,6 +11,7 @@
 
 #include <VAL/ptree.h>
 
+#include <cassert>    // assert
 #include <exception>  // std::domain_error
 #include <sstream>    // std::stringstream
 
@@ -21,26 +22,35 @@ namespace {
 using ::symbolic::DisjunctiveFormula;
 using ::symbolic::Formula;
 using ::symbolic::Object;
-using ::symbolic::ParameterGenerator;
+using ::symbolic::ParameterBinder;
 using ::symbolic::Pddl;
 using ::symbolic::SignedProposition;
 
-using AxiomApplicationFunction =
-    std::function<const std::vector<Object>*(const std::vector<Object>&)>;
-
 /**
  * Prepares list of possible arguments given axiom parameters.
  */
 std::vector<std::vector<Object>> PrepareArguments(
-    const Pddl& pddl, const ParameterGenerator& param_gen,
+    const Pddl& pddl, const ParameterBinder& param_binder,
     const Formula& preconditions, const std::vector<Object>& parameters) {
+  // Prune argument prefixes whose bound positive conjuncts simplify to false.
+  const auto IsSatisfiable = [&pddl, &parameters](
+                                 const Formula& P, bool is_negated,
+                                 const std::vector<Object>& args) {
+    return is_negated ||
+           DisjunctiveFormula::Create(pddl, P, parameters, args).has_value();
+  };
+
   std::vector<std::vector<Object>> arguments;
-  for (const std::vector<Object>& args : param_gen) {
-    const std::optional<DisjunctiveFormula> dnf =
-        DisjunctiveFormula::Create(pddl, preconditions, parameters, args);
-    if (!dnf.has_value()) continue;
-    arguments.push_back(args);
-  }
+  std::vector<Object> args(parameters.size());
+  param_binder.ForEachChecked(
+      IsSatisfiable, &args,
+      [&pddl, &preconditions, &parameters,
+       &arguments](const std::vector<Object>& args) {
+        const std::optional<DisjunctiveFormula> dnf =
+            DisjunctiveFormula::Create(pddl, preconditions, parameters, args);
+        if (dnf.has_value()) arguments.push_back(args);
+        return true;
+      });
   return arguments;
 }
 
@@ -111,7 +121,7 @@ namespace symbolic {
  */
 Axiom::Axiom(const Pddl& pddl, const VAL::operator_* symbol)
     : Action(pddl, symbol),
-      arguments_(PrepareArguments(pddl, parameter_generator(), preconditions(),
+      arguments_(PrepareArguments(pddl, parameter_binder(), preconditions(),
                                   parameters())),
       context_(ExtractContextPredicate(pddl, preconditions())),
       formula_(StringifyFormula(pddl, preconditions(), postconditions(),
@@ -233,18 +243,17 @@ std::ostream& operator<<(std::ostream& os, const Axiom& axiom) {
   return os;
 }
 
-std::optional<AxiomApplicationFunction> Axiom::CreateApplicationFunction(
-    const std::vector<Object>& action_params,
-    const std::vector<Object>& action_prop_params,
-    const std::vector<Object>& axiom_params,
-    const std::vector<Object>& axiom_prop_params) {
+std::optional<Axiom::Trigger> Axiom::Trigger::Create(
+    const Axiom& axiom, const std::vector<Object>& action_params,
+    const std::vector<Object>& action_prop_params) {
+  const std::vector<Object>& axiom_params = axiom.parameters();
+  const std::vector<Object>& axiom_prop_params = axiom.context().arguments();
   const size_t num_prop_params = action_prop_params.size();
   assert(num_prop_params == axiom_prop_params.size());
 
   // Check unmatched axiom prop param equal action param.
-  std::vector<std::pair<size_t, size_t>> idx_params;
-  auto axiom_args = std::make_shared<std::vector<Object>>(axiom_params);
-  std::vector<std::pair<size_t, Object>> future_action_args;
+  Trigger trigger(axiom);
+  std::vector<Object> axiom_args = axiom_params;
   for (size_t idx_prop = 0; idx_prop < num_prop_params; idx_prop++) {
     // Check if axiom prop param has corresponding axiom param.
     const Object& axiom_prop_param = axiom_prop_params[idx_prop];
@@ -267,38 +276,37 @@ std::optional<AxiomApplicationFunction> Axiom::CreateApplicationFunction(
       if (axiom_prop_param != action_prop_param) return {};
     } else if (is_axiom_prop_arg) {
       // Make sure axiom prop arg and future action prop arg are equal.
-      future_action_args.emplace_back(j, axiom_prop_param);
+      trigger.future_action_args_.emplace_back(j, axiom_prop_param);
     } else if (is_action_prop_arg) {
       // Instantiate axiom prop param with action prop arg.
-      (*axiom_args)[i] = action_prop_param;
+      axiom_args[i] = action_prop_param;
     } else {
       // Match axiom prop param and action prop param.
-      idx_params.emplace_back(i, j);
+      trigger.idx_params_.emplace_back(i, j);
     }
   }
+  trigger.axiom_args_ =
+      ThreadLocalBuffer<std::vector<Object>>(std::move(axiom_args));
+  return trigger;
+}
 
-  // TODO(tmigimatsu): shared_ptr makes this not thread-safe.
-  return [ptr_axiom_args = std::move(axiom_args),
-          idx_params = std::move(idx_params),
-          future_action_args = std::move(future_action_args)](
-             const std::vector<Object>& action_args)
-             -> const std::vector<Object>* {
-    // Check that action args match up with axiom context proposition.
-    for (const std::pair<size_t, Object>& idx_argument : future_action_args) {
-      const size_t idx_arg = idx_argument.first;
-      const Object& expected_arg = idx_argument.second;
-      if (action_args[idx_arg] != expected_arg) return nullptr;
-    }
+const std::vector<Object>* Axiom::Trigger::operator()(
+    const std::vector<Object>& action_args) const {
+  // Check that action args match up with axiom context proposition.
+  for (const std::pair<size_t, Object>& idx_argument : future_action_args_) {
+    const size_t idx_arg = idx_argument.first;
+    const Object& expected_arg = idx_argument.second;
+    if (action_args[idx_arg] != expected_arg) return nullptr;
+  }
 
-    // Assign axiom args to action args.
-    std::vector<Object>& axiom_args = *ptr_axiom_args;
-    for (const std::pair<size_t, size_t>& idx_axiom_action : idx_params) {
-      const size_t idx_axiom = idx_axiom_action.first;
-      const size_t idx_action = idx_axiom_action.second;
-      axiom_args[idx_axiom] = action_args[idx_action];
-    }
-    return &axiom_args;
-  };
+  // Assign axiom args to action args.
+  std::vector<Object>& axiom_args = axiom_args_.get();
+  for (const std::pair<size_t, size_t>& idx_axiom_action : idx_params_) {
+    const size_t idx_axiom = idx_axiom_action.first;
+    const size_t idx_action = idx_axiom_action.second;
+    axiom_args[idx_axiom] = action_args[idx_action];
+  }
+  return &axiom_args;
 }
 
 }  // namespace symbolic
@@ -0,0 +1,377 @@
+/**
+ * axiom_propagator.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/axiom_propagator.h"
+
+#include <VAL/ptree.h>
+
+#include <algorithm>      // std::find, std::sort, std::swap, std::unique
+#include <thread>         // std::thread
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move
+
+#include "symbolic/normal_form.h"
+#include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::DisjunctiveFormula;
+using ::symbolic::Formula;
+using ::symbolic::Object;
+using ::symbolic::ParameterGenerator;
+using ::symbolic::PartialState;
+using ::symbolic::Pddl;
+using ::symbolic::Proposition;
+using ::symbolic::SignedProposition;
+
+/**
+ * Ground implication `premises => conclusion` of an axiom.
+ */
+struct GroundImplication {
+  std::vector<SignedProposition> premises;
+  SignedProposition conclusion;
+};
+
+bool IsStaticPredicate(const Pddl& pddl, const std::string& name_predicate) {
+  return name_predicate == "=" ||
+         pddl.object_map().find(name_predicate) != pddl.object_map().end();
+}
+
+/**
+ * Recursively grounds the effects of an axiom into implications.
+ */
+void GroundEffects(const Pddl& pddl, const VAL::effect_lists* effects,
+                   const std::vector<Object>& parameters,
+                   const std::vector<Object>& arguments,
+                   std::vector<SignedProposition>* premises,
+                   std::vector<GroundImplication>* implications) {
+  // Forall effects
+  for (const VAL::forall_effect* effect : effects->forall_effects) {
+    std::vector<Object> forall_params = parameters;
+    const std::vector<Object> types =
+        Object::CreateList(pddl, effect->getVarsList());
+    forall_params.insert(forall_params.end(), types.begin(), types.end());
+
+    // Loop over forall arguments
+    ParameterGenerator gen(pddl, types);
+    for (const std::vector<Object>& forall_objs : gen) {
+      std::vector<Object> forall_args = arguments;
+      forall_args.insert(forall_args.end(), forall_objs.begin(),
+                         forall_objs.end());
+      GroundEffects(pddl, effect->getEffects(), forall_params, forall_args,
+                    premises, implications);
+    }
+  }
+
+  // Add and del effects
+  auto AddSimpleEffects = [&](const auto& simple_effects, bool is_pos) {
+    for (const VAL::simple_effect* effect : simple_effects) {
+      const std::string& name_predicate = effect->prop->head->getNameRef();
+      if (IsStaticPredicate(pddl, name_predicate)) continue;
+
+      const std::vector<Object> effect_params =
+          Object::CreateList(pddl, effect->prop->args);
+      const auto Apply =
+          Formula::CreateApplicationFunction(parameters, effect_params);
+      implications->push_back(
+          {*premises, SignedProposition(name_predicate,
+                                        std::vector<Object>(Apply(arguments)),
+                                        is_pos)});
+    }
+  };
+  AddSimpleEffects(effects->add_effects, true);
+  AddSimpleEffects(effects->del_effects, false);
+
+  // Cond effects
+  for (const VAL::cond_effect* effect : effects->cond_effects) {
+    const std::optional<DisjunctiveFormula> condition =
+        DisjunctiveFormula::Create(pddl, effect->getCondition(), parameters,
+                                   arguments);
+    if (!condition.has_value()) continue;  // Condition always false
+
+    if (condition->empty()) {
+      // Condition always true
+      GroundEffects(pddl, effect->getEffects(), parameters, arguments,
+                    premises, implications);
+      continue;
+    }
+
+    // Each conjunction of the condition is a separate set of premises.
+    for (const PartialState& conj : condition->conjunctions) {
+      const size_t num_premises = premises->size();
+      for (const Proposition& prop : conj.pos()) {
+        premises->emplace_back(Proposition(prop), true);
+      }
+      for (const Proposition& prop : conj.neg()) {
+        premises->emplace_back(Proposition(prop), false);
+      }
+      GroundEffects(pddl, effect->getEffects(), parameters, arguments,
+                    premises, implications);
+      premises->erase(premises->begin() + num_premises, premises->end());
+    }
+  }
+}
+
+}  // namespace
+
+namespace symbolic {
+
+AxiomPropagator::AxiomPropagator(
+    const Pddl& pddl, const std::vector<std::shared_ptr<Axiom>>& axioms) {
+  for (const std::shared_ptr<Axiom>& axiom : axioms) {
+    const SignedProposition& context = axiom->context();
+    const auto ApplyContext = Formula::CreateApplicationFunction(
+        axiom->parameters(), context.arguments());
+
+    // Ground implications for all valid axiom arguments.
+    for (const std::vector<Object>& args : axiom->arguments()) {
+      std::vector<SignedProposition> premises = {SignedProposition(
+          context.name(), std::vector<Object>(ApplyContext(args)),
+          context.is_pos())};
+      std::vector<GroundImplication> implications;
+      GroundEffects(pddl, axiom->postconditions(), axiom->parameters(), args,
+                    &premises, &implications);
+
+      for (GroundImplication& implication : implications) {
+        std::vector<Literal> clause;
+        clause.reserve(implication.premises.size() + 1);
+        for (const SignedProposition& premise : implication.premises) {
+          clause.push_back(GetLiteral(premise, !premise.is_pos()));
+        }
+        const SignedProposition& conclusion = implication.conclusion;
+        AddClause(std::move(clause),
+                  GetLiteral(conclusion, conclusion.is_pos()), axiom.get());
+      }
+    }
+  }
+
+  // Watch the first two literals of each clause.
+  Scratch scratch;
+  scratch.watched.reserve(num_clauses());
+  scratch.watches.resize(2 * propositions_.size());
+  for (size_t i = 0; i < num_clauses(); i++) {
+    const size_t idx_begin = idx_clauses_[i];
+    const size_t size = idx_clauses_[i + 1] - idx_begin;
+    const Literal lit_0 = literals_[idx_begin];
+    const Literal lit_1 = size > 1 ? literals_[idx_begin + 1] : lit_0;
+    scratch.watched.push_back({lit_0, lit_1});
+    scratch.watches[lit_0].push_back(i);
+    if (size > 1) scratch.watches[lit_1].push_back(i);
+  }
+  scratch.values.resize(propositions_.size(), 0);
+  scratch_ = ThreadLocalBuffer<Scratch>(std::move(scratch));
+}
+
+AxiomPropagator::Literal AxiomPropagator::GetLiteral(const Proposition& prop,
+                                                     bool is_pos) {
+  auto it = idx_propositions_.find(prop);
+  if (it == idx_propositions_.end()) {
+    // Copy without the sign if given a SignedProposition.
+    it = idx_propositions_.emplace(Proposition(prop.name(), prop.arguments()),
+                                   propositions_.size())
+             .first;
+    propositions_.push_back(it->first);
+  }
+  return 2 * it->second + static_cast<Literal>(!is_pos);
+}
+
+void AxiomPropagator::AddClause(std::vector<Literal>&& premises,
+                                Literal conclusion, const Axiom* axiom) {
+  std::vector<Literal>& clause = premises;
+  clause.push_back(conclusion);
+  std::sort(clause.begin(), clause.end());
+  clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+
+  // Skip tautologies (literals l and !l are adjacent after sorting).
+  for (size_t i = 1; i < clause.size(); i++) {
+    if ((clause[i - 1] ^ 1) == clause[i]) return;
+  }
+
+  // Watch the conclusion first, since it is the only literal that can be
+  // propagated.
+  std::swap(*std::find(clause.begin(), clause.end(), conclusion),
+            clause.front());
+
+  literals_.insert(literals_.end(), clause.begin(), clause.end());
+  idx_clauses_.push_back(literals_.size());
+  conclusions_.push_back(conclusion);
+  axioms_.push_back(axiom);
+}
+
+bool AxiomPropagator::Propagate(PartialState* state,
+                                const Axiom** violated_axiom) const {
+  Scratch& scratch = scratch_.get();
+  std::vector<std::array<Literal, 2>>& watched_all = scratch.watched;
+  std::vector<std::vector<uint32_t>>& watches_all = scratch.watches;
+  std::vector<int8_t>& values = scratch.values;
+  std::vector<Literal>& trail = scratch.trail;
+
+  // Literal values: 1 if true, -1 if false, 0 if unknown.
+  auto Value = [&values](Literal lit) -> int {
+    const int value = values[lit / 2];
+    return (lit & 1) ? -value : value;
+  };
+
+  // Assigns the literal and returns false on conflict.
+  auto Assign = [&values, &trail, &Value](Literal lit) -> bool {
+    const int value = Value(lit);
+    if (value != 0) return value > 0;
+    values[lit / 2] = (lit & 1) ? -1 : 1;
+    trail.push_back(lit);
+    return true;
+  };
+
+  auto Reset = [&values, &trail]() {
+    for (Literal lit : trail) values[lit / 2] = 0;
+    trail.clear();
+  };
+
+  // Assign known propositions from the partial state.
+  if (violated_axiom != nullptr) *violated_axiom = nullptr;
+  bool is_consistent = true;
+  for (const Proposition& prop : state->pos()) {
+    const auto it = idx_propositions_.find(prop);
+    if (it == idx_propositions_.end()) continue;
+    is_consistent &= Assign(2 * it->second);
+  }
+  for (const Proposition& prop : state->neg()) {
+    const auto it = idx_propositions_.find(prop);
+    if (it == idx_propositions_.end()) continue;
+    is_consistent &= Assign(2 * it->second + 1);
+  }
+  const size_t num_given = trail.size();
+
+  // Propagate assignments through the watch lists.
+  for (size_t idx_trail = 0; is_consistent && idx_trail < trail.size();
+       idx_trail++) {
+    const Literal lit_false = trail[idx_trail] ^ 1;
+    std::vector<uint32_t>& watches = watches_all[lit_false];
+    for (size_t i = 0; i < watches.size();) {
+      const uint32_t idx_clause = watches[i];
+      const Literal* clause = &literals_[idx_clauses_[idx_clause]];
+      const size_t size = idx_clauses_[idx_clause + 1] - idx_clauses_[idx_clause];
+      if (size == 1) {
+        if (violated_axiom != nullptr) *violated_axiom = axioms_[idx_clause];
+        is_consistent = false;
+        break;
+      }
+
+      // Move the false literal to the second watch.
+      std::array<Literal, 2>& watched = watched_all[idx_clause];
+      if (watched[0] == lit_false) std::swap(watched[0], watched[1]);
+      const Literal lit_other = watched[0];
+      if (Value(lit_other) > 0) {
+        i++;
+        continue;
+      }
+
+      // Find a new unwatched literal to watch.
+      size_t k = 0;
+      for (; k < size; k++) {
+        if (clause[k] == lit_other || clause[k] == lit_false) continue;
+        if (Value(clause[k]) >= 0) break;
+      }
+      if (k < size) {
+        watched[1] = clause[k];
+        watches_all[watched[1]].push_back(idx_clause);
+        watches[i] = watches.back();
+        watches.pop_back();
+        continue;
+      }
+
+      // All other literals are false.
+      const int value_other = Value(lit_other);
+      if (value_other < 0) {
+        if (violated_axiom != nullptr) *violated_axiom = axioms_[idx_clause];
+        is_consistent = false;
+        break;
+      }
+      if (value_other == 0 && lit_other == conclusions_[idx_clause]) {
+        Assign(lit_other);
+      }
+      i++;
+    }
+  }
+
+  if (!is_consistent) {
+    Reset();
+    return false;
+  }
+
+  // Add derived propositions to the partial state.
+  for (size_t i = num_given; i < trail.size(); i++) {
+    const Literal lit = trail[i];
+    const Proposition& prop = propositions_[lit / 2];
+    if (lit & 1) {
+      state->erase(prop);
+    } else {
+      state->insert(prop);
+    }
+  }
+  Reset();
+  return true;
+}
+
+TEST_CASE_FIXTURE(testing::AxiomsFixture, "AxiomPropagator.Propagate") {
+  const AxiomPropagator propagator(pddl, pddl.axioms());
+
+  // Picking up a block clears it and removes it from all surfaces.
+  PartialState state(pddl, {"inhand(b1)"}, {});
+  REQUIRE(propagator.Propagate(&state));
+  REQUIRE(state.pos().contains(Proposition(pddl, "clear(b1)")));
+  REQUIRE(state.neg().contains(Proposition(pddl, "on(b1, b0)")));
+  REQUIRE(state.neg().contains(Proposition(pddl, "handempty()")));
+
+  // Propagation should match naive axiom application.
+  PartialState naive_state(pddl, {"inhand(b1)"}, {});
+  bool is_changed = true;
+  while (is_changed) {
+    is_changed = false;
+    for (const std::shared_ptr<Axiom>& axiom : pddl.axioms()) {
+      is_changed |= axiom->Apply(&naive_state) > 0;
+    }
+  }
+  REQUIRE(state == naive_state);
+
+  // Axiom violations are detected without modifying the state.
+  const PartialState invalid_state(pddl, {"on(b2, b1)", "clear(b1)"}, {});
+  PartialState test_state = invalid_state;
+  const Axiom* violated_axiom = nullptr;
+  REQUIRE_FALSE(propagator.Propagate(&test_state, &violated_axiom));
+  REQUIRE(test_state == invalid_state);
+  REQUIRE(violated_axiom != nullptr);
+  PartialState violated_state = invalid_state;
+  REQUIRE(violated_axiom->Apply(&violated_state) == 2);
+
+  // Concurrent propagation should match sequential propagation.
+  const std::vector<std::string> props = {"inhand(b0)", "inhand(b1)",
+                                          "on(b2, b1)"};
+  std::vector<PartialState> expected_states;
+  for (const std::string& prop : props) {
+    expected_states.emplace_back(pddl, std::unordered_set<std::string>{prop},
+                                 std::unordered_set<std::string>{});
+    REQUIRE(propagator.Propagate(&expected_states.back()));
+  }
+  std::vector<size_t> num_equal(props.size(), 0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < props.size(); i++) {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0; j < 100; j++) {
+        PartialState test_state(pddl, {props[i]}, {});
+        propagator.Propagate(&test_state);
+        num_equal[i] += test_state == expected_states[i];
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (const size_t num_equal_i : num_equal) REQUIRE(num_equal_i == 100);
+}
+
+}  // namespace symbolic
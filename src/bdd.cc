@@ -0,0 +1,530 @@
+/**
+ * bdd.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/bdd.h"
+
+#include <VAL/ptree.h>
+
+#include <algorithm>      // std::min, std::sort, std::swap, std::unique
+#include <cmath>          // std::ldexp
+#include <stdexcept>      // std::runtime_error
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::pair
+
+#include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace {
+
+constexpr size_t kHashOffset = 0x9e3779b97f4a7c15;
+constexpr size_t kHashL = 6;
+constexpr size_t kHashR = 2;
+
+size_t HashCombine(size_t seed, size_t value) {
+  return seed ^ (value + kHashOffset + (seed << kHashL) + (seed >> kHashR));
+}
+
+}  // namespace
+
+namespace symbolic {
+
+BddManager::BddManager(size_t num_variables)
+    : num_variables_(num_variables),
+      nodes_({{kTerminalVariable, kFalse, kFalse},
+              {kTerminalVariable, kTrue, kTrue}}),
+      computed_table_(kCacheSize) {}
+
+BddManager::BddManager(const Pddl& pddl, size_t num_copies)
+    : BddManager(num_copies * pddl.state_index().size()) {
+  pddl_ = &pddl;
+  num_copies_ = num_copies;
+}
+
+size_t BddManager::NodeHash::operator()(const NodeData& node) const {
+  return HashCombine(HashCombine(node.var, node.low), node.high);
+}
+
+BddManager::Node BddManager::MakeNode(Variable var, Node low, Node high) {
+  if (low == high) return low;
+
+  const NodeData node{var, low, high};
+  const auto it = unique_table_.find(node);
+  if (it != unique_table_.end()) return it->second;
+
+  const Node f = static_cast<Node>(nodes_.size());
+  nodes_.push_back(node);
+  unique_table_.emplace(node, f);
+  return f;
+}
+
+BddManager::Node BddManager::Var(Variable var) {
+  return MakeNode(var, kFalse, kTrue);
+}
+
+BddManager::Node BddManager::NotVar(Variable var) {
+  return MakeNode(var, kTrue, kFalse);
+}
+
+size_t BddManager::CacheIndex(Op op, Node f, Node g, Node h) const {
+  const size_t hash = HashCombine(
+      HashCombine(HashCombine(static_cast<size_t>(op), f), g), h);
+  return hash & (kCacheSize - 1);
+}
+
+std::optional<BddManager::Node> BddManager::FindCached(Op op, Node f, Node g,
+                                                       Node h) const {
+  const CacheEntry& entry = computed_table_[CacheIndex(op, f, g, h)];
+  if (entry.op != op || entry.f != f || entry.g != g || entry.h != h) {
+    return {};
+  }
+  return entry.result;
+}
+
+void BddManager::Cache(Op op, Node f, Node g, Node h, Node result) {
+  computed_table_[CacheIndex(op, f, g, h)] = {op, f, g, h, result};
+}
+
+BddManager::Node BddManager::Ite(Node f, Node g, Node h) {
+  // Terminal cases
+  if (f == kTrue) return g;
+  if (f == kFalse) return h;
+  if (g == h) return g;
+  if (g == kTrue && h == kFalse) return f;
+
+  const std::optional<Node> cached = FindCached(Op::kIte, f, g, h);
+  if (cached.has_value()) return *cached;
+
+  // Shannon expansion on the top variable
+  const Variable var =
+      std::min({TopVariable(f), TopVariable(g), TopVariable(h)});
+  const Node high = Ite(Cofactor(f, var, true), Cofactor(g, var, true),
+                        Cofactor(h, var, true));
+  const Node low = Ite(Cofactor(f, var, false), Cofactor(g, var, false),
+                       Cofactor(h, var, false));
+  const Node result = MakeNode(var, low, high);
+
+  Cache(Op::kIte, f, g, h, result);
+  return result;
+}
+
+BddManager::Node BddManager::Cube(const std::vector<Variable>& vars) {
+  std::vector<Variable> sorted_vars = vars;
+  std::sort(sorted_vars.begin(), sorted_vars.end());
+
+  // Build the cube from the bottom up.
+  Node cube = kTrue;
+  for (auto it = sorted_vars.rbegin(); it != sorted_vars.rend(); ++it) {
+    cube = MakeNode(*it, kFalse, cube);
+  }
+  return cube;
+}
+
+BddManager::Node BddManager::Exists(Node f, Node cube) {
+  if (IsTerminal(f)) return f;
+
+  // Skip quantified variables above the top variable of f.
+  const Variable var = TopVariable(f);
+  while (TopVariable(cube) < var) cube = nodes_[cube].high;
+  if (cube == kTrue) return f;
+
+  const std::optional<Node> cached = FindCached(Op::kExists, f, cube, 0);
+  if (cached.has_value()) return *cached;
+
+  Node result;
+  if (TopVariable(cube) == var) {
+    const Node cube_next = nodes_[cube].high;
+    const Node high = Exists(nodes_[f].high, cube_next);
+    result =
+        high == kTrue ? kTrue : Or(Exists(nodes_[f].low, cube_next), high);
+  } else {
+    result = MakeNode(var, Exists(nodes_[f].low, cube),
+                      Exists(nodes_[f].high, cube));
+  }
+
+  Cache(Op::kExists, f, cube, 0, result);
+  return result;
+}
+
+BddManager::Node BddManager::AndExists(Node f, Node g, Node cube) {
+  // Terminal cases
+  if (f == kFalse || g == kFalse) return kFalse;
+  if (f == kTrue) return Exists(g, cube);
+  if (g == kTrue || f == g) return Exists(f, cube);
+  if (f > g) std::swap(f, g);
+
+  // Skip quantified variables above the top variable.
+  const Variable var = std::min(TopVariable(f), TopVariable(g));
+  while (TopVariable(cube) < var) cube = nodes_[cube].high;
+  if (cube == kTrue) return And(f, g);
+
+  const std::optional<Node> cached = FindCached(Op::kAndExists, f, g, cube);
+  if (cached.has_value()) return *cached;
+
+  const Node f_low = Cofactor(f, var, false);
+  const Node f_high = Cofactor(f, var, true);
+  const Node g_low = Cofactor(g, var, false);
+  const Node g_high = Cofactor(g, var, true);
+
+  Node result;
+  if (TopVariable(cube) == var) {
+    const Node cube_next = nodes_[cube].high;
+    const Node low = AndExists(f_low, g_low, cube_next);
+    result = low == kTrue ? kTrue
+                          : Or(low, AndExists(f_high, g_high, cube_next));
+  } else {
+    result = MakeNode(var, AndExists(f_low, g_low, cube),
+                      AndExists(f_high, g_high, cube));
+  }
+
+  Cache(Op::kAndExists, f, g, cube, result);
+  return result;
+}
+
+BddManager::Node BddManager::Rename(Node f, const std::vector<Variable>& map) {
+  std::unordered_map<Node, Node> renamed;
+  auto RenameRecursive = [this, &map, &renamed](Node f,
+                                                const auto& Recurse) -> Node {
+    if (IsTerminal(f)) return f;
+    const auto it = renamed.find(f);
+    if (it != renamed.end()) return it->second;
+
+    const NodeData node = nodes_[f];
+    const Node low = Recurse(node.low, Recurse);
+    const Node high = Recurse(node.high, Recurse);
+    const Node result = Ite(Var(map[node.var]), high, low);
+    renamed.emplace(f, result);
+    return result;
+  };
+  return RenameRecursive(f, RenameRecursive);
+}
+
+BddManager::Node BddManager::Compose(
+    Node f, const std::unordered_map<Variable, Node>& substitution) {
+  std::unordered_map<Node, Node> composed;
+  auto ComposeRecursive = [this, &substitution, &composed](
+                              Node f, const auto& Recurse) -> Node {
+    if (IsTerminal(f)) return f;
+    const auto it = composed.find(f);
+    if (it != composed.end()) return it->second;
+
+    const NodeData node = nodes_[f];
+    const Node low = Recurse(node.low, Recurse);
+    const Node high = Recurse(node.high, Recurse);
+    const auto it_sub = substitution.find(node.var);
+    const Node var =
+        it_sub == substitution.end() ? Var(node.var) : it_sub->second;
+    const Node result = Ite(var, high, low);
+    composed.emplace(f, result);
+    return result;
+  };
+  return ComposeRecursive(f, ComposeRecursive);
+}
+
+double BddManager::SatCount(Node f) const {
+  // Fraction of assignments that satisfy each node.
+  std::unordered_map<Node, double> fractions = {{kFalse, 0.}, {kTrue, 1.}};
+  auto Fraction = [this, &fractions](Node f, const auto& Recurse) -> double {
+    const auto it = fractions.find(f);
+    if (it != fractions.end()) return it->second;
+
+    const double fraction = 0.5 * Recurse(nodes_[f].low, Recurse) +
+                            0.5 * Recurse(nodes_[f].high, Recurse);
+    fractions.emplace(f, fraction);
+    return fraction;
+  };
+  return std::ldexp(Fraction(f, Fraction), static_cast<int>(num_variables_));
+}
+
+size_t BddManager::Size(Node f) const {
+  std::unordered_set<Node> visited;
+  std::vector<Node> stack = {f};
+  while (!stack.empty()) {
+    const Node node = stack.back();
+    stack.pop_back();
+    if (!visited.insert(node).second || IsTerminal(node)) continue;
+    stack.push_back(nodes_[node].low);
+    stack.push_back(nodes_[node].high);
+  }
+  return visited.size();
+}
+
+BddManager::Node BddManager::CreateProposition(const Pddl& pddl,
+                                               const Proposition& prop,
+                                               size_t copy) {
+  // Evaluate equality and type predicates.
+  if (prop.name() == "=") {
+    return prop.arguments()[0] == prop.arguments()[1] ? kTrue : kFalse;
+  }
+  if (pddl.object_map().find(prop.name()) != pddl.object_map().end()) {
+    return prop.arguments()[0].type().IsSubtype(prop.name()) ? kTrue : kFalse;
+  }
+
+  return Var(GetVariable(pddl.state_index().GetPropositionIndex(prop), copy));
+}
+
+BddManager::Node BddManager::Create(const Pddl& pddl, const VAL::goal* symbol,
+                                    const std::vector<Object>& parameters,
+                                    const std::vector<Object>& arguments,
+                                    size_t copy) {
+  // Proposition
+  const auto* simple_goal = dynamic_cast<const VAL::simple_goal*>(symbol);
+  if (simple_goal != nullptr) {
+    const VAL::proposition* prop = simple_goal->getProp();
+    const std::vector<Object> prop_params =
+        Object::CreateList(pddl, prop->args);
+    const auto Apply =
+        Formula::CreateApplicationFunction(parameters, prop_params);
+    return CreateProposition(
+        pddl, Proposition(prop->head->getName(), Apply(arguments)), copy);
+  }
+
+  // Conjunction
+  const auto* conj_goal = dynamic_cast<const VAL::conj_goal*>(symbol);
+  if (conj_goal != nullptr) {
+    Node result = kTrue;
+    for (const VAL::goal* goal : *conj_goal->getGoals()) {
+      result = And(result, Create(pddl, goal, parameters, arguments, copy));
+      if (result == kFalse) break;
+    }
+    return result;
+  }
+
+  // Disjunction
+  const auto* disj_goal = dynamic_cast<const VAL::disj_goal*>(symbol);
+  if (disj_goal != nullptr) {
+    Node result = kFalse;
+    for (const VAL::goal* goal : *disj_goal->getGoals()) {
+      result = Or(result, Create(pddl, goal, parameters, arguments, copy));
+      if (result == kTrue) break;
+    }
+    return result;
+  }
+
+  // Negation
+  const auto* neg_goal = dynamic_cast<const VAL::neg_goal*>(symbol);
+  if (neg_goal != nullptr) {
+    return Not(Create(pddl, neg_goal->getGoal(), parameters, arguments, copy));
+  }
+
+  // Forall and exists
+  const auto* qfied_goal = dynamic_cast<const VAL::qfied_goal*>(symbol);
+  if (qfied_goal != nullptr) {
+    const bool is_forall =
+        qfied_goal->getQuantifier() == VAL::quantifier::E_FORALL;
+
+    // Create qfied parameters
+    std::vector<Object> qfied_params = parameters;
+    const std::vector<Object> types =
+        Object::CreateList(pddl, qfied_goal->getVars());
+    qfied_params.insert(qfied_params.end(), types.begin(), types.end());
+
+    // Loop over qfied arguments
+    Node result = is_forall ? kTrue : kFalse;
+    ParameterGenerator gen(pddl, types);
+    for (const std::vector<Object>& qfied_objs : gen) {
+      std::vector<Object> qfied_args = arguments;
+      qfied_args.insert(qfied_args.end(), qfied_objs.begin(), qfied_objs.end());
+
+      const Node qfied = Create(pddl, qfied_goal->getGoal(), qfied_params,
+                                qfied_args, copy);
+      result = is_forall ? And(result, qfied) : Or(result, qfied);
+      if (result == (is_forall ? kFalse : kTrue)) break;
+    }
+    return result;
+  }
+
+  throw std::runtime_error("BddManager::Create(): Goal type not supported.");
+}
+
+BddManager::Node BddManager::Create(const DisjunctiveFormula& dnf,
+                                    size_t copy) {
+  if (dnf.empty()) return kTrue;
+
+  Node result = kFalse;
+  for (const DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
+    result = Or(result, Create(conj, copy));
+    if (result == kTrue) break;
+  }
+  return result;
+}
+
+BddManager::Node BddManager::Create(const PartialState& conj, size_t copy) {
+  if (pddl_ == nullptr) {
+    throw std::runtime_error(
+        "BddManager::Create(): Manager was created without a state index.");
+  }
+
+  // Collect literals as (variable, is_pos) and build the cube bottom up.
+  std::vector<std::pair<Variable, bool>> literals;
+  literals.reserve(conj.size());
+  for (const Proposition& prop : conj.pos()) {
+    literals.emplace_back(
+        GetVariable(pddl_->state_index().GetPropositionIndex(prop), copy),
+        true);
+  }
+  for (const Proposition& prop : conj.neg()) {
+    literals.emplace_back(
+        GetVariable(pddl_->state_index().GetPropositionIndex(prop), copy),
+        false);
+  }
+  std::sort(literals.begin(), literals.end());
+
+  Node result = kTrue;
+  for (auto it = literals.rbegin(); it != literals.rend(); ++it) {
+    const Variable var = it->first;
+    if (TopVariable(result) == var) {
+      // Contradictory literals are adjacent after sorting.
+      if ((nodes_[result].high == kFalse) == it->second) return kFalse;
+      continue;
+    }
+    result = it->second ? MakeNode(var, kFalse, result)
+                        : MakeNode(var, result, kFalse);
+  }
+  return result;
+}
+
+BddManager::Node BddManager::CreateState(const State& state, size_t copy) {
+  if (pddl_ == nullptr) {
+    throw std::runtime_error(
+        "BddManager::CreateState(): Manager was created without a state "
+        "index.");
+  }
+  const StateIndex& state_index = pddl_->state_index();
+  std::vector<bool> is_true(state_index.size(), false);
+  for (const Proposition& prop : state) {
+    is_true[state_index.GetPropositionIndex(prop)] = true;
+  }
+
+  // Build the minterm from the bottom up.
+  Node result = kTrue;
+  for (size_t i = is_true.size(); i-- > 0;) {
+    const Variable var = GetVariable(i, copy);
+    result = is_true[i] ? MakeNode(var, kFalse, result)
+                        : MakeNode(var, result, kFalse);
+  }
+  return result;
+}
+
+std::optional<DisjunctiveFormula> BddManager::GetDisjunctiveFormula(
+    Node f, size_t copy) const {
+  if (f == kFalse) return {};
+  if (pddl_ == nullptr) {
+    throw std::runtime_error(
+        "BddManager::GetDisjunctiveFormula(): Manager was created without a "
+        "state index.");
+  }
+  const StateIndex& state_index = pddl_->state_index();
+
+  // Enumerate paths to the true terminal.
+  DisjunctiveFormula dnf;
+  DisjunctiveFormula::Conjunction conj;
+  auto AddPaths = [this, copy, &state_index, &dnf, &conj](
+                      Node f, const auto& Recurse) {
+    if (f == kFalse) return;
+    if (f == kTrue) {
+      dnf.conjunctions.push_back(conj);
+      return;
+    }
+    const NodeData& node = nodes_[f];
+
+    // Skip variables of other copies.
+    if (node.var % num_copies_ != copy) {
+      Recurse(node.low, Recurse);
+      Recurse(node.high, Recurse);
+      return;
+    }
+    const Proposition prop = state_index.GetProposition(node.var / num_copies_);
+
+    conj.erase(prop);
+    Recurse(node.low, Recurse);
+    conj.neg().erase(prop);
+
+    conj.insert(prop);
+    Recurse(node.high, Recurse);
+    conj.pos().erase(prop);
+  };
+  AddPaths(f, AddPaths);
+
+  // Paths that differ only in other copies give the same conjunction.
+  std::sort(dnf.conjunctions.begin(), dnf.conjunctions.end());
+  dnf.conjunctions.erase(
+      std::unique(dnf.conjunctions.begin(), dnf.conjunctions.end()),
+      dnf.conjunctions.end());
+  return dnf;
+}
+
+std::optional<State> BddManager::PickState(Node f, size_t copy) const {
+  if (f == kFalse) return {};
+  if (pddl_ == nullptr) {
+    throw std::runtime_error(
+        "BddManager::PickState(): Manager was created without a state index.");
+  }
+  const StateIndex& state_index = pddl_->state_index();
+
+  // Follow low edges when possible so that unconstrained propositions are
+  // false.
+  State state;
+  while (!IsTerminal(f)) {
+    const NodeData& node = nodes_[f];
+    const bool is_true = node.low == kFalse;
+    if (is_true && node.var % num_copies_ == copy) {
+      state.insert(state_index.GetProposition(node.var / num_copies_));
+    }
+    f = is_true ? node.high : node.low;
+  }
+  return state;
+}
+
+TEST_CASE_FIXTURE(testing::Fixture, "BddManager") {
+  BddManager bdd(pddl);
+
+  for (const Action& action : pddl.actions()) {
+    for (const std::vector<Object>& args : action.parameter_generator()) {
+      const BddManager::Node pre =
+          bdd.Create(pddl, action.preconditions(), action.parameters(), args);
+
+      // Equivalent formulas should share the same node.
+      std::optional<DisjunctiveFormula> dnf = DisjunctiveFormula::Create(
+          pddl, action.preconditions(), action.parameters(), args);
+      REQUIRE(bdd.Create(dnf) == pre);
+      REQUIRE(bdd.Create(bdd.GetDisjunctiveFormula(pre)) == pre);
+
+      // Negation
+      if (dnf.has_value()) {
+        REQUIRE(bdd.Create(Negate(pddl, std::move(*dnf))) == bdd.Not(pre));
+      }
+
+      // States picked from the BDD should satisfy the preconditions.
+      const std::optional<State> state = bdd.PickState(pre);
+      if (state.has_value()) REQUIRE(action.IsValid(*state, args));
+    }
+  }
+
+  // A single state is one satisfying assignment.
+  const BddManager::Node state = bdd.CreateState(pddl.initial_state());
+  REQUIRE(bdd.SatCount(state) == 1.);
+  REQUIRE(bdd.PickState(state) == pddl.initial_state());
+
+  // Quantifying out all variables of a satisfiable BDD gives true.
+  std::vector<BddManager::Variable> vars(bdd.num_variables());
+  for (size_t i = 0; i < vars.size(); i++) {
+    vars[i] = static_cast<BddManager::Variable>(i);
+  }
+  REQUIRE(bdd.Exists(state, bdd.Cube(vars)) == BddManager::kTrue);
+
+  // Formulas of one copy should ignore the variables of the other copy.
+  BddManager bdd2(pddl, 2);
+  const BddManager::Node state2 = bdd2.CreateState(pddl.initial_state(), 0);
+  const BddManager::Node empty2 = bdd2.CreateState(State(), 1);
+  const BddManager::Node transition = bdd2.And(state2, empty2);
+  REQUIRE(bdd2.Create(bdd2.GetDisjunctiveFormula(transition, 0), 0) == state2);
+  REQUIRE(bdd2.Create(bdd2.GetDisjunctiveFormula(transition, 1), 1) == empty2);
+}
+
+}  // namespace symbolic
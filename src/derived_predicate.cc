@@ -11,17 +11,517 @@
 
 #include <VAL/ptree.h>
 
+#include <algorithm>      // std::any_of, std::find, std::min
+#include <functional>     // std::hash
+#include <unordered_set>  // std::unordered_set
+
 #include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::DerivedPredicate;
+using ::symbolic::Object;
+using ::symbolic::Pddl;
+using ::symbolic::Proposition;
+using ::symbolic::PropositionRef;
+using ::symbolic::State;
+
+using BodyAtom = DerivedPredicate::BodyAtom;
+using Stratum = DerivedPredicate::Stratum;
+
+/**
+ * Recursively collects the predicate atoms in the derived predicate body.
+ *
+ * Quantified variables shadow head parameters with the same name.
+ */
+void CollectBodyAtoms(const Pddl& pddl, const VAL::goal* symbol,
+                      const std::vector<Object>& parameters,
+                      std::vector<Object>* quantified, bool is_pos,
+                      std::vector<BodyAtom>* atoms) {
+  // Proposition
+  const auto* simple_goal = dynamic_cast<const VAL::simple_goal*>(symbol);
+  if (simple_goal != nullptr) {
+    const VAL::proposition* prop = simple_goal->getProp();
+    BodyAtom atom;
+    atom.name = prop->head->getNameRef();
+    if (atom.name == "=") return;
+    atom.is_pos = is_pos;
+    for (const VAL::parameter_symbol* arg : *prop->args) {
+      const Object obj(pddl, arg);
+      if (dynamic_cast<const VAL::var_symbol*>(arg) == nullptr) {
+        atom.idx_params.push_back(-1);
+        atom.constants.emplace_back(obj);
+        continue;
+      }
+      atom.constants.emplace_back();
+      if (std::find(quantified->begin(), quantified->end(), obj) !=
+          quantified->end()) {
+        atom.idx_params.push_back(-1);
+        continue;
+      }
+      const auto it = std::find(parameters.begin(), parameters.end(), obj);
+      atom.idx_params.push_back(
+          it == parameters.end() ? -1 : static_cast<int>(it - parameters.begin()));
+    }
+    atoms->push_back(std::move(atom));
+    return;
+  }
+
+  // Conjunction
+  const auto* conj_goal = dynamic_cast<const VAL::conj_goal*>(symbol);
+  if (conj_goal != nullptr) {
+    for (const VAL::goal* goal : *conj_goal->getGoals()) {
+      CollectBodyAtoms(pddl, goal, parameters, quantified, is_pos, atoms);
+    }
+    return;
+  }
+
+  // Disjunction
+  const auto* disj_goal = dynamic_cast<const VAL::disj_goal*>(symbol);
+  if (disj_goal != nullptr) {
+    for (const VAL::goal* goal : *disj_goal->getGoals()) {
+      CollectBodyAtoms(pddl, goal, parameters, quantified, is_pos, atoms);
+    }
+    return;
+  }
+
+  // Negation
+  const auto* neg_goal = dynamic_cast<const VAL::neg_goal*>(symbol);
+  if (neg_goal != nullptr) {
+    CollectBodyAtoms(pddl, neg_goal->getGoal(), parameters, quantified,
+                     !is_pos, atoms);
+    return;
+  }
+
+  // Forall and exists (both monotone in their subformula)
+  const auto* qfied_goal = dynamic_cast<const VAL::qfied_goal*>(symbol);
+  if (qfied_goal != nullptr) {
+    const std::vector<Object> vars =
+        Object::CreateList(pddl, qfied_goal->getVars());
+    quantified->insert(quantified->end(), vars.begin(), vars.end());
+    CollectBodyAtoms(pddl, qfied_goal->getGoal(), parameters, quantified,
+                     is_pos, atoms);
+    quantified->resize(quantified->size() - vars.size());
+  }
+}
+
+std::vector<BodyAtom> CreateBodyAtoms(const Pddl& pddl,
+                                      const VAL::goal* symbol,
+                                      const std::vector<Object>& parameters) {
+  std::vector<BodyAtom> atoms;
+  std::vector<Object> quantified;
+  CollectBodyAtoms(pddl, symbol, parameters, &quantified, true, &atoms);
+  return atoms;
+}
+
+/**
+ * Tarjan's strongly connected components over the derived predicate
+ * dependency graph. Components are emitted after all of their dependencies.
+ */
+class StratumBuilder {
+ public:
+  explicit StratumBuilder(const std::vector<DerivedPredicate>& predicates)
+      : predicates_(predicates),
+        dependencies_(predicates.size()),
+        index_(predicates.size(), -1),
+        lowlink_(predicates.size(), 0),
+        on_stack_(predicates.size(), false) {
+    for (size_t i = 0; i < predicates_.size(); i++) {
+      for (const BodyAtom& atom : predicates_[i].body_atoms()) {
+        for (size_t j = 0; j < predicates_.size(); j++) {
+          if (atom.name != predicates_[j].name()) continue;
+          dependencies_[i].emplace_back(j, atom.is_pos);
+        }
+      }
+    }
+  }
+
+  std::vector<Stratum> Build() {
+    for (size_t i = 0; i < predicates_.size(); i++) {
+      if (index_[i] < 0) Visit(i);
+    }
+    return std::move(strata_);
+  }
+
+ private:
+  void Visit(size_t i) {
+    index_[i] = lowlink_[i] = next_index_++;
+    stack_.push_back(i);
+    on_stack_[i] = true;
+
+    for (const std::pair<size_t, bool>& dep : dependencies_[i]) {
+      const size_t j = dep.first;
+      if (index_[j] < 0) {
+        Visit(j);
+        lowlink_[i] = std::min(lowlink_[i], lowlink_[j]);
+      } else if (on_stack_[j]) {
+        lowlink_[i] = std::min(lowlink_[i], index_[j]);
+      }
+    }
+
+    // Return if i is not the root of a component.
+    if (lowlink_[i] != index_[i]) return;
+
+    Stratum stratum;
+    size_t j;
+    do {
+      j = stack_.back();
+      stack_.pop_back();
+      on_stack_[j] = false;
+      stratum.predicates.push_back(j);
+    } while (j != i);
+    std::reverse(stratum.predicates.begin(), stratum.predicates.end());
+
+    // Check for recursion and recursion through negation.
+    for (size_t k : stratum.predicates) {
+      for (const std::pair<size_t, bool>& dep : dependencies_[k]) {
+        const bool is_internal =
+            std::find(stratum.predicates.begin(), stratum.predicates.end(),
+                      dep.first) != stratum.predicates.end();
+        if (!is_internal) continue;
+        stratum.is_recursive = true;
+        if (!dep.second) stratum.is_stratified = false;
+      }
+    }
+    strata_.push_back(std::move(stratum));
+  }
+
+  const std::vector<DerivedPredicate>& predicates_;
+  std::vector<std::vector<std::pair<size_t, bool>>> dependencies_;
+
+  std::vector<int> index_;
+  std::vector<int> lowlink_;
+  std::vector<bool> on_stack_;
+  std::vector<size_t> stack_;
+  int next_index_ = 0;
+
+  std::vector<Stratum> strata_;
+};
+
+/**
+ * Adds all bindings of the derived predicate head that are consistent with the
+ * body atom being instantiated with the given arguments.
+ */
+void AddAtomBindings(const DerivedPredicate& pred, const BodyAtom& atom,
+                     const std::vector<Object>& atom_args, State* bindings) {
+  const std::vector<Object>& params = pred.parameters();
+  std::vector<Object> args = params;
+  std::vector<bool> is_bound(params.size(), false);
+  for (size_t i = 0; i < atom_args.size(); i++) {
+    const Object& arg = atom_args[i];
+    if (atom.constants[i].has_value() && *atom.constants[i] != arg) return;
+
+    const int idx_param = atom.idx_params[i];
+    if (idx_param < 0) continue;
+    if (is_bound[idx_param]) {
+      if (args[idx_param] != arg) return;
+      continue;
+    }
+    if (!arg.type().IsSubtype(params[idx_param].type())) return;
+    args[idx_param] = arg;
+    is_bound[idx_param] = true;
+  }
+
+  // Enumerate the remaining free parameters.
+  const Pddl& pddl = pred.pddl();
+  std::vector<size_t> idx_free;
+  std::vector<const std::vector<Object>*> options;
+  for (size_t i = 0; i < params.size(); i++) {
+    if (is_bound[i]) continue;
+    const auto it = pddl.object_map().find(params[i].type().name());
+    if (it == pddl.object_map().end() || it->second.empty()) return;
+    idx_free.push_back(i);
+    options.push_back(&it->second);
+  }
+
+  std::vector<size_t> digits(idx_free.size(), 0);
+  for (size_t i = 0; i < idx_free.size(); i++) {
+    args[idx_free[i]] = options[i]->front();
+  }
+  while (true) {
+    bindings->emplace(pred.name(), args);
+
+    // Increment digits from right to left.
+    size_t i = idx_free.size();
+    for (; i > 0; i--) {
+      const size_t d = i - 1;
+      if (++digits[d] < options[d]->size()) {
+        args[idx_free[d]] = (*options[d])[digits[d]];
+        break;
+      }
+      digits[d] = 0;
+      args[idx_free[d]] = options[d]->front();
+    }
+    if (i == 0) break;
+  }
+}
+
+/**
+ * Adds all bindings of the derived predicate head whose body may be affected
+ * by the given changed atoms.
+ *
+ * @param pred Derived predicate.
+ * @param changes Changed atoms.
+ * @param is_pos If set, only consider body atoms with the given polarity.
+ * @param bindings Output set of bindings.
+ */
+template <typename Container>
+void AddAffectedBindings(const DerivedPredicate& pred, const Container& changes,
+                         std::optional<bool> is_pos, State* bindings) {
+  for (const BodyAtom& atom : pred.body_atoms()) {
+    if (is_pos.has_value() && atom.is_pos != *is_pos) continue;
+    for (const Proposition& prop : changes) {
+      if (prop.name() != atom.name) continue;
+      AddAtomBindings(pred, atom, prop.arguments(), bindings);
+    }
+  }
+}
+
+bool IsInStratum(const std::vector<DerivedPredicate>& predicates,
+                 const Stratum& stratum, const std::string& name) {
+  return std::any_of(stratum.predicates.begin(), stratum.predicates.end(),
+                     [&predicates, &name](size_t i) {
+                       return predicates[i].name() == name;
+                     });
+}
+
+/**
+ * Semi-naive propagation of newly derived atoms within a recursive stratum.
+ *
+ * @param predicates Derived predicates.
+ * @param stratum Recursive, stratified stratum.
+ * @param delta Atoms of the stratum that were just inserted into the state.
+ * @param state State to update in place.
+ * @param inserted Output list of all atoms inserted during propagation.
+ */
+void PropagateSemiNaive(const std::vector<DerivedPredicate>& predicates,
+                        const Stratum& stratum, std::vector<Proposition> delta,
+                        State* state, std::vector<Proposition>* inserted) {
+  while (!delta.empty()) {
+    std::vector<Proposition> next_delta;
+    for (size_t i : stratum.predicates) {
+      const DerivedPredicate& pred = predicates[i];
+
+      // Only revisit bindings that depend on new atoms.
+      State bindings;
+      AddAffectedBindings(pred, delta, std::nullopt, &bindings);
+      for (const Proposition& binding : bindings) {
+        if (state->contains(binding)) continue;
+        if (!pred.IsValid(*state, binding.arguments())) continue;
+        state->insert(binding);
+        next_delta.push_back(binding);
+      }
+    }
+    inserted->insert(inserted->end(), next_delta.begin(), next_delta.end());
+    delta = std::move(next_delta);
+  }
+}
+
+/**
+ * Evaluates a recursive, stratified component with semi-naive iteration.
+ */
+bool ApplySemiNaive(const std::vector<DerivedPredicate>& predicates,
+                    const Stratum& stratum, State* state) {
+  // Remove the previous atoms of the stratum, since recursive predicates are
+  // recomputed from the least fixpoint.
+  std::vector<Proposition> old_atoms;
+  for (const Proposition& prop : *state) {
+    if (!IsInStratum(predicates, stratum, prop.name())) continue;
+    old_atoms.push_back(prop);
+  }
+  for (const Proposition& prop : old_atoms) {
+    state->erase(prop);
+  }
+
+  // First pass over all bindings.
+  std::vector<Proposition> delta;
+  for (size_t i : stratum.predicates) {
+    const DerivedPredicate& pred = predicates[i];
+    for (const std::vector<Object>& arguments : pred.parameter_generator()) {
+      if (!pred.IsValid(*state, arguments)) continue;
+      Proposition prop(pred.name(), arguments);
+      if (!state->insert(prop)) continue;
+      delta.push_back(std::move(prop));
+    }
+  }
+  std::vector<Proposition> derived = delta;
+  PropagateSemiNaive(predicates, stratum, std::move(delta), state, &derived);
+
+  if (derived.size() != old_atoms.size()) return true;
+  return std::any_of(
+      old_atoms.begin(), old_atoms.end(),
+      [state](const Proposition& prop) { return !state->contains(prop); });
+}
+
+/**
+ * Net changes to the state relative to the last derived-consistent state.
+ */
+class StateDelta {
+ public:
+  StateDelta(const State& added, const State& deleted) {
+    for (const Proposition& prop : added) Record(prop, true);
+    for (const Proposition& prop : deleted) Record(prop, false);
+  }
+
+  const State& added() const { return added_; }
+  const State& deleted() const { return deleted_; }
+
+  bool empty() const { return added_.empty() && deleted_.empty(); }
+
+  size_t num_records() const { return num_records_; }
+
+  /**
+   * Whether any atom of the given predicate may have changed.
+   */
+  bool contains(const std::string& name) const {
+    return names_.find(name) != names_.end();
+  }
+
+  void Record(const Proposition& prop, bool is_added) {
+    State& opposite = is_added ? deleted_ : added_;
+    State& same = is_added ? added_ : deleted_;
+    if (!opposite.erase(prop)) same.insert(prop);
+    names_.insert(prop.name());
+    num_records_++;
+  }
+
+ private:
+  State added_;
+  State deleted_;
+  std::unordered_set<std::string> names_;
+  size_t num_records_ = 0;
+};
+
+/**
+ * Re-evaluates a non-recursive stratum at the bindings affected by the delta.
+ */
+void UpdateNonRecursive(const DerivedPredicate& pred, StateDelta* delta,
+                        State* state) {
+  State bindings;
+  AddAffectedBindings(pred, delta->added(), std::nullopt, &bindings);
+  AddAffectedBindings(pred, delta->deleted(), std::nullopt, &bindings);
+  for (const Proposition& binding : bindings) {
+    if (pred.IsValid(*state, binding.arguments())) {
+      if (state->insert(binding)) delta->Record(binding, true);
+    } else if (state->erase(binding)) {
+      delta->Record(binding, false);
+    }
+  }
+}
+
+/**
+ * Maintains a recursive, stratified stratum with delete-and-rederive.
+ */
+void UpdateDRed(const std::vector<DerivedPredicate>& predicates,
+                const Stratum& stratum, StateDelta* delta, State* state) {
+  // Seed bindings that may lose support (positive atoms deleted or negative
+  // atoms added) and bindings that may gain support.
+  State overdeleted;
+  State candidates;
+  for (size_t i : stratum.predicates) {
+    const DerivedPredicate& pred = predicates[i];
+    AddAffectedBindings(pred, delta->deleted(), true, &overdeleted);
+    AddAffectedBindings(pred, delta->added(), false, &overdeleted);
+    AddAffectedBindings(pred, delta->added(), true, &candidates);
+    AddAffectedBindings(pred, delta->deleted(), false, &candidates);
+  }
+
+  // Over-delete: propagate potential loss of support through the stratum.
+  std::vector<Proposition> queue;
+  for (const Proposition& prop : overdeleted) {
+    if (state->contains(prop)) queue.push_back(prop);
+  }
+  overdeleted = State();
+  while (!queue.empty()) {
+    const std::vector<Proposition> atoms = {std::move(queue.back())};
+    queue.pop_back();
+    if (!overdeleted.insert(atoms.front())) continue;
+
+    State bindings;
+    for (size_t i : stratum.predicates) {
+      AddAffectedBindings(predicates[i], atoms, true, &bindings);
+    }
+    for (const Proposition& prop : bindings) {
+      if (state->contains(prop) && !overdeleted.contains(prop)) {
+        queue.push_back(prop);
+      }
+    }
+  }
+  for (const Proposition& prop : overdeleted) {
+    state->erase(prop);
+  }
+
+  // Rederive: over-deleted atoms with alternative support and new candidates.
+  std::vector<Proposition> inserted;
+  auto Rederive = [&predicates, &stratum, state, &inserted](
+                      const Proposition& prop) {
+    if (state->contains(prop)) return;
+    for (size_t i : stratum.predicates) {
+      const DerivedPredicate& pred = predicates[i];
+      if (pred.name() != prop.name()) continue;
+      if (!pred.IsValid(*state, prop.arguments())) return;
+      state->insert(prop);
+      inserted.push_back(prop);
+      return;
+    }
+  };
+  for (const Proposition& prop : overdeleted) Rederive(prop);
+  for (const Proposition& prop : candidates) Rederive(prop);
+
+  std::vector<Proposition> seeds = inserted;
+  PropagateSemiNaive(predicates, stratum, std::move(seeds), state, &inserted);
+
+  // Record net changes.
+  for (const Proposition& prop : overdeleted) {
+    if (!state->contains(prop)) delta->Record(prop, false);
+  }
+  for (const Proposition& prop : inserted) {
+    if (!overdeleted.contains(prop)) delta->Record(prop, true);
+  }
+}
+
+/**
+ * Naively re-evaluates an unstratified stratum and records its changes.
+ */
+void UpdateNaive(const std::vector<DerivedPredicate>& predicates,
+                 const Stratum& stratum, StateDelta* delta, State* state) {
+  State old_atoms;
+  for (const Proposition& prop : *state) {
+    if (IsInStratum(predicates, stratum, prop.name())) old_atoms.insert(prop);
+  }
+
+  bool is_changed = true;
+  while (is_changed) {
+    is_changed = false;
+    for (size_t i : stratum.predicates) {
+      is_changed |= predicates[i].Apply(state);
+    }
+  }
+
+  for (const Proposition& prop : old_atoms) {
+    if (!state->contains(prop)) delta->Record(prop, false);
+  }
+  for (const Proposition& prop : *state) {
+    if (!IsInStratum(predicates, stratum, prop.name())) continue;
+    if (!old_atoms.contains(prop)) delta->Record(prop, true);
+  }
+}
+
+}  // namespace
 
 namespace symbolic {
 
 DerivedPredicate::DerivedPredicate(const Pddl& pddl,
                                    const VAL::derivation_rule* symbol)
     : symbol_(symbol) {
+  pddl_ = &pddl;
   name_ = symbol_->get_head()->head->getName();
   parameters_ = Object::CreateList(pddl, symbol_->get_head()->args);
   param_gen_ = ParameterGenerator(pddl, parameters_);
   Preconditions_ = Formula(pddl, symbol_->get_body(), parameters_);
+  body_atoms_ = CreateBodyAtoms(pddl, symbol_->get_body(), parameters_);
+  predicate_hash_ = std::hash<std::string>{}(name_);
 }
 
 bool DerivedPredicate::Apply(State* state) const {
@@ -31,9 +531,9 @@ bool DerivedPredicate::Apply(State* state) const {
     // Keep iterating until predicate converges
     is_iter_changed = false;
     for (const std::vector<Object>& arguments : parameter_generator()) {
-      is_iter_changed |= IsValid(*state, arguments)
-                             ? state->emplace(name(), arguments)
-                             : state->erase(Proposition(name(), arguments));
+      const PropositionRef prop(&name_, &arguments, predicate_hash_);
+      is_iter_changed |= IsValid(*state, arguments) ? state->insert(prop)
+                                                    : state->erase(prop);
     }
     is_changed |= is_iter_changed;
   }
@@ -42,19 +542,89 @@ bool DerivedPredicate::Apply(State* state) const {
 
 bool DerivedPredicate::Apply(const std::vector<DerivedPredicate>& predicates,
                              State* state) {
+  return Apply(predicates, Stratify(predicates), state);
+}
+
+bool DerivedPredicate::Apply(const std::vector<DerivedPredicate>& predicates,
+                             const std::vector<Stratum>& strata,
+                             State* state) {
   bool is_changed = false;
-  bool is_iter_changed = true;
-  while (is_iter_changed) {
-    // Keep iterating until predicates converge
-    is_iter_changed = false;
-    for (const DerivedPredicate& pred : predicates) {
-      is_iter_changed |= pred.Apply(state);
+  for (const Stratum& stratum : strata) {
+    if (!stratum.is_recursive) {
+      // Dependencies have already converged, so a single pass suffices.
+      const DerivedPredicate& pred = predicates[stratum.predicates.front()];
+      for (const std::vector<Object>& arguments : pred.parameter_generator()) {
+        const PropositionRef prop(&pred.name_, &arguments,
+                                  pred.predicate_hash_);
+        is_changed |= pred.IsValid(*state, arguments) ? state->insert(prop)
+                                                      : state->erase(prop);
+      }
+    } else if (stratum.is_stratified) {
+      is_changed |= ApplySemiNaive(predicates, stratum, state);
+    } else {
+      // Recursion through negation: keep iterating until predicates converge.
+      bool is_iter_changed = true;
+      while (is_iter_changed) {
+        is_iter_changed = false;
+        for (size_t i : stratum.predicates) {
+          is_iter_changed |= predicates[i].Apply(state);
+        }
+        is_changed |= is_iter_changed;
+      }
     }
-    is_changed |= is_iter_changed;
   }
   return is_changed;
 }
 
+bool DerivedPredicate::Update(const std::vector<DerivedPredicate>& predicates,
+                              const std::vector<Stratum>& strata,
+                              const State& prev_state, State* state) {
+  if (predicates.empty()) return false;
+
+  State added;
+  State deleted;
+  for (const Proposition& prop : prev_state) {
+    if (!state->contains(prop)) deleted.insert(prop);
+  }
+  for (const Proposition& prop : *state) {
+    if (!prev_state.contains(prop)) added.insert(prop);
+  }
+  return Update(predicates, strata, added, deleted, state);
+}
+
+bool DerivedPredicate::Update(const std::vector<DerivedPredicate>& predicates,
+                              const std::vector<Stratum>& strata,
+                              const State& added, const State& deleted,
+                              State* state) {
+  if (predicates.empty()) return false;
+
+  StateDelta delta(added, deleted);
+  const size_t num_changes = delta.num_records();
+  for (const Stratum& stratum : strata) {
+    if (delta.empty()) break;
+
+    // Skip strata that do not depend on any changed predicate.
+    const bool is_affected = std::any_of(
+        stratum.predicates.begin(), stratum.predicates.end(),
+        [&predicates, &delta](size_t i) {
+          const std::vector<BodyAtom>& atoms = predicates[i].body_atoms();
+          return std::any_of(
+              atoms.begin(), atoms.end(),
+              [&delta](const BodyAtom& atom) { return delta.contains(atom.name); });
+        });
+    if (!is_affected) continue;
+
+    if (!stratum.is_recursive) {
+      UpdateNonRecursive(predicates[stratum.predicates.front()], &delta, state);
+    } else if (stratum.is_stratified) {
+      UpdateDRed(predicates, stratum, &delta, state);
+    } else {
+      UpdateNaive(predicates, stratum, &delta, state);
+    }
+  }
+  return delta.num_records() != num_changes;
+}
+
 State DerivedPredicate::Apply(const State& state,
                               const std::vector<DerivedPredicate>& predicates) {
   State next_state = state;
@@ -62,4 +632,68 @@ State DerivedPredicate::Apply(const State& state,
   return next_state;
 }
 
+std::vector<DerivedPredicate::Stratum> DerivedPredicate::Stratify(
+    const std::vector<DerivedPredicate>& predicates) {
+  return StratumBuilder(predicates).Build();
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "DerivedPredicate.Apply") {
+  const std::vector<DerivedPredicate>& predicates = pddl.derived_predicates();
+
+  // above is recursive, clear is not.
+  const std::vector<DerivedPredicate::Stratum>& strata = pddl.derived_strata();
+  REQUIRE(strata.size() == predicates.size());
+  for (const DerivedPredicate::Stratum& stratum : strata) {
+    const DerivedPredicate& pred = predicates[stratum.predicates.front()];
+    REQUIRE(stratum.is_recursive == (pred.name() == "above"));
+  }
+
+  // Semi-naive evaluation should match naive fixpoint iteration.
+  State state = pddl.initial_state();
+  State state_naive = state;
+  DerivedPredicate::Apply(predicates, strata, &state);
+  bool is_changed = true;
+  while (is_changed) {
+    is_changed = false;
+    for (const DerivedPredicate& pred : predicates) {
+      is_changed |= pred.Apply(&state_naive);
+    }
+  }
+  REQUIRE(state == state_naive);
+  REQUIRE(state.contains(Proposition(pddl, "above(c, table)")));
+  REQUIRE(state.contains(Proposition(pddl, "clear(c)")));
+  REQUIRE_FALSE(state.contains(Proposition(pddl, "clear(a)")));
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "DerivedPredicate.Update") {
+  // Incremental maintenance should match full evaluation along all paths.
+  std::vector<State> states = {pddl.initial_state()};
+  for (size_t depth = 0; depth < 4; depth++) {
+    std::vector<State> next_states;
+    for (const State& state : states) {
+      for (const Action& action : pddl.actions()) {
+        for (const std::vector<Object>& args : action.parameter_generator()) {
+          if (!action.IsValid(state, args)) continue;
+          State next_state = action.Apply(state, args);
+          const State derived_state = pddl.DerivedState(next_state);
+          DerivedPredicate::Update(pddl.derived_predicates(),
+                                   pddl.derived_strata(), state, &next_state);
+          REQUIRE(next_state == derived_state);
+
+          // Updating from the recorded effects should match as well.
+          State recorded_state = state;
+          StateRecorder recorder(&recorded_state);
+          action.Apply(args, &recorder);
+          DerivedPredicate::Update(pddl.derived_predicates(),
+                                   pddl.derived_strata(), recorder.added(),
+                                   recorder.deleted(), &recorded_state);
+          REQUIRE(recorded_state == derived_state);
+          next_states.push_back(std::move(next_state));
+        }
+      }
+    }
+    states = std::move(next_states);
+  }
+}
+
 }  // namespace symbolic
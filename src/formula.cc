@@ -14,20 +14,26 @@
 #include <cassert>        // assert
 #include <exception>      // std::runtime_error
 #include <sstream>        // std::stringstream
+#include <type_traits>    // std::is_same_v
 #include <unordered_map>  // std::unordered_map
 #include <utility>        // std::move
 
 #include "symbolic/pddl.h"
+#include "symbolic/utils/parameter_binder.h"
+#include "symbolic/utils/thread_local_buffer.h"
 
 namespace {
 
 using ::symbolic::Formula;
 using ::symbolic::Object;
+using ::symbolic::ParameterBinder;
 using ::symbolic::ParameterGenerator;
 using ::symbolic::PartialState;
 using ::symbolic::Pddl;
 using ::symbolic::Proposition;
 using ::symbolic::PropositionRef;
+using ::symbolic::State;
+using ::symbolic::ThreadLocalBuffer;
 
 template <typename T>
 using FormulaFunction =
@@ -233,21 +239,32 @@ NamedFormulaFunction<T> CreateForall(const Pddl& pddl,
   const VAL::goal* goal = symbol->getGoal();
   NamedFormulaFunction<T> P_str = CreateFormula<T>(pddl, goal, forall_params);
 
-  FormulaFunction<T> F = [gen = ParameterGenerator(pddl, types),
-                          types = std::move(types), P = std::move(P_str.first)](
-                             const T& state,
-                             const std::vector<Object>& arguments) -> bool {
-    // Loop over forall arguments
-    for (const std::vector<Object>& forall_objs : gen) {
-      // Create forall arguments
+  FormulaFunction<T> F;
+  if constexpr (std::is_same_v<T, State>) {
+    // Search for a binding that violates the formula, pruning argument
+    // prefixes that already satisfy it.
+    F = [binder = ParameterBinder(pddl, goal, forall_params, parameters.size(),
+                                  true)](const T& state,
+                                         const std::vector<Object>& arguments) {
       std::vector<Object> forall_args = arguments;
-      forall_args.insert(forall_args.end(), forall_objs.begin(),
-                         forall_objs.end());
-
-      if (!P(state, forall_args)) return false;
-    }
-    return true;
-  };
+      forall_args.resize(binder.num_parameters());
+      return binder.ForEach(state, &forall_args,
+                            [](const std::vector<Object>&) { return false; });
+    };
+  } else {
+    F = [gen = ParameterGenerator(pddl, types), num_forall = types.size(),
+         P = std::move(P_str.first)](const T& state,
+                                     const std::vector<Object>& arguments) {
+      // Loop over forall arguments written in place after the outer arguments
+      std::vector<Object> forall_args = arguments;
+      forall_args.resize(arguments.size() + num_forall);
+      return gen.ForEachInPlace(
+          &forall_args, arguments.size(),
+          [&P, &state](const std::vector<Object>& args) {
+            return P(state, args);
+          });
+    };
+  }
 
   std::stringstream ss("(forall (");
   std::string delim;
@@ -272,21 +289,31 @@ NamedFormulaFunction<T> CreateExists(const Pddl& pddl,
   const VAL::goal* goal = symbol->getGoal();
   NamedFormulaFunction<T> P_str = CreateFormula<T>(pddl, goal, exists_params);
 
-  FormulaFunction<T> F = [gen = ParameterGenerator(pddl, types),
-                          types = std::move(types), P = std::move(P_str.first)](
-                             const T& state,
-                             const std::vector<Object>& arguments) -> bool {
-    // Loop over exists arguments
-    for (const std::vector<Object>& exists_objs : gen) {
-      // Create exists arguments
+  FormulaFunction<T> F;
+  if constexpr (std::is_same_v<T, State>) {
+    // Search for a binding that satisfies the formula, pruning argument
+    // prefixes that already violate it.
+    F = [binder = ParameterBinder(pddl, goal, exists_params, parameters.size())](
+            const T& state, const std::vector<Object>& arguments) {
       std::vector<Object> exists_args = arguments;
-      exists_args.insert(exists_args.end(), exists_objs.begin(),
-                         exists_objs.end());
-
-      if (P(state, exists_args)) return true;
-    }
-    return false;
-  };
+      exists_args.resize(binder.num_parameters());
+      return !binder.ForEach(state, &exists_args,
+                             [](const std::vector<Object>&) { return false; });
+    };
+  } else {
+    F = [gen = ParameterGenerator(pddl, types), num_exists = types.size(),
+         P = std::move(P_str.first)](const T& state,
+                                     const std::vector<Object>& arguments) {
+      // Loop over exists arguments written in place after the outer arguments
+      std::vector<Object> exists_args = arguments;
+      exists_args.resize(arguments.size() + num_exists);
+      return !gen.ForEachInPlace(
+          &exists_args, arguments.size(),
+          [&P, &state](const std::vector<Object>& args) {
+            return !P(state, args);
+          });
+    };
+  }
 
   std::stringstream ss("(exists (");
   std::string delim;
@@ -379,7 +406,7 @@ ostream& operator<<(ostream& os, const Formula& F) {
 ApplicationFunction Formula::CreateApplicationFunction(
     const std::vector<Object>& action_params,
     const std::vector<Object>& prop_params) {
-  auto prop_args = std::make_shared<std::vector<Object>>(prop_params);
+  const ThreadLocalBuffer<std::vector<Object>> buffer(prop_params);
 
   // List of (prop parameter index, action parameter index) pairs.
   std::vector<std::pair<size_t, size_t>> idx_params;
@@ -391,12 +418,10 @@ ApplicationFunction Formula::CreateApplicationFunction(
     }
   }
 
-  // TODO(tmigimatsu): shared_ptr makes this not thread-safe.
-  return [ptr_prop_args = std::move(prop_args),
-          idx_params =
-              std::move(idx_params)](const std::vector<Object>& action_args)
+  return [buffer, idx_params = std::move(idx_params)](
+             const std::vector<Object>& action_args)
              -> const std::vector<Object>& {
-    std::vector<Object>& prop_args = *ptr_prop_args;
+    std::vector<Object>& prop_args = buffer.get();
     for (const std::pair<size_t, size_t>& idx_prop_action : idx_params) {
       const size_t idx_prop = idx_prop_action.first;
       const size_t idx_action = idx_prop_action.second;
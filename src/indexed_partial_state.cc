@@ -0,0 +1,225 @@
+/**
+ * indexed_partial_state.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/indexed_partial_state.h"
+
+#include <algorithm>  // std::sort
+#include <cassert>    // assert
+#include <stdexcept>  // std::invalid_argument
+#include <utility>    // std::move
+
+#include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace symbolic {
+
+IndexedPartialState::IndexedPartialState(const StateIndex& state_index,
+                                         const PartialState& state)
+    : IndexedPartialState(state_index.size()) {
+  for (const Proposition& prop : state.pos()) {
+    insert(state_index.GetPropositionIndex(prop));
+  }
+  for (const Proposition& prop : state.neg()) {
+    // Overlapping propositions are kept in both vectors, as in PartialState.
+    const size_t idx_prop = state_index.GetPropositionIndex(prop);
+    neg_[idx_prop / kBitsPerWord] |= Mask(idx_prop);
+  }
+}
+
+IndexedPartialState::IndexedPartialState(std::vector<Word>&& pos,
+                                         std::vector<Word>&& neg, size_t size)
+    : pos_(std::move(pos)), neg_(std::move(neg)), size_(size) {
+  if (pos_.size() != NumWords(size_) || neg_.size() != NumWords(size_)) {
+    throw std::invalid_argument(
+        "IndexedPartialState::IndexedPartialState(): Number of words does not "
+        "match the state index size.");
+  }
+
+  // Padding bits past the last proposition have no index.
+  const size_t num_padding = pos_.size() * kBitsPerWord - size_;
+  const Word padding =
+      num_padding == 0 ? 0 : ~Word{0} << (kBitsPerWord - num_padding);
+  if (!pos_.empty() && ((pos_.back() | neg_.back()) & padding) != 0) {
+    throw std::invalid_argument(
+        "IndexedPartialState::IndexedPartialState(): Bits are set past the "
+        "state index size.");
+  }
+  if (!IsConsistent()) {
+    throw std::invalid_argument(
+        "IndexedPartialState::IndexedPartialState(): Propositions are both "
+        "positive and negative.");
+  }
+}
+
+PartialState IndexedPartialState::GetPartialState(
+    const StateIndex& state_index) const {
+  assert(size() == state_index.size());
+  PartialState state;
+
+  // Iterate over set bits of each word.
+  auto AddPropositions = [&state_index](const std::vector<Word>& words,
+                                        State* state) {
+    for (size_t idx_word = 0; idx_word < words.size(); idx_word++) {
+      for (Word word = words[idx_word]; word != 0; word &= word - 1) {
+        const size_t idx_bit = __builtin_ctzll(word);
+        state->insert(
+            state_index.GetProposition(idx_word * kBitsPerWord + idx_bit));
+      }
+    }
+  };
+  AddPropositions(pos_, &state.pos());
+  AddPropositions(neg_, &state.neg());
+
+  return state;
+}
+
+bool IndexedPartialState::IsConsistent() const {
+  for (size_t i = 0; i < pos_.size(); i++) {
+    if (pos_[i] & neg_[i]) return false;
+  }
+  return true;
+}
+
+IndexedFormula::IndexedFormula(const StateIndex& state_index,
+                               const DisjunctiveFormula& dnf) {
+  Compile(state_index, dnf);
+}
+
+IndexedFormula::IndexedFormula(const Pddl& pddl, const Formula& formula,
+                               const std::vector<Object>& parameters,
+                               const std::vector<Object>& arguments) {
+  const std::optional<DisjunctiveFormula> dnf =
+      DisjunctiveFormula::Create(pddl, formula, parameters, arguments);
+  if (!dnf.has_value()) {
+    is_false_ = true;
+    return;
+  }
+  Compile(pddl.state_index(), *dnf);
+}
+
+void IndexedFormula::Compile(const StateIndex& state_index,
+                             const DisjunctiveFormula& dnf) {
+  for (const DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
+    // Collect (word, pos, neg) masks and merge them by word.
+    std::vector<Mask> masks;
+    for (const Proposition& prop : conj.pos()) {
+      const size_t idx_prop = state_index.GetPropositionIndex(prop);
+      masks.push_back({static_cast<uint32_t>(
+                           idx_prop / IndexedPartialState::kBitsPerWord),
+                       IndexedPartialState::Word{1}
+                           << (idx_prop % IndexedPartialState::kBitsPerWord),
+                       0});
+    }
+    for (const Proposition& prop : conj.neg()) {
+      const size_t idx_prop = state_index.GetPropositionIndex(prop);
+      masks.push_back({static_cast<uint32_t>(
+                           idx_prop / IndexedPartialState::kBitsPerWord),
+                       0,
+                       IndexedPartialState::Word{1}
+                           << (idx_prop % IndexedPartialState::kBitsPerWord)});
+    }
+    std::sort(masks.begin(), masks.end(), [](const Mask& a, const Mask& b) {
+      return a.idx_word < b.idx_word;
+    });
+    for (const Mask& mask : masks) {
+      if (masks_.size() > idx_conjunctions_.back() &&
+          masks_.back().idx_word == mask.idx_word) {
+        masks_.back().pos |= mask.pos;
+        masks_.back().neg |= mask.neg;
+      } else {
+        masks_.push_back(mask);
+      }
+    }
+    idx_conjunctions_.push_back(masks_.size());
+  }
+}
+
+std::optional<bool> IndexedFormula::operator()(
+    const IndexedPartialState& state) const {
+  if (is_false_) return false;
+
+  // An empty disjunctive formula is always true.
+  const size_t num_conjunctions = idx_conjunctions_.size() - 1;
+  if (num_conjunctions == 0) return true;
+
+  // Kleene disjunction over the conjunctions.
+  bool is_unknown = false;
+  for (size_t i = 0; i < num_conjunctions; i++) {
+    IndexedPartialState::Word missing = 0;
+    IndexedPartialState::Word violated = 0;
+    for (size_t j = idx_conjunctions_[i]; j < idx_conjunctions_[i + 1]; j++) {
+      const Mask& mask = masks_[j];
+      const IndexedPartialState::Word pos = state.pos()[mask.idx_word];
+      const IndexedPartialState::Word neg = state.neg()[mask.idx_word];
+      missing |= (mask.pos & ~pos) | (mask.neg & ~neg);
+      violated |= (mask.pos & neg) | (mask.neg & pos);
+    }
+    if (violated != 0) continue;  // Conjunction is false
+    if (missing == 0) return true;
+    is_unknown = true;
+  }
+  if (is_unknown) return {};
+  return false;
+}
+
+TEST_CASE_FIXTURE(testing::Fixture, "IndexedFormula") {
+  const StateIndex& state_index = pddl.state_index();
+
+  // Round trip through the packed representation.
+  const PartialState state(pddl, {"inhand(hook)", "inworkspace(table)"},
+                           {"on(hook, table)", "inworkspace(shelf)"});
+  const IndexedPartialState indexed_state(state_index, state);
+  REQUIRE(indexed_state.IsConsistent());
+  REQUIRE(indexed_state.GetPartialState(state_index) == state);
+
+  // Packed words with padding bits or overlapping propositions are rejected.
+  using Words = std::vector<IndexedPartialState::Word>;
+  const size_t num_words = indexed_state.pos().size();
+  REQUIRE_NOTHROW(IndexedPartialState(Words(indexed_state.pos()),
+                                      Words(indexed_state.neg()),
+                                      state_index.size()));
+  Words padding(num_words, 0);
+  padding.back() = IndexedPartialState::Word{1}
+                   << ((state_index.size() - 1) %
+                       IndexedPartialState::kBitsPerWord);
+  if (state_index.size() % IndexedPartialState::kBitsPerWord != 0) {
+    padding.back() <<= 1;
+    REQUIRE_THROWS(IndexedPartialState(Words(padding), Words(num_words, 0),
+                                       state_index.size()));
+  }
+  REQUIRE_THROWS(IndexedPartialState(Words(indexed_state.pos()),
+                                     Words(indexed_state.pos()),
+                                     state_index.size()));
+
+  // Complete partial state with the initial state.
+  PartialState complete_state(pddl.initial_state(), {});
+  for (size_t i = 0; i < state_index.size(); i++) {
+    const Proposition prop = state_index.GetProposition(i);
+    if (!complete_state.pos().contains(prop)) complete_state.erase(prop);
+  }
+  const IndexedPartialState indexed_complete(state_index, complete_state);
+
+  // Three-valued evaluation should agree with the formula closures. The
+  // closures stop at the first unknown proposition, so Kleene evaluation may
+  // be determined where the closures are not.
+  for (const Action& action : pddl.actions()) {
+    for (const std::vector<Object>& args : action.parameter_generator()) {
+      const IndexedFormula formula(pddl, action.preconditions(),
+                                   action.parameters(), args);
+      const std::optional<bool> is_valid = action.IsValid(state, args);
+      if (is_valid.has_value()) {
+        REQUIRE(formula(indexed_state) == is_valid);
+      }
+      REQUIRE(formula(indexed_complete) ==
+              action.IsValid(pddl.initial_state(), args));
+    }
+  }
+}
+
+}  // namespace symbolic
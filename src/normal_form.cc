@@ -11,22 +11,32 @@
 
 #include <VAL/ptree.h>
 
-#include <algorithm>  // std::swap, std::all_of
-#include <cassert>    // assert
-#include <iterator>   // std::make_move_iterator
-#include <optional>   // std::optional
-
+#include <algorithm>      // std::copy, std::fill, std::find, std::stable_sort
+#include <cassert>        // assert
+#include <cstdint>        // uint64_t
+#include <iterator>       // std::make_move_iterator
+#include <optional>       // std::optional
+#include <sstream>        // std::stringstream
+#include <stdexcept>      // std::invalid_argument
+#include <unordered_map>  // std::unordered_map
+
+#include "symbolic/bdd.h"
 #include "symbolic/pddl.h"
-#include "symbolic/utils/combination_generator.h"
+#include "utils/doctest.h"
 
 namespace {
 
+using ::symbolic::BddManager;
 using ::symbolic::DisjunctiveFormula;
 using ::symbolic::Object;
 using ::symbolic::ParameterGenerator;
 using ::symbolic::PartialState;
 using ::symbolic::Pddl;
 using ::symbolic::Proposition;
+using ::symbolic::State;
+
+// Size of a partial product above which Conjoin() falls back to BDDs.
+constexpr size_t kMaxConjunctions = 4096;
 
 std::optional<bool> Negate(const std::optional<bool>& x) {
   return x.has_value() ? !*x : std::optional<bool>{};
@@ -66,6 +76,77 @@ std::optional<bool> EvaluateType(const Pddl& pddl,
              : Negate(EvaluateType(pddl, *formula.neg().begin()));
 }
 
+/**
+ * Whether the proposition is a type predicate on one of the parameters that
+ * is not implied by the parameter type. Its value depends on the object bound
+ * to the parameter, so it cannot be evaluated with the parameter as a
+ * placeholder.
+ */
+bool HasUndecidedType(const Pddl& pddl, const VAL::proposition* prop,
+                      const std::vector<Object>& parameters) {
+  const std::string name_predicate = prop->head->getName();
+  if (pddl.object_map().find(name_predicate) == pddl.object_map().end()) {
+    return false;
+  }
+  for (const Object& arg : Object::CreateList(pddl, prop->args)) {
+    const auto it = std::find(parameters.begin(), parameters.end(), arg);
+    if (it != parameters.end() && !it->type().IsSubtype(name_predicate)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HasUndecidedType(const Pddl& pddl, const VAL::goal* symbol,
+                      const std::vector<Object>& parameters) {
+  const auto* simple_goal = dynamic_cast<const VAL::simple_goal*>(symbol);
+  if (simple_goal != nullptr) {
+    return HasUndecidedType(pddl, simple_goal->getProp(), parameters);
+  }
+
+  const VAL::goal_list* goals = nullptr;
+  if (const auto* conj_goal = dynamic_cast<const VAL::conj_goal*>(symbol)) {
+    goals = conj_goal->getGoals();
+  } else if (const auto* disj_goal =
+                 dynamic_cast<const VAL::disj_goal*>(symbol)) {
+    goals = disj_goal->getGoals();
+  }
+  if (goals != nullptr) {
+    for (const VAL::goal* goal : *goals) {
+      if (HasUndecidedType(pddl, goal, parameters)) return true;
+    }
+    return false;
+  }
+
+  if (const auto* neg_goal = dynamic_cast<const VAL::neg_goal*>(symbol)) {
+    return HasUndecidedType(pddl, neg_goal->getGoal(), parameters);
+  }
+  if (const auto* qfied_goal = dynamic_cast<const VAL::qfied_goal*>(symbol)) {
+    return HasUndecidedType(pddl, qfied_goal->getGoal(), parameters);
+  }
+  return false;
+}
+
+bool HasUndecidedType(const Pddl& pddl, const VAL::effect_lists* symbol,
+                      const std::vector<Object>& parameters) {
+  for (const VAL::forall_effect* effect : symbol->forall_effects) {
+    if (HasUndecidedType(pddl, effect->getEffects(), parameters)) return true;
+  }
+  for (const VAL::simple_effect* effect : symbol->add_effects) {
+    if (HasUndecidedType(pddl, effect->prop, parameters)) return true;
+  }
+  for (const VAL::simple_effect* effect : symbol->del_effects) {
+    if (HasUndecidedType(pddl, effect->prop, parameters)) return true;
+  }
+  for (const VAL::cond_effect* effect : symbol->cond_effects) {
+    if (HasUndecidedType(pddl, effect->getCondition(), parameters) ||
+        HasUndecidedType(pddl, effect->getEffects(), parameters)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 template <typename T>
 bool Contains(const std::vector<T> vals, const T& val) {
   assert(std::is_sorted(vals.begin(), vals.end()));
@@ -84,44 +165,235 @@ void SortUnique(std::vector<T>* vals) {
   vals->erase(last, vals->end());
 }
 
-bool IsSubset(const DisjunctiveFormula::Conjunction& sub,
-              const DisjunctiveFormula::Conjunction& super) {
-  if (sub.size() > super.size()) return false;
+/**
+ * Index of the propositions appearing in a set of formulas, used to encode
+ * conjunctions as bitsets.
+ */
+class PropositionIndex {
+ public:
+  using Word = uint64_t;
+  static constexpr size_t kBitsPerWord = 64;
+
+  void Add(const DisjunctiveFormula& dnf) {
+    for (const DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
+      for (const Proposition& prop : conj.pos()) Add(prop);
+      for (const Proposition& prop : conj.neg()) Add(prop);
+    }
+  }
 
-  for (const Proposition& prop : sub.pos()) {
-    if (!super.pos().contains(prop)) return false;
+  void Add(const Proposition& prop) {
+    if (idx_propositions_.emplace(prop, propositions_.size()).second) {
+      propositions_.push_back(&prop);
+    }
   }
-  for (const Proposition& prop : sub.neg()) {
-    if (!super.neg().contains(prop)) return false;
+
+  size_t at(const Proposition& prop) const {
+    return idx_propositions_.at(prop);
   }
-  return true;
-}
 
-// Try to insert conj as a subset of one of the elements in the conjunctions.
-// If conj is a superset, keep the subset. If conj is neither a subset nor
-// superset, return false.
-bool TryInsertSubset(
-    const DisjunctiveFormula::Conjunction& conj,
-    std::vector<DisjunctiveFormula::Conjunction>* conjunctions) {
-  for (const DisjunctiveFormula::Conjunction& conj_i : *conjunctions) {
-    // If current conjunction is a superset, don't add it
-    if (IsSubset(conj_i, conj)) return true;
+  const Proposition& GetProposition(size_t idx) const {
+    return *propositions_[idx];
+  }
+
+  size_t size() const { return propositions_.size(); }
+
+  size_t num_words() const {
+    return (propositions_.size() + kBitsPerWord - 1) / kBitsPerWord;
+  }
+
+ private:
+  // Pointers to the propositions of the indexed formulas, which must outlive
+  // the index.
+  std::vector<const Proposition*> propositions_;
+  std::unordered_map<Proposition, size_t> idx_propositions_;
+};
+
+/**
+ * Set of conjunctions encoded as positive and negative bitsets, maintained
+ * without subsumed conjunctions.
+ *
+ * Each conjunction is stored contiguously as its positive words followed by
+ * its negative words.
+ */
+class ConjunctionSet {
+ public:
+  using Word = PropositionIndex::Word;
+
+  explicit ConjunctionSet(size_t num_words) : num_words_(num_words) {}
+
+  size_t size() const { return sizes_.size(); }
+  bool empty() const { return sizes_.empty(); }
+
+  size_t num_words() const { return num_words_; }
+  size_t stride() const { return 2 * num_words_; }
+
+  const Word* at(size_t i) const { return &words_[i * stride()]; }
+
+  /**
+   * Encodes the conjunction into the buffer.
+   *
+   * @returns False if the conjunction is contradictory.
+   */
+  bool Encode(const PropositionIndex& index,
+              const DisjunctiveFormula::Conjunction& conj, Word* buffer) const {
+    std::fill(buffer, buffer + stride(), 0);
+    for (const Proposition& prop : conj.pos()) Set(index.at(prop), buffer);
+    for (const Proposition& prop : conj.neg()) {
+      Set(index.at(prop), buffer + num_words_);
+    }
+    return !IsContradiction(buffer);
+  }
+
+  /**
+   * Writes the conjunction of a and b into the buffer.
+   *
+   * @returns False if the result is contradictory.
+   */
+  bool Conjoin(const Word* a, const Word* b, Word* buffer) const {
+    for (size_t i = 0; i < stride(); i++) buffer[i] = a[i] | b[i];
+    return !IsContradiction(buffer);
+  }
+
+  /**
+   * Inserts the conjunction unless it is subsumed by an existing one, and
+   * removes existing conjunctions subsumed by it.
+   *
+   * @returns False if the conjunction is subsumed.
+   */
+  bool Insert(const Word* conj) {
+    const size_t size = Count(conj);
+
+    // Only smaller conjunctions can subsume the new one.
+    for (size_t i = 0; i < sizes_.size(); i++) {
+      if (sizes_[i] <= size && IsSubset(at(i), conj)) return false;
+    }
+
+    // Only larger conjunctions can be subsumed by the new one.
+    for (size_t i = 0; i < sizes_.size();) {
+      if (sizes_[i] > size && IsSubset(conj, at(i))) {
+        Remove(i);
+      } else {
+        i++;
+      }
+    }
+
+    words_.insert(words_.end(), conj, conj + stride());
+    sizes_.push_back(size);
+    return true;
+  }
+
+  DisjunctiveFormula::Conjunction Decode(const PropositionIndex& index,
+                                         size_t i) const {
+    DisjunctiveFormula::Conjunction conj;
+    const Word* words = at(i);
+    auto DecodeWords = [&index, this](const Word* words, State* props) {
+      for (size_t idx_word = 0; idx_word < num_words_; idx_word++) {
+        for (Word word = words[idx_word]; word != 0; word &= word - 1) {
+          const size_t idx_bit = __builtin_ctzll(word);
+          props->insert(index.GetProposition(
+              idx_word * PropositionIndex::kBitsPerWord + idx_bit));
+        }
+      }
+    };
+    DecodeWords(words, &conj.pos());
+    DecodeWords(words + num_words_, &conj.neg());
+    return conj;
+  }
+
+ private:
+  static void Set(size_t idx, Word* words) {
+    words[idx / PropositionIndex::kBitsPerWord] |=
+        Word{1} << (idx % PropositionIndex::kBitsPerWord);
   }
 
-  bool is_subset = false;
-  for (DisjunctiveFormula::Conjunction& conj_i : *conjunctions) {
-    // Current conjunction is a subset: replace previous one
-    if (IsSubset(conj, conj_i)) {
-      is_subset = true;
-      conj_i = conj;
+  bool IsContradiction(const Word* conj) const {
+    for (size_t i = 0; i < num_words_; i++) {
+      if (conj[i] & conj[num_words_ + i]) return true;
     }
+    return false;
   }
 
-  if (is_subset) {
-    SortUnique(conjunctions);
+  bool IsSubset(const Word* sub, const Word* super) const {
+    for (size_t i = 0; i < stride(); i++) {
+      if (sub[i] & ~super[i]) return false;
+    }
+    return true;
+  }
+
+  size_t Count(const Word* conj) const {
+    size_t count = 0;
+    for (size_t i = 0; i < stride(); i++) count += __builtin_popcountll(conj[i]);
+    return count;
+  }
+
+  void Remove(size_t i) {
+    // Overwrite with the last conjunction.
+    const size_t last = sizes_.size() - 1;
+    if (i != last) {
+      std::copy(at(last), at(last) + stride(), &words_[i * stride()]);
+      sizes_[i] = sizes_[last];
+    }
+    words_.resize(last * stride());
+    sizes_.pop_back();
   }
 
-  return is_subset;
+  size_t num_words_;
+  std::vector<Word> words_;
+  std::vector<size_t> sizes_;
+};
+
+/**
+ * Creates the BDD of the disjunction of the conjunctions, with one variable
+ * per indexed proposition.
+ */
+BddManager::Node CreateBdd(const ConjunctionSet& conjunctions,
+                           BddManager* bdd) {
+  using Word = ConjunctionSet::Word;
+  const size_t num_words = conjunctions.num_words();
+  BddManager::Node disj = BddManager::kFalse;
+  for (size_t i = 0; i < conjunctions.size(); i++) {
+    const Word* words = conjunctions.at(i);
+    BddManager::Node conj = BddManager::kTrue;
+    for (size_t idx_word = 0; idx_word < conjunctions.stride(); idx_word++) {
+      const bool is_pos = idx_word < num_words;
+      const size_t offset =
+          (idx_word % num_words) * PropositionIndex::kBitsPerWord;
+      for (Word word = words[idx_word]; word != 0; word &= word - 1) {
+        const auto var =
+            static_cast<BddManager::Variable>(offset + __builtin_ctzll(word));
+        conj = bdd->And(conj, is_pos ? bdd->Var(var) : bdd->NotVar(var));
+      }
+    }
+    disj = bdd->Or(disj, conj);
+  }
+  return disj;
+}
+
+/**
+ * Inserts the paths of the BDD to the true terminal into the conjunction set.
+ *
+ * @param path Buffer of one conjunction, cleared when the function returns.
+ */
+void InsertPaths(const BddManager& bdd, BddManager::Node f,
+                 std::vector<ConjunctionSet::Word>* path,
+                 ConjunctionSet* conjunctions) {
+  if (f == BddManager::kFalse) return;
+  if (f == BddManager::kTrue) {
+    conjunctions->Insert(path->data());
+    return;
+  }
+  const BddManager::Variable var = bdd.variable(f);
+  const size_t idx_word = var / PropositionIndex::kBitsPerWord;
+  const ConjunctionSet::Word bit = ConjunctionSet::Word{1}
+                                   << (var % PropositionIndex::kBitsPerWord);
+
+  (*path)[conjunctions->num_words() + idx_word] |= bit;
+  InsertPaths(bdd, bdd.low(f), path, conjunctions);
+  (*path)[conjunctions->num_words() + idx_word] &= ~bit;
+
+  (*path)[idx_word] |= bit;
+  InsertPaths(bdd, bdd.high(f), path, conjunctions);
+  (*path)[idx_word] &= ~bit;
 }
 
 }  // namespace
@@ -143,35 +415,32 @@ std::optional<bool> Evaluate(const Pddl& pddl,
   if (!conj.IsConsistent()) return false;
 
   // Ensure axioms are satisfied.
-  if (apply_axioms && !Axiom::IsConsistent(pddl.axioms(), conj)) return false;
+  if (apply_axioms && !pddl.IsValidState(conj)) return false;
   return {};
 }
 
-std::optional<DisjunctiveFormula> Simplify(const Pddl& pddl,
-                                           DisjunctiveFormula&& dnf,
-                                           bool apply_axioms) {
-  if (dnf.empty()) return std::move(dnf);
-
+/**
+ * Converts the conjunction set into a sorted DNF.
+ *
+ * Conjunctions are evaluated as in Simplify(). Subsumed conjunctions have
+ * already been removed by the set.
+ */
+std::optional<DisjunctiveFormula> CreateDnf(const Pddl& pddl,
+                                            const PropositionIndex& index,
+                                            const ConjunctionSet& conjunctions,
+                                            bool apply_axioms) {
   DisjunctiveFormula ret;
-  ret.conjunctions.reserve(dnf.conjunctions.size());
-  for (DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
-    // Apply derived predicates to conjunction
-    // TODO(tmigimatsu): Need to generate all combinations of unspecified
-    // predicates (ones not in conj.pos nor conj.neg) to satisfy all possible
-    // derived predicate conditions.
-    // DerivedPredicate::Apply(pddl.derived_predicates(), &conj.pos);
+  ret.conjunctions.reserve(conjunctions.size());
+  for (size_t i = 0; i < conjunctions.size(); i++) {
+    DisjunctiveFormula::Conjunction conj = conjunctions.Decode(index, i);
 
     // Evaluate conjunction
     const std::optional<bool> is_true = Evaluate(pddl, conj, apply_axioms);
     if (!is_true.has_value()) {
-      if (!TryInsertSubset(conj, &ret.conjunctions)) {
-        // Current conjunction is not a subset or superset: append it
-        ret.conjunctions.push_back(std::move(conj));
-      }
+      ret.conjunctions.push_back(std::move(conj));
     } else if (*is_true) {
       // Conjunction is true: short-circuit disjunction and return empty formula
-      ret.conjunctions.clear();
-      return std::move(ret);
+      return DisjunctiveFormula();
     }
 
     // Conjunction is false: discard it from the disjunction
@@ -186,6 +455,30 @@ std::optional<DisjunctiveFormula> Simplify(const Pddl& pddl,
   return std::move(ret);
 }
 
+std::optional<DisjunctiveFormula> Simplify(const Pddl& pddl,
+                                           DisjunctiveFormula&& dnf,
+                                           bool apply_axioms) {
+  if (dnf.empty()) return std::move(dnf);
+
+  // TODO(tmigimatsu): Need to generate all combinations of unspecified
+  // predicates (ones not in conj.pos nor conj.neg) to satisfy all possible
+  // derived predicate conditions.
+  // DerivedPredicate::Apply(pddl.derived_predicates(), &conj.pos);
+
+  PropositionIndex index;
+  index.Add(dnf);
+
+  // Remove contradictory and subsumed conjunctions.
+  ConjunctionSet conjunctions(index.num_words());
+  std::vector<PropositionIndex::Word> buffer(conjunctions.stride());
+  for (const DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
+    if (!conjunctions.Encode(index, conj, buffer.data())) continue;
+    conjunctions.Insert(buffer.data());
+  }
+
+  return CreateDnf(pddl, index, conjunctions, apply_axioms);
+}
+
 std::optional<DisjunctiveFormula> Disjoin(
     const Pddl& pddl, std::vector<DisjunctiveFormula>&& dnfs,
     bool apply_axioms) {
@@ -198,35 +491,83 @@ std::optional<DisjunctiveFormula> Disjoin(
   return Simplify(pddl, std::move(disj), apply_axioms);
 }
 
+/**
+ * Conjoins the DNFs by multiplying them out.
+ *
+ * If a partial product exceeds max_conjunctions, the remaining factors are
+ * conjoined as BDDs instead, which stay compact when the explicit product
+ * blows up, and the DNF is read off the paths of the resulting BDD.
+ */
 std::optional<DisjunctiveFormula> Conjoin(
     const Pddl& pddl, const std::vector<DisjunctiveFormula>& dnfs,
-    bool apply_axioms) {
+    bool apply_axioms, size_t max_conjunctions = kMaxConjunctions) {
   // ((a | b) & (c | d) & (e | f))
   // ((a & c & e) | ...)
-  DisjunctiveFormula conj;
 
-  // Create combination generator for conjunctions
-  std::vector<const std::vector<DisjunctiveFormula::Conjunction>*> conjunctions;
-  conjunctions.reserve(dnfs.size());
+  // Conjoin the smallest disjunctions first to keep the product small.
+  std::vector<const DisjunctiveFormula*> terms;
+  terms.reserve(dnfs.size());
+  PropositionIndex index;
   for (const DisjunctiveFormula& dnf : dnfs) {
     if (dnf.empty()) continue;
-    conjunctions.push_back(&dnf.conjunctions);
+    terms.push_back(&dnf);
+    index.Add(dnf);
   }
-  CombinationGenerator<const std::vector<DisjunctiveFormula::Conjunction>> gen(
-      conjunctions);
+  if (terms.empty()) return DisjunctiveFormula();
+  std::stable_sort(terms.begin(), terms.end(),
+                   [](const DisjunctiveFormula* a, const DisjunctiveFormula* b) {
+                     return a->conjunctions.size() < b->conjunctions.size();
+                   });
+
+  // Start with the true conjunction.
+  ConjunctionSet product(index.num_words());
+  std::vector<PropositionIndex::Word> buffer(product.stride(), 0);
+  product.Insert(buffer.data());
+
+  std::vector<PropositionIndex::Word> term_i(product.stride());
+  for (auto it = terms.begin(); it != terms.end(); ++it) {
+    // Contradictions and subsumed conjunctions are pruned after every
+    // factor, so the product only grows with the number of minimal terms.
+    ConjunctionSet next(index.num_words());
+    for (const DisjunctiveFormula::Conjunction& conj : (*it)->conjunctions) {
+      if (!product.Encode(index, conj, term_i.data())) continue;
+      for (size_t i = 0; i < product.size(); i++) {
+        if (!product.Conjoin(product.at(i), term_i.data(), buffer.data())) {
+          continue;
+        }
+        next.Insert(buffer.data());
+      }
+      if (next.size() > max_conjunctions) break;
+    }
 
-  // Iterate over all combinations
-  for (const std::vector<DisjunctiveFormula::Conjunction>& combo : gen) {
-    State pos;
-    State neg;
-    for (const DisjunctiveFormula::Conjunction& term_i : combo) {
-      pos.insert(term_i.pos().begin(), term_i.pos().end());
-      neg.insert(term_i.neg().begin(), term_i.neg().end());
+    if (next.size() > max_conjunctions) {
+      // Fall back to conjoining the remaining factors as BDDs.
+      BddManager bdd(index.size());
+      BddManager::Node f = CreateBdd(product, &bdd);
+      for (; it != terms.end() && f != BddManager::kFalse; ++it) {
+        ConjunctionSet factor(index.num_words());
+        for (const DisjunctiveFormula::Conjunction& conj :
+             (*it)->conjunctions) {
+          if (!factor.Encode(index, conj, term_i.data())) continue;
+          factor.Insert(term_i.data());
+        }
+        f = bdd.And(f, CreateBdd(factor, &bdd));
+      }
+      if (f == BddManager::kFalse) return {};
+
+      std::fill(buffer.begin(), buffer.end(), 0);
+      product = ConjunctionSet(index.num_words());
+      InsertPaths(bdd, f, &buffer, &product);
+      break;
     }
-    conj.conjunctions.emplace_back(std::move(pos), std::move(neg));
+
+    // All conjunctions are contradictory: terminate early.
+    if (next.empty()) return {};
+
+    product = std::move(next);
   }
 
-  return Simplify(pddl, std::move(conj), apply_axioms);
+  return CreateDnf(pddl, index, product, apply_axioms);
 }
 
 ConjunctiveFormula Flip(DisjunctiveFormula&& dnf) {
@@ -481,67 +822,28 @@ std::optional<std::pair<DisjunctiveFormula, DisjunctiveFormula>>
 DisjunctiveFormula::NormalizeConditions(const Pddl& pddl,
                                         const std::string& action_call,
                                         bool apply_axioms) {
-  const auto aa = Action::Parse(pddl, action_call);
-  std::optional<DisjunctiveFormula> pre =
-      DisjunctiveFormula::Create(pddl, aa.first.preconditions().symbol(),
-                                 aa.first.parameters(), aa.second);
-  if (!pre.has_value()) return {};
-  std::optional<DisjunctiveFormula> post = DisjunctiveFormula::Create(
-      pddl, aa.first.postconditions(), aa.first.parameters(), aa.second);
-  if (!post.has_value()) return {};
-
-  if (apply_axioms) {
-    std::vector<DisjunctiveFormula::Conjunction> conj_pre;
-    conj_pre.reserve(pre->conjunctions.size());
-    for (const DisjunctiveFormula::Conjunction& conj : pre->conjunctions) {
-      conj_pre.push_back(pddl.ConsistentState(conj));
-    }
-    std::vector<DisjunctiveFormula::Conjunction> conj_post;
-    conj_post.reserve(post->conjunctions.size());
-    for (const DisjunctiveFormula::Conjunction& conj : post->conjunctions) {
-      conj_post.push_back(pddl.ConsistentState(conj));
-    }
-    return std::make_pair(DisjunctiveFormula(std::move(conj_pre)),
-                          DisjunctiveFormula(std::move(conj_post)));
+  NormalFormCache::Conditions conditions =
+      pddl.normal_form_cache().NormalizeConditions(pddl, action_call,
+                                                   apply_axioms);
+  if (!conditions.first.has_value() || !conditions.second.has_value()) {
+    return {};
   }
-  return std::make_pair(std::move(*pre), std::move(*post));
+  return std::make_pair(std::move(*conditions.first),
+                        std::move(*conditions.second));
 }
 
 std::optional<DisjunctiveFormula> DisjunctiveFormula::NormalizePreconditions(
     const Pddl& pddl, const std::string& action_call, bool apply_axioms) {
-  const auto aa = Action::Parse(pddl, action_call);
-  std::optional<DisjunctiveFormula> pre =
-      DisjunctiveFormula::Create(pddl, aa.first.preconditions().symbol(),
-                                 aa.first.parameters(), aa.second);
-  if (!pre.has_value()) return pre;
-
-  if (apply_axioms) {
-    std::vector<DisjunctiveFormula::Conjunction> conj_pre;
-    conj_pre.reserve(pre->conjunctions.size());
-    for (const DisjunctiveFormula::Conjunction& conj : pre->conjunctions) {
-      conj_pre.push_back(pddl.ConsistentState(conj));
-    }
-    pre = DisjunctiveFormula(std::move(conj_pre));
-  }
-  return pre;
+  return pddl.normal_form_cache()
+      .NormalizeConditions(pddl, action_call, apply_axioms)
+      .first;
 }
 
 std::optional<DisjunctiveFormula> DisjunctiveFormula::NormalizePostconditions(
     const Pddl& pddl, const std::string& action_call, bool apply_axioms) {
-  const auto aa = Action::Parse(pddl, action_call);
-  std::optional<DisjunctiveFormula> post = DisjunctiveFormula::Create(
-      pddl, aa.first.postconditions(), aa.first.parameters(), aa.second);
-  if (!post.has_value()) return post;
-
-  if (apply_axioms) {
-    std::vector<DisjunctiveFormula::Conjunction> conj_post;
-    conj_post.reserve(post->conjunctions.size());
-    for (const DisjunctiveFormula::Conjunction& conj : post->conjunctions) {
-      conj_post.push_back(pddl.ConsistentState(conj));
-    }
-    post = DisjunctiveFormula(std::move(conj_post));
-  }
-  return post;
+  return pddl.normal_form_cache()
+      .NormalizeConditions(pddl, action_call, apply_axioms)
+      .second;
 }
 
 std::optional<DisjunctiveFormula> DisjunctiveFormula::NormalizeGoal(
@@ -561,6 +863,192 @@ std::optional<DisjunctiveFormula> DisjunctiveFormula::NormalizeGoal(
   return goal;
 }
 
+NormalFormCache::Conditions NormalFormCache::NormalizeConditions(
+    const Pddl& pddl, const std::string& action_call, bool apply_axioms) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  LruCache<std::string, Conditions>& ground_conditions =
+      apply_axioms ? ground_conditions_axioms_ : ground_conditions_;
+
+  // Check cache
+  const Conditions* cached = ground_conditions.find(action_call);
+  if (cached != nullptr) return *cached;
+
+  // Parse action call
+  const LiftedAction& lifted =
+      GetLiftedAction(pddl, Proposition::ParseHead(action_call));
+  const Action& action = pddl.actions()[lifted.idx_action];
+  const std::vector<Object> args = Object::ParseArguments(pddl, action_call);
+  if (args.size() != action.parameters().size()) {
+    std::stringstream ss;
+    ss << "NormalFormCache::NormalizeConditions(): action " << action
+       << " requires " << action.parameters().size()
+       << " arguments but received " << args.size() << ": " << action_call
+       << ".";
+    throw std::invalid_argument(ss.str());
+  }
+  for (size_t i = 0; i < args.size(); i++) {
+    const Object& param = action.parameters()[i];
+    if (!args[i].type().IsSubtype(param.type())) {
+      std::stringstream ss;
+      ss << "NormalFormCache::NormalizeConditions(): action " << action
+         << " requires parameter " << param << " to be of type "
+         << param.type() << " but received " << args[i] << ": " << action_call
+         << ".";
+      throw std::invalid_argument(ss.str());
+    }
+  }
+
+  Conditions conditions;
+  if (lifted.is_lifted) {
+    conditions.first = Instantiate(pddl, lifted.pre, args);
+    conditions.second = Instantiate(pddl, lifted.post, args);
+  } else {
+    conditions.first = DisjunctiveFormula::Create(
+        pddl, action.preconditions().symbol(), action.parameters(), args);
+    conditions.second = DisjunctiveFormula::Create(
+        pddl, action.postconditions(), action.parameters(), args);
+  }
+
+  if (apply_axioms) {
+    for (std::optional<DisjunctiveFormula>* dnf :
+         {&conditions.first, &conditions.second}) {
+      if (!dnf->has_value()) continue;
+      for (DisjunctiveFormula::Conjunction& conj : (*dnf)->conjunctions) {
+        conj = pddl.ConsistentState(conj);
+      }
+    }
+  }
+  return ground_conditions.insert(action_call, std::move(conditions));
+}
+
+const NormalFormCache::LiftedAction& NormalFormCache::GetLiftedAction(
+    const Pddl& pddl, const std::string& name_action) {
+  const auto it = lifted_actions_.find(name_action);
+  if (it != lifted_actions_.end()) return it->second;
+
+  const auto it_action =
+      std::find_if(pddl.actions().begin(), pddl.actions().end(),
+                   [&name_action](const Action& action) {
+                     return action.name() == name_action;
+                   });
+  if (it_action == pddl.actions().end()) {
+    throw std::invalid_argument(
+        "NormalFormCache::GetLiftedAction(): Action " + name_action +
+        " does not exist.");
+  }
+
+  const Action& action = *it_action;
+  const std::vector<Object>& params = action.parameters();
+  LiftedAction lifted;
+  lifted.idx_action = it_action - pddl.actions().begin();
+
+  // Objects are compared by name, so parameters can only serve as placeholders
+  // if they don't share a name with an object. Type predicates on parameters
+  // must also be implied by the parameter types, since otherwise they would
+  // be evaluated to false before the arguments are bound.
+  lifted.is_lifted =
+      !HasUndecidedType(pddl, action.preconditions().symbol(), params) &&
+      !HasUndecidedType(pddl, action.postconditions(), params);
+  for (const Object& param : params) {
+    for (const Object& obj : pddl.objects()) {
+      if (param.name() == obj.name()) lifted.is_lifted = false;
+    }
+  }
+  if (!lifted.is_lifted) {
+    return lifted_actions_.emplace(name_action, std::move(lifted))
+        .first->second;
+  }
+
+  // Normalize the conditions with the parameters as arguments.
+  lifted.pre = Lift(params, DisjunctiveFormula::Create(
+                                pddl, action.preconditions().symbol(), params,
+                                params));
+  lifted.post = Lift(params, DisjunctiveFormula::Create(
+                                 pddl, action.postconditions(), params, params));
+  return lifted_actions_.emplace(name_action, std::move(lifted)).first->second;
+}
+
+NormalFormCache::LiftedFormula NormalFormCache::Lift(
+    const std::vector<Object>& parameters,
+    std::optional<DisjunctiveFormula>&& dnf) {
+  if (!dnf.has_value()) return {};
+
+  auto LiftPropositions = [&parameters](const State& props) {
+    std::vector<LiftedProposition> lifted_props;
+    lifted_props.reserve(props.size());
+    for (const Proposition& prop : props) {
+      LiftedProposition lifted_prop{prop.name(), prop.arguments(), {}};
+      lifted_prop.idx_parameters.reserve(prop.arguments().size());
+      for (const Object& arg : prop.arguments()) {
+        const auto it = std::find(parameters.begin(), parameters.end(), arg);
+        lifted_prop.idx_parameters.push_back(
+            it == parameters.end() ? -1
+                                   : static_cast<int>(it - parameters.begin()));
+      }
+      lifted_props.push_back(std::move(lifted_prop));
+    }
+    return lifted_props;
+  };
+
+  std::vector<LiftedConjunction> lifted;
+  lifted.reserve(dnf->conjunctions.size());
+  for (const DisjunctiveFormula::Conjunction& conj : dnf->conjunctions) {
+    lifted.push_back({LiftPropositions(conj.pos()), LiftPropositions(conj.neg())});
+  }
+  return lifted;
+}
+
+std::optional<DisjunctiveFormula> NormalFormCache::Instantiate(
+    const Pddl& pddl, const LiftedFormula& formula,
+    const std::vector<Object>& arguments) {
+  if (!formula.has_value()) return {};
+  if (formula->empty()) return DisjunctiveFormula();
+
+  // Substitutes the arguments and evaluates = and type predicates, which may
+  // not have been decidable for the lifted formula. Returns false if the
+  // literal is false and should invalidate the conjunction.
+  auto AddLiteral = [&pddl, &arguments](const LiftedProposition& lifted_prop,
+                                        bool is_pos, State* props) {
+    std::vector<Object> args = lifted_prop.arguments;
+    for (size_t i = 0; i < args.size(); i++) {
+      const int idx_param = lifted_prop.idx_parameters[i];
+      if (idx_param >= 0) args[i] = arguments[idx_param];
+    }
+    Proposition prop(lifted_prop.name, std::move(args));
+
+    std::optional<bool> is_true = EvaluateEquals(prop);
+    if (!is_true.has_value()) is_true = EvaluateType(pddl, prop);
+    if (is_true.has_value()) return *is_true == is_pos;
+
+    props->insert(std::move(prop));
+    return true;
+  };
+
+  DisjunctiveFormula dnf;
+  dnf.conjunctions.reserve(formula->size());
+  for (const LiftedConjunction& lifted_conj : *formula) {
+    DisjunctiveFormula::Conjunction conj;
+    bool is_valid = true;
+    for (const LiftedProposition& prop : lifted_conj.pos) {
+      is_valid &= AddLiteral(prop, true, &conj.pos());
+    }
+    for (const LiftedProposition& prop : lifted_conj.neg) {
+      is_valid &= AddLiteral(prop, false, &conj.neg());
+    }
+    if (!is_valid) continue;
+
+    // Conjunction is true: short-circuit disjunction and return empty formula
+    if (conj.empty()) return DisjunctiveFormula();
+
+    dnf.conjunctions.push_back(std::move(conj));
+  }
+
+  // If all conjunctions were false, return null
+  if (dnf.empty()) return {};
+
+  return Simplify(pddl, std::move(dnf), false);
+}
+
 std::ostream& operator<<(std::ostream& os, const DisjunctiveFormula& dnf) {
   os << "(or" << std::endl;
   for (const DisjunctiveFormula::Conjunction& conj : dnf.conjunctions) {
@@ -593,3 +1081,117 @@ std::ostream& operator<<(std::ostream& os, const ConjunctiveFormula& cnf) {
 }
 
 }  // namespace symbolic
+
+namespace {
+
+// Normalizes the conditions directly from the action formulas.
+symbolic::NormalFormCache::Conditions NormalizeConditionsUncached(
+    const Pddl& pddl, const symbolic::Action& action,
+    const std::vector<Object>& args) {
+  return {DisjunctiveFormula::Create(pddl, action.preconditions().symbol(),
+                                     action.parameters(), args),
+          DisjunctiveFormula::Create(pddl, action.postconditions(),
+                                     action.parameters(), args)};
+}
+
+void TestNormalFormCache(const Pddl& pddl) {
+  symbolic::NormalFormCache cache(8);
+  for (size_t i = 0; i < 2; i++) {
+    for (const symbolic::Action& action : pddl.actions()) {
+      for (const std::vector<Object>& args : action.parameter_generator()) {
+        const std::string action_call = action.to_string(args);
+        symbolic::NormalFormCache::Conditions expected =
+            NormalizeConditionsUncached(pddl, action, args);
+        REQUIRE(cache.NormalizeConditions(pddl, action_call, false) ==
+                expected);
+
+        // Lifted conditions with axioms should match the consistent states of
+        // the uncached conditions.
+        for (std::optional<DisjunctiveFormula>* dnf :
+             {&expected.first, &expected.second}) {
+          if (!dnf->has_value()) continue;
+          for (PartialState& conj : (*dnf)->conjunctions) {
+            conj = pddl.ConsistentState(conj);
+          }
+        }
+        REQUIRE(cache.NormalizeConditions(pddl, action_call, true) ==
+                expected);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+namespace symbolic {
+
+TEST_CASE_FIXTURE(testing::Fixture, "DisjunctiveFormula.Negate") {
+  const Proposition p(pddl, "inhand(hook)");
+  const Proposition q(pddl, "inworkspace(box)");
+  const Proposition r(pddl, "on(box, table)");
+
+  // !((p & q) | (p & r)) = !p | (!q & !r), with subsumed terms absorbed.
+  const std::optional<DisjunctiveFormula> neg =
+      Negate(pddl, DisjunctiveFormula({PartialState({p, q}, {}),
+                                       PartialState({p, r}, {})}));
+  REQUIRE(neg.has_value());
+  REQUIRE(neg->conjunctions.size() == 2);
+  const PartialState not_p({}, {p});
+  const PartialState not_q_r({}, {q, r});
+  for (const PartialState& conj : neg->conjunctions) {
+    REQUIRE((conj == not_p || conj == not_q_r));
+  }
+
+  // !(p | !p) is false.
+  REQUIRE_FALSE(Negate(pddl, DisjunctiveFormula({PartialState({p}, {}),
+                                                 PartialState({}, {p})}))
+                    .has_value());
+}
+
+TEST_CASE_FIXTURE(testing::Fixture, "DisjunctiveFormula.Conjoin") {
+  const Proposition p(pddl, "inhand(hook)");
+  const Proposition q(pddl, "inworkspace(box)");
+  const Proposition r(pddl, "on(box, table)");
+  const Proposition s(pddl, "inworkspace(hook)");
+
+  // (p | q) & (r | s) & (!p | !r) multiplies out to more than 2 terms.
+  const std::vector<DisjunctiveFormula> dnfs = {
+      DisjunctiveFormula({PartialState({p}, {}), PartialState({q}, {})}),
+      DisjunctiveFormula({PartialState({r}, {}), PartialState({s}, {})}),
+      DisjunctiveFormula({PartialState({}, {p}), PartialState({}, {r})})};
+  const std::optional<DisjunctiveFormula> product = Conjoin(pddl, dnfs, false);
+  REQUIRE(product.has_value());
+  REQUIRE(product->conjunctions.size() > 2);
+
+  // Exceeding the limit should fall back to BDDs with an equivalent result.
+  BddManager bdd(pddl);
+  for (const size_t max_conjunctions : {0, 2}) {
+    const std::optional<DisjunctiveFormula> fallback =
+        Conjoin(pddl, dnfs, false, max_conjunctions);
+    REQUIRE(fallback.has_value());
+    REQUIRE(bdd.Create(*fallback) == bdd.Create(*product));
+  }
+
+  // p & (!p | q) & !q is false.
+  REQUIRE_FALSE(Conjoin(pddl,
+                        {DisjunctiveFormula({PartialState({p}, {})}),
+                         DisjunctiveFormula({PartialState({}, {p}),
+                                             PartialState({q}, {})}),
+                         DisjunctiveFormula({PartialState({}, {q})})},
+                        false, 0)
+                    .has_value());
+}
+
+TEST_CASE_FIXTURE(testing::Fixture, "NormalFormCache") {
+  TestNormalFormCache(pddl);
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "NormalFormCache.Blocks") {
+  TestNormalFormCache(pddl);
+}
+
+TEST_CASE_FIXTURE(testing::AxiomsFixture, "NormalFormCache.Axioms") {
+  TestNormalFormCache(pddl);
+}
+
+}  // namespace symbolic
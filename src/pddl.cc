@@ -13,11 +13,13 @@
 #include <VAL/ptree.h>
 #include <VAL/typecheck.h>
 
-#include <fstream>  // std::ifstream
-#include <sstream>  // std::stringstream
-#include <string>   // std::string
-#include <utility>  // std::move
+#include <fstream>    // std::ifstream
+#include <sstream>    // std::stringstream
+#include <stdexcept>  // std::invalid_argument
+#include <string>     // std::string
+#include <utility>    // std::move, std::pair
 
+#include "symbolic/normal_form.h"
 #include "symbolic/utils/parameter_generator.h"
 #include "utils/doctest.h"
 
@@ -109,7 +111,10 @@ using ::symbolic::PartialState;
 using ::symbolic::Pddl;
 using ::symbolic::Predicate;
 using ::symbolic::Proposition;
+using ::symbolic::SignedProposition;
 using ::symbolic::State;
+using ::symbolic::StateIndex;
+using ::symbolic::StateRecorder;
 
 State ParseState(const Pddl& pddl, const std::set<std::string>& str_state) {
   State state;
@@ -191,15 +196,18 @@ void UpdateAxioms(const Pddl& pddl,
   }
 }
 
-std::unordered_map<std::string, std::vector<std::weak_ptr<Axiom>>>
-CreateAxiomContextMap(const std::vector<std::shared_ptr<Axiom>>& axioms) {
-  std::unordered_map<std::string, std::vector<std::weak_ptr<Axiom>>> axiom_map(
-      axioms.size());
+std::vector<std::vector<const Axiom*>> CreateAxiomTriggers(
+    const std::vector<std::shared_ptr<Axiom>>& axioms,
+    const StateIndex& state_index) {
+  std::vector<std::vector<const Axiom*>> axiom_triggers(
+      2 * state_index.num_predicates());
   for (const std::shared_ptr<Axiom>& axiom : axioms) {
-    axiom_map[axiom->context().sign() + axiom->context().name()].emplace_back(
-        axiom);
+    const SignedProposition& context = axiom->context();
+    const int idx_predicate = state_index.GetPredicateIndex(context.name());
+    if (idx_predicate < 0) continue;
+    axiom_triggers[2 * idx_predicate + context.is_pos()].push_back(axiom.get());
   }
-  return axiom_map;
+  return axiom_triggers;
 }
 
 std::vector<DerivedPredicate> GetDerivedPredicates(const Pddl& pddl,
@@ -228,18 +236,58 @@ State GetInitialState(const VAL::domain& domain, const VAL::problem& problem) {
   return initial_state;
 }
 
+/**
+ * Parses the action call into one of the actions of the pddl, which avoids
+ * compiling the action again as Action::Parse() does.
+ */
+std::pair<const Action*, std::vector<Object>> ParseAction(
+    const Pddl& pddl, const std::string& action_call) {
+  const std::string name_action = Proposition::ParseHead(action_call);
+  std::vector<Object> arguments = Object::ParseArguments(pddl, action_call);
+  const auto IsValid = [&arguments](const Action& action) {
+    if (action.parameters().size() != arguments.size()) return false;
+    for (size_t i = 0; i < arguments.size(); i++) {
+      const Object& param = action.parameters()[i];
+      if (!arguments[i].type().IsSubtype(param.type())) return false;
+    }
+    return true;
+  };
+  for (const Action& action : pddl.actions()) {
+    if (action.name() == name_action && IsValid(action)) {
+      return {&action, std::move(arguments)};
+    }
+  }
+
+  // Let Action::Parse() report why the action call is invalid.
+  Action::Parse(pddl, action_call);
+  throw std::invalid_argument("ParseAction(): Invalid action call " +
+                              action_call + ".");
+}
+
 State Apply(const State& state, const Action& action,
-            const std::vector<Object>& arguments,
-            const std::vector<DerivedPredicate>& predicates) {
+            const std::vector<Object>& arguments, const Pddl& pddl) {
+  // The derived predicates of a state from the caller may be stale, so they
+  // are recomputed from scratch.
   State next_state = action.Apply(state, arguments);
-  DerivedPredicate::Apply(predicates, &next_state);
+  DerivedPredicate::Apply(pddl.derived_predicates(), pddl.derived_strata(),
+                          &next_state);
   return next_state;
 }
 
+/**
+ * Applies the action and updates the derived predicates incrementally, so the
+ * derived predicates must be up to date in the given state.
+ */
 bool Apply(const Action& action, const std::vector<Object>& arguments,
-           const std::vector<DerivedPredicate>& predicates, State* state) {
-  bool is_changed = action.Apply(arguments, state);
-  is_changed |= DerivedPredicate::Apply(predicates, state);
+           const Pddl& pddl, State* state) {
+  if (pddl.derived_predicates().empty()) return action.Apply(arguments, state);
+
+  StateRecorder recorder(state);
+  bool is_changed = action.Apply(arguments, &recorder);
+  is_changed |= DerivedPredicate::Update(pddl.derived_predicates(),
+                                         pddl.derived_strata(),
+                                         recorder.added(), recorder.deleted(),
+                                         state);
   return is_changed;
 }
 
@@ -258,25 +306,31 @@ Pddl::Pddl(const std::string& domain_pddl, const std::string& problem_pddl,
       axioms_(GetAxioms(*this, *analysis_->the_domain)),
       predicates_(GetPredicates(*this, *analysis_->the_domain)),
       derived_predicates_(GetDerivedPredicates(*this, *analysis_->the_domain)),
+      derived_strata_(DerivedPredicate::Stratify(derived_predicates_)),
       state_index_(predicates_),
       initial_state_(
           GetInitialState(*analysis_->the_domain, *analysis_->the_problem)),
       goal_(*this, analysis_->the_problem->the_goal) {
-  // Create axiom map after initialization list to avoid conflicts with
-  // GetAxioms(), which accesses the axiom map during the construction of DNFs.
-  axiom_map_ = CreateAxiomContextMap(axioms());
+  // Create axiom triggers after initialization list to avoid conflicts with
+  // GetAxioms(), which accesses the triggers during the construction of DNFs.
+  axiom_triggers_ = CreateAxiomTriggers(axioms(), state_index_);
 
-  // Recreate axioms with updated axiom map. Axioms need to be pointers so
-  // that they can be updated and remain usable from Action::Apply() lambdas
-  // while handling axiom loops.
+  // Recreate axioms with updated axiom triggers. Axioms need to be pointers
+  // so that they can be updated and remain usable from Action::Apply()
+  // lambdas while handling axiom loops.
   UpdateAxioms(*this, &axioms_);
+  axiom_propagator_ = std::make_shared<const AxiomPropagator>(*this, axioms_);
 
   // Create actions after all axioms have settled.
   actions_ = GetActions(*this, *analysis_->the_domain);
+  normal_form_cache_ = std::make_shared<NormalFormCache>();
 
   if (apply_axioms) {
     initial_state_ = ConsistentState(initial_state_);
   }
+
+  // Derived predicates are maintained incrementally from the initial state.
+  initial_state_ = DerivedState(initial_state_);
 }
 
 Pddl::Pddl(const std::string& domain_pddl)
@@ -287,18 +341,21 @@ Pddl::Pddl(const std::string& domain_pddl)
       axioms_(GetAxioms(*this, *analysis_->the_domain)),
       predicates_(GetPredicates(*this, *analysis_->the_domain)),
       derived_predicates_(GetDerivedPredicates(*this, *analysis_->the_domain)),
+      derived_strata_(DerivedPredicate::Stratify(derived_predicates_)),
       state_index_(predicates_) {
-  // Create axiom map after initialization list to avoid conflicts with
-  // GetAxioms(), which accesses the axiom map during the construction of DNFs.
-  axiom_map_ = CreateAxiomContextMap(axioms());
+  // Create axiom triggers after initialization list to avoid conflicts with
+  // GetAxioms(), which accesses the triggers during the construction of DNFs.
+  axiom_triggers_ = CreateAxiomTriggers(axioms(), state_index_);
 
-  // Recreate axioms with updated axiom map. Axioms need to be pointers so
-  // that they can be updated and remain usable from Action::Apply() lambdas
-  // while handling axiom loops.
+  // Recreate axioms with updated axiom triggers. Axioms need to be pointers
+  // so that they can be updated and remain usable from Action::Apply()
+  // lambdas while handling axiom loops.
   UpdateAxioms(*this, &axioms_);
+  axiom_propagator_ = std::make_shared<const AxiomPropagator>(*this, axioms_);
 
   // Create actions after all axioms have settled.
   actions_ = GetActions(*this, *analysis_->the_domain);
+  normal_form_cache_ = std::make_shared<NormalFormCache>();
 }
 
 bool Pddl::IsValid(bool verbose, std::ostream& os) const {
@@ -319,15 +376,27 @@ bool Pddl::IsValid(bool verbose, std::ostream& os) const {
 
 TEST_CASE_FIXTURE(testing::Fixture, "Pddl.IsValid") { REQUIRE(pddl.IsValid()); }
 
+const std::vector<const Axiom*>& Pddl::axiom_triggers(
+    const std::string& name_predicate, bool is_pos) const {
+  static const std::vector<const Axiom*> kNoAxioms;
+
+  // Axioms are created before the triggers during construction.
+  if (axiom_triggers_.empty()) return kNoAxioms;
+
+  const int idx_predicate = state_index_.GetPredicateIndex(name_predicate);
+  if (idx_predicate < 0) return kNoAxioms;
+  return axiom_triggers_[2 * idx_predicate + is_pos];
+}
+
 State Pddl::NextState(const State& state,
                       const std::string& action_call) const {
   // Parse strings
-  const std::pair<Action, std::vector<Object>> action_args =
-      Action::Parse(*this, action_call);
-  const Action& action = action_args.first;
+  const std::pair<const Action*, std::vector<Object>> action_args =
+      ParseAction(*this, action_call);
+  const Action& action = *action_args.first;
   const std::vector<Object>& arguments = action_args.second;
 
-  return Apply(state, action, arguments, derived_predicates());
+  return Apply(state, action, arguments, *this);
 }
 
 TEST_CASE_FIXTURE(testing::Fixture, "Pddl.NextState") {
@@ -336,24 +405,57 @@ TEST_CASE_FIXTURE(testing::Fixture, "Pddl.NextState") {
   next_state.erase(Proposition(pddl, "on(hook, table)"));
   next_state.emplace(pddl, "inhand(hook)");
   REQUIRE(pddl.NextState(state, "pick(hook)") == next_state);
+
+  // Invalid action calls should still be reported.
+  REQUIRE_THROWS(pddl.NextState(state, "pick(hook, box)"));
+  REQUIRE_THROWS(pddl.NextState(state, "fly(hook)"));
 }
 
 State Pddl::ApplyActions(const State& state,
                          const std::vector<std::string>& action_calls) const {
   State next_state(state);
-  for (const std::string& action_call : action_calls) {
-    const std::pair<Action, std::vector<Object>> action_args =
-        Action::Parse(*this, action_call);
-    const Action& action = action_args.first;
+  for (size_t i = 0; i < action_calls.size(); i++) {
+    const std::pair<const Action*, std::vector<Object>> action_args =
+        ParseAction(*this, action_calls[i]);
+    const Action& action = *action_args.first;
     const std::vector<Object>& arguments = action_args.second;
 
-    Apply(action, arguments, derived_predicates(), &next_state);
+    // Derive the given state from scratch, after which it stays up to date.
+    if (i == 0) {
+      next_state = Apply(next_state, action, arguments, *this);
+    } else {
+      Apply(action, arguments, *this, &next_state);
+    }
   }
   return next_state;
 }
 
+TEST_CASE_FIXTURE(testing::BlocksFixture, "Pddl.NextState.DerivedPredicates") {
+  // Derived predicates should be recomputed in states where they are stale.
+  State stale_state;
+  for (const Proposition& prop : pddl.initial_state()) {
+    if (prop.name() == "clear" || prop.name() == "above") continue;
+    stale_state.insert(prop);
+  }
+  REQUIRE(stale_state != pddl.initial_state());
+
+  const State next_state = pddl.NextState(pddl.initial_state(), "pick(c)");
+  REQUIRE(pddl.NextState(stale_state, "pick(c)") == next_state);
+
+  // Incremental updates after the first action should match recomputation.
+  const std::vector<std::string> actions = {"pick(c)", "place(c, table)",
+                                            "pick(b)"};
+  State final_state = pddl.initial_state();
+  for (const std::string& action : actions) {
+    final_state = pddl.NextState(final_state, action);
+  }
+  REQUIRE(pddl.ApplyActions(stale_state, actions) == final_state);
+}
+
 State Pddl::DerivedState(const State& state) const {
-  return DerivedPredicate::Apply(state, derived_predicates());
+  State next_state = state;
+  DerivedPredicate::Apply(derived_predicates(), derived_strata(), &next_state);
+  return next_state;
 }
 
 State Pddl::ConsistentState(const State& state) const {
@@ -369,31 +471,18 @@ State Pddl::ConsistentState(const State& state) const {
 }
 
 PartialState Pddl::ConsistentState(const PartialState& state) const {
-  constexpr int kMaxIterations = 50;
   PartialState next_state = state;
-
-  size_t i = 0;
-  bool is_changed = true;
-  while (is_changed) {
-    is_changed = false;
-    for (const std::shared_ptr<Axiom>& axiom : axioms()) {
-      const int axiom_change = axiom->Apply(&next_state);
-      is_changed |= axiom_change > 0;
-
-      if (axiom_change == 2) {
-        std::stringstream ss;
-        ss << "Pddl::ConsistentState(): Axiom violation" << std::endl
-           << axiom << std::endl
-           << std::endl
-           << next_state << std::endl;
-        throw std::runtime_error(ss.str());
-      }
-    }
-
-    if (i++ > kMaxIterations) {
-      throw std::runtime_error(
-          "Pddl::ConsistentState(): Exceeded max num iterations.");
+  const Axiom* axiom = nullptr;
+  if (!axiom_propagator_->Propagate(&next_state, &axiom)) {
+    std::stringstream ss;
+    ss << "Pddl::ConsistentState(): Axiom violation" << std::endl;
+    if (axiom != nullptr) {
+      ss << *axiom << std::endl;
+    } else {
+      ss << "Contradictory partial state" << std::endl;
     }
+    ss << std::endl << next_state << std::endl;
+    throw std::runtime_error(ss.str());
   }
   return next_state;
 }
@@ -401,9 +490,9 @@ PartialState Pddl::ConsistentState(const PartialState& state) const {
 bool Pddl::IsValidAction(const State& state,
                          const std::string& action_call) const {
   // Parse strings
-  const std::pair<Action, std::vector<Object>> action_args =
-      Action::Parse(*this, action_call);
-  const Action& action = action_args.first;
+  const std::pair<const Action*, std::vector<Object>> action_args =
+      ParseAction(*this, action_call);
+  const Action& action = *action_args.first;
   const std::vector<Object>& arguments = action_args.second;
 
   return action.IsValid(state, arguments);
@@ -423,19 +512,24 @@ bool Pddl::IsValidState(const State& state) const {
 }
 
 bool Pddl::IsValidState(const PartialState& state) const {
-  return Axiom::IsConsistent(axioms(), state);
+  // Normal forms are also evaluated while the axioms and their propagator are
+  // being constructed, in which case the axioms are applied naively.
+  if (axiom_propagator_ == nullptr) return Axiom::IsConsistent(axioms_, state);
+
+  PartialState test_state = state;
+  return axiom_propagator_->Propagate(&test_state);
 }
 
 bool Pddl::IsValidTuple(const State& state, const std::string& action_call,
                         const State& next_state) const {
   // Parse strings
-  const std::pair<Action, std::vector<Object>> action_args =
-      Action::Parse(*this, action_call);
-  const Action& action = action_args.first;
+  const std::pair<const Action*, std::vector<Object>> action_args =
+      ParseAction(*this, action_call);
+  const Action& action = *action_args.first;
   const std::vector<Object>& arguments = action_args.second;
 
   return action.IsValid(state, arguments) &&
-         Apply(state, action, arguments, derived_predicates()) == next_state;
+         Apply(state, action, arguments, *this) == next_state;
 }
 bool Pddl::IsValidTuple(const std::set<std::string>& str_state,
                         const std::string& action_call,
@@ -457,13 +551,13 @@ bool Pddl::IsValidPlan(const std::vector<std::string>& action_skeleton) const {
   State state = initial_state_;
   for (const std::string& action_call : action_skeleton) {
     // Parse strings
-    std::pair<Action, std::vector<Object>> action_args =
-        Action::Parse(*this, action_call);
-    const Action& action = action_args.first;
+    const std::pair<const Action*, std::vector<Object>> action_args =
+        ParseAction(*this, action_call);
+    const Action& action = *action_args.first;
     const std::vector<Object>& arguments = action_args.second;
 
     if (!action.IsValid(state, arguments)) return false;
-    Apply(action, arguments, derived_predicates(), &state);
+    Apply(action, arguments, *this, &state);
   }
   return goal_(state);
 }
@@ -471,10 +565,12 @@ bool Pddl::IsValidPlan(const std::vector<std::string>& action_skeleton) const {
 std::vector<std::vector<Object>> Pddl::ListValidArguments(
     const State& state, const Action& action) const {
   std::vector<std::vector<Object>> arguments;
-  ParameterGenerator param_gen(*this, action.parameters());
-  for (const std::vector<Object>& args : param_gen) {
-    if (action.IsValid(state, args)) arguments.push_back(args);
-  }
+  std::vector<Object> args(action.parameters().size());
+  action.parameter_binder().ForEach(
+      state, &args, [&arguments](const std::vector<Object>& args) {
+        arguments.push_back(args);
+        return true;
+      });
   return arguments;
 }
 std::vector<std::vector<std::string>> Pddl::ListValidArguments(
@@ -0,0 +1,181 @@
+/**
+ * bitstate_search.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/bitstate_search.h"
+
+#include <algorithm>  // std::fill, std::reverse
+#include <cmath>      // std::pow
+#include <deque>      // std::deque
+#include <iostream>   // std::cout
+#include <stdexcept>  // std::runtime_error
+
+#include "symbolic/planning/planner.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Planner;
+
+constexpr size_t kWordSize = 64;
+
+constexpr uint64_t kAtomSeed = 0x9e3779b97f4a7c15;
+
+uint64_t Mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111eb;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * Node on the search path with its remaining children.
+ */
+struct Frame {
+  explicit Frame(const Planner::Node& node)
+      : node(node), it(this->node.begin()), end(this->node.end()) {}
+
+  const Planner::Node node;
+  Planner::Node::iterator it;
+  const Planner::Node::iterator end;
+};
+
+}  // namespace
+
+namespace symbolic {
+
+BitstateSearch::BitstateSearch(const Pddl& pddl, size_t log2_num_bits,
+                               size_t num_hashes)
+    : pddl_(pddl), num_hashes_(num_hashes) {
+  if (log2_num_bits < 6 || log2_num_bits >= kWordSize) {
+    throw std::runtime_error(
+        "BitstateSearch::BitstateSearch(): The bit array must have between 2^6 "
+        "and 2^63 bits.");
+  }
+  if (num_hashes == 0) {
+    throw std::runtime_error(
+        "BitstateSearch::BitstateSearch(): At least one hash is required.");
+  }
+  mask_ = (uint64_t{1} << log2_num_bits) - 1;
+  bits_.resize((mask_ + 1) / kWordSize, 0);
+}
+
+bool BitstateSearch::Insert(const State& state, size_t hash) {
+  // Hash the atoms independently of the state hash.
+  pddl_.state_index().GetPropositionIndices(state, &atoms_);
+  uint64_t h2 = kAtomSeed;
+  for (const size_t atom : atoms_) h2 = Mix(h2 ^ atom);
+
+  const uint64_t h1 = Mix(hash);
+  h2 |= 1;
+  bool is_new = false;
+  for (size_t i = 0; i < num_hashes_; i++) {
+    const uint64_t idx = (h1 + i * h2) & mask_;
+    uint64_t& word = bits_[idx / kWordSize];
+    const uint64_t bit = uint64_t{1} << (idx % kWordSize);
+    if (word & bit) continue;
+    word |= bit;
+    num_set_++;
+    is_new = true;
+  }
+  return is_new;
+}
+
+std::optional<std::vector<std::string>> BitstateSearch::Search(
+    size_t max_depth, bool verbose) {
+  std::fill(bits_.begin(), bits_.end(), 0);
+  num_set_ = 0;
+  statistics_ = Statistics();
+
+  const auto UpdateStatistics = [this]() {
+    statistics_.fill_ratio = static_cast<double>(num_set_) / num_bits();
+    statistics_.omission_probability =
+        std::pow(statistics_.fill_ratio, num_hashes_);
+  };
+  const auto Store = [this, &UpdateStatistics](const Planner::Node& node) {
+    UpdateStatistics();
+    if (!Insert(node.state(), node.hash())) {
+      statistics_.num_matched++;
+      return false;
+    }
+    const double p = statistics_.omission_probability;
+    statistics_.expected_omissions += p < 1. ? p / (1. - p) : 0.;
+    statistics_.num_stored++;
+    return true;
+  };
+
+  const Planner planner(pddl_);
+  std::optional<std::vector<std::string>> plan;
+
+  // Frames are never moved, since their iterators refer to their nodes.
+  std::deque<Frame> path;
+  Store(planner.root());
+  path.emplace_back(planner.root());
+  while (!path.empty()) {
+    Frame& frame = path.back();
+    if (frame.node) {
+      plan.emplace();
+      for (std::optional<Planner::Node> node = frame.node; node->parent();
+           node = node->parent()) {
+        plan->push_back(node->action());
+      }
+      std::reverse(plan->begin(), plan->end());
+      break;
+    }
+
+    if (path.size() > max_depth || frame.it == frame.end) {
+      path.pop_back();
+      continue;
+    }
+
+    const Planner::Node child = *frame.it;
+    ++frame.it;
+    if (Store(child)) path.emplace_back(child);
+  }
+
+  UpdateStatistics();
+  statistics_.coverage =
+      statistics_.num_stored /
+      (statistics_.num_stored + statistics_.expected_omissions);
+  if (verbose) {
+    std::cout << "Bitstate search: " << statistics_.num_stored
+              << " states stored, " << statistics_.num_matched
+              << " matched, fill ratio " << statistics_.fill_ratio
+              << ", omission probability "
+              << statistics_.omission_probability << ", estimated coverage "
+              << statistics_.coverage << std::endl;
+  }
+  return plan;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "BitstateSearch") {
+  BitstateSearch search(pddl, 20, 3);
+  const std::optional<std::vector<std::string>> plan = search.Search();
+  REQUIRE(plan.has_value());
+
+  REQUIRE(testing::IsValidPlan(pddl, *plan));
+
+  // A sparse bit array should omit hardly any states.
+  const BitstateSearch::Statistics& stats = search.statistics();
+  REQUIRE(stats.num_stored > 1);
+  REQUIRE(stats.omission_probability < 1e-6);
+  REQUIRE(stats.coverage > 0.999);
+
+  // Without expanding the root, only the root should be stored.
+  REQUIRE(!search.Search(0).has_value());
+  REQUIRE(search.statistics().num_stored == 1);
+
+  // A tiny bit array should report that states may have been omitted.
+  BitstateSearch tiny_search(pddl, 6, 3);
+  tiny_search.Search();
+  REQUIRE(tiny_search.statistics().omission_probability > 0.);
+}
+
+}  // namespace symbolic
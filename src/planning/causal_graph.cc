@@ -0,0 +1,496 @@
+/**
+ * causal_graph.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/causal_graph.h"
+
+#include <algorithm>  // std::lower_bound, std::push_heap, std::sort
+#include <limits>     // std::numeric_limits
+#include <queue>      // std::queue
+#include <set>        // std::set
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/width_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Fact;
+
+bool CompareFacts(const Fact& lhs, const Fact& rhs) {
+  return lhs.var < rhs.var || (lhs.var == rhs.var && lhs.value < rhs.value);
+}
+
+/**
+ * Returns the value of the variable in the sorted facts, or -1.
+ */
+size_t FindValue(const std::vector<Fact>& facts, size_t var) {
+  const auto it =
+      std::lower_bound(facts.begin(), facts.end(), Fact{var, 0}, CompareFacts);
+  return it != facts.end() && it->var == var ? it->value : -1;
+}
+
+/**
+ * Orders the priority queue by increasing cost.
+ */
+struct CompareCosts {
+  template <typename T>
+  bool operator()(const T& lhs, const T& rhs) const {
+    return lhs.first > rhs.first;
+  }
+};
+
+/**
+ * Returns the position of the variable in the sorted variables.
+ */
+size_t FindVariable(const std::vector<size_t>& vars, size_t var) {
+  return std::lower_bound(vars.begin(), vars.end(), var) - vars.begin();
+}
+
+}  // namespace
+
+namespace symbolic {
+
+CausalGraph::CausalGraph(const GroundedTask& task,
+                         const FiniteDomainEncoding& encoding)
+    : encoding_(encoding) {
+  const std::vector<int>& idx_variables = encoding.idx_variables();
+  const std::vector<size_t>& values = encoding.values();
+  const std::vector<size_t>& static_atoms = encoding.static_atoms();
+  const auto IsStatic = [&static_atoms](size_t atom) {
+    return std::binary_search(static_atoms.begin(), static_atoms.end(), atom);
+  };
+  const auto IsBinary = [&encoding](size_t var) {
+    return encoding.variables()[var].atoms.size() == 1;
+  };
+  const auto None = [&encoding](size_t var) {
+    return encoding.variables()[var].none();
+  };
+
+  // Atoms that are neither fluent, static, nor derived are never true.
+  std::vector<bool> is_derived(task.num_atoms(), false);
+  for (const GroundedTask::Rule& rule : task.rules()) {
+    is_derived[rule.head] = true;
+  }
+  const auto IsUnreachable = [&](size_t atom) {
+    return idx_variables[atom] < 0 && !is_derived[atom] && !IsStatic(atom);
+  };
+
+  // Adds the fact unless it contradicts another fact on the same variable.
+  const auto AddFact = [](const Fact& fact, std::vector<Fact>* facts) {
+    for (const Fact& other : *facts) {
+      if (other.var == fact.var) return other.value == fact.value;
+    }
+    facts->push_back(fact);
+    return true;
+  };
+
+  std::vector<Fact> pre;
+  std::vector<Fact> eff;
+  for (size_t idx_op = 0; idx_op < task.operators().size(); idx_op++) {
+    const GroundedTask::Operator& op = task.operators()[idx_op];
+    pre.clear();
+    eff.clear();
+
+    bool is_applicable = true;
+    for (const size_t atom : op.pre_pos) {
+      if (IsUnreachable(atom)) {
+        is_applicable = false;
+        break;
+      }
+      const int var = idx_variables[atom];
+      if (var < 0) continue;
+      is_applicable = AddFact({static_cast<size_t>(var), values[atom]}, &pre);
+      if (!is_applicable) break;
+    }
+    for (const size_t atom : op.pre_neg) {
+      if (!is_applicable) break;
+      if (IsStatic(atom)) is_applicable = false;
+      const int var = idx_variables[atom];
+      if (var < 0 || !IsBinary(var)) continue;
+      is_applicable = AddFact({static_cast<size_t>(var), None(var)}, &pre);
+    }
+    if (!is_applicable) continue;
+    std::sort(pre.begin(), pre.end(), CompareFacts);
+
+    for (const size_t atom : op.add) {
+      const int var = idx_variables[atom];
+      if (var >= 0) AddFact({static_cast<size_t>(var), values[atom]}, &eff);
+    }
+    for (const size_t atom : op.del) {
+      const int var = idx_variables[atom];
+      if (var < 0 || (!IsBinary(var) && FindValue(pre, var) != values[atom])) {
+        continue;
+      }
+      AddFact({static_cast<size_t>(var), None(var)}, &eff);
+    }
+    std::sort(eff.begin(), eff.end(), CompareFacts);
+
+    // Drop effects that the preconditions already satisfy.
+    eff.erase(std::remove_if(eff.begin(), eff.end(),
+                             [&pre](const Fact& fact) {
+                               return FindValue(pre, fact.var) == fact.value;
+                             }),
+              eff.end());
+    if (eff.empty()) continue;
+
+    operators_.push_back({idx_op, pre, eff});
+  }
+
+  for (const size_t atom : task.goal_pos()) {
+    if (IsUnreachable(atom)) is_solvable_ = false;
+    const int var = idx_variables[atom];
+    if (var < 0) continue;
+    if (!AddFact({static_cast<size_t>(var), values[atom]}, &goal_)) {
+      is_solvable_ = false;
+    }
+  }
+  for (const size_t atom : task.goal_neg()) {
+    if (IsStatic(atom)) is_solvable_ = false;
+    const int var = idx_variables[atom];
+    if (var < 0 || !IsBinary(var)) continue;
+    if (!AddFact({static_cast<size_t>(var), None(var)}, &goal_)) {
+      is_solvable_ = false;
+    }
+  }
+  std::sort(goal_.begin(), goal_.end(), CompareFacts);
+
+  // Connect the preconditions and side effects to the effects.
+  std::vector<std::set<size_t>> successors(encoding.num_variables());
+  for (const Operator& op : operators_) {
+    for (const Fact& fact_eff : op.eff) {
+      for (const Fact& fact_pre : op.pre) {
+        if (fact_pre.var != fact_eff.var) {
+          successors[fact_pre.var].insert(fact_eff.var);
+        }
+      }
+      for (const Fact& other : op.eff) {
+        if (other.var != fact_eff.var) {
+          successors[other.var].insert(fact_eff.var);
+        }
+      }
+    }
+  }
+  successors_.resize(encoding.num_variables());
+  predecessors_.resize(encoding.num_variables());
+  for (size_t u = 0; u < successors.size(); u++) {
+    successors_[u].assign(successors[u].begin(), successors[u].end());
+    for (const size_t v : successors[u]) predecessors_[v].push_back(u);
+  }
+}
+
+DomainTransitionGraph::DomainTransitionGraph(const CausalGraph& causal_graph,
+                                             size_t var)
+    : var_(var) {
+  const size_t domain_size =
+      causal_graph.encoding().variables()[var].domain_size();
+  transitions_from_.resize(domain_size);
+
+  for (size_t idx_op = 0; idx_op < causal_graph.operators().size(); idx_op++) {
+    const CausalGraph::Operator& op = causal_graph.operators()[idx_op];
+    const size_t target = FindValue(op.eff, var);
+    if (target == static_cast<size_t>(-1)) continue;
+
+    Transition transition{0, target, idx_op, {}, {}};
+    for (const Fact& fact : op.pre) {
+      if (fact.var != var) transition.conditions.push_back(fact);
+    }
+    for (const Fact& fact : op.eff) {
+      if (fact.var != var) transition.side_effects.push_back(fact);
+    }
+
+    const size_t source = FindValue(op.pre, var);
+    for (size_t value = 0; value < domain_size; value++) {
+      if (value == target ||
+          (source != static_cast<size_t>(-1) && value != source)) {
+        continue;
+      }
+      transition.source = value;
+      transitions_from_[value].push_back(transitions_.size());
+      transitions_.push_back(transition);
+    }
+  }
+
+  // Compute the shortest paths from every value.
+  distances_.assign(domain_size * domain_size, kInfinity);
+  std::queue<size_t> queue;
+  for (size_t source = 0; source < domain_size; source++) {
+    uint16_t* distances = &distances_[source * domain_size];
+    distances[source] = 0;
+    queue.push(source);
+    while (!queue.empty()) {
+      const size_t value = queue.front();
+      queue.pop();
+      for (const size_t idx_transition : transitions_from_[value]) {
+        const size_t target = transitions_[idx_transition].target;
+        if (distances[target] != kInfinity) continue;
+        distances[target] = distances[value] + 1;
+        queue.push(target);
+      }
+    }
+  }
+}
+
+struct ContextEnhancedAdditiveHeuristic::LocalTransition {
+  const DomainTransitionGraph::Transition* label;
+  LocalProblem* problem;
+  int cost;
+  int target_cost;
+  size_t num_unreached;
+};
+
+struct ContextEnhancedAdditiveHeuristic::LocalProblem {
+  struct Node {
+    // Cost from the start value, or -1 if the node has not been reached.
+    int cost;
+    bool is_expanded;
+    LocalTransition* reached_by;
+
+    // Values of the context variables.
+    std::vector<size_t> context;
+
+    // Transitions of other problems that are waiting for this node.
+    std::vector<LocalTransition*> waiting;
+  };
+
+  size_t start;
+  size_t idx_evaluation;
+  const std::vector<size_t>* context_vars;
+  std::vector<Node> nodes;
+  std::vector<LocalTransition> transitions;
+  std::vector<std::vector<LocalTransition*>> transitions_from;
+};
+
+ContextEnhancedAdditiveHeuristic::ContextEnhancedAdditiveHeuristic(
+    const Pddl& pddl)
+    : task_(pddl), encoding_(task_), causal_graph_(task_, encoding_) {
+  const size_t num_variables = encoding_.num_variables();
+  dtgs_.reserve(num_variables);
+  context_vars_.resize(num_variables + 1);
+  problems_.resize(num_variables + 1);
+  for (size_t var = 0; var < num_variables; var++) {
+    dtgs_.emplace_back(causal_graph_, var);
+    problems_[var].resize(dtgs_[var].domain_size());
+
+    std::set<size_t> context_vars;
+    for (const DomainTransitionGraph::Transition& transition :
+         dtgs_[var].transitions()) {
+      for (const Fact& fact : transition.conditions) {
+        context_vars.insert(fact.var);
+      }
+    }
+    context_vars_[var].assign(context_vars.begin(), context_vars.end());
+  }
+
+  goal_transition_ = {0, 1, 0, causal_graph_.goal(), {}};
+  for (const Fact& fact : causal_graph_.goal()) {
+    context_vars_[num_variables].push_back(fact.var);
+  }
+  problems_[num_variables].resize(1);
+}
+
+ContextEnhancedAdditiveHeuristic::~ContextEnhancedAdditiveHeuristic() =
+    default;
+
+ContextEnhancedAdditiveHeuristic::LocalProblem&
+ContextEnhancedAdditiveHeuristic::GetLocalProblem(size_t var, size_t value) {
+  std::unique_ptr<LocalProblem>& ptr_problem = problems_[var][value];
+  if (!ptr_problem) {
+    ptr_problem = std::make_unique<LocalProblem>();
+    LocalProblem& problem = *ptr_problem;
+    problem.start = value;
+    problem.idx_evaluation = 0;
+    problem.context_vars = &context_vars_[var];
+
+    const bool is_goal = var == dtgs_.size();
+    const size_t domain_size = is_goal ? 2 : dtgs_[var].domain_size();
+    problem.nodes.resize(domain_size);
+    for (LocalProblem::Node& node : problem.nodes) {
+      node.context.resize(problem.context_vars->size());
+    }
+
+    // Copy the transitions and link them to their source.
+    if (is_goal) {
+      problem.transitions.push_back({&goal_transition_, &problem, 0, 0, 0});
+    } else {
+      for (const DomainTransitionGraph::Transition& transition :
+           dtgs_[var].transitions()) {
+        problem.transitions.push_back({&transition, &problem, 1, 0, 0});
+      }
+    }
+    problem.transitions_from.resize(domain_size);
+    for (LocalTransition& transition : problem.transitions) {
+      problem.transitions_from[transition.label->source].push_back(&transition);
+    }
+  }
+
+  LocalProblem& problem = *ptr_problem;
+  if (problem.idx_evaluation == idx_evaluation_) return problem;
+
+  // Reset the problem for the current evaluation.
+  problem.idx_evaluation = idx_evaluation_;
+  for (LocalProblem::Node& node : problem.nodes) {
+    node.cost = -1;
+    node.is_expanded = false;
+    node.reached_by = nullptr;
+    node.waiting.clear();
+  }
+  LocalProblem::Node& start = problem.nodes[value];
+  for (size_t i = 0; i < problem.context_vars->size(); i++) {
+    start.context[i] = encoding_.Get(*state_, (*problem.context_vars)[i]);
+  }
+  start.cost = 0;
+  Push(0, &problem, value);
+  return problem;
+}
+
+void ContextEnhancedAdditiveHeuristic::Push(int cost, LocalProblem* problem,
+                                            size_t value) {
+  queue_.push_back({cost, {problem, value}});
+  std::push_heap(queue_.begin(), queue_.end(), CompareCosts());
+}
+
+void ContextEnhancedAdditiveHeuristic::Expand(LocalProblem* problem,
+                                              size_t value) {
+  LocalProblem::Node& node = problem->nodes[value];
+  node.is_expanded = true;
+
+  // Derive the context from the transition that reached the node.
+  const std::vector<size_t>& context_vars = *problem->context_vars;
+  if (node.reached_by != nullptr) {
+    const LocalTransition& reached_by = *node.reached_by;
+    node.context = problem->nodes[reached_by.label->source].context;
+    for (const std::vector<Fact>* facts :
+         {&reached_by.label->conditions, &reached_by.label->side_effects}) {
+      for (const Fact& fact : *facts) {
+        const size_t idx = FindVariable(context_vars, fact.var);
+        if (idx < context_vars.size() && context_vars[idx] == fact.var) {
+          node.context[idx] = fact.value;
+        }
+      }
+    }
+  }
+
+  for (LocalTransition* transition : node.waiting) {
+    transition->target_cost += node.cost;
+    if (--transition->num_unreached == 0) Reach(transition);
+  }
+
+  for (LocalTransition* transition : problem->transitions_from[value]) {
+    const std::vector<Fact>& conditions = transition->label->conditions;
+    transition->target_cost = node.cost + transition->cost;
+    transition->num_unreached = conditions.size() + 1;
+    for (const Fact& condition : conditions) {
+      const size_t idx = FindVariable(context_vars, condition.var);
+      Watch(transition, condition, problem->nodes[value].context[idx]);
+    }
+    if (--transition->num_unreached == 0) Reach(transition);
+  }
+}
+
+void ContextEnhancedAdditiveHeuristic::Watch(LocalTransition* transition,
+                                             const Fact& condition,
+                                             size_t context_value) {
+  const DomainTransitionGraph& dtg = dtgs_[condition.var];
+  if (dtg.distance(context_value, condition.value) ==
+      DomainTransitionGraph::kInfinity) {
+    return;
+  }
+
+  LocalProblem& problem = GetLocalProblem(condition.var, context_value);
+  LocalProblem::Node& node = problem.nodes[condition.value];
+  if (node.is_expanded) {
+    transition->target_cost += node.cost;
+    transition->num_unreached--;
+  } else {
+    node.waiting.push_back(transition);
+  }
+}
+
+void ContextEnhancedAdditiveHeuristic::Reach(LocalTransition* transition) {
+  LocalProblem::Node& node =
+      transition->problem->nodes[transition->label->target];
+  if (node.is_expanded ||
+      (node.cost >= 0 && node.cost <= transition->target_cost)) {
+    return;
+  }
+  node.cost = transition->target_cost;
+  node.reached_by = transition;
+  Push(node.cost, transition->problem, transition->label->target);
+}
+
+double ContextEnhancedAdditiveHeuristic::Evaluate(
+    const FiniteDomainEncoding::PackedState& state) {
+  constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  if (!causal_graph_.is_solvable()) return kInfinity;
+
+  // Check the goal values against the domain transition graphs first.
+  for (const Fact& fact : causal_graph_.goal()) {
+    const size_t value = encoding_.Get(state, fact.var);
+    if (dtgs_[fact.var].distance(value, fact.value) ==
+        DomainTransitionGraph::kInfinity) {
+      return kInfinity;
+    }
+  }
+
+  idx_evaluation_++;
+  state_ = &state;
+  queue_.clear();
+  const LocalProblem* goal = &GetLocalProblem(dtgs_.size(), 0);
+  while (!queue_.empty()) {
+    std::pop_heap(queue_.begin(), queue_.end(), CompareCosts());
+    const auto [cost, problem_value] = queue_.back();
+    queue_.pop_back();
+    auto [problem, value] = problem_value;
+    const LocalProblem::Node& node = problem->nodes[value];
+    if (node.is_expanded || node.cost != cost) continue;
+    if (problem == goal && value == 1) return static_cast<double>(cost);
+
+    Expand(problem, value);
+  }
+  return kInfinity;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "ContextEnhancedAdditiveHeuristic") {
+  ContextEnhancedAdditiveHeuristic h_cea(pddl);
+  const CausalGraph& causal_graph = h_cea.causal_graph();
+  const FiniteDomainEncoding& encoding = h_cea.encoding();
+  REQUIRE(causal_graph.is_solvable());
+  REQUIRE(causal_graph.goal().size() == 3);
+
+  // Each block variable is changed by picking and placing it.
+  for (size_t var = 0; var < causal_graph.num_variables(); var++) {
+    const DomainTransitionGraph& dtg = h_cea.domain_transition_graph(var);
+    REQUIRE(dtg.domain_size() == encoding.variables()[var].domain_size());
+    for (size_t source = 0; source < dtg.domain_size(); source++) {
+      for (size_t target = 0; target < dtg.domain_size(); target++) {
+        REQUIRE(dtg.distance(source, target) <= 2);
+      }
+    }
+  }
+
+  // The heuristic should be zero only at the goal along a plan.
+  const Planner planner(pddl);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), 10);
+  REQUIRE(bfs.begin() != bfs.end());
+  const std::vector<Planner::Node> plan = *bfs.begin();
+  for (const Planner::Node& node : plan) {
+    const double h = h_cea(node);
+    REQUIRE(h < std::numeric_limits<double>::infinity());
+    REQUIRE((h == 0.) == static_cast<bool>(node));
+  }
+
+  // The heuristic should plug into the search engines as a score function.
+  BestFirstWidthSearch<Planner::Node> bfws(
+      planner.root(), pddl.state_index(),
+      [&h_cea](const Planner::Node& node) { return h_cea(node); }, 10);
+  REQUIRE(bfws.begin() != bfws.end());
+  REQUIRE(pddl.IsGoalSatisfied((*bfws.begin()).back().state()));
+}
+
+}  // namespace symbolic
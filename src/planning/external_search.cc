@@ -0,0 +1,429 @@
+/**
+ * external_search.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/external_search.h"
+
+#include <stdlib.h>  // mkdtemp
+
+#include <algorithm>   // std::max, std::min, std::sort
+#include <cstring>     // std::memcmp
+#include <filesystem>  // std::filesystem
+#include <fstream>     // std::ifstream, std::ofstream
+#include <iostream>    // std::cout
+#include <optional>    // std::optional
+#include <queue>       // std::priority_queue
+#include <stdexcept>   // std::runtime_error
+
+#include "symbolic/planning/planner.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Planner;
+
+constexpr size_t kWordSize = 64;
+
+// Size of the buffer of every open layer and run file in bytes, reduced for
+// small memory budgets.
+constexpr size_t kIoBufferSize = size_t{1} << 20;
+
+// Minimum number of runs merged at once.
+constexpr size_t kMinFanIn = 2;
+
+/**
+ * Orders records of the given number of words. The order only needs to be
+ * consistent across the runs and layers.
+ */
+int Compare(const uint64_t* lhs, const uint64_t* rhs, size_t num_words) {
+  return std::memcmp(lhs, rhs, num_words * sizeof(uint64_t));
+}
+
+/**
+ * Buffered writer of fixed-size records.
+ */
+class RecordWriter {
+ public:
+  RecordWriter(const std::string& path, size_t num_words, size_t buffer_size)
+      : file_(path, std::ios::binary | std::ios::trunc),
+        num_words_(num_words) {
+    if (!file_) {
+      throw std::runtime_error("RecordWriter::RecordWriter(): Could not open " +
+                               path + ".");
+    }
+    buffer_.reserve(std::max(buffer_size / sizeof(uint64_t), num_words));
+  }
+
+  void Write(const uint64_t* record) {
+    if (buffer_.size() + num_words_ > buffer_.capacity()) Flush();
+    buffer_.insert(buffer_.end(), record, record + num_words_);
+    num_records_++;
+  }
+
+  /**
+   * Writes the remaining records and checks for errors.
+   */
+  void Close() {
+    Flush();
+    file_.close();
+    if (!file_) {
+      throw std::runtime_error("RecordWriter::Close(): Could not write file.");
+    }
+  }
+
+  size_t num_records() const { return num_records_; }
+
+ private:
+  void Flush() {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file_.write(reinterpret_cast<const char*>(buffer_.data()),
+                buffer_.size() * sizeof(uint64_t));
+    buffer_.clear();
+  }
+
+  std::ofstream file_;
+  size_t num_words_;
+  size_t num_records_ = 0;
+  std::vector<uint64_t> buffer_;
+};
+
+/**
+ * Buffered reader of fixed-size records.
+ */
+class RecordReader {
+ public:
+  RecordReader(const std::string& path, size_t num_words, size_t buffer_size)
+      : file_(path, std::ios::binary),
+        num_words_(num_words),
+        buffer_(std::max(buffer_size / sizeof(uint64_t) / num_words,
+                         size_t{1}) *
+                num_words) {
+    if (!file_) {
+      throw std::runtime_error("RecordReader::RecordReader(): Could not open " +
+                               path + ".");
+    }
+  }
+
+  /**
+   * Advances to the next record.
+   *
+   * @returns False if the end of the file has been reached.
+   */
+  bool Next() {
+    idx_ += num_words_;
+    if (idx_ < size_) return true;
+
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    file_.read(reinterpret_cast<char*>(buffer_.data()),
+               buffer_.size() * sizeof(uint64_t));
+    size_ = file_.gcount() / sizeof(uint64_t);
+    idx_ = 0;
+    return size_ >= num_words_;
+  }
+
+  const uint64_t* record() const { return &buffer_[idx_]; }
+
+ private:
+  std::ifstream file_;
+  size_t num_words_;
+  std::vector<uint64_t> buffer_;
+  size_t idx_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace
+
+namespace symbolic {
+
+ExternalBreadthFirstSearch::ExternalBreadthFirstSearch(
+    const Pddl& pddl, const std::string& directory, size_t memory_budget)
+    : pddl_(pddl),
+      num_words_((pddl.state_index().size() + kWordSize - 1) / kWordSize) {
+  num_words_ = std::max(num_words_, size_t{1});
+  buffer_size_ = std::max(memory_budget / sizeof(uint64_t), num_words_);
+
+  // Every merge buffers its inputs, the closed list, and the output at once.
+  io_buffer_size_ = std::min(kIoBufferSize, memory_budget / (kMinFanIn + 2));
+  io_buffer_size_ = std::max(io_buffer_size_, sizeof(uint64_t));
+  max_fan_in_ = std::max(memory_budget / io_buffer_size_, kMinFanIn + 2) - 2;
+
+  const std::filesystem::path parent =
+      directory.empty() ? std::filesystem::temp_directory_path()
+                        : std::filesystem::path(directory);
+  std::string path = (parent / "symbolic_bfs_XXXXXX").string();
+  if (mkdtemp(path.data()) == nullptr) {
+    throw std::runtime_error(
+        "ExternalBreadthFirstSearch::ExternalBreadthFirstSearch(): Could not "
+        "create a temporary directory in " +
+        parent.string() + ".");
+  }
+  directory_ = path;
+}
+
+ExternalBreadthFirstSearch::~ExternalBreadthFirstSearch() {
+  std::error_code error;
+  std::filesystem::remove_all(directory_, error);
+}
+
+std::string ExternalBreadthFirstSearch::LayerPath(size_t depth) const {
+  return directory_ + "/layer_" + std::to_string(depth) + ".bin";
+}
+
+std::string ExternalBreadthFirstSearch::RunPath(size_t idx_run) const {
+  return directory_ + "/run_" + std::to_string(idx_run) + ".bin";
+}
+
+std::string ExternalBreadthFirstSearch::ClosedPath() const {
+  return directory_ + "/closed.bin";
+}
+
+std::string ExternalBreadthFirstSearch::MergePath() const {
+  return directory_ + "/merge.bin";
+}
+
+void ExternalBreadthFirstSearch::Encode(const State& state,
+                                        uint64_t* record) const {
+  std::vector<size_t> atoms;
+  pddl_.state_index().GetPropositionIndices(state, &atoms);
+  std::fill(record, record + num_words_, 0);
+  for (const size_t atom : atoms) {
+    record[atom / kWordSize] |= uint64_t{1} << (atom % kWordSize);
+  }
+}
+
+State ExternalBreadthFirstSearch::Decode(const uint64_t* record) const {
+  State state;
+  for (size_t w = 0; w < num_words_; w++) {
+    for (uint64_t bits = record[w]; bits != 0; bits &= bits - 1) {
+      const size_t atom = w * kWordSize + __builtin_ctzll(bits);
+      state.insert(pddl_.state_index().GetProposition(atom));
+    }
+  }
+  return state;
+}
+
+void ExternalBreadthFirstSearch::WriteRun(std::vector<uint64_t>* buffer,
+                                          size_t idx_run) const {
+  std::vector<const uint64_t*> records;
+  records.reserve(buffer->size() / num_words_);
+  for (size_t i = 0; i < buffer->size(); i += num_words_) {
+    records.push_back(&(*buffer)[i]);
+  }
+  const size_t num_words = num_words_;
+  std::sort(records.begin(), records.end(),
+            [num_words](const uint64_t* lhs, const uint64_t* rhs) {
+              return Compare(lhs, rhs, num_words) < 0;
+            });
+
+  RecordWriter run(RunPath(idx_run), num_words_, io_buffer_size_);
+  for (size_t i = 0; i < records.size(); i++) {
+    if (i > 0 && Compare(records[i - 1], records[i], num_words_) == 0) continue;
+    run.Write(records[i]);
+  }
+  run.Close();
+  buffer->clear();
+}
+
+size_t ExternalBreadthFirstSearch::Merge(
+    const std::vector<std::string>& paths, const std::string& path_output,
+    const std::string& path_closed) const {
+  std::vector<RecordReader> inputs;
+  inputs.reserve(paths.size());
+  for (const std::string& path : paths) {
+    inputs.emplace_back(path, num_words_, io_buffer_size_);
+  }
+  const size_t num_words = num_words_;
+  const auto CompareInputs = [&inputs, num_words](size_t lhs, size_t rhs) {
+    return Compare(inputs[lhs].record(), inputs[rhs].record(), num_words) > 0;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(CompareInputs)>
+      queue(CompareInputs);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (inputs[i].Next()) queue.push(i);
+  }
+
+  std::optional<RecordReader> closed;
+  bool has_closed = false;
+  if (!path_closed.empty()) {
+    closed.emplace(path_closed, num_words_, io_buffer_size_);
+    has_closed = closed->Next();
+  }
+
+  RecordWriter output(path_output, num_words_, io_buffer_size_);
+  std::vector<uint64_t> last(num_words_);
+  bool has_last = false;
+  while (!queue.empty()) {
+    const size_t idx_input = queue.top();
+    queue.pop();
+    const uint64_t* record = inputs[idx_input].record();
+
+    if (!has_last || Compare(record, last.data(), num_words_) != 0) {
+      last.assign(record, record + num_words_);
+      has_last = true;
+
+      // Skip states in the closed list.
+      while (has_closed && Compare(closed->record(), record, num_words_) < 0) {
+        has_closed = closed->Next();
+      }
+      if (!has_closed || Compare(closed->record(), record, num_words_) != 0) {
+        output.Write(record);
+      }
+    }
+
+    if (inputs[idx_input].Next()) queue.push(idx_input);
+  }
+  output.Close();
+  return output.num_records();
+}
+
+size_t ExternalBreadthFirstSearch::MergeRuns(size_t num_runs,
+                                             size_t depth) const {
+  // Merge the runs in passes until they fit in a single merge.
+  while (num_runs > max_fan_in_) {
+    const size_t num_merged = (num_runs + max_fan_in_ - 1) / max_fan_in_;
+    for (size_t i = 0; i < num_merged; i++) {
+      std::vector<std::string> paths;
+      for (size_t j = i * max_fan_in_;
+           j < std::min((i + 1) * max_fan_in_, num_runs); j++) {
+        paths.push_back(RunPath(j));
+      }
+      Merge(paths, MergePath());
+
+      // Inputs of the earlier merges have already been removed.
+      for (const std::string& path : paths) std::filesystem::remove(path);
+      std::filesystem::rename(MergePath(), RunPath(i));
+    }
+    num_runs = num_merged;
+  }
+
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < num_runs; i++) paths.push_back(RunPath(i));
+  const size_t size = Merge(paths, LayerPath(depth + 1), ClosedPath());
+  for (const std::string& path : paths) std::filesystem::remove(path);
+
+  // Add the new layer to the closed list.
+  Merge({ClosedPath(), LayerPath(depth + 1)}, MergePath());
+  std::filesystem::rename(MergePath(), ClosedPath());
+  return size;
+}
+
+std::vector<std::string> ExternalBreadthFirstSearch::ExtractPlan(
+    size_t depth, std::vector<uint64_t> record) const {
+  std::vector<std::string> plan(depth);
+  std::vector<uint64_t> child_record(num_words_);
+  for (size_t d = depth; d-- > 0;) {
+    RecordReader layer(LayerPath(d), num_words_, io_buffer_size_);
+    bool is_found = false;
+    while (!is_found && layer.Next()) {
+      for (const Planner::Node& child :
+           Planner::Node(pddl_, Decode(layer.record()))) {
+        Encode(child.state(), child_record.data());
+        if (child_record != record) continue;
+
+        plan[d] = child.action();
+        record.assign(layer.record(), layer.record() + num_words_);
+        is_found = true;
+        break;
+      }
+    }
+    if (!is_found) {
+      throw std::runtime_error(
+          "ExternalBreadthFirstSearch::ExtractPlan(): Could not find the "
+          "parent of a state in layer " +
+          std::to_string(d + 1) + ".");
+    }
+  }
+  return plan;
+}
+
+void ExternalBreadthFirstSearch::RemoveFiles() const {
+  for (const std::filesystem::directory_entry& entry :
+       std::filesystem::directory_iterator(directory_)) {
+    std::filesystem::remove(entry.path());
+  }
+}
+
+std::optional<std::vector<std::string>> ExternalBreadthFirstSearch::Search(
+    size_t max_depth, bool verbose) {
+  RemoveFiles();
+  layer_sizes_.clear();
+
+  std::vector<uint64_t> record(num_words_);
+  Encode(pddl_.initial_state(), record.data());
+  for (const std::string& path : {LayerPath(0), ClosedPath()}) {
+    RecordWriter root(path, num_words_, io_buffer_size_);
+    root.Write(record.data());
+    root.Close();
+  }
+  layer_sizes_.push_back(1);
+
+  std::vector<uint64_t> buffer;
+  for (size_t depth = 0;; depth++) {
+    if (verbose) {
+      std::cout << "External BFS depth " << depth << ": "
+                << layer_sizes_.back() << " states" << std::endl;
+    }
+
+    // Stream the layer from disk and spill its children in sorted runs.
+    size_t num_runs = 0;
+    buffer.reserve(buffer_size_);
+    RecordReader layer(LayerPath(depth), num_words_, io_buffer_size_);
+    while (layer.Next()) {
+      const State state = Decode(layer.record());
+      if (pddl_.IsGoalSatisfied(state)) {
+        record.assign(layer.record(), layer.record() + num_words_);
+        return ExtractPlan(depth, std::move(record));
+      }
+      if (depth >= max_depth) continue;
+
+      for (const Planner::Node& child : Planner::Node(pddl_, state)) {
+        buffer.resize(buffer.size() + num_words_);
+        Encode(child.state(), &buffer[buffer.size() - num_words_]);
+        if (buffer.size() + num_words_ > buffer_size_) {
+          WriteRun(&buffer, num_runs++);
+        }
+      }
+    }
+    if (depth >= max_depth) break;
+    if (!buffer.empty()) WriteRun(&buffer, num_runs++);
+
+    // Release the sorting buffer so that the merge stays within the budget.
+    std::vector<uint64_t>().swap(buffer);
+    const size_t size = MergeRuns(num_runs, depth);
+    if (size == 0) break;
+    layer_sizes_.push_back(size);
+  }
+  return {};
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "ExternalBreadthFirstSearch") {
+  // Spill a run for every few states to exercise the merge.
+  ExternalBreadthFirstSearch search(pddl, "", 4 * sizeof(uint64_t));
+  const std::optional<std::vector<std::string>> plan = search.Search();
+  REQUIRE(plan.has_value());
+
+  REQUIRE(testing::IsValidPlan(pddl, *plan));
+
+  // The plan should be as short as the explicit BFS plan.
+  REQUIRE(plan->size() == testing::OptimalPlanLength(pddl));
+
+  // Layers should not repeat states.
+  const std::vector<size_t>& layer_sizes = search.layer_sizes();
+  REQUIRE(layer_sizes.size() == plan->size() + 1);
+  REQUIRE(layer_sizes[1] == 1);
+
+  // Merging all the runs at once should find the same layers.
+  ExternalBreadthFirstSearch search_single(pddl);
+  REQUIRE(search_single.Search().has_value());
+  REQUIRE(search_single.layer_sizes() == layer_sizes);
+
+  // The search should stop at the maximum depth.
+  REQUIRE(!search.Search(plan->size() - 1).has_value());
+}
+
+}  // namespace symbolic
@@ -0,0 +1,746 @@
+/**
+ * finite_domain.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/finite_domain.h"
+
+#include <algorithm>      // std::any_of, std::binary_search, std::sort
+#include <deque>          // std::deque
+#include <map>            // std::map
+#include <set>            // std::set
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string
+#include <tuple>          // std::tie
+#include <unordered_set>  // std::unordered_set
+#include <utility>        // std::move
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/planner.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Axiom;
+using ::symbolic::GroundedTask;
+using ::symbolic::MutexGroup;
+using ::symbolic::PartialState;
+using ::symbolic::Proposition;
+using ::symbolic::State;
+using ::symbolic::StateIndex;
+
+constexpr size_t kWordSize = 64;
+constexpr size_t kHashOffset = 0x9e3779b97f4a7c15;
+constexpr size_t kHashL = 6;
+constexpr size_t kHashR = 2;
+
+// Limits of the candidate invariant search.
+constexpr size_t kMaxFamilySize = 3;
+constexpr size_t kMaxNumCandidates = 1000;
+
+/**
+ * Classification of the atoms by relaxed reachability.
+ */
+struct AtomAnalysis {
+  std::vector<bool> is_derived;
+  std::vector<bool> is_static;
+  std::vector<bool> is_fluent;
+  std::vector<bool> is_unreachable;
+
+  // Operators that are applicable in the delete relaxation.
+  std::vector<size_t> idx_operators;
+};
+
+AtomAnalysis AnalyzeAtoms(const GroundedTask& task) {
+  const size_t num_atoms = task.num_atoms();
+  AtomAnalysis analysis;
+  analysis.is_derived.assign(num_atoms, false);
+  for (const GroundedTask::Rule& rule : task.rules()) {
+    analysis.is_derived[rule.head] = true;
+  }
+
+  // Compute the relaxed reachable atoms, ignoring negative conditions.
+  std::vector<bool> is_reached(num_atoms, false);
+  for (const size_t atom : task.initial_state()) is_reached[atom] = true;
+  const auto IsReached = [&is_reached](const std::vector<size_t>& atoms) {
+    for (const size_t atom : atoms) {
+      if (!is_reached[atom]) return false;
+    }
+    return true;
+  };
+  std::vector<bool> is_applied(task.operators().size(), false);
+  bool is_changed = true;
+  while (is_changed) {
+    is_changed = false;
+    for (size_t i = 0; i < task.operators().size(); i++) {
+      const GroundedTask::Operator& op = task.operators()[i];
+      if (is_applied[i] || !IsReached(op.pre_pos)) continue;
+      is_applied[i] = true;
+      analysis.idx_operators.push_back(i);
+      for (const size_t atom : op.add) is_reached[atom] = true;
+      is_changed = true;
+    }
+    for (const GroundedTask::Rule& rule : task.rules()) {
+      if (is_reached[rule.head] || !IsReached(rule.pos)) continue;
+      is_reached[rule.head] = true;
+      is_changed = true;
+    }
+  }
+  std::sort(analysis.idx_operators.begin(), analysis.idx_operators.end());
+
+  std::vector<bool> is_deleted(num_atoms, false);
+  for (const size_t idx_op : analysis.idx_operators) {
+    const GroundedTask::Operator& op = task.operators()[idx_op];
+    for (const size_t atom : op.del) {
+      if (!std::binary_search(op.add.begin(), op.add.end(), atom)) {
+        is_deleted[atom] = true;
+      }
+    }
+  }
+
+  std::vector<bool> is_initial(num_atoms, false);
+  for (const size_t atom : task.initial_state()) is_initial[atom] = true;
+
+  analysis.is_static.assign(num_atoms, false);
+  analysis.is_fluent.assign(num_atoms, false);
+  analysis.is_unreachable.assign(num_atoms, false);
+  for (size_t atom = 0; atom < num_atoms; atom++) {
+    if (analysis.is_derived[atom]) continue;
+    if (!is_reached[atom]) {
+      analysis.is_unreachable[atom] = true;
+    } else if (is_initial[atom] && !is_deleted[atom]) {
+      analysis.is_static[atom] = true;
+    } else {
+      analysis.is_fluent[atom] = true;
+    }
+  }
+  return analysis;
+}
+
+/**
+ * Predicate of a schematic invariant with the positions of its arguments that
+ * are fixed within an instance.
+ */
+struct Member {
+  size_t idx_predicate;
+  std::vector<size_t> fixed;
+
+  friend bool operator<(const Member& lhs, const Member& rhs) {
+    return std::tie(lhs.idx_predicate, lhs.fixed) <
+           std::tie(rhs.idx_predicate, rhs.fixed);
+  }
+
+  friend bool operator==(const Member& lhs, const Member& rhs) {
+    return std::tie(lhs.idx_predicate, lhs.fixed) ==
+           std::tie(rhs.idx_predicate, rhs.fixed);
+  }
+};
+
+// Sorted members of a schematic invariant.
+using Family = std::vector<Member>;
+
+// Fixed arguments of an instance.
+using Key = std::vector<std::string>;
+
+/**
+ * Checks schematic invariants against the grounded operators.
+ */
+class InvariantChecker {
+ public:
+  InvariantChecker(const GroundedTask& task, const AtomAnalysis& analysis);
+
+  const std::vector<size_t>& atoms(size_t idx_predicate) const {
+    return atoms_by_predicate_[idx_predicate];
+  }
+
+  const std::vector<std::string>& arguments(size_t atom) const {
+    return arguments_[atom];
+  }
+
+  size_t idx_predicate(size_t atom) const { return idx_predicates_[atom]; }
+
+  /**
+   * Groups the reached atoms of the family by their fixed arguments.
+   */
+  std::map<Key, std::vector<size_t>> Instantiate(const Family& family) const;
+
+  /**
+   * Returns -1 if the instance is invariant, the operator that violates the
+   * invariant, or the number of operators if the initial state violates it.
+   */
+  size_t Check(const std::vector<size_t>& atoms);
+
+  /**
+   * Whether an invariant instance always has exactly one true atom.
+   */
+  bool IsExactlyOne(const std::vector<size_t>& atoms);
+
+ private:
+  void Mark(const std::vector<size_t>& atoms);
+
+  bool IsMarked(size_t atom) const { return marks_[atom] == mark_; }
+
+  const GroundedTask& task_;
+
+  std::vector<size_t> idx_predicates_;
+  std::vector<std::vector<std::string>> arguments_;
+  std::vector<std::vector<size_t>> atoms_by_predicate_;
+  std::vector<bool> is_initial_;
+
+  // Reachable operators that add and delete each atom.
+  std::vector<std::vector<size_t>> achievers_;
+  std::vector<std::vector<size_t>> deleters_;
+
+  std::vector<size_t> marks_;
+  size_t mark_ = 0;
+};
+
+InvariantChecker::InvariantChecker(const GroundedTask& task,
+                                   const AtomAnalysis& analysis)
+    : task_(task),
+      idx_predicates_(task.num_atoms()),
+      arguments_(task.num_atoms()),
+      is_initial_(task.num_atoms(), false),
+      achievers_(task.num_atoms()),
+      deleters_(task.num_atoms()),
+      marks_(task.num_atoms(), 0) {
+  const StateIndex& state_index = task.pddl().state_index();
+  atoms_by_predicate_.resize(state_index.num_predicates());
+  for (size_t atom = 0; atom < task.num_atoms(); atom++) {
+    const Proposition prop = state_index.GetProposition(atom);
+    idx_predicates_[atom] = state_index.GetPredicateIndex(prop.name());
+    for (const symbolic::Object& arg : prop.arguments()) {
+      arguments_[atom].push_back(arg.name());
+    }
+    if (analysis.is_fluent[atom] || analysis.is_static[atom]) {
+      atoms_by_predicate_[idx_predicates_[atom]].push_back(atom);
+    }
+  }
+  for (const size_t atom : task.initial_state()) is_initial_[atom] = true;
+
+  for (const size_t idx_op : analysis.idx_operators) {
+    const GroundedTask::Operator& op = task.operators()[idx_op];
+    for (const size_t atom : op.add) achievers_[atom].push_back(idx_op);
+    for (const size_t atom : op.del) deleters_[atom].push_back(idx_op);
+  }
+}
+
+std::map<Key, std::vector<size_t>> InvariantChecker::Instantiate(
+    const Family& family) const {
+  std::map<Key, std::vector<size_t>> instances;
+  Key key;
+  for (const Member& member : family) {
+    for (const size_t atom : atoms_by_predicate_[member.idx_predicate]) {
+      key.clear();
+      for (const size_t pos : member.fixed) {
+        key.push_back(arguments_[atom][pos]);
+      }
+      instances[key].push_back(atom);
+    }
+  }
+  for (auto& key_atoms : instances) {
+    std::sort(key_atoms.second.begin(), key_atoms.second.end());
+  }
+  return instances;
+}
+
+void InvariantChecker::Mark(const std::vector<size_t>& atoms) {
+  mark_++;
+  for (const size_t atom : atoms) marks_[atom] = mark_;
+}
+
+size_t InvariantChecker::Check(const std::vector<size_t>& atoms) {
+  const size_t kValid = -1;
+  const size_t num_operators = task_.operators().size();
+
+  size_t num_initial = 0;
+  for (const size_t atom : atoms) num_initial += is_initial_[atom] ? 1 : 0;
+  if (num_initial > 1) return num_operators;
+
+  Mark(atoms);
+  for (const size_t atom : atoms) {
+    for (const size_t idx_op : achievers_[atom]) {
+      const GroundedTask::Operator& op = task_.operators()[idx_op];
+
+      // Adding two atoms of the group violates the invariant.
+      size_t num_added = 0;
+      for (const size_t added : op.add) num_added += IsMarked(added) ? 1 : 0;
+      if (num_added > 1) return idx_op;
+
+      // The atom is already true, so the others are false.
+      if (std::binary_search(op.pre_pos.begin(), op.pre_pos.end(), atom)) {
+        continue;
+      }
+
+      // Some other atom of the group is required and deleted.
+      bool is_balanced = false;
+      for (const size_t pre : op.pre_pos) {
+        if (pre != atom && IsMarked(pre) &&
+            std::binary_search(op.del.begin(), op.del.end(), pre)) {
+          is_balanced = true;
+          break;
+        }
+      }
+      if (is_balanced) continue;
+
+      // All other atoms of the group are required false or deleted.
+      is_balanced = true;
+      for (const size_t other : atoms) {
+        if (other == atom) continue;
+        if (!std::binary_search(op.del.begin(), op.del.end(), other) &&
+            !std::binary_search(op.pre_neg.begin(), op.pre_neg.end(), other)) {
+          is_balanced = false;
+          break;
+        }
+      }
+      if (!is_balanced) return idx_op;
+    }
+  }
+  return kValid;
+}
+
+bool InvariantChecker::IsExactlyOne(const std::vector<size_t>& atoms) {
+  size_t num_initial = 0;
+  for (const size_t atom : atoms) num_initial += is_initial_[atom] ? 1 : 0;
+  if (num_initial != 1) return false;
+
+  // Every operator that deletes a possibly true atom must add another one.
+  Mark(atoms);
+  for (const size_t atom : atoms) {
+    for (const size_t idx_op : deleters_[atom]) {
+      const GroundedTask::Operator& op = task_.operators()[idx_op];
+      if (std::binary_search(op.pre_neg.begin(), op.pre_neg.end(), atom)) {
+        continue;
+      }
+      bool is_added = false;
+      for (const size_t added : op.add) is_added |= IsMarked(added);
+      if (!is_added) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Enumerates the positions of the arguments of an atom that match the given
+ * fixed arguments.
+ */
+void MatchPositions(const std::vector<std::string>& args, const Key& key,
+                    std::vector<size_t>* fixed,
+                    std::vector<std::vector<size_t>>* matches) {
+  if (fixed->size() == key.size()) {
+    matches->push_back(*fixed);
+    return;
+  }
+  const std::string& arg = key[fixed->size()];
+  for (size_t pos = 0; pos < args.size(); pos++) {
+    if (args[pos] != arg ||
+        std::find(fixed->begin(), fixed->end(), pos) != fixed->end()) {
+      continue;
+    }
+    fixed->push_back(pos);
+    MatchPositions(args, key, fixed, matches);
+    fixed->pop_back();
+  }
+}
+
+/**
+ * Creates a candidate that relates the atom to the fixed arguments.
+ */
+void AddMatchingMembers(const InvariantChecker& checker, const Family& family,
+                        const Key& key, size_t atom,
+                        std::vector<Family>* candidates) {
+  const size_t idx_predicate = checker.idx_predicate(atom);
+  for (const Member& member : family) {
+    if (member.idx_predicate == idx_predicate) return;
+  }
+
+  std::vector<size_t> fixed;
+  std::vector<std::vector<size_t>> matches;
+  MatchPositions(checker.arguments(atom), key, &fixed, &matches);
+  for (std::vector<size_t>& match : matches) {
+    Family candidate = family;
+    candidate.push_back({idx_predicate, std::move(match)});
+    std::sort(candidate.begin(), candidate.end());
+    candidates->push_back(std::move(candidate));
+  }
+}
+
+/**
+ * Creates candidates from the axioms whose context implies that other atoms
+ * are false.
+ */
+void AddAxiomCandidates(const GroundedTask& task, const AtomAnalysis& analysis,
+                        const InvariantChecker& checker,
+                        std::vector<Family>* candidates) {
+  const StateIndex& state_index = task.pddl().state_index();
+  for (const std::shared_ptr<Axiom>& axiom : task.pddl().axioms()) {
+    if (!axiom->context().is_pos()) continue;
+    const int idx_predicate =
+        state_index.GetPredicateIndex(axiom->context().name());
+    if (idx_predicate < 0) continue;
+
+    for (const size_t atom : checker.atoms(idx_predicate)) {
+      const State context = {state_index.GetProposition(atom)};
+      const PartialState implied = axiom->Apply(PartialState(context, State()));
+      for (const Proposition& prop : implied.neg()) {
+        const size_t other = state_index.GetPropositionIndex(prop);
+        if (!analysis.is_fluent[other]) continue;
+
+        // Fix the arguments that the two atoms share.
+        Family family = {{static_cast<size_t>(idx_predicate), {}}};
+        Key key;
+        const std::vector<std::string>& args = checker.arguments(atom);
+        const std::vector<std::string>& other_args = checker.arguments(other);
+        for (size_t pos = 0; pos < args.size(); pos++) {
+          if (std::find(other_args.begin(), other_args.end(), args[pos]) ==
+              other_args.end()) {
+            continue;
+          }
+          family[0].fixed.push_back(pos);
+          key.push_back(args[pos]);
+        }
+        AddMatchingMembers(checker, family, key, other, candidates);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+namespace symbolic {
+
+std::vector<MutexGroup> FindMutexGroups(const GroundedTask& task) {
+  const AtomAnalysis analysis = AnalyzeAtoms(task);
+  InvariantChecker checker(task, analysis);
+  const StateIndex& state_index = task.pddl().state_index();
+
+  // Seed candidates with at most one counted argument per predicate.
+  std::vector<Family> seeds;
+  for (size_t idx_predicate = 0; idx_predicate < state_index.num_predicates();
+       idx_predicate++) {
+    const std::vector<size_t>& atoms = checker.atoms(idx_predicate);
+    const bool has_fluent = std::any_of(
+        atoms.begin(), atoms.end(),
+        [&analysis](size_t atom) { return analysis.is_fluent[atom]; });
+    if (!has_fluent) continue;
+
+    const size_t arity = checker.arguments(atoms.front()).size();
+    for (size_t counted = 0; counted <= arity; counted++) {
+      Member member{idx_predicate, {}};
+      for (size_t pos = 0; pos < arity; pos++) {
+        if (pos != counted) member.fixed.push_back(pos);
+      }
+      seeds.push_back({std::move(member)});
+    }
+  }
+  AddAxiomCandidates(task, analysis, checker, &seeds);
+
+  std::deque<Family> queue(seeds.begin(), seeds.end());
+  std::set<Family> visited(seeds.begin(), seeds.end());
+  std::map<std::vector<size_t>, bool> groups;
+  std::vector<Family> refinements;
+  size_t num_candidates = 0;
+  while (!queue.empty() && num_candidates < kMaxNumCandidates) {
+    const Family family = std::move(queue.front());
+    queue.pop_front();
+    num_candidates++;
+
+    const std::map<Key, std::vector<size_t>> instances =
+        checker.Instantiate(family);
+    bool is_invariant = true;
+    for (const auto& [key, atoms] : instances) {
+      const size_t idx_op = checker.Check(atoms);
+      if (idx_op == static_cast<size_t>(-1)) continue;
+      is_invariant = false;
+
+      // Refine the candidate with the atoms deleted by the operator.
+      if (idx_op == task.operators().size() ||
+          family.size() >= kMaxFamilySize) {
+        break;
+      }
+      refinements.clear();
+      for (const size_t atom : task.operators()[idx_op].del) {
+        if (!analysis.is_fluent[atom]) continue;
+        AddMatchingMembers(checker, family, key, atom, &refinements);
+      }
+      for (Family& refinement : refinements) {
+        if (visited.insert(refinement).second) {
+          queue.push_back(std::move(refinement));
+        }
+      }
+      break;
+    }
+    if (!is_invariant) continue;
+
+    for (const auto& key_atoms : instances) {
+      const std::vector<size_t>& atoms = key_atoms.second;
+      std::vector<size_t> fluents;
+      for (const size_t atom : atoms) {
+        if (analysis.is_fluent[atom]) fluents.push_back(atom);
+      }
+      if (fluents.size() < 2) continue;
+      const bool is_exactly_one =
+          fluents.size() == atoms.size() && checker.IsExactlyOne(atoms);
+      bool& is_exactly_one_group = groups[std::move(fluents)];
+      is_exactly_one_group |= is_exactly_one;
+    }
+  }
+
+  std::vector<MutexGroup> mutex_groups;
+  mutex_groups.reserve(groups.size());
+  for (const auto& [atoms, is_exactly_one] : groups) {
+    mutex_groups.push_back({atoms, is_exactly_one});
+  }
+  return mutex_groups;
+}
+
+size_t FiniteDomainEncoding::Hash::operator()(
+    const PackedState& state) const {
+  size_t seed = 0;
+  for (const uint64_t word : state) {
+    seed ^= word + kHashOffset + (seed << kHashL) + (seed >> kHashR);
+  }
+  return seed;
+}
+
+FiniteDomainEncoding::FiniteDomainEncoding(const GroundedTask& task)
+    : FiniteDomainEncoding(task, FindMutexGroups(task)) {}
+
+FiniteDomainEncoding::FiniteDomainEncoding(
+    const GroundedTask& task, const std::vector<MutexGroup>& mutex_groups)
+    : pddl_(&task.pddl()),
+      idx_variables_(task.num_atoms(), -1),
+      values_(task.num_atoms(), 0) {
+  const AtomAnalysis analysis = AnalyzeAtoms(task);
+  is_unreachable_ = analysis.is_unreachable;
+  for (size_t atom = 0; atom < task.num_atoms(); atom++) {
+    if (analysis.is_static[atom]) static_atoms_.push_back(atom);
+  }
+
+  // Cover the fluent atoms greedily with the largest remaining group.
+  std::vector<bool> is_covered(task.num_atoms(), false);
+  std::vector<size_t> atoms;
+  while (true) {
+    size_t max_size = 0;
+    const MutexGroup* max_group = nullptr;
+    for (const MutexGroup& group : mutex_groups) {
+      size_t size = 0;
+      for (const size_t atom : group.atoms) {
+        size += analysis.is_fluent[atom] && !is_covered[atom] ? 1 : 0;
+      }
+      if (size > max_size) {
+        max_size = size;
+        max_group = &group;
+      }
+    }
+    if (max_size < 2) break;
+
+    atoms.clear();
+    for (const size_t atom : max_group->atoms) {
+      if (!analysis.is_fluent[atom] || is_covered[atom]) continue;
+      is_covered[atom] = true;
+      atoms.push_back(atom);
+    }
+    const bool has_none =
+        !max_group->is_exactly_one || atoms.size() != max_group->atoms.size();
+    variables_.push_back({atoms, has_none, 0, 0, 0});
+  }
+  for (size_t atom = 0; atom < task.num_atoms(); atom++) {
+    if (analysis.is_fluent[atom] && !is_covered[atom]) {
+      variables_.push_back({{atom}, true, 0, 0, 0});
+    }
+  }
+
+  for (size_t i = 0; i < variables_.size(); i++) {
+    const Variable& var = variables_[i];
+    for (size_t value = 0; value < var.atoms.size(); value++) {
+      idx_variables_[var.atoms[value]] = static_cast<int>(i);
+      values_[var.atoms[value]] = value;
+    }
+  }
+
+  // Pack the widest variables first into the first word with enough space.
+  std::vector<size_t> bits(variables_.size());
+  std::vector<size_t> order(variables_.size());
+  for (size_t i = 0; i < variables_.size(); i++) {
+    const size_t max_value = variables_[i].domain_size() - 1;
+    bits[i] = max_value == 0 ? 1 : kWordSize - __builtin_clzll(max_value);
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&bits](size_t a, size_t b) { return bits[a] > bits[b]; });
+  std::vector<size_t> word_bits;
+  for (const size_t i : order) {
+    size_t idx_word = 0;
+    while (idx_word < word_bits.size() &&
+           word_bits[idx_word] + bits[i] > kWordSize) {
+      idx_word++;
+    }
+    if (idx_word == word_bits.size()) word_bits.push_back(0);
+
+    Variable& var = variables_[i];
+    var.idx_word = idx_word;
+    var.shift = static_cast<uint8_t>(word_bits[idx_word]);
+    var.mask = bits[i] == kWordSize ? ~uint64_t{0}
+                                    : (uint64_t{1} << bits[i]) - 1;
+    word_bits[idx_word] += bits[i];
+  }
+  num_words_ = word_bits.size();
+}
+
+FiniteDomainEncoding::PackedState FiniteDomainEncoding::Encode(
+    const State& state) const {
+  std::vector<size_t> atoms;
+  pddl_->state_index().GetPropositionIndices(state, &atoms);
+  return Encode(atoms);
+}
+
+FiniteDomainEncoding::PackedState FiniteDomainEncoding::Encode(
+    const std::vector<size_t>& atoms) const {
+  PackedState state;
+  Encode(atoms, &state);
+  return state;
+}
+
+void FiniteDomainEncoding::Encode(const std::vector<size_t>& atoms,
+                                  PackedState* state) const {
+  state->assign(num_words_, 0);
+  size_t num_unassigned = 0;
+  for (size_t i = 0; i < variables_.size(); i++) {
+    if (variables_[i].has_none) {
+      Set(i, variables_[i].none(), state);
+    } else {
+      num_unassigned++;
+    }
+  }
+
+  for (const size_t atom : atoms) {
+    if (is_unreachable_[atom]) {
+      throw std::runtime_error(
+          "FiniteDomainEncoding::Encode(): Unreachable atom " +
+          pddl_->state_index().GetProposition(atom).to_string() + ".");
+    }
+    const int idx_var = idx_variables_[atom];
+    if (idx_var >= 0) Set(idx_var, values_[atom], state);
+  }
+
+  // Atoms of the same variable have different values, so an atom that was
+  // overwritten by another one violates a mutex group. Otherwise, each atom
+  // assigns a different variable.
+  for (const size_t atom : atoms) {
+    const int idx_var = idx_variables_[atom];
+    if (idx_var < 0) continue;
+
+    if (Get(*state, idx_var) != values_[atom]) {
+      throw std::runtime_error(
+          "FiniteDomainEncoding::Encode(): Atom " +
+          pddl_->state_index().GetProposition(atom).to_string() +
+          " violates a mutex group.");
+    }
+    if (!variables_[idx_var].has_none) num_unassigned--;
+  }
+
+  if (num_unassigned > 0) {
+    throw std::runtime_error(
+        "FiniteDomainEncoding::Encode(): State violates an exactly-one "
+        "mutex group.");
+  }
+}
+
+State FiniteDomainEncoding::Decode(const PackedState& state) const {
+  const StateIndex& state_index = pddl_->state_index();
+  State decoded;
+  decoded.reserve(static_atoms_.size() + variables_.size());
+  for (const size_t atom : static_atoms_) {
+    decoded.insert(state_index.GetProposition(atom));
+  }
+  for (size_t i = 0; i < variables_.size(); i++) {
+    const size_t value = Get(state, i);
+    if (value < variables_[i].atoms.size()) {
+      decoded.insert(state_index.GetProposition(variables_[i].atoms[value]));
+    }
+  }
+  return pddl_->DerivedState(decoded);
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "FiniteDomainEncoding") {
+  const GroundedTask task(pddl);
+  const StateIndex& state_index = pddl.state_index();
+
+  // Each block is either held or on exactly one object.
+  const std::vector<MutexGroup> mutex_groups = FindMutexGroups(task);
+  for (const std::string block : {"a", "b", "c"}) {
+    std::vector<size_t> atoms = {state_index.GetPropositionIndex(
+        Proposition(pddl, "inhand(" + block + ")"))};
+    for (const std::string obj : {"a", "b", "c", "table"}) {
+      if (obj == block) continue;
+      atoms.push_back(state_index.GetPropositionIndex(
+          Proposition(pddl, "on(" + block + ", " + obj + ")")));
+    }
+    std::sort(atoms.begin(), atoms.end());
+    const auto it = std::find_if(
+        mutex_groups.begin(), mutex_groups.end(),
+        [&atoms](const MutexGroup& group) { return group.atoms == atoms; });
+    REQUIRE(it != mutex_groups.end());
+    REQUIRE(it->is_exactly_one);
+  }
+
+  // At most one block is held.
+  std::vector<size_t> inhand;
+  for (const std::string block : {"a", "b", "c"}) {
+    inhand.push_back(state_index.GetPropositionIndex(
+        Proposition(pddl, "inhand(" + block + ")")));
+  }
+  std::sort(inhand.begin(), inhand.end());
+  const auto it = std::find_if(
+      mutex_groups.begin(), mutex_groups.end(),
+      [&inhand](const MutexGroup& group) { return group.atoms == inhand; });
+  REQUIRE(it != mutex_groups.end());
+  REQUIRE(!it->is_exactly_one);
+
+  // One four-valued variable per block.
+  const FiniteDomainEncoding encoding(task);
+  REQUIRE(encoding.num_variables() == 3);
+  REQUIRE(encoding.num_words() == 1);
+  for (const FiniteDomainEncoding::Variable& var : encoding.variables()) {
+    REQUIRE(var.domain_size() == 4);
+    REQUIRE(var.mask == 3);
+  }
+
+  // States should round trip through the encoding, and distinct states
+  // should have distinct encodings.
+  const Planner planner(pddl);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), 4);
+  std::unordered_set<State> states;
+  std::unordered_set<FiniteDomainEncoding::PackedState,
+                     FiniteDomainEncoding::Hash>
+      packed_states;
+  std::vector<size_t> atoms;
+  FiniteDomainEncoding::PackedState reused;
+  for (const std::vector<Planner::Node>& plan : bfs) {
+    for (const Planner::Node& node : plan) {
+      const FiniteDomainEncoding::PackedState packed =
+          encoding.Encode(node.state());
+      REQUIRE(encoding.Decode(packed) == node.state());
+
+      // Encoding into a reused buffer should give the same packed state.
+      pddl.state_index().GetPropositionIndices(node.state(), &atoms);
+      encoding.Encode(atoms, &reused);
+      REQUIRE(reused == packed);
+      states.insert(node.state());
+      packed_states.insert(packed);
+    }
+  }
+  REQUIRE(states.size() == packed_states.size());
+
+  // States that violate a mutex group cannot be encoded.
+  State state = pddl.initial_state();
+  state.emplace(pddl, "inhand(a)");
+  REQUIRE_THROWS(encoding.Encode(state));
+}
+
+}  // namespace symbolic
@@ -0,0 +1,146 @@
+/**
+ * grounded_task.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/grounded_task.h"
+
+#include <algorithm>  // std::includes
+#include <optional>   // std::optional
+#include <stdexcept>  // std::runtime_error
+#include <utility>    // std::pair
+
+#include "symbolic/normal_form.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::DisjunctiveFormula;
+using ::symbolic::State;
+using ::symbolic::StateIndex;
+
+std::vector<size_t> GetAtoms(const StateIndex& state_index,
+                             const State& state) {
+  std::vector<size_t> atoms;
+  state_index.GetPropositionIndices(state, &atoms);
+  return atoms;
+}
+
+}  // namespace
+
+namespace symbolic {
+
+GroundedTask::GroundedTask(const Pddl& pddl)
+    : pddl_(pddl), num_atoms_(pddl.state_index().size()) {
+  const StateIndex& state_index = pddl.state_index();
+
+  // Ground the actions.
+  for (size_t idx_action = 0; idx_action < pddl.actions().size();
+       idx_action++) {
+    const Action& action = pddl.actions()[idx_action];
+    const ParameterGenerator& param_gen = action.parameter_generator();
+    for (size_t idx_args = 0; idx_args < param_gen.size(); idx_args++) {
+      const std::optional<std::pair<DisjunctiveFormula, DisjunctiveFormula>>
+          conditions = DisjunctiveFormula::NormalizeConditions(
+              pddl, action.to_string(param_gen[idx_args]));
+      if (!conditions.has_value()) continue;
+
+      const DisjunctiveFormula& post = conditions->second;
+      if (post.conjunctions.size() != 1) {
+        throw std::runtime_error(
+            "GroundedTask::GroundedTask(): Conditional effects are not "
+            "supported.");
+      }
+      const PartialState& effects = post.conjunctions[0];
+      const std::vector<size_t> add = GetAtoms(state_index, effects.pos());
+      const std::vector<size_t> del = GetAtoms(state_index, effects.neg());
+
+      for (const PartialState& pre : conditions->first.conjunctions) {
+        operators_.push_back({idx_action, idx_args,
+                              GetAtoms(state_index, pre.pos()),
+                              GetAtoms(state_index, pre.neg()), add, del});
+      }
+    }
+  }
+
+  // Ground the derived predicates.
+  for (const DerivedPredicate& pred : pddl.derived_predicates()) {
+    const ParameterGenerator& param_gen = pred.parameter_generator();
+    for (size_t idx_args = 0; idx_args < param_gen.size(); idx_args++) {
+      const std::vector<Object> args = param_gen[idx_args];
+      const std::optional<DisjunctiveFormula> body = DisjunctiveFormula::Create(
+          pddl, pred.preconditions().symbol(), pred.parameters(), args);
+      if (!body.has_value()) continue;
+
+      const size_t head =
+          state_index.GetPropositionIndex(Proposition(pred.name(), args));
+      for (const PartialState& conj : body->conjunctions) {
+        rules_.push_back({head, GetAtoms(state_index, conj.pos()),
+                          GetAtoms(state_index, conj.neg())});
+      }
+    }
+  }
+
+  initial_state_ = GetAtoms(state_index, pddl.initial_state());
+
+  const std::optional<DisjunctiveFormula> goal =
+      DisjunctiveFormula::NormalizeGoal(pddl);
+  if (!goal.has_value() || goal->conjunctions.size() != 1) {
+    throw std::runtime_error(
+        "GroundedTask::GroundedTask(): The goal must be a single conjunction.");
+  }
+  goal_pos_ = GetAtoms(state_index, goal->conjunctions[0].pos());
+  goal_neg_ = GetAtoms(state_index, goal->conjunctions[0].neg());
+}
+
+std::string GroundedTask::action(const Operator& op) const {
+  const Action& action = pddl_.actions()[op.idx_action];
+  return action.to_string(action.parameter_generator()[op.idx_arguments]);
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "GroundedTask") {
+  const GroundedTask task(pddl);
+  const StateIndex& state_index = pddl.state_index();
+
+  // Each applicable operator should reproduce the successor state, up to the
+  // derived predicates.
+  const State& state = pddl.initial_state();
+  const std::vector<size_t> atoms = GetAtoms(state_index, state);
+  const auto Contains = [&atoms](const std::vector<size_t>& subset) {
+    return std::includes(atoms.begin(), atoms.end(), subset.begin(),
+                         subset.end());
+  };
+  size_t num_applicable = 0;
+  for (const GroundedTask::Operator& op : task.operators()) {
+    bool is_applicable = Contains(op.pre_pos);
+    for (const size_t atom : op.pre_neg) {
+      is_applicable &= !Contains({atom});
+    }
+    REQUIRE(is_applicable == pddl.IsValidAction(state, task.action(op)));
+    if (!is_applicable) continue;
+    num_applicable++;
+
+    const State next_state = pddl.NextState(state, task.action(op));
+    for (const size_t atom : op.add) {
+      REQUIRE(next_state.contains(state_index.GetProposition(atom)));
+    }
+    for (const size_t atom : op.del) {
+      REQUIRE(!next_state.contains(state_index.GetProposition(atom)));
+    }
+  }
+  REQUIRE(num_applicable == pddl.ListValidActions(state).size());
+
+  // Every satisfied rule should derive an atom of the initial state.
+  for (const GroundedTask::Rule& rule : task.rules()) {
+    if (!Contains(rule.pos)) continue;
+    bool is_satisfied = true;
+    for (const size_t atom : rule.neg) is_satisfied &= !Contains({atom});
+    if (is_satisfied) REQUIRE(Contains({rule.head}));
+  }
+}
+
+}  // namespace symbolic
@@ -0,0 +1,306 @@
+/**
+ * landmarks.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/landmarks.h"
+
+#include <algorithm>  // std::copy, std::fill
+#include <limits>     // std::numeric_limits
+#include <utility>    // std::move
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/width_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+constexpr size_t kWordSize = 64;
+
+size_t NumWords(size_t num_bits) {
+  return (num_bits + kWordSize - 1) / kWordSize;
+}
+
+bool TestBit(const uint64_t* bits, size_t idx) {
+  return (bits[idx / kWordSize] >> (idx % kWordSize)) & 1;
+}
+
+void SetBit(uint64_t* bits, size_t idx) {
+  bits[idx / kWordSize] |= uint64_t{1} << (idx % kWordSize);
+}
+
+/**
+ * Operator of the delete relaxation, with derived predicate rules as
+ * achievers of their head.
+ */
+struct RelaxedOperator {
+  const std::vector<size_t>* pre;
+  std::vector<size_t> add;
+};
+
+}  // namespace
+
+namespace symbolic {
+
+LandmarkGraph::LandmarkGraph(const GroundedTask& task)
+    : idx_landmarks_(task.num_atoms(), -1) {
+  const size_t num_atoms = task.num_atoms();
+  const size_t num_words = NumWords(num_atoms);
+
+  std::vector<RelaxedOperator> ops;
+  ops.reserve(task.operators().size() + task.rules().size());
+  for (const GroundedTask::Operator& op : task.operators()) {
+    ops.push_back({&op.pre_pos, op.add});
+  }
+  for (const GroundedTask::Rule& rule : task.rules()) {
+    ops.push_back({&rule.pos, {rule.head}});
+  }
+
+  // Landmark sets of each atom, stored as rows of a bit matrix.
+  std::vector<uint64_t> landmarks(num_atoms * num_words, 0);
+  std::vector<bool> is_reached(num_atoms, false);
+  const auto Row = [&landmarks, num_words](size_t atom) {
+    return &landmarks[atom * num_words];
+  };
+  for (const size_t atom : task.initial_state()) {
+    is_reached[atom] = true;
+    SetBit(Row(atom), atom);
+  }
+
+  // Computes the union of the landmarks of the operator preconditions, or
+  // returns false if the operator is not reached yet.
+  std::vector<uint64_t> pre_landmarks(num_words);
+  const auto UnionPreconditions = [&](const RelaxedOperator& op) {
+    for (const size_t atom : *op.pre) {
+      if (!is_reached[atom]) return false;
+    }
+    std::fill(pre_landmarks.begin(), pre_landmarks.end(), 0);
+    for (const size_t atom : *op.pre) {
+      const uint64_t* row = Row(atom);
+      for (size_t w = 0; w < num_words; w++) pre_landmarks[w] |= row[w];
+    }
+    return true;
+  };
+
+  // Propagate landmark sets to a fixpoint.
+  bool is_changed = true;
+  while (is_changed) {
+    is_changed = false;
+    for (const RelaxedOperator& op : ops) {
+      if (!UnionPreconditions(op)) continue;
+
+      for (const size_t atom : op.add) {
+        uint64_t* row = Row(atom);
+        if (!is_reached[atom]) {
+          is_reached[atom] = true;
+          std::copy(pre_landmarks.begin(), pre_landmarks.end(), row);
+          SetBit(row, atom);
+          is_changed = true;
+          continue;
+        }
+
+        // Intersect with the landmarks of this achiever.
+        for (size_t w = 0; w < num_words; w++) {
+          uint64_t word = pre_landmarks[w];
+          if (w == atom / kWordSize) word |= uint64_t{1} << (atom % kWordSize);
+          if ((row[w] & word) == row[w]) continue;
+          row[w] &= word;
+          is_changed = true;
+        }
+      }
+    }
+  }
+
+  // Collect the landmarks of the goal atoms.
+  std::vector<uint64_t> goal_landmarks(num_words, 0);
+  for (const size_t atom : task.goal_pos()) {
+    if (!is_reached[atom]) {
+      is_solvable_ = false;
+      continue;
+    }
+    const uint64_t* row = Row(atom);
+    for (size_t w = 0; w < num_words; w++) goal_landmarks[w] |= row[w];
+  }
+  for (size_t atom = 0; atom < num_atoms; atom++) {
+    if (!TestBit(goal_landmarks.data(), atom)) continue;
+    idx_landmarks_[atom] = static_cast<int>(atoms_.size());
+    atoms_.push_back(atom);
+  }
+  is_goal_.resize(atoms_.size(), false);
+  for (const size_t atom : task.goal_pos()) {
+    if (idx_landmarks_[atom] >= 0) is_goal_[idx_landmarks_[atom]] = true;
+  }
+
+  // Natural orderings follow from the landmark sets.
+  natural_orderings_.resize(atoms_.size());
+  for (size_t i = 0; i < atoms_.size(); i++) {
+    const uint64_t* row = Row(atoms_[i]);
+    for (size_t j = 0; j < atoms_.size(); j++) {
+      if (j != i && TestBit(row, atoms_[j])) natural_orderings_[i].push_back(j);
+    }
+  }
+
+  // Greedy-necessary orderings are the landmarks shared by the preconditions
+  // of all first achievers, which can be applied before the landmark holds.
+  std::vector<std::vector<size_t>> achievers(num_atoms);
+  for (size_t i = 0; i < ops.size(); i++) {
+    for (const size_t atom : ops[i].add) {
+      if (idx_landmarks_[atom] >= 0) achievers[atom].push_back(i);
+    }
+  }
+  greedy_necessary_orderings_.resize(atoms_.size());
+  std::vector<uint64_t> shared(num_words);
+  std::vector<uint64_t> pre(num_words);
+  for (size_t i = 0; i < atoms_.size(); i++) {
+    const size_t atom = atoms_[i];
+    bool has_achiever = false;
+    std::fill(shared.begin(), shared.end(), ~uint64_t{0});
+    for (const size_t idx_op : achievers[atom]) {
+      if (!UnionPreconditions(ops[idx_op]) ||
+          TestBit(pre_landmarks.data(), atom)) {
+        continue;
+      }
+      has_achiever = true;
+      std::fill(pre.begin(), pre.end(), 0);
+      for (const size_t atom_pre : *ops[idx_op].pre) {
+        SetBit(pre.data(), atom_pre);
+      }
+      for (size_t w = 0; w < num_words; w++) shared[w] &= pre[w];
+    }
+    if (!has_achiever) continue;
+
+    for (size_t j = 0; j < atoms_.size(); j++) {
+      if (j != i && TestBit(shared.data(), atoms_[j])) {
+        greedy_necessary_orderings_[i].push_back(j);
+      }
+    }
+  }
+}
+
+LandmarkCountHeuristic::LandmarkCountHeuristic(const Pddl& pddl)
+    : task_(pddl),
+      graph_(task_),
+      greedy_necessary_successors_(graph_.size()) {
+  for (size_t i = 0; i < graph_.size(); i++) {
+    for (const size_t j : graph_.greedy_necessary_orderings()[i]) {
+      greedy_necessary_successors_[j].push_back(i);
+    }
+  }
+}
+
+void LandmarkCountHeuristic::GetTrueLandmarks(const State& state,
+                                              Status* is_true) const {
+  is_true->assign(NumWords(graph_.size()), 0);
+  std::vector<size_t> atoms;
+  task_.pddl().state_index().GetPropositionIndices(state, &atoms);
+  for (const size_t atom : atoms) {
+    const int idx_landmark = graph_.idx_landmarks()[atom];
+    if (idx_landmark >= 0) SetBit(is_true->data(), idx_landmark);
+  }
+}
+
+LandmarkCountHeuristic::Status LandmarkCountHeuristic::InitialStatus(
+    const State& state) const {
+  Status status;
+  GetTrueLandmarks(state, &status);
+  return status;
+}
+
+void LandmarkCountHeuristic::Progress(const Status& parent, const State& state,
+                                      Status* status) const {
+  GetTrueLandmarks(state, status);
+  for (size_t w = 0; w < status->size(); w++) (*status)[w] |= parent[w];
+}
+
+double LandmarkCountHeuristic::Evaluate(const Status& status,
+                                        const State& state) const {
+  if (!graph_.is_solvable()) return std::numeric_limits<double>::infinity();
+
+  size_t num_accepted = 0;
+  for (const uint64_t word : status) num_accepted += __builtin_popcountll(word);
+  size_t count = graph_.size() - num_accepted;
+
+  // Count the accepted landmarks that are required again.
+  Status is_true;
+  GetTrueLandmarks(state, &is_true);
+  for (size_t i = 0; i < graph_.size(); i++) {
+    if (!TestBit(status.data(), i) || TestBit(is_true.data(), i)) continue;
+    if (graph_.is_goal()[i]) {
+      count++;
+      continue;
+    }
+    for (const size_t j : greedy_necessary_successors_[i]) {
+      if (TestBit(status.data(), j)) continue;
+      count++;
+      break;
+    }
+  }
+  return static_cast<double>(count);
+}
+
+double LandmarkCountHeuristic::operator()(const Planner::Node& node) const {
+  // Accept the landmarks that are true in the node or any of its ancestors.
+  Status status = InitialStatus(node.state());
+  Status is_true;
+  for (std::optional<Planner::Node> parent = node.parent();
+       parent.has_value(); parent = parent->parent()) {
+    GetTrueLandmarks(parent->state(), &is_true);
+    for (size_t w = 0; w < status.size(); w++) status[w] |= is_true[w];
+  }
+  return Evaluate(status, node.state());
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "LandmarkCountHeuristic") {
+  LandmarkCountHeuristic lm_count(pddl);
+  const LandmarkGraph& graph = lm_count.graph();
+  const StateIndex& state_index = pddl.state_index();
+  REQUIRE(graph.is_solvable());
+
+  // Goal atoms are landmarks.
+  for (const size_t atom : lm_count.task().goal_pos()) {
+    REQUIRE(graph.idx_landmarks()[atom] >= 0);
+  }
+
+  // Every landmark should hold at some point along a plan.
+  const Planner planner(pddl);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), 10);
+  REQUIRE(bfs.begin() != bfs.end());
+  const std::vector<Planner::Node> plan = *bfs.begin();
+  for (const size_t atom : graph.atoms()) {
+    const Proposition prop = state_index.GetProposition(atom);
+    bool is_reached = false;
+    for (const Planner::Node& node : plan) {
+      is_reached |= node.state().contains(prop);
+    }
+    REQUIRE(is_reached);
+  }
+
+  // The heuristic should be zero only at the goal along the plan.
+  for (const Planner::Node& node : plan) {
+    const double h = lm_count(node);
+    REQUIRE((h == 0.) == static_cast<bool>(node));
+  }
+
+  // Statuses propagated along the plan should match the node evaluation.
+  LandmarkCountHeuristic::Status status =
+      lm_count.InitialStatus(plan.front().state());
+  for (size_t i = 1; i < plan.size(); i++) {
+    LandmarkCountHeuristic::Status child_status;
+    lm_count.Progress(status, plan[i].state(), &child_status);
+    status = std::move(child_status);
+    REQUIRE(lm_count.Evaluate(status, plan[i].state()) == lm_count(plan[i]));
+  }
+
+  // The heuristic should plug into the search engines as a score function.
+  BestFirstWidthSearch<Planner::Node> bfws(
+      planner.root(), state_index,
+      [&lm_count](const Planner::Node& node) { return lm_count(node); }, 10);
+  REQUIRE(bfws.begin() != bfws.end());
+  REQUIRE(pddl.IsGoalSatisfied((*bfws.begin()).back().state()));
+}
+
+}  // namespace symbolic
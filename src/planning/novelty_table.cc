@@ -0,0 +1,60 @@
+/**
+ * novelty_table.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/novelty_table.h"
+
+#include <stdexcept>  // std::runtime_error
+
+#include "utils/doctest.h"
+
+namespace symbolic {
+
+NoveltyTable::NoveltyTable(size_t num_atoms, size_t width) : width_(width) {
+  if (width < 1 || width > 2) {
+    throw std::runtime_error(
+        "NoveltyTable::NoveltyTable(): Only widths 1 and 2 are supported.");
+  }
+  singles_.resize((num_atoms + 63) / 64, 0);
+  if (width == 2) {
+    pairs_.resize((PairIndex(0, num_atoms) + 63) / 64, 0);
+  }
+}
+
+size_t NoveltyTable::Insert(const std::vector<size_t>& atoms) {
+  size_t novelty = width_ + 1;
+  for (const size_t atom : atoms) {
+    if (TestAndSet(singles_, atom)) novelty = 1;
+  }
+  if (width_ < 2) return novelty;
+
+  for (size_t j = 1; j < atoms.size(); j++) {
+    for (size_t i = 0; i < j; i++) {
+      if (TestAndSet(pairs_, PairIndex(atoms[i], atoms[j])) && novelty > 2) {
+        novelty = 2;
+      }
+    }
+  }
+  return novelty;
+}
+
+TEST_CASE("NoveltyTable") {
+  NoveltyTable table(100, 2);
+  REQUIRE(table.Insert({1, 5, 70}) == 1);
+  REQUIRE(table.Insert({1, 5}) == 3);
+  REQUIRE(table.Insert({1, 70}) == 3);
+  REQUIRE(table.Insert({5, 70, 99}) == 1);
+  REQUIRE(table.Insert({1, 99}) == 2);
+  REQUIRE(table.Insert({1, 5, 70, 99}) == 3);
+
+  NoveltyTable table_1(100, 1);
+  REQUIRE(table_1.Insert({0, 63, 64}) == 1);
+  REQUIRE(table_1.Insert({0, 64}) == 2);
+}
+
+}  // namespace symbolic
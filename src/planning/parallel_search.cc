@@ -0,0 +1,369 @@
+/**
+ * parallel_search.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/parallel_search.h"
+
+#include <algorithm>      // std::reverse
+#include <atomic>         // std::atomic
+#include <exception>      // std::exception_ptr
+#include <functional>     // std::greater
+#include <iostream>       // std::cout
+#include <memory>         // std::unique_ptr
+#include <mutex>          // std::lock_guard, std::mutex
+#include <queue>          // std::priority_queue
+#include <random>         // std::mt19937_64
+#include <thread>         // std::thread
+#include <tuple>          // std::tie
+#include <unordered_map>  // std::unordered_map
+
+#include "symbolic/planning/grounded_task.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Planner;
+
+constexpr uint64_t kZobristSeed = 0x5eed;
+
+/**
+ * Lock-free multi-producer, single-consumer inbox of planner nodes.
+ *
+ * Producers push onto an atomic stack, and the consumer takes the whole stack
+ * at once, so popped messages are never accessed by the producers.
+ */
+class Inbox {
+ public:
+  struct Message {
+    Planner::Node node;
+    Message* next = nullptr;
+  };
+
+  Inbox() = default;
+  Inbox(const Inbox&) = delete;
+  Inbox& operator=(const Inbox&) = delete;
+
+  ~Inbox() {
+    for (Message* message = PopAll(); message != nullptr;) {
+      Message* next = message->next;
+      delete message;
+      message = next;
+    }
+  }
+
+  void Push(Message* message) {
+    message->next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(message->next, message,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * Takes all messages, most recent first.
+   */
+  Message* PopAll() {
+    return head_.exchange(nullptr, std::memory_order_acquire);
+  }
+
+ private:
+  std::atomic<Message*> head_{nullptr};
+};
+
+/**
+ * State shared by all workers.
+ */
+struct Coordinator {
+  std::atomic<bool> is_done{false};
+
+  // Nodes pushed into and processed from the inboxes.
+  std::atomic<uint64_t> num_sent{0};
+  std::atomic<uint64_t> num_received{0};
+
+  // Length of the best plan found so far.
+  std::atomic<size_t> incumbent_cost{std::numeric_limits<size_t>::max()};
+  std::mutex mtx_incumbent;
+  std::optional<Planner::Node> incumbent;
+
+  std::mutex mtx_exception;
+  std::exception_ptr exception;
+};
+
+}  // namespace
+
+namespace symbolic {
+
+class HashDistributedAStar::Worker {
+ public:
+  Worker(const HashDistributedAStar& search, size_t idx_worker,
+         std::vector<std::unique_ptr<Worker>>* workers,
+         Coordinator* coordinator)
+      : search_(search),
+        idx_worker_(idx_worker),
+        workers_(*workers),
+        coordinator_(*coordinator),
+        heuristic_(search.heuristic_
+                       ? search.heuristic_()
+                       : Heuristic([](const Planner::Node&) { return 0.; })) {}
+
+  /**
+   * Expands nodes until the search terminates.
+   */
+  void Run(size_t max_depth);
+
+  /**
+   * Adds the node to the open list if it improves the cost of its state.
+   */
+  void Insert(const Planner::Node& node);
+
+  /**
+   * Sends a node from another thread.
+   */
+  void Send(const Planner::Node& node) {
+    coordinator_.num_sent.fetch_add(1);
+    inbox_.Push(new Inbox::Message{node});
+  }
+
+  bool is_idle() const { return is_idle_.load(); }
+
+  size_t num_expanded() const { return num_expanded_; }
+  size_t num_sent() const { return num_sent_; }
+
+ private:
+  struct QueueItem {
+    double f;
+    double h;
+    size_t idx;
+    Planner::Node node;
+
+    bool operator>(const QueueItem& rhs) const {
+      return std::tie(f, h, idx) > std::tie(rhs.f, rhs.h, rhs.idx);
+    }
+  };
+
+  void Expand(size_t max_depth);
+
+  /**
+   * Encodes the state into the closed list key buffer.
+   */
+  const FiniteDomainEncoding::PackedState& Key(const State& state);
+
+  /**
+   * Whether every worker is idle and every sent node has been received.
+   */
+  bool IsTerminated() const;
+
+  const HashDistributedAStar& search_;
+  const size_t idx_worker_;
+  std::vector<std::unique_ptr<Worker>>& workers_;
+  Coordinator& coordinator_;
+  Heuristic heuristic_;
+
+  Inbox inbox_;
+  std::atomic<bool> is_idle_{false};
+
+  std::priority_queue<QueueItem, std::vector<QueueItem>,
+                      std::greater<QueueItem>>
+      open_;
+  std::unordered_map<FiniteDomainEncoding::PackedState, size_t,
+                     FiniteDomainEncoding::Hash>
+      costs_;
+  size_t idx_push_ = 0;
+
+  // Scratch buffers of the closed list keys.
+  std::vector<size_t> atoms_;
+  FiniteDomainEncoding::PackedState key_;
+
+  size_t num_expanded_ = 0;
+  size_t num_sent_ = 0;
+};
+
+void HashDistributedAStar::Worker::Insert(const Planner::Node& node) {
+  const size_t g = node.depth();
+  const auto [it, is_new] = costs_.emplace(Key(node.state()), g);
+  if (!is_new) {
+    if (it->second <= g) return;
+    it->second = g;
+  }
+
+  const double h = heuristic_(node);
+  const double f = g + h;
+  if (f >= static_cast<double>(coordinator_.incumbent_cost.load())) return;
+  open_.push({f, h, idx_push_++, node});
+}
+
+void HashDistributedAStar::Worker::Expand(size_t max_depth) {
+  const Planner::Node node = open_.top().node;
+  open_.pop();
+
+  // Skip nodes whose state was reopened with a lower cost.
+  if (costs_.at(Key(node.state())) < node.depth()) return;
+  num_expanded_++;
+
+  if (node) {
+    std::lock_guard<std::mutex> lock(coordinator_.mtx_incumbent);
+    if (node.depth() < coordinator_.incumbent_cost.load()) {
+      coordinator_.incumbent = node;
+      coordinator_.incumbent_cost.store(node.depth());
+    }
+    return;
+  }
+  if (node.depth() >= max_depth) return;
+
+  for (const Planner::Node& child : node) {
+    const size_t owner = search_.Hash(child.state()) % workers_.size();
+    if (owner == idx_worker_) {
+      Insert(child);
+    } else {
+      workers_[owner]->Send(child);
+      num_sent_++;
+    }
+  }
+}
+
+const FiniteDomainEncoding::PackedState& HashDistributedAStar::Worker::Key(
+    const State& state) {
+  search_.pddl_.state_index().GetPropositionIndices(state, &atoms_);
+  search_.encoding_.Encode(atoms_, &key_);
+  return key_;
+}
+
+bool HashDistributedAStar::Worker::IsTerminated() const {
+  // A worker marks itself busy before acknowledging the nodes it receives, so
+  // all nodes acknowledged before the idle flags are read have been inserted.
+  const uint64_t num_received = coordinator_.num_received.load();
+  for (const std::unique_ptr<Worker>& worker : workers_) {
+    if (!worker->is_idle()) return false;
+  }
+  return num_received == coordinator_.num_sent.load();
+}
+
+void HashDistributedAStar::Worker::Run(size_t max_depth) {
+  while (!coordinator_.is_done.load()) {
+    Inbox::Message* message = inbox_.PopAll();
+    if (message != nullptr) {
+      is_idle_.store(false);
+      uint64_t num_received = 0;
+      while (message != nullptr) {
+        Insert(message->node);
+        Inbox::Message* next = message->next;
+        delete message;
+        message = next;
+        num_received++;
+      }
+      coordinator_.num_received.fetch_add(num_received);
+    }
+
+    const size_t incumbent_cost = coordinator_.incumbent_cost.load();
+    if (!open_.empty() &&
+        open_.top().f < static_cast<double>(incumbent_cost)) {
+      is_idle_.store(false);
+      Expand(max_depth);
+      continue;
+    }
+
+    is_idle_.store(true);
+    if (IsTerminated()) {
+      coordinator_.is_done.store(true);
+      break;
+    }
+    std::this_thread::yield();
+  }
+}
+
+HashDistributedAStar::HashDistributedAStar(const Pddl& pddl,
+                                           size_t num_threads,
+                                           HeuristicFactory heuristic)
+    : pddl_(pddl),
+      num_threads_(num_threads > 0
+                       ? num_threads
+                       : std::max(std::thread::hardware_concurrency(), 1U)),
+      heuristic_(std::move(heuristic)),
+      encoding_(GroundedTask(pddl)),
+      keys_(pddl.state_index().size()) {
+  std::mt19937_64 rng(kZobristSeed);
+  for (uint64_t& key : keys_) key = rng();
+}
+
+uint64_t HashDistributedAStar::Hash(const State& state) const {
+  // Thread-local buffer, since workers hash concurrently.
+  thread_local std::vector<size_t> atoms;
+  pddl_.state_index().GetPropositionIndices(state, &atoms);
+  uint64_t hash = 0;
+  for (const size_t atom : atoms) hash ^= keys_[atom];
+  return hash;
+}
+
+std::optional<std::vector<std::string>> HashDistributedAStar::Search(
+    size_t max_depth, bool verbose) {
+  Coordinator coordinator;
+  std::vector<std::unique_ptr<Worker>> workers;
+  workers.reserve(num_threads_);
+  for (size_t i = 0; i < num_threads_; i++) {
+    workers.push_back(
+        std::make_unique<Worker>(*this, i, &workers, &coordinator));
+  }
+
+  const Planner planner(pddl_);
+  workers[Hash(planner.root().state()) % num_threads_]->Insert(planner.root());
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads_);
+  for (const std::unique_ptr<Worker>& worker : workers) {
+    threads.emplace_back([&coordinator, &worker, max_depth]() {
+      try {
+        worker->Run(max_depth);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(coordinator.mtx_exception);
+        coordinator.exception = std::current_exception();
+        coordinator.is_done.store(true);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  if (coordinator.exception) std::rethrow_exception(coordinator.exception);
+
+  num_expanded_ = 0;
+  num_sent_ = 0;
+  for (size_t i = 0; i < num_threads_; i++) {
+    const Worker& worker = *workers[i];
+    num_expanded_ += worker.num_expanded();
+    num_sent_ += worker.num_sent();
+    if (verbose) {
+      std::cout << "HDA* worker " << i << ": " << worker.num_expanded()
+                << " expanded, " << worker.num_sent() << " sent" << std::endl;
+    }
+  }
+
+  if (!coordinator.incumbent.has_value()) return {};
+  std::vector<std::string> plan;
+  for (std::optional<Planner::Node> node = coordinator.incumbent;
+       node->parent(); node = node->parent()) {
+    plan.push_back(node->action());
+  }
+  std::reverse(plan.begin(), plan.end());
+  return plan;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "HashDistributedAStar") {
+  const size_t optimal_length = testing::OptimalPlanLength(pddl);
+
+  for (const size_t num_threads : {1, 4}) {
+    HashDistributedAStar hda(pddl, num_threads);
+    const std::optional<std::vector<std::string>> plan = hda.Search();
+    REQUIRE(plan.has_value());
+    REQUIRE(plan->size() == optimal_length);
+    REQUIRE(testing::IsValidPlan(pddl, *plan));
+    REQUIRE(hda.num_expanded() > 0);
+
+    // The search should terminate without a plan below the optimal length.
+    REQUIRE(!hda.Search(optimal_length - 1).has_value());
+  }
+}
+
+}  // namespace symbolic
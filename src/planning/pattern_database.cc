@@ -0,0 +1,633 @@
+/**
+ * pattern_database.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/pattern_database.h"
+
+#include <fcntl.h>     // open
+#include <stdlib.h>    // mkstemp
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+
+#include <algorithm>   // std::fill, std::find, std::max, std::min, std::sort
+#include <cstdio>      // std::remove
+#include <cstring>     // std::memcmp, std::memcpy
+#include <filesystem>  // std::filesystem
+#include <fstream>     // std::fstream, std::ofstream
+#include <limits>      // std::numeric_limits
+#include <queue>       // std::queue
+#include <stdexcept>   // std::runtime_error
+#include <tuple>       // std::tie
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::GroundedTask;
+using ::symbolic::PatternDatabaseHeuristic;
+using ::symbolic::Pddl;
+using ::symbolic::StateIndex;
+
+constexpr char kMagic[8] = {'S', 'Y', 'M', 'P', 'D', 'B', '2', '\0'};
+constexpr size_t kTableAlignment = 64;
+
+// FNV-1a parameters, used because the hash is stored in files.
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325;
+constexpr uint64_t kFnvPrime = 0x100000001b3;
+
+/**
+ * Projection of an operator onto a pattern, as bit masks over the pattern.
+ */
+struct AbstractOperator {
+  uint32_t pre_mask;
+  uint32_t pre_val;
+  uint32_t eff_mask;
+  uint32_t eff_val;
+
+  bool operator<(const AbstractOperator& rhs) const {
+    return std::tie(pre_mask, pre_val, eff_mask, eff_val) <
+           std::tie(rhs.pre_mask, rhs.pre_val, rhs.eff_mask, rhs.eff_val);
+  }
+  bool operator==(const AbstractOperator& rhs) const {
+    return std::tie(pre_mask, pre_val, eff_mask, eff_val) ==
+           std::tie(rhs.pre_mask, rhs.pre_val, rhs.eff_mask, rhs.eff_val);
+  }
+};
+
+/**
+ * Returns the bit of the atom in the pattern, or -1 if it is not in it.
+ */
+int FindBit(const std::vector<size_t>& pattern, size_t atom) {
+  const auto it = std::find(pattern.begin(), pattern.end(), atom);
+  return it == pattern.end() ? -1 : static_cast<int>(it - pattern.begin());
+}
+
+std::vector<AbstractOperator> ProjectOperators(
+    const GroundedTask& task, const std::vector<size_t>& pattern) {
+  std::vector<AbstractOperator> ops;
+  for (const GroundedTask::Operator& op : task.operators()) {
+    AbstractOperator abs_op = {0, 0, 0, 0};
+    bool is_consistent = true;
+    for (const size_t atom : op.pre_pos) {
+      const int bit = FindBit(pattern, atom);
+      if (bit < 0) continue;
+      abs_op.pre_mask |= 1U << bit;
+      abs_op.pre_val |= 1U << bit;
+    }
+    for (const size_t atom : op.pre_neg) {
+      const int bit = FindBit(pattern, atom);
+      if (bit < 0) continue;
+      is_consistent &= (abs_op.pre_val & (1U << bit)) == 0;
+      abs_op.pre_mask |= 1U << bit;
+    }
+    for (const size_t atom : op.del) {
+      const int bit = FindBit(pattern, atom);
+      if (bit >= 0) abs_op.eff_mask |= 1U << bit;
+    }
+    for (const size_t atom : op.add) {
+      const int bit = FindBit(pattern, atom);
+      if (bit < 0) continue;
+      abs_op.eff_mask |= 1U << bit;
+      abs_op.eff_val |= 1U << bit;
+    }
+    if (!is_consistent || abs_op.eff_mask == 0) continue;
+    ops.push_back(abs_op);
+  }
+  std::sort(ops.begin(), ops.end());
+  ops.erase(std::unique(ops.begin(), ops.end()), ops.end());
+  return ops;
+}
+
+/**
+ * Computes the goal distances of the abstract states by regression.
+ */
+void ComputeDistances(const GroundedTask& task,
+                      const std::vector<size_t>& pattern, uint8_t* distances) {
+  const std::vector<AbstractOperator> ops = ProjectOperators(task, pattern);
+  const uint32_t num_states = 1U << pattern.size();
+  std::fill(distances, distances + num_states,
+            PatternDatabaseHeuristic::kInfinity);
+
+  uint32_t goal_mask = 0;
+  uint32_t goal_val = 0;
+  for (const size_t atom : task.goal_pos()) {
+    const int bit = FindBit(pattern, atom);
+    if (bit < 0) continue;
+    goal_mask |= 1U << bit;
+    goal_val |= 1U << bit;
+  }
+  for (const size_t atom : task.goal_neg()) {
+    const int bit = FindBit(pattern, atom);
+    if (bit >= 0) goal_mask |= 1U << bit;
+  }
+
+  std::queue<uint32_t> queue;
+  for (uint32_t s = 0; s < num_states; s++) {
+    if ((s & goal_mask) != goal_val) continue;
+    distances[s] = 0;
+    queue.push(s);
+  }
+
+  while (!queue.empty()) {
+    const uint32_t s_next = queue.front();
+    queue.pop();
+    const uint8_t distance = std::min<uint8_t>(
+        distances[s_next] + 1, PatternDatabaseHeuristic::kInfinity - 1);
+
+    for (const AbstractOperator& op : ops) {
+      // The successor must contain the effects and the preconditions that the
+      // effects leave untouched.
+      if ((s_next & op.eff_mask) != op.eff_val) continue;
+      const uint32_t mask_kept = op.pre_mask & ~op.eff_mask;
+      if ((s_next & mask_kept) != (op.pre_val & mask_kept)) continue;
+
+      // Predecessors take the preconditions on the effect bits, and any value
+      // on the remaining effect bits.
+      const uint32_t base =
+          (s_next & ~op.eff_mask) | (op.pre_val & op.eff_mask);
+      const uint32_t free = op.eff_mask & ~op.pre_mask;
+      uint32_t sub = free;
+      while (true) {
+        const uint32_t s = base | sub;
+        if (distances[s] == PatternDatabaseHeuristic::kInfinity) {
+          distances[s] = distance;
+          queue.push(s);
+        }
+        if (sub == 0) break;
+        sub = (sub - 1) & free;
+      }
+    }
+  }
+}
+
+/**
+ * Enumerates the maximal cliques of the compatibility graph.
+ */
+void FindMaximalCliques(const std::vector<std::vector<bool>>& is_compatible,
+                        std::vector<size_t>* clique,
+                        std::vector<size_t> candidates,
+                        std::vector<size_t> excluded,
+                        std::vector<std::vector<size_t>>* cliques) {
+  if (candidates.empty()) {
+    if (excluded.empty()) cliques->push_back(*clique);
+    return;
+  }
+  while (!candidates.empty()) {
+    const size_t v = candidates.back();
+    candidates.pop_back();
+    std::vector<size_t> next_candidates;
+    std::vector<size_t> next_excluded;
+    for (const size_t u : candidates) {
+      if (is_compatible[v][u]) next_candidates.push_back(u);
+    }
+    for (const size_t u : excluded) {
+      if (is_compatible[v][u]) next_excluded.push_back(u);
+    }
+    clique->push_back(v);
+    FindMaximalCliques(is_compatible, clique, std::move(next_candidates),
+                       std::move(next_excluded), cliques);
+    clique->pop_back();
+    excluded.push_back(v);
+  }
+}
+
+std::vector<std::vector<size_t>> FindAdditiveSubsets(
+    const GroundedTask& task,
+    const std::vector<std::vector<size_t>>& patterns) {
+  // Patterns are additive if no operator affects both.
+  const size_t num_patterns = patterns.size();
+  std::vector<std::vector<bool>> is_affected(
+      num_patterns, std::vector<bool>(task.operators().size(), false));
+  for (size_t i = 0; i < num_patterns; i++) {
+    for (size_t j = 0; j < task.operators().size(); j++) {
+      const GroundedTask::Operator& op = task.operators()[j];
+      for (const std::vector<size_t>* effects : {&op.add, &op.del}) {
+        for (const size_t atom : *effects) {
+          if (FindBit(patterns[i], atom) >= 0) is_affected[i][j] = true;
+        }
+      }
+    }
+  }
+  std::vector<std::vector<bool>> is_additive(
+      num_patterns, std::vector<bool>(num_patterns, false));
+  for (size_t i = 0; i < num_patterns; i++) {
+    for (size_t k = i + 1; k < num_patterns; k++) {
+      bool is_disjoint = true;
+      for (size_t j = 0; j < task.operators().size(); j++) {
+        is_disjoint &= !(is_affected[i][j] && is_affected[k][j]);
+      }
+      is_additive[i][k] = is_disjoint;
+      is_additive[k][i] = is_disjoint;
+    }
+  }
+
+  std::vector<size_t> candidates(num_patterns);
+  for (size_t i = 0; i < num_patterns; i++) {
+    candidates[i] = num_patterns - 1 - i;
+  }
+  std::vector<size_t> clique;
+  std::vector<std::vector<size_t>> cliques;
+  FindMaximalCliques(is_additive, &clique, std::move(candidates), {}, &cliques);
+  for (std::vector<size_t>& subset : cliques) {
+    std::sort(subset.begin(), subset.end());
+  }
+  return cliques;
+}
+
+/**
+ * Atoms that some operator adds or deletes.
+ */
+std::vector<bool> FindFluentAtoms(const GroundedTask& task) {
+  std::vector<bool> is_fluent(task.num_atoms(), false);
+  for (const GroundedTask::Operator& op : task.operators()) {
+    for (const size_t atom : op.add) is_fluent[atom] = true;
+    for (const size_t atom : op.del) is_fluent[atom] = true;
+  }
+  return is_fluent;
+}
+
+void WriteUint64(std::ofstream& file, uint64_t value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Reads a uint64 from the mapped file, advancing the offset.
+ */
+uint64_t ReadUint64(const uint8_t* data, size_t size, size_t* offset) {
+  if (*offset + sizeof(uint64_t) > size) {
+    throw std::runtime_error(
+        "PatternDatabaseHeuristic::Load(): Unexpected end of file.");
+  }
+  uint64_t value;
+  std::memcpy(&value, data + *offset, sizeof(value));
+  *offset += sizeof(value);
+  return value;
+}
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+/**
+ * Hashes the ordered atom names of the problem with the patterns and their
+ * additive subsets, so that a file is only loaded for the problem it was built
+ * for and with the patterns it was written with.
+ */
+uint64_t HashPdbs(const Pddl& pddl,
+                  const std::vector<std::vector<size_t>>& patterns,
+                  const std::vector<std::vector<size_t>>& additive_subsets) {
+  uint64_t hash = kFnvOffset;
+  const StateIndex& state_index = pddl.state_index();
+  for (size_t atom = 0; atom < state_index.size(); atom++) {
+    const std::string name = state_index.GetProposition(atom).to_string();
+    hash = HashBytes(hash, name.c_str(), name.size() + 1);
+  }
+  for (const auto* sets : {&patterns, &additive_subsets}) {
+    for (const std::vector<size_t>& set : *sets) {
+      const uint64_t size = set.size();
+      hash = HashBytes(hash, &size, sizeof(size));
+      for (const uint64_t idx : set) hash = HashBytes(hash, &idx, sizeof(idx));
+    }
+  }
+  return hash;
+}
+
+size_t AlignTables(size_t offset) {
+  return (offset + kTableAlignment - 1) / kTableAlignment * kTableAlignment;
+}
+
+}  // namespace
+
+namespace symbolic {
+
+PatternDatabaseHeuristic::PatternDatabaseHeuristic(
+    const Pddl& pddl, const std::vector<std::vector<size_t>>& patterns)
+    : pddl_(&pddl) {
+  const GroundedTask task(pddl);
+  const std::vector<bool> is_fluent = FindFluentAtoms(task);
+
+  // Drop the atoms that are constant in the projection.
+  std::vector<std::vector<size_t>> fluent_patterns;
+  for (const std::vector<size_t>& pattern : patterns) {
+    std::vector<size_t> atoms;
+    for (const size_t atom : pattern) {
+      if (is_fluent[atom] && FindBit(atoms, atom) < 0) atoms.push_back(atom);
+    }
+    if (atoms.empty()) continue;
+    if (atoms.size() > kMaxPatternSize) {
+      throw std::runtime_error(
+          "PatternDatabaseHeuristic::PatternDatabaseHeuristic(): Pattern "
+          "exceeds the maximum pattern size.");
+    }
+    fluent_patterns.push_back(std::move(atoms));
+  }
+
+  // Allocate the tables before setting their pointers.
+  std::vector<size_t> offsets;
+  size_t size_tables = 0;
+  for (const std::vector<size_t>& pattern : fluent_patterns) {
+    offsets.push_back(size_tables);
+    size_tables += size_t{1} << pattern.size();
+  }
+  tables_.resize(size_tables);
+
+  for (size_t i = 0; i < fluent_patterns.size(); i++) {
+    ComputeDistances(task, fluent_patterns[i], &tables_[offsets[i]]);
+  }
+  additive_subsets_ = FindAdditiveSubsets(task, fluent_patterns);
+
+  for (size_t i = 0; i < fluent_patterns.size(); i++) {
+    patterns_.push_back({std::move(fluent_patterns[i]), &tables_[offsets[i]]});
+  }
+  IndexAtoms();
+}
+
+PatternDatabaseHeuristic::PatternDatabaseHeuristic(const Pddl& pddl,
+                                                   size_t max_pattern_size)
+    : PatternDatabaseHeuristic(
+          pddl, GeneratePatterns(GroundedTask(pddl), max_pattern_size)) {}
+
+std::vector<std::vector<size_t>> PatternDatabaseHeuristic::GeneratePatterns(
+    const GroundedTask& task, size_t max_pattern_size) {
+  max_pattern_size = std::min(max_pattern_size, kMaxPatternSize);
+  const std::vector<bool> is_fluent = FindFluentAtoms(task);
+
+  // Achievers of each atom.
+  std::vector<std::vector<size_t>> achievers(task.num_atoms());
+  for (size_t i = 0; i < task.operators().size(); i++) {
+    for (const size_t atom : task.operators()[i].add) {
+      achievers[atom].push_back(i);
+    }
+  }
+
+  std::vector<std::vector<size_t>> patterns;
+  for (const size_t goal : task.goal_pos()) {
+    if (!is_fluent[goal]) continue;
+
+    // Singleton goal patterns are additive when their achievers differ.
+    patterns.push_back({goal});
+
+    // Extend the pattern backward along the achiever preconditions.
+    std::vector<size_t> pattern = {goal};
+    for (size_t i = 0; i < pattern.size() && pattern.size() < max_pattern_size;
+         i++) {
+      for (const size_t idx_op : achievers[pattern[i]]) {
+        const GroundedTask::Operator& op = task.operators()[idx_op];
+        for (const std::vector<size_t>* pre : {&op.pre_pos, &op.pre_neg}) {
+          for (const size_t atom : *pre) {
+            if (pattern.size() >= max_pattern_size) break;
+            if (!is_fluent[atom] || FindBit(pattern, atom) >= 0) continue;
+            pattern.push_back(atom);
+          }
+        }
+      }
+    }
+    std::sort(pattern.begin(), pattern.end());
+    patterns.push_back(std::move(pattern));
+  }
+  std::sort(patterns.begin(), patterns.end());
+  patterns.erase(std::unique(patterns.begin(), patterns.end()),
+                 patterns.end());
+  return patterns;
+}
+
+void PatternDatabaseHeuristic::IndexAtoms() {
+  atom_bits_.assign(pddl_->state_index().size(), {});
+  for (size_t i = 0; i < patterns_.size(); i++) {
+    const std::vector<size_t>& atoms = patterns_[i].atoms;
+    for (size_t bit = 0; bit < atoms.size(); bit++) {
+      atom_bits_[atoms[bit]].emplace_back(static_cast<uint32_t>(i),
+                                          static_cast<uint32_t>(bit));
+    }
+  }
+}
+
+double PatternDatabaseHeuristic::Evaluate(const State& state) const {
+  std::vector<size_t> atoms;
+  pddl_->state_index().GetPropositionIndices(state, &atoms);
+
+  // Rank the abstract state of each pattern.
+  std::vector<uint32_t> ranks(patterns_.size(), 0);
+  for (const size_t atom : atoms) {
+    for (const std::pair<uint32_t, uint32_t>& pattern_bit : atom_bits_[atom]) {
+      ranks[pattern_bit.first] |= 1U << pattern_bit.second;
+    }
+  }
+
+  std::vector<uint8_t> distances(patterns_.size());
+  for (size_t i = 0; i < patterns_.size(); i++) {
+    distances[i] = patterns_[i].distances[ranks[i]];
+    if (distances[i] == kInfinity) {
+      return std::numeric_limits<double>::infinity();
+    }
+  }
+
+  size_t h = 0;
+  for (const std::vector<size_t>& subset : additive_subsets_) {
+    size_t h_subset = 0;
+    for (const size_t idx_pattern : subset) h_subset += distances[idx_pattern];
+    h = std::max(h, h_subset);
+  }
+  return static_cast<double>(h);
+}
+
+void PatternDatabaseHeuristic::Save(const std::string& filename) const {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("PatternDatabaseHeuristic::Save(): Unable to "
+                             "open file: " +
+                             filename);
+  }
+
+  // Header.
+  file.write(kMagic, sizeof(kMagic));
+  WriteUint64(file, pddl_->state_index().size());
+  WriteUint64(file, patterns_.size());
+  for (const Pattern& pattern : patterns_) {
+    WriteUint64(file, pattern.atoms.size());
+    for (const size_t atom : pattern.atoms) WriteUint64(file, atom);
+  }
+  WriteUint64(file, additive_subsets_.size());
+  for (const std::vector<size_t>& subset : additive_subsets_) {
+    WriteUint64(file, subset.size());
+    for (const size_t idx_pattern : subset) WriteUint64(file, idx_pattern);
+  }
+  std::vector<std::vector<size_t>> patterns;
+  patterns.reserve(patterns_.size());
+  for (const Pattern& pattern : patterns_) patterns.push_back(pattern.atoms);
+  WriteUint64(file, HashPdbs(*pddl_, patterns, additive_subsets_));
+
+  auto CheckWrite = [&file, &filename]() {
+    if (file) return;
+    throw std::runtime_error("PatternDatabaseHeuristic::Save(): Unable to "
+                             "write file: " +
+                             filename);
+  };
+
+  // Tables, aligned so that they can be read in place.
+  const std::streamoff offset_file = file.tellp();
+  CheckWrite();
+  const size_t offset = static_cast<size_t>(offset_file);
+  const std::vector<char> padding(AlignTables(offset) - offset, 0);
+  file.write(padding.data(), padding.size());
+  for (const Pattern& pattern : patterns_) {
+    file.write(reinterpret_cast<const char*>(pattern.distances),
+               size_t{1} << pattern.atoms.size());
+  }
+
+  file.close();
+  CheckWrite();
+}
+
+PatternDatabaseHeuristic PatternDatabaseHeuristic::Load(
+    const Pddl& pddl, const std::string& filename) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("PatternDatabaseHeuristic::Load(): Unable to "
+                             "open file: " +
+                             filename);
+  }
+  struct stat file_stat {};
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("PatternDatabaseHeuristic::Load(): Unable to "
+                             "read file: " +
+                             filename);
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("PatternDatabaseHeuristic::Load(): Unable to "
+                             "map file: " +
+                             filename);
+  }
+
+  PatternDatabaseHeuristic pdb(pddl);
+  pdb.mapping_ = std::shared_ptr<const void>(address, [size](const void* ptr) {
+    munmap(const_cast<void*>(ptr), size);
+  });
+  const auto* data = static_cast<const uint8_t*>(address);
+
+  size_t offset = sizeof(kMagic);
+  if (size < offset || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error(
+        "PatternDatabaseHeuristic::Load(): Invalid file format.");
+  }
+  if (ReadUint64(data, size, &offset) != pddl.state_index().size()) {
+    throw std::runtime_error(
+        "PatternDatabaseHeuristic::Load(): The PDBs were built for a different "
+        "problem.");
+  }
+
+  const size_t num_patterns = ReadUint64(data, size, &offset);
+  std::vector<std::vector<size_t>> patterns(num_patterns);
+  for (std::vector<size_t>& pattern : patterns) {
+    pattern.resize(ReadUint64(data, size, &offset));
+    if (pattern.size() > kMaxPatternSize) {
+      throw std::runtime_error(
+          "PatternDatabaseHeuristic::Load(): Invalid pattern size.");
+    }
+    for (size_t& atom : pattern) {
+      atom = ReadUint64(data, size, &offset);
+      if (atom >= pddl.state_index().size()) {
+        throw std::runtime_error(
+            "PatternDatabaseHeuristic::Load(): Invalid atom index.");
+      }
+    }
+  }
+  pdb.additive_subsets_.resize(ReadUint64(data, size, &offset));
+  for (std::vector<size_t>& subset : pdb.additive_subsets_) {
+    subset.resize(ReadUint64(data, size, &offset));
+    for (size_t& idx_pattern : subset) {
+      idx_pattern = ReadUint64(data, size, &offset);
+      if (idx_pattern >= num_patterns) {
+        throw std::runtime_error(
+            "PatternDatabaseHeuristic::Load(): Invalid pattern index.");
+      }
+    }
+  }
+  if (ReadUint64(data, size, &offset) !=
+      HashPdbs(pddl, patterns, pdb.additive_subsets_)) {
+    throw std::runtime_error(
+        "PatternDatabaseHeuristic::Load(): The PDBs were built for a different "
+        "problem or the file is corrupted.");
+  }
+
+  offset = AlignTables(offset);
+  for (std::vector<size_t>& pattern : patterns) {
+    const size_t size_table = size_t{1} << pattern.size();
+    if (offset + size_table > size) {
+      throw std::runtime_error(
+          "PatternDatabaseHeuristic::Load(): Unexpected end of file.");
+    }
+    pdb.patterns_.push_back({std::move(pattern), data + offset});
+    offset += size_table;
+  }
+  pdb.IndexAtoms();
+  return pdb;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "PatternDatabaseHeuristic") {
+  const PatternDatabaseHeuristic pdb(pddl, 8);
+  REQUIRE(pdb.num_patterns() > 0);
+
+  // The heuristic should be admissible along a shortest plan.
+  const Planner planner(pddl);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), 10);
+  REQUIRE(bfs.begin() != bfs.end());
+  const std::vector<Planner::Node> plan = *bfs.begin();
+  for (size_t i = 0; i < plan.size(); i++) {
+    REQUIRE(pdb(plan[i]) <= static_cast<double>(plan.size() - 1 - i));
+  }
+  REQUIRE(pdb(plan.back()) == 0.);
+  REQUIRE(pdb(plan.front()) > 0.);
+
+  // The mapped file should reproduce the heuristic.
+  std::string filename =
+      (std::filesystem::temp_directory_path() / "symbolic_pdb_XXXXXX").string();
+  const int fd = mkstemp(filename.data());
+  REQUIRE(fd >= 0);
+  close(fd);
+  pdb.Save(filename);
+  {
+    const PatternDatabaseHeuristic pdb_mapped =
+        PatternDatabaseHeuristic::Load(pddl, filename);
+    REQUIRE(pdb_mapped.num_patterns() == pdb.num_patterns());
+    REQUIRE(pdb_mapped.additive_subsets() == pdb.additive_subsets());
+    for (const Planner::Node& node : plan) {
+      REQUIRE(pdb_mapped(node) == pdb(node));
+    }
+  }
+
+  // Files with modified patterns should be rejected.
+  {
+    std::fstream file(filename,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    const std::streamoff offset_atom = sizeof(kMagic) + 3 * sizeof(uint64_t);
+    uint64_t atom;
+    file.seekg(offset_atom);
+    file.read(reinterpret_cast<char*>(&atom), sizeof(atom));
+    atom = atom > 0 ? atom - 1 : atom + 1;
+    file.seekp(offset_atom);
+    file.write(reinterpret_cast<const char*>(&atom), sizeof(atom));
+  }
+  REQUIRE_THROWS(PatternDatabaseHeuristic::Load(pddl, filename));
+  std::remove(filename.c_str());
+
+  // Write errors should be reported.
+  REQUIRE_THROWS(pdb.Save("/dev/full"));
+}
+
+}  // namespace symbolic
@@ -9,107 +9,158 @@
 
 #include "symbolic/planning/planner.h"
 
-// #define SYMBOLIC_PLANNER_USE_ORDERED_CACHE
+#include <algorithm>   // std::find
+#include <atomic>      // std::atomic
+#include <cstdint>     // uint32_t, uint64_t
+#include <functional>  // std::hash
+#include <limits>      // std::numeric_limits
 
-#ifdef SYMBOLIC_PLANNER_USE_ORDERED_CACHE
-#include <set>            // std::set
-#else                     // SYMBOLIC_PLANNER_USE_ORDERED_CACHE
-#include <unordered_set>  // std::unordered_set
-#endif                    // SYMBOLIC_PLANNER_USE_ORDERED_CACHE
+#include "symbolic/planning/beam_search.h"
+#include "symbolic/planning/stubborn_sets.h"
+#include "symbolic/planning/width_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+/**
+ * Two bits of a 64-bit Bloom filter selected by the state hash.
+ */
+uint64_t BloomBits(size_t hash) {
+  return (uint64_t{1} << (hash & 63)) | (uint64_t{1} << ((hash >> 6) & 63));
+}
+
+}  // namespace
 
 namespace symbolic {
 
+/**
+ * Nodes form a persistent parent-linked chain, so children share the path to
+ * the root instead of copying the set of their ancestors.
+ */
 struct Planner::Node::NodeImpl {
-#ifdef SYMBOLIC_PLANNER_USE_ORDERED_CACHE
-  using Cache = std::set<Node>;
-#else   // SYMBOLIC_PLANNER_USE_ORDERED_CACHE
-  using Cache = std::unordered_set<Node>;
-#endif  // SYMBOLIC_PLANNER_USE_ORDERED_CACHE
-
-  NodeImpl(const Pddl& pddl, State&& state,
-           const std::shared_ptr<const Cache>& ancestors, std::string&& action,
-           size_t depth)
-      : pddl_(pddl),
+  /**
+   * Options shared by all the nodes of a search tree.
+   */
+  struct Options {
+    const StubbornSets* stubborn_sets;
+    const std::atomic<bool>* stop;
+  };
+
+  NodeImpl(const std::shared_ptr<const NodeImpl>& parent, State&& state,
+           size_t idx_action, size_t idx_arguments)
+      : pddl_(parent->pddl_),
+        options_(parent->options_),
         state_(std::move(state)),
-        ancestors_(ancestors),
-        action_(std::move(action)),
-        depth_(depth) {}
-
-  NodeImpl(const Pddl& pddl, const State& state, size_t depth = 0)
+        parent_(parent),
+        hash_(std::hash<State>{}(state_)),
+        path_bloom_(parent->path_bloom_ | BloomBits(hash_)),
+        idx_arguments_(idx_arguments),
+        idx_action_(static_cast<uint32_t>(idx_action)),
+        depth_(parent->depth_ + 1) {}
+
+  NodeImpl(const Pddl& pddl, const State& state, size_t depth,
+           const Options* options)
       : pddl_(pddl),
+        options_(options),
         state_(state),
-        ancestors_(std::make_shared<const Cache>()),
-        depth_(depth) {}
+        hash_(std::hash<State>{}(state_)),
+        path_bloom_(BloomBits(hash_)),
+        depth_(static_cast<uint32_t>(depth)) {}
+
+  /**
+   * Whether the state is on the path from the root to this node.
+   */
+  bool IsOnPath(const State& state, size_t hash) const {
+    const uint64_t bits = BloomBits(hash);
+    if ((path_bloom_ & bits) != bits) return false;
+
+    for (const NodeImpl* node = this; node != nullptr;
+         node = node->parent_.get()) {
+      if (node->hash_ == hash && node->state_ == state) return true;
+    }
+    return false;
+  }
 
   const Pddl& pddl_;
 
+  // Owned by the root, which outlives its descendants through their parents.
+  const Options* options_;
+
   const State state_;
-  const std::shared_ptr<const Cache> ancestors_;
+  const std::shared_ptr<const NodeImpl> parent_;
+
+  // Hash of the state and the Bloom filter of the state hashes on the path.
+  const size_t hash_;
+  const uint64_t path_bloom_;
 
-  // For debugging
-  const std::string action_;
-  const size_t depth_;
+  // The action label is rendered on request from the action index and the
+  // index of its arguments in the action's parameter generator.
+  const size_t idx_arguments_ = 0;
+  const uint32_t idx_action_ = kNoAction;
+  const uint32_t depth_;
+
+  static constexpr uint32_t kNoAction = std::numeric_limits<uint32_t>::max();
 };
 
-Planner::Node::Node(const Pddl& pddl, const State& state, size_t depth)
-    : impl_(std::make_shared<NodeImpl>(pddl, state, depth)) {}
-
-Planner::Node::Node(const Node& parent, const Node& sibling, State&& state,
-                    std::string&& action) {
-  if (!sibling.impl_) {
-    auto ancestors =
-        std::make_shared<Planner::Node::NodeImpl::Cache>(*parent->ancestors_);
-    ancestors->insert(parent);
-    impl_ = std::make_shared<NodeImpl>(parent->pddl_, std::move(state),
-                                       std::move(ancestors), std::move(action),
-                                       parent.depth() + 1);
-  } else {
-    impl_ = std::make_shared<NodeImpl>(sibling->pddl_, std::move(state),
-                                       sibling->ancestors_, std::move(action),
-                                       sibling.depth());
-  }
-}
+/**
+ * Root node, which stores the options so that the other nodes only need a
+ * pointer to them.
+ */
+struct Planner::Node::RootImpl : public NodeImpl {
+  RootImpl(const Pddl& pddl, const State& state, size_t depth,
+           const Options& options)
+      : NodeImpl(pddl, state, depth, &root_options_), root_options_(options) {}
 
-const std::string& Planner::Node::action() const { return impl_->action_; }
+  const Options root_options_;
+};
+
+Planner::Node::Node(const Pddl& pddl, const State& state, size_t depth,
+                    const StubbornSets* stubborn_sets,
+                    const std::atomic<bool>* stop)
+    : impl_(std::make_shared<RootImpl>(
+          pddl, state, depth, NodeImpl::Options{stubborn_sets, stop})) {}
+
+Planner::Node::Node(const Node& parent, State&& state, size_t idx_action,
+                    size_t idx_arguments)
+    : impl_(std::make_shared<NodeImpl>(parent.impl_, std::move(state),
+                                       idx_action, idx_arguments)) {}
+
+std::string Planner::Node::action() const {
+  if (impl_->idx_action_ == NodeImpl::kNoAction) return "";
+
+  const Action& action = impl_->pddl_.actions()[impl_->idx_action_];
+  std::vector<Object> arguments(action.parameters().size());
+  action.parameter_generator().GetInPlace(impl_->idx_arguments_, &arguments,
+                                          0);
+  return action.to_string(arguments);
+}
 
 const State& Planner::Node::state() const { return impl_->state_; }
 
 size_t Planner::Node::depth() const { return impl_->depth_; }
 
+std::optional<Planner::Node> Planner::Node::parent() const {
+  if (impl_->parent_ == nullptr) return {};
+  Node parent;
+  parent.impl_ = std::const_pointer_cast<NodeImpl>(impl_->parent_);
+  return parent;
+}
+
+size_t Planner::Node::hash() const { return impl_->hash_; }
+
 Planner::Node::iterator Planner::Node::begin() const {
   iterator it(*this);
   if (it == end()) return it;
 
-  if (it.it_param_ == it.it_action_->parameter_generator().end()) {
-    ++it;
-    return it;
-  }
-
-  // Check action preconditions
-  const Action& action = *it.it_action_;
-  const std::vector<Object>& arguments = *it.it_param_;
-  const Node& parent = it.parent_;
-  if (action.IsValid(parent.state(), arguments)) {
-    // Set action and apply postconditions to child
-    State state = action.Apply(parent.state(), arguments);
-    DerivedPredicate::Apply(impl_->pddl_.derived_predicates(), &state);
-    it.child_ =
-        Node(parent, it.child_, std::move(state), action.to_string(arguments));
-
-    // Return if state hasn't been previously visited
-    const std::shared_ptr<const Planner::Node::NodeImpl::Cache> ancestors =
-        it.child_->ancestors_;
-    if (ancestors->count(it.child_) == 0) return it;
-  }
+  // Return if the first child hasn't been previously visited
+  if (it.UpdateChild()) return it;
 
   ++it;
   return it;
 }
 
 Planner::Node::iterator Planner::Node::end() const {
-  iterator it(*this);
-  it.it_action_ = impl_->pddl_.actions().end();
-  return it;
+  return iterator(*this, impl_->pddl_.actions().end());
 }
 
 Planner::Node::operator bool() const {
@@ -121,7 +172,7 @@ bool Planner::Node::operator<(const Node& rhs) const {
 }
 
 bool Planner::Node::operator==(const Node& rhs) const {
-  return impl_->state_ == rhs->state_;
+  return impl_->hash_ == rhs->hash_ && impl_->state_ == rhs->state_;
 }
 
 std::ostream& bold_on(std::ostream& os) { return os << "\e[1m"; }
@@ -143,40 +194,89 @@ Planner::Node::iterator::iterator(const Node& parent)
     : pddl_(parent->pddl_),
       parent_(parent),
       it_action_(pddl_.actions().begin()),
-      it_param_(it_action_->parameter_generator().begin()) {}
+      stubborn_sets_(parent->options_->stubborn_sets) {
+  // A stopped search has no more children to expand.
+  const std::atomic<bool>* stop = parent->options_->stop;
+  if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+    it_action_ = pddl_.actions().end();
+  }
+
+  // Move onto the first action with valid arguments.
+  while (it_action_ != pddl_.actions().end() && !FindArguments(false)) {
+    ++it_action_;
+    idx_arguments_ = 0;
+  }
+}
+
+Planner::Node::iterator::iterator(const Node& parent,
+                                  std::vector<Action>::const_iterator it_action)
+    : pddl_(parent->pddl_),
+      parent_(parent),
+      it_action_(it_action),
+      stubborn_sets_(parent->options_->stubborn_sets) {}
+
+bool Planner::Node::iterator::FindArguments(bool is_reverse) {
+  const Action& action = *it_action_;
+  const ParameterBinder& binder = action.parameter_binder();
+  arguments_.resize(action.parameters().size());
+
+  // Compute the stubborn set once per expansion.
+  if (stubborn_sets_ != nullptr && stubborn_.empty()) {
+    stubborn_sets_->Compute(parent_.state(), &stubborn_);
+    stubborn_sets_->num_expanded_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  const size_t idx_action = it_action_ - pddl_.actions().begin();
+  while (true) {
+    idx_arguments_ =
+        is_reverse
+            ? binder.FindPrev(parent_.state(), idx_arguments_, &arguments_)
+            : binder.FindNext(parent_.state(), idx_arguments_, &arguments_);
+    if (idx_arguments_ == binder.size()) return false;
+    if (stubborn_sets_ == nullptr) return true;
+
+    // Skip the actions outside the stubborn set.
+    if (stubborn_sets_->Contains(stubborn_, idx_action, idx_arguments_)) {
+      stubborn_sets_->num_generated_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    stubborn_sets_->num_pruned_.fetch_add(1, std::memory_order_relaxed);
+    if (!is_reverse) ++idx_arguments_;
+  }
+}
+
+bool Planner::Node::iterator::UpdateChild() {
+  // Apply postconditions to child
+  const Action& action = *it_action_;
+  State state = parent_.state();
+  if (pddl_.derived_predicates().empty()) {
+    action.Apply(arguments_, &state);
+  } else {
+    // Update the derived predicates from the changes made by the action.
+    StateRecorder recorder(&state);
+    action.Apply(arguments_, &recorder);
+    DerivedPredicate::Update(pddl_.derived_predicates(), pddl_.derived_strata(),
+                             recorder.added(), recorder.deleted(), &state);
+  }
+  child_ = Node(parent_, std::move(state),
+                it_action_ - pddl_.actions().begin(), idx_arguments_);
+
+  // Check if state hasn't been previously visited
+  return !parent_->IsOnPath(child_.state(), child_->hash_);
+}
 
 Planner::Node::iterator& Planner::Node::iterator::operator++() {
   while (it_action_ != pddl_.actions().end()) {
-    const ParameterGenerator& param_gen = it_action_->parameter_generator();
-    if (it_param_ == param_gen.end()) {
+    // Move onto next arguments
+    ++idx_arguments_;
+    while (!FindArguments(false)) {
       // Move onto next action
       ++it_action_;
-      if (it_action_ == pddl_.actions().end()) break;
-
-      // Generate new parameters
-      it_param_ = it_action_->parameter_generator().begin();
-      if (it_param_ == it_action_->parameter_generator().end()) continue;
-    } else {
-      // Move onto next parameters
-      ++it_param_;
-      if (it_param_ == param_gen.end()) continue;
+      if (it_action_ == pddl_.actions().end()) return *this;
+      idx_arguments_ = 0;
     }
 
-    // Check action preconditions
-    const Action& action = *it_action_;
-    const std::vector<Object>& arguments = *it_param_;
-    if (action.IsValid(parent_.state(), arguments)) {
-      // Set action and apply postconditions to child
-      State state = action.Apply(parent_.state(), arguments);
-      DerivedPredicate::Apply(pddl_.derived_predicates(), &state);
-      child_ =
-          Node(parent_, child_, std::move(state), action.to_string(arguments));
-
-      // Return if state hasn't been previously visited
-      const std::shared_ptr<const Planner::Node::NodeImpl::Cache> ancestors =
-          child_->ancestors_;
-      if (ancestors->count(child_) == 0) break;
-    }
+    if (UpdateChild()) break;
   }
 
   return *this;
@@ -185,55 +285,20 @@ Planner::Node::iterator& Planner::Node::iterator::operator++() {
 Planner::Node::iterator& Planner::Node::iterator::operator--() {
   if (it_action_ == pddl_.actions().end()) {
     --it_action_;
-    const Action& action = *it_action_;
-    it_param_ = it_action_->parameter_generator().end();
-    --it_param_;
-
-    // Check action preconditions
-    const std::vector<Object>& arguments = *it_param_;
-    if (action.IsValid(parent_.state(), arguments)) {
-      // Set action and apply postconditions to child
-      State state = action.Apply(parent_.state(), arguments);
-      DerivedPredicate::Apply(pddl_.derived_predicates(), &state);
-      child_ =
-          Node(parent_, child_, std::move(state), action.to_string(arguments));
-
-      // Return if state hasn't been previously visited
-      const std::shared_ptr<const Planner::Node::NodeImpl::Cache> ancestors =
-          child_->ancestors_;
-      if (ancestors->count(child_) == 0) return *this;
-    }
+    idx_arguments_ = it_action_->parameter_binder().size();
   }
 
-  while (it_action_ != pddl_.actions().begin() ||
-         it_param_ != it_action_->parameter_generator().begin()) {
-    if (it_param_ == it_action_->parameter_generator().begin()) {
-      // Move onto next action
-      --it_action_;
-
-      // Generate new parameters
-      it_param_ = it_action_->parameter_generator().end();
-      --it_param_;
-    } else {
-      // Move onto next parameters
-      --it_param_;
+  while (true) {
+    if (FindArguments(true)) {
+      // Move onto previous arguments
+      if (UpdateChild()) break;
+      continue;
     }
+    if (it_action_ == pddl_.actions().begin()) break;
 
-    // Check action preconditions
-    const Action& action = *it_action_;
-    const std::vector<Object>& arguments = *it_param_;
-    if (action.IsValid(parent_.state(), arguments)) {
-      // Set action and apply postconditions to child
-      State state = action.Apply(parent_.state(), arguments);
-      DerivedPredicate::Apply(pddl_.derived_predicates(), &state);
-      child_ =
-          Node(parent_, child_, std::move(state), action.to_string(arguments));
-
-      // Return if state hasn't been previously visited
-      const std::shared_ptr<const Planner::Node::NodeImpl::Cache> ancestors =
-          child_->ancestors_;
-      if (ancestors->count(child_) == 0) break;
-    }
+    // Move onto previous action
+    --it_action_;
+    idx_arguments_ = it_action_->parameter_binder().size();
   }
 
   return *this;
@@ -243,13 +308,103 @@ bool Planner::Node::iterator::operator==(const iterator& other) const {
   return it_action_ == other.it_action_ && it_action_ == pddl_.actions().end();
 }
 
+TEST_CASE_FIXTURE(testing::BlocksFixture, "Planner.Node") {
+  const Planner planner(pddl);
+  for (const Planner::Node& child : planner.root()) {
+    // The lazily rendered label should reproduce the child state.
+    REQUIRE(pddl.IsValidAction(planner.root().state(), child.action()));
+    REQUIRE(pddl.NextState(planner.root().state(), child.action()) ==
+            child.state());
+    REQUIRE(child.depth() == 1);
+  }
+
+  // Children should skip exactly the states already on the path.
+  std::vector<State> path = {planner.root().state()};
+  std::function<void(const Planner::Node&)> Expand =
+      [&](const Planner::Node& node) {
+        if (node.depth() == 4) return;
+        size_t num_children = 0;
+        for (const Planner::Node& child : node) {
+          REQUIRE(std::find(path.begin(), path.end(), child.state()) ==
+                  path.end());
+          path.push_back(child.state());
+          Expand(child);
+          path.pop_back();
+          num_children++;
+        }
+
+        size_t num_expected = 0;
+        for (const std::string& action : pddl.ListValidActions(node.state())) {
+          State state = pddl.NextState(node.state(), action);
+          if (std::find(path.begin(), path.end(), state) == path.end()) {
+            num_expected++;
+          }
+        }
+        REQUIRE(num_children == num_expected);
+      };
+  Expand(planner.root());
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "Planner.BeamSearch") {
+  const Planner planner(pddl);
+  const size_t num_bfs = testing::OptimalPlanLength(pddl) + 1;
+  const auto Score = [](const Planner::Node& node) {
+    return static_cast<double>(node.state().size());
+  };
+
+  // A beam wide enough to hold every layer reproduces the BFS plan length.
+  BeamSearch<Planner::Node> beam(planner.root(), Score, 1000, num_bfs - 1);
+  REQUIRE(beam.begin() != beam.end());
+  REQUIRE(testing::IsValidPlan(pddl, *beam.begin()));
+  REQUIRE((*beam.begin()).size() == num_bfs);
+
+  // Beam-stack search with a narrow beam ends with a shortest plan.
+  BeamStackSearch<Planner::Node> beam_stack(planner.root(), Score, 2,
+                                            num_bfs + 1);
+  size_t num_prev = num_bfs + 3;
+  for (const std::vector<Planner::Node>& plan : beam_stack) {
+    REQUIRE(testing::IsValidPlan(pddl, plan));
+    REQUIRE(plan.size() < num_prev);
+    num_prev = plan.size();
+  }
+  REQUIRE(num_prev == num_bfs);
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "Planner.WidthSearch") {
+  const Planner planner(pddl);
+  const size_t num_bfs = testing::OptimalPlanLength(pddl) + 1;
+
+  // The goal has width 2, so IW(2) finds a shortest plan.
+  IteratedWidthSearch<Planner::Node> iw(planner.root(), pddl.state_index(), 2,
+                                        10);
+  REQUIRE(iw.begin() != iw.end());
+  REQUIRE(testing::IsValidPlan(pddl, *iw.begin()));
+  REQUIRE((*iw.begin()).size() == num_bfs);
+
+  // BFWS is complete within the depth bound.
+  BestFirstWidthSearch<Planner::Node> bfws(
+      planner.root(), pddl.state_index(),
+      [](const Planner::Node& node) { return 0.; }, 10);
+  REQUIRE(bfws.begin() != bfws.end());
+  REQUIRE(testing::IsValidPlan(pddl, *bfws.begin()));
+
+  // Distinct scores for every node should share the capped partitions.
+  size_t num_scores = 0;
+  BestFirstWidthSearch<Planner::Node> bfws_distinct(
+      planner.root(), pddl.state_index(),
+      [&num_scores](const Planner::Node&) { return 0.7 * ++num_scores; }, 10);
+  REQUIRE(bfws_distinct.begin() != bfws_distinct.end());
+  REQUIRE(testing::IsValidPlan(pddl, *bfws_distinct.begin()));
+  REQUIRE(num_scores > 16);
+}
+
 }  // namespace symbolic
 
 namespace std {
 
 size_t hash<::symbolic::Planner::Node>::operator()(
     const ::symbolic::Planner::Node& node) const noexcept {
-  return hash<::symbolic::State>{}(node.state());
+  return node.hash();
 }
 
 }  // namespace std
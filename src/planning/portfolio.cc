@@ -0,0 +1,236 @@
+/**
+ * portfolio.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/portfolio.h"
+
+#include <unistd.h>  // sysconf
+
+#include <atomic>              // std::atomic
+#include <condition_variable>  // std::condition_variable
+#include <exception>           // std::exception_ptr
+#include <fstream>             // std::ifstream
+#include <iostream>            // std::cout
+#include <mutex>               // std::mutex, std::unique_lock
+#include <stdexcept>           // std::runtime_error
+#include <thread>              // std::thread
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/depth_first_search.h"
+#include "symbolic/planning/width_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Planner;
+using ::symbolic::Portfolio;
+
+constexpr std::chrono::milliseconds kPollInterval(10);
+
+/**
+ * Resident memory of the process in bytes, or 0 if unknown.
+ */
+size_t ResidentMemory() {
+  std::ifstream statm("/proc/self/statm");
+  size_t num_pages = 0;
+  size_t num_resident_pages = 0;
+  if (!(statm >> num_pages >> num_resident_pages)) return 0;
+  return num_resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+Portfolio::Plan GetPlan(const std::vector<Planner::Node>& nodes) {
+  Portfolio::Plan plan;
+  plan.reserve(nodes.size() - 1);
+  for (size_t i = 1; i < nodes.size(); i++) {
+    plan.push_back(nodes[i].action());
+  }
+  return plan;
+}
+
+template <typename SearchT>
+std::optional<Portfolio::Plan> FirstPlan(SearchT&& search) {
+  const auto it = search.begin();
+  if (it == search.end()) return {};
+  return GetPlan(*it);
+}
+
+/**
+ * Result of one engine.
+ */
+struct Outcome {
+  std::optional<Portfolio::Plan> plan;
+  std::exception_ptr exception;
+  std::chrono::duration<float> time;
+};
+
+}  // namespace
+
+namespace symbolic {
+
+const std::vector<std::string>& Portfolio::BuiltinEngines() {
+  static const std::vector<std::string> kEngines = {"bfs", "dfs", "iw",
+                                                    "bfws"};
+  return kEngines;
+}
+
+void Portfolio::Add(const std::string& name) {
+  const StateIndex& state_index = pddl_.state_index();
+  if (name == "bfs") {
+    Add(name, [](const Planner::Node& root, size_t max_depth) {
+      return FirstPlan(BreadthFirstSearch<Planner::Node>(root, max_depth));
+    });
+  } else if (name == "dfs") {
+    Add(name, [](const Planner::Node& root, size_t max_depth) {
+      return FirstPlan(DepthFirstSearch<Planner::Node>(root, max_depth));
+    });
+  } else if (name == "iw") {
+    Add(name, [&state_index](const Planner::Node& root, size_t max_depth) {
+      return FirstPlan(
+          IteratedWidthSearch<Planner::Node>(root, state_index, 2, max_depth));
+    });
+  } else if (name == "bfws") {
+    Add(name, [&state_index](const Planner::Node& root, size_t max_depth) {
+      return FirstPlan(BestFirstWidthSearch<Planner::Node>(
+          root, state_index, [](const Planner::Node&) { return 0.; },
+          max_depth));
+    });
+  } else {
+    throw std::runtime_error("Portfolio::Add(): Unknown engine " + name + ".");
+  }
+}
+
+void Portfolio::Add(const std::string& name, Engine engine) {
+  engines_.emplace_back(name, std::move(engine));
+}
+
+std::optional<Portfolio::Plan> Portfolio::Search(
+    size_t max_depth, std::chrono::milliseconds deadline, bool verbose) {
+  winner_.clear();
+  is_out_of_memory_ = false;
+
+  std::atomic<bool> stop{false};
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<Outcome> outcomes(engines_.size());
+  size_t num_done = 0;
+
+  const auto t_start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(engines_.size());
+  for (size_t i = 0; i < engines_.size(); i++) {
+    threads.emplace_back([this, i, max_depth, deadline, t_start, &stop, &mtx,
+                          &cv, &outcomes, &num_done]() {
+      Outcome outcome;
+      try {
+        const Planner planner(pddl_, pddl_.initial_state(), nullptr, &stop);
+        outcome.plan = engines_[i].second(planner.root(), max_depth);
+      } catch (...) {
+        outcome.exception = std::current_exception();
+      }
+      outcome.time = std::chrono::steady_clock::now() - t_start;
+
+      std::lock_guard<std::mutex> lock(mtx);
+      if (outcome.plan.has_value() && winner_.empty()) {
+        winner_ = engines_[i].first;
+        if (deadline.count() == 0) stop.store(true);
+      }
+      outcomes[i] = std::move(outcome);
+      num_done++;
+      cv.notify_all();
+    });
+  }
+
+  // Poll the deadline and memory budget until every engine returns.
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (num_done < engines_.size()) {
+      if (!stop.load()) {
+        const bool is_late = deadline.count() > 0 &&
+                             std::chrono::steady_clock::now() - t_start >=
+                                 deadline;
+        is_out_of_memory_ =
+            memory_budget_ > 0 && ResidentMemory() > memory_budget_;
+        if (is_late || is_out_of_memory_) stop.store(true);
+      }
+      cv.wait_for(lock, kPollInterval);
+    }
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Take the first plan, or the shortest one with a deadline.
+  std::optional<Plan> plan;
+  std::exception_ptr exception;
+  for (size_t i = 0; i < engines_.size(); i++) {
+    Outcome& outcome = outcomes[i];
+    const std::string& name = engines_[i].first;
+    if (verbose) {
+      std::cout << "Portfolio engine " << name << ": ";
+      if (outcome.plan.has_value()) {
+        std::cout << "plan of length " << outcome.plan->size();
+      } else {
+        std::cout << (outcome.exception ? "failed" : "no plan");
+      }
+      std::cout << " after " << outcome.time.count() << "s" << std::endl;
+    }
+    if (outcome.exception && !exception) exception = outcome.exception;
+    if (!outcome.plan.has_value()) continue;
+
+    if (deadline.count() == 0) {
+      if (name == winner_) plan = std::move(outcome.plan);
+    } else if (!plan.has_value() || outcome.plan->size() < plan->size()) {
+      plan = std::move(outcome.plan);
+      winner_ = name;
+    }
+  }
+  if (!plan.has_value() && exception) std::rethrow_exception(exception);
+  return plan;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "Portfolio") {
+  const size_t optimal_length = testing::OptimalPlanLength(pddl);
+
+  // Engine that only returns once the portfolio is stopped.
+  const Portfolio::Engine WaitForStop =
+      [](const Planner::Node& root, size_t) -> std::optional<Portfolio::Plan> {
+    while (root.begin() != root.end()) std::this_thread::yield();
+    return {};
+  };
+
+  // The first plan should stop the other engines.
+  Portfolio portfolio(pddl);
+  for (const std::string& name : Portfolio::BuiltinEngines()) {
+    portfolio.Add(name);
+  }
+  portfolio.Add("wait", WaitForStop);
+  std::optional<Portfolio::Plan> plan = portfolio.Search(10);
+  REQUIRE(plan.has_value());
+  REQUIRE(testing::IsValidPlan(pddl, *plan));
+  REQUIRE(!portfolio.winner().empty());
+  REQUIRE(portfolio.winner() != "wait");
+
+  // With a deadline, the shortest plan should be returned once all the engines
+  // return.
+  Portfolio optimal_portfolio(pddl);
+  optimal_portfolio.Add("bfws");
+  optimal_portfolio.Add("bfs");
+  plan = optimal_portfolio.Search(10, std::chrono::minutes(1));
+  REQUIRE(plan.has_value());
+  REQUIRE(testing::IsValidPlan(pddl, *plan));
+  REQUIRE(plan->size() == optimal_length);
+
+  // Exceeding the memory budget should stop the engines.
+  Portfolio tiny_portfolio(pddl, 1);
+  tiny_portfolio.Add("wait", WaitForStop);
+  REQUIRE(!tiny_portfolio.Search(10).has_value());
+  REQUIRE(tiny_portfolio.is_out_of_memory());
+  REQUIRE(tiny_portfolio.winner().empty());
+
+  REQUIRE_THROWS(tiny_portfolio.Add("unknown"));
+}
+
+}  // namespace symbolic
@@ -0,0 +1,338 @@
+/**
+ * stubborn_sets.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/stubborn_sets.h"
+
+#include <algorithm>  // std::find, std::sort, std::unique
+#include <thread>     // std::thread
+
+#include "symbolic/planning/breadth_first_search.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::GroundedTask;
+
+constexpr size_t kWordSize = 64;
+
+size_t NumWords(size_t num_bits) {
+  return (num_bits + kWordSize - 1) / kWordSize;
+}
+
+bool TestBit(const uint64_t* bits, size_t idx) {
+  return (bits[idx / kWordSize] >> (idx % kWordSize)) & 1;
+}
+
+void SetBit(uint64_t* bits, size_t idx) {
+  bits[idx / kWordSize] |= uint64_t{1} << (idx % kWordSize);
+}
+
+/**
+ * Computes the atoms that each derived atom depends on through its rules.
+ */
+std::vector<std::vector<size_t>> ComputeDerivedSupports(
+    const GroundedTask& task) {
+  std::vector<std::vector<size_t>> rules(task.num_atoms());
+  for (size_t i = 0; i < task.rules().size(); i++) {
+    rules[task.rules()[i].head].push_back(i);
+  }
+
+  std::vector<std::vector<size_t>> supports(task.num_atoms());
+  std::vector<size_t> visited(task.num_atoms(), -1);
+  std::vector<size_t> stack;
+  for (size_t head = 0; head < task.num_atoms(); head++) {
+    if (rules[head].empty()) continue;
+
+    std::vector<size_t>& support = supports[head];
+    stack = {head};
+    visited[head] = head;
+    while (!stack.empty()) {
+      const size_t atom = stack.back();
+      stack.pop_back();
+      if (rules[atom].empty()) {
+        support.push_back(atom);
+        continue;
+      }
+      for (const size_t idx_rule : rules[atom]) {
+        const GroundedTask::Rule& rule = task.rules()[idx_rule];
+        for (const std::vector<size_t>* body : {&rule.pos, &rule.neg}) {
+          for (const size_t child : *body) {
+            if (visited[child] == head) continue;
+            visited[child] = head;
+            stack.push_back(child);
+          }
+        }
+      }
+    }
+    std::sort(support.begin(), support.end());
+  }
+  return supports;
+}
+
+}  // namespace
+
+namespace symbolic {
+
+StubbornSets::StubbornSets(const Pddl& pddl)
+    : task_(pddl),
+      num_words_(NumWords(task_.operators().size())),
+      achievers_pos_(task_.num_atoms()),
+      achievers_neg_(task_.num_atoms()),
+      interference_(task_.operators().size() * num_words_, 0) {
+  const std::vector<GroundedTask::Operator>& ops = task_.operators();
+  const size_t num_atoms = task_.num_atoms();
+  const std::vector<std::vector<size_t>> supports =
+      ComputeDerivedSupports(task_);
+
+  // Index the operators by the atoms they read and write.
+  std::vector<std::vector<size_t>> adders(num_atoms);
+  std::vector<std::vector<size_t>> deleters(num_atoms);
+  std::vector<std::vector<size_t>> readers_pos(num_atoms);
+  std::vector<std::vector<size_t>> readers_neg(num_atoms);
+  std::vector<std::vector<size_t>> readers_derived(num_atoms);
+  for (size_t i = 0; i < ops.size(); i++) {
+    const GroundedTask::Operator& op = ops[i];
+    for (const size_t atom : op.add) adders[atom].push_back(i);
+    for (const size_t atom : op.del) deleters[atom].push_back(i);
+    for (const size_t atom : op.pre_pos) {
+      if (supports[atom].empty()) {
+        readers_pos[atom].push_back(i);
+      }
+      for (const size_t base : supports[atom]) {
+        readers_derived[base].push_back(i);
+      }
+    }
+    for (const size_t atom : op.pre_neg) {
+      if (supports[atom].empty()) {
+        readers_neg[atom].push_back(i);
+      }
+      for (const size_t base : supports[atom]) {
+        readers_derived[base].push_back(i);
+      }
+    }
+  }
+
+  // Achievers of derived atoms are the writers of their supports.
+  for (size_t atom = 0; atom < num_atoms; atom++) {
+    if (supports[atom].empty()) {
+      achievers_pos_[atom] = adders[atom];
+      achievers_neg_[atom] = deleters[atom];
+      continue;
+    }
+    std::vector<size_t>& achievers = achievers_pos_[atom];
+    for (const size_t base : supports[atom]) {
+      achievers.insert(achievers.end(), adders[base].begin(),
+                       adders[base].end());
+      achievers.insert(achievers.end(), deleters[base].begin(),
+                       deleters[base].end());
+    }
+    std::sort(achievers.begin(), achievers.end());
+    achievers.erase(std::unique(achievers.begin(), achievers.end()),
+                    achievers.end());
+    achievers_neg_[atom] = achievers;
+  }
+
+  // Operators interfere if one disables the other or their effects conflict.
+  const auto Interfere = [this](size_t i, const std::vector<size_t>& others) {
+    for (const size_t j : others) {
+      if (i == j) continue;
+      SetBit(&interference_[i * num_words_], j);
+      SetBit(&interference_[j * num_words_], i);
+    }
+  };
+  for (size_t i = 0; i < ops.size(); i++) {
+    const GroundedTask::Operator& op = ops[i];
+    for (const size_t atom : op.del) {
+      Interfere(i, readers_pos[atom]);
+      Interfere(i, readers_derived[atom]);
+      Interfere(i, adders[atom]);
+    }
+    for (const size_t atom : op.add) {
+      Interfere(i, readers_neg[atom]);
+      Interfere(i, readers_derived[atom]);
+    }
+  }
+
+  // Index the operators of each action call.
+  const std::vector<Action>& actions = pddl.actions();
+  idx_operators_.resize(actions.size());
+  size_t idx_op = 0;
+  for (size_t idx_action = 0; idx_action < actions.size(); idx_action++) {
+    const size_t num_arguments =
+        actions[idx_action].parameter_generator().size();
+    std::vector<size_t>& idx_operators = idx_operators_[idx_action];
+    idx_operators.resize(num_arguments + 1);
+    for (size_t idx_args = 0; idx_args <= num_arguments; idx_args++) {
+      while (idx_op < ops.size() &&
+             (ops[idx_op].idx_action < idx_action ||
+              (ops[idx_op].idx_action == idx_action &&
+               ops[idx_op].idx_arguments < idx_args))) {
+        idx_op++;
+      }
+      idx_operators[idx_args] = idx_op;
+    }
+  }
+}
+
+const std::vector<size_t>* StubbornSets::FindAchievers(
+    const std::vector<size_t>& pos, const std::vector<size_t>& neg,
+    const Bitset& is_true) const {
+  const std::vector<size_t>* min_achievers = nullptr;
+  for (const size_t atom : pos) {
+    if (TestBit(is_true.data(), atom)) continue;
+    const std::vector<size_t>& achievers = achievers_pos_[atom];
+    if (min_achievers == nullptr || achievers.size() < min_achievers->size()) {
+      min_achievers = &achievers;
+    }
+  }
+  for (const size_t atom : neg) {
+    if (!TestBit(is_true.data(), atom)) continue;
+    const std::vector<size_t>& achievers = achievers_neg_[atom];
+    if (min_achievers == nullptr || achievers.size() < min_achievers->size()) {
+      min_achievers = &achievers;
+    }
+  }
+  return min_achievers;
+}
+
+void StubbornSets::Compute(const State& state, Bitset* stubborn) const {
+  std::vector<size_t> atoms;
+  task_.pddl().state_index().GetPropositionIndices(state, &atoms);
+  Bitset is_true(NumWords(task_.num_atoms()), 0);
+  for (const size_t atom : atoms) SetBit(is_true.data(), atom);
+
+  // Keep all operators in goal states.
+  const std::vector<size_t>* goal_achievers =
+      FindAchievers(task_.goal_pos(), task_.goal_neg(), is_true);
+  if (goal_achievers == nullptr) {
+    stubborn->assign(num_words_, ~uint64_t{0});
+    return;
+  }
+
+  stubborn->assign(num_words_, 0);
+  std::vector<size_t> queue;
+  const auto Insert = [stubborn, &queue](const std::vector<size_t>& ops) {
+    for (const size_t idx_op : ops) {
+      if (TestBit(stubborn->data(), idx_op)) continue;
+      SetBit(stubborn->data(), idx_op);
+      queue.push_back(idx_op);
+    }
+  };
+  Insert(*goal_achievers);
+
+  while (!queue.empty()) {
+    const size_t idx_op = queue.back();
+    queue.pop_back();
+    const GroundedTask::Operator& op = task_.operators()[idx_op];
+
+    // Add a necessary enabling set of an inapplicable operator.
+    const std::vector<size_t>* achievers =
+        FindAchievers(op.pre_pos, op.pre_neg, is_true);
+    if (achievers != nullptr) {
+      Insert(*achievers);
+      continue;
+    }
+
+    // Add the operators that interfere with an applicable operator.
+    const uint64_t* row = &interference_[idx_op * num_words_];
+    for (size_t w = 0; w < num_words_; w++) {
+      uint64_t added = row[w] & ~(*stubborn)[w];
+      (*stubborn)[w] |= added;
+      while (added != 0) {
+        queue.push_back(w * kWordSize + __builtin_ctzll(added));
+        added &= added - 1;
+      }
+    }
+  }
+}
+
+bool StubbornSets::Contains(const Bitset& stubborn, size_t idx_action,
+                            size_t idx_arguments) const {
+  const std::vector<size_t>& idx_operators = idx_operators_[idx_action];
+  for (size_t idx_op = idx_operators[idx_arguments];
+       idx_op < idx_operators[idx_arguments + 1]; idx_op++) {
+    if (TestBit(stubborn.data(), idx_op)) return true;
+  }
+  return false;
+}
+
+bool StubbornSets::Interferes(size_t idx_op, size_t idx_other) const {
+  return TestBit(&interference_[idx_op * num_words_], idx_other);
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "StubbornSets") {
+  StubbornSets stubborn_sets(pddl);
+  const GroundedTask& task = stubborn_sets.task();
+
+  // Picking any two blocks interferes through the hand.
+  const auto FindOperator = [&task](const std::string& action) {
+    for (size_t i = 0; i < task.operators().size(); i++) {
+      if (task.action(task.operators()[i]) == action) return i;
+    }
+    return task.operators().size();
+  };
+  const size_t pick_a = FindOperator("pick(a)");
+  const size_t pick_b = FindOperator("pick(b)");
+  const size_t place_a_b = FindOperator("place(a, b)");
+  REQUIRE(stubborn_sets.Interferes(pick_a, pick_b));
+  REQUIRE(stubborn_sets.Interferes(pick_b, place_a_b));
+  REQUIRE(!stubborn_sets.Interferes(pick_a, pick_a));
+
+  // Pruned search should find plans of the same length.
+  const Planner planner(pddl);
+  const Planner pruned_planner(pddl, pddl.initial_state(), &stubborn_sets);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), 10);
+  BreadthFirstSearch<Planner::Node> pruned_bfs(pruned_planner.root(), 10);
+  REQUIRE(pruned_bfs.begin() != pruned_bfs.end());
+  const std::vector<Planner::Node> plan = *bfs.begin();
+  const std::vector<Planner::Node> pruned_plan = *pruned_bfs.begin();
+  REQUIRE(pruned_plan.size() == plan.size());
+  for (size_t i = 1; i < pruned_plan.size(); i++) {
+    REQUIRE(pddl.NextState(pruned_plan[i - 1].state(),
+                           pruned_plan[i].action()) == pruned_plan[i].state());
+  }
+  REQUIRE(stubborn_sets.num_expanded() > 0);
+
+  // Statistics should count every expansion of concurrent searches.
+  const auto Search = [this, &stubborn_sets]() {
+    const Planner planner(pddl, pddl.initial_state(), &stubborn_sets);
+    BreadthFirstSearch<Planner::Node> bfs(planner.root(), 10);
+    bfs.begin();
+  };
+  stubborn_sets.ResetStatistics();
+  Search();
+  const size_t num_expanded = stubborn_sets.num_expanded();
+  const size_t num_generated = stubborn_sets.num_generated();
+  stubborn_sets.ResetStatistics();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; i++) threads.emplace_back(Search);
+  for (std::thread& thread : threads) thread.join();
+  REQUIRE(stubborn_sets.num_expanded() == 4 * num_expanded);
+  REQUIRE(stubborn_sets.num_generated() == 4 * num_generated);
+
+  // Pruned children should be a nonempty subset of the children in every
+  // non-goal state along the plan.
+  for (const Planner::Node& node : plan) {
+    if (node) continue;
+    std::vector<State> children;
+    for (const Planner::Node& child : Planner::Node(pddl, node.state())) {
+      children.push_back(child.state());
+    }
+    size_t num_pruned_children = 0;
+    for (const Planner::Node& child :
+         Planner::Node(pddl, node.state(), 0, &stubborn_sets)) {
+      REQUIRE(std::find(children.begin(), children.end(), child.state()) !=
+              children.end());
+      num_pruned_children++;
+    }
+    REQUIRE(num_pruned_children > 0);
+  }
+}
+
+}  // namespace symbolic
@@ -0,0 +1,299 @@
+/**
+ * symbolic_search.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/symbolic_search.h"
+
+#include <VAL/ptree.h>
+
+#include <algorithm>  // std::reverse
+#include <cmath>      // std::ldexp
+#include <iostream>   // std::cout
+#include <stdexcept>  // std::runtime_error
+
+#include "utils/doctest.h"
+
+namespace symbolic {
+
+SymbolicSearch::SymbolicSearch(const Pddl& pddl)
+    : pddl_(pddl),
+      bdd_(pddl, 2),
+      is_derived_(pddl.state_index().size(), false) {
+  if (!pddl.axioms().empty()) {
+    throw std::runtime_error(
+        "SymbolicSearch::SymbolicSearch(): Axioms are not supported.");
+  }
+
+  CreateDerivedPredicates();
+
+  // Variable sets for quantification and renaming.
+  const StateIndex& state_index = pddl_.state_index();
+  std::vector<BddManager::Variable> vars_current;
+  std::vector<BddManager::Variable> vars_next;
+  next_to_current_.resize(bdd_.num_variables());
+  for (size_t i = 0; i < bdd_.num_variables(); i++) {
+    next_to_current_[i] = static_cast<BddManager::Variable>(i);
+  }
+  for (size_t i = 0; i < state_index.size(); i++) {
+    if (is_derived_[i]) continue;
+    vars_current.push_back(bdd_.GetVariable(i, 0));
+    vars_next.push_back(bdd_.GetVariable(i, 1));
+    next_to_current_[bdd_.GetVariable(i, 1)] = bdd_.GetVariable(i, 0);
+  }
+  cube_current_ = bdd_.Cube(vars_current);
+  cube_next_ = bdd_.Cube(vars_next);
+
+  // Transition relations
+  for (size_t i = 0; i < pddl_.actions().size(); i++) {
+    for (const std::vector<Object>& args :
+         pddl_.actions()[i].parameter_generator()) {
+      CreateTransition(i, args);
+    }
+  }
+
+  goal_ = CreateFormula(pddl_.goal(), {}, {});
+}
+
+SymbolicSearch::Node SymbolicSearch::CreateFormula(
+    const Formula& formula, const std::vector<Object>& parameters,
+    const std::vector<Object>& arguments) {
+  return bdd_.Compose(bdd_.Create(pddl_, formula, parameters, arguments),
+                      derived_);
+}
+
+SymbolicSearch::Node SymbolicSearch::CreateState(const State& state,
+                                                 size_t copy) {
+  const StateIndex& state_index = pddl_.state_index();
+  std::vector<bool> is_true(state_index.size(), false);
+  for (const Proposition& prop : state) {
+    is_true[state_index.GetPropositionIndex(prop)] = true;
+  }
+
+  // Build the minterm from the bottom up.
+  Node result = BddManager::kTrue;
+  for (size_t i = is_true.size(); i-- > 0;) {
+    if (is_derived_[i]) continue;
+    const BddManager::Variable var = bdd_.GetVariable(i, copy);
+    result = bdd_.And(is_true[i] ? bdd_.Var(var) : bdd_.NotVar(var), result);
+  }
+  return result;
+}
+
+void SymbolicSearch::CreateDerivedPredicates() {
+  const StateIndex& state_index = pddl_.state_index();
+
+  // Derived propositions start false for the least fixed point.
+  for (const DerivedPredicate& pred : pddl_.derived_predicates()) {
+    for (const std::vector<Object>& args : pred.parameter_generator()) {
+      const size_t idx_prop =
+          state_index.GetPropositionIndex(Proposition(pred.name(), args));
+      is_derived_[idx_prop] = true;
+      derived_[bdd_.GetVariable(idx_prop)] = BddManager::kFalse;
+    }
+  }
+
+  // Iterate each stratum until its definitions converge.
+  for (const DerivedPredicate::Stratum& stratum : pddl_.derived_strata()) {
+    if (!stratum.is_stratified) {
+      throw std::runtime_error(
+          "SymbolicSearch::CreateDerivedPredicates(): Unstratified derived "
+          "predicates are not supported.");
+    }
+
+    bool is_changed = true;
+    while (is_changed) {
+      is_changed = false;
+      for (size_t idx_pred : stratum.predicates) {
+        const DerivedPredicate& pred = pddl_.derived_predicates()[idx_pred];
+        for (const std::vector<Object>& args : pred.parameter_generator()) {
+          const BddManager::Variable var = bdd_.GetVariable(
+              state_index.GetPropositionIndex(Proposition(pred.name(), args)));
+          const Node body =
+              CreateFormula(pred.preconditions(), pred.parameters(), args);
+          if (derived_[var] == body) continue;
+          derived_[var] = body;
+          is_changed = true;
+        }
+      }
+    }
+  }
+}
+
+void SymbolicSearch::CreateTransition(size_t idx_action,
+                                      const std::vector<Object>& arguments) {
+  const Action& action = pddl_.actions()[idx_action];
+  const Node pre =
+      CreateFormula(action.preconditions(), action.parameters(), arguments);
+  if (pre == BddManager::kFalse) return;
+
+  // Next value of every proposition as a function of the current state.
+  const size_t num_props = pddl_.state_index().size();
+  std::vector<Node> values;
+  values.reserve(num_props);
+  for (size_t i = 0; i < num_props; i++) {
+    values.push_back(bdd_.Var(bdd_.GetVariable(i, 0)));
+  }
+  ApplyEffects(action.postconditions(), action.parameters(), arguments,
+               BddManager::kTrue, &values);
+
+  // Relate the next state variables to the new values from the bottom up.
+  Node transition = BddManager::kTrue;
+  for (size_t i = num_props; i-- > 0;) {
+    if (is_derived_[i]) continue;
+    const Node var_next = bdd_.Var(bdd_.GetVariable(i, 1));
+    transition = bdd_.And(bdd_.Not(bdd_.Xor(var_next, values[i])), transition);
+  }
+  transition = bdd_.And(pre, transition);
+
+  actions_.push_back({idx_action, arguments, transition});
+}
+
+void SymbolicSearch::ApplyEffects(const VAL::effect_lists* effects,
+                                  const std::vector<Object>& parameters,
+                                  const std::vector<Object>& arguments,
+                                  Node guard, std::vector<Node>* values) {
+  const StateIndex& state_index = pddl_.state_index();
+
+  // Forall effects
+  for (const VAL::forall_effect* effect : effects->forall_effects) {
+    std::vector<Object> forall_params = parameters;
+    const std::vector<Object> types =
+        Object::CreateList(pddl_, effect->getVarsList());
+    forall_params.insert(forall_params.end(), types.begin(), types.end());
+
+    ParameterGenerator gen(pddl_, types);
+    for (const std::vector<Object>& forall_objs : gen) {
+      std::vector<Object> forall_args = arguments;
+      forall_args.insert(forall_args.end(), forall_objs.begin(),
+                         forall_objs.end());
+      ApplyEffects(effect->getEffects(), forall_params, forall_args, guard,
+                   values);
+    }
+  }
+
+  // Add and del effects
+  auto ApplySimpleEffects = [&](const auto& simple_effects, bool is_add) {
+    for (const VAL::simple_effect* effect : simple_effects) {
+      const std::vector<Object> effect_params =
+          Object::CreateList(pddl_, effect->prop->args);
+      const auto Apply =
+          Formula::CreateApplicationFunction(parameters, effect_params);
+      const size_t idx_prop = state_index.GetPropositionIndex(
+          Proposition(effect->prop->head->getName(), Apply(arguments)));
+      if (is_derived_[idx_prop]) {
+        throw std::runtime_error(
+            "SymbolicSearch::ApplyEffects(): Effects on derived predicates "
+            "are not supported.");
+      }
+
+      Node& value = (*values)[idx_prop];
+      value = is_add ? bdd_.Ite(guard, BddManager::kTrue, value)
+                     : bdd_.Ite(guard, BddManager::kFalse, value);
+    }
+  };
+  ApplySimpleEffects(effects->add_effects, true);
+  ApplySimpleEffects(effects->del_effects, false);
+
+  // Cond effects
+  for (const VAL::cond_effect* effect : effects->cond_effects) {
+    // Evaluate the condition on the partially updated state.
+    std::unordered_map<BddManager::Variable, Node> updated;
+    for (size_t i = 0; i < values->size(); i++) {
+      const BddManager::Variable var = bdd_.GetVariable(i, 0);
+      if ((*values)[i] != bdd_.Var(var)) updated[var] = (*values)[i];
+    }
+    const Node condition = bdd_.Compose(
+        CreateFormula(Formula(pddl_, effect->getCondition(), parameters),
+                      parameters, arguments),
+        updated);
+
+    const Node cond_guard = bdd_.And(guard, condition);
+    if (cond_guard == BddManager::kFalse) continue;
+    ApplyEffects(effect->getEffects(), parameters, arguments, cond_guard,
+                 values);
+  }
+}
+
+SymbolicSearch::Node SymbolicSearch::Image(Node states) {
+  Node image = BddManager::kFalse;
+  for (const GroundAction& action : actions_) {
+    image = bdd_.Or(image,
+                    bdd_.AndExists(states, action.transition, cube_current_));
+  }
+  return bdd_.Rename(image, next_to_current_);
+}
+
+double SymbolicSearch::CountStates(Node states) const {
+  // Discount the variables that are not basic current state variables.
+  const size_t num_basic = static_cast<size_t>(
+      std::count(is_derived_.begin(), is_derived_.end(), false));
+  return std::ldexp(bdd_.SatCount(states),
+                    -static_cast<int>(bdd_.num_variables() - num_basic));
+}
+
+std::optional<std::vector<std::string>> SymbolicSearch::Search(
+    size_t max_depth, bool verbose) {
+  layers_ = {CreateState(pddl_.initial_state(), 0)};
+  Node reached = layers_.front();
+
+  for (size_t depth = 0;; depth++) {
+    if (verbose) {
+      std::cout << "Symbolic BFS depth " << depth << ": "
+                << CountStates(layers_.back()) << " states ("
+                << bdd_.Size(layers_.back()) << " nodes)" << std::endl;
+    }
+
+    const Node goal_states = bdd_.And(layers_.back(), goal_);
+    if (goal_states != BddManager::kFalse) return ExtractPlan(goal_states);
+    if (depth >= max_depth) return {};
+
+    // Expand the frontier and remove previously reached states.
+    const Node frontier = bdd_.And(Image(layers_.back()), bdd_.Not(reached));
+    if (frontier == BddManager::kFalse) return {};
+
+    reached = bdd_.Or(reached, frontier);
+    layers_.push_back(frontier);
+  }
+}
+
+std::vector<std::string> SymbolicSearch::ExtractPlan(Node goal_states) {
+  std::vector<std::string> plan;
+  plan.reserve(layers_.size() - 1);
+
+  // Backtrack through the layers from a goal state.
+  State state = *bdd_.PickState(goal_states);
+  for (size_t i = layers_.size() - 1; i > 0; i--) {
+    const Node next = CreateState(state, 1);
+    for (const GroundAction& action : actions_) {
+      const Node prev = bdd_.And(
+          bdd_.AndExists(action.transition, next, cube_next_), layers_[i - 1]);
+      if (prev == BddManager::kFalse) continue;
+
+      state = *bdd_.PickState(prev);
+      plan.push_back(
+          pddl_.actions()[action.idx_action].to_string(action.arguments));
+      break;
+    }
+  }
+
+  std::reverse(plan.begin(), plan.end());
+  return plan;
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "SymbolicSearch") {
+  SymbolicSearch search(pddl);
+  const std::optional<std::vector<std::string>> plan = search.Search();
+  REQUIRE(plan.has_value());
+
+  REQUIRE(testing::IsValidPlan(pddl, *plan));
+
+  // The plan should be as short as the explicit BFS plan.
+  REQUIRE(plan->size() == testing::OptimalPlanLength(pddl));
+}
+
+}  // namespace symbolic
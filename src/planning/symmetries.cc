@@ -0,0 +1,428 @@
+/**
+ * symmetries.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/planning/symmetries.h"
+
+#include <algorithm>      // std::binary_search, std::lower_bound, std::sort
+#include <map>            // std::map
+#include <numeric>        // std::iota
+#include <optional>       // std::optional
+#include <stdexcept>      // std::runtime_error
+#include <string>         // std::string, std::to_string
+#include <unordered_map>  // std::unordered_map
+
+#include "symbolic/normal_form.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::ColoredGraph;
+using ::symbolic::DisjunctiveFormula;
+using ::symbolic::Object;
+using ::symbolic::PartialState;
+using ::symbolic::Pddl;
+using ::symbolic::Proposition;
+using ::symbolic::State;
+using ::symbolic::StateIndex;
+
+using Permutation = ColoredGraph::Permutation;
+using Neighbors = std::vector<std::vector<size_t>>;
+
+size_t CountColors(const std::vector<size_t>& colors) {
+  std::vector<size_t> sorted = colors;
+  std::sort(sorted.begin(), sorted.end());
+  return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+}
+
+/**
+ * Refines the coloring until it is equitable, i.e. until all vertices of the
+ * same color have the same number of neighbors of each color.
+ *
+ * Colors are relabeled by the rank of their signatures, so isomorphic colored
+ * graphs are refined to isomorphic colorings.
+ */
+void Refine(const Neighbors& neighbors, std::vector<size_t>* colors) {
+  const size_t num_vertices = colors->size();
+  std::vector<std::vector<size_t>> signatures(num_vertices);
+  std::vector<size_t> order(num_vertices);
+  size_t num_colors = CountColors(*colors);
+  while (true) {
+    for (size_t v = 0; v < num_vertices; v++) {
+      std::vector<size_t>& signature = signatures[v];
+      signature.clear();
+      signature.push_back((*colors)[v]);
+      for (const size_t u : neighbors[v]) signature.push_back((*colors)[u]);
+      std::sort(signature.begin() + 1, signature.end());
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&signatures](size_t a, size_t b) {
+      return signatures[a] < signatures[b];
+    });
+    size_t rank = 0;
+    for (size_t i = 0; i < num_vertices; i++) {
+      if (i > 0 && signatures[order[i]] != signatures[order[i - 1]]) rank++;
+      (*colors)[order[i]] = rank;
+    }
+
+    const size_t num_refined = num_vertices == 0 ? 0 : rank + 1;
+    if (num_refined == num_colors) break;
+    num_colors = num_refined;
+  }
+}
+
+/**
+ * Returns the sorted vertices of the smallest color shared by more than one
+ * vertex, or an empty cell if the coloring is discrete.
+ */
+std::vector<size_t> FindTargetCell(const std::vector<size_t>& colors) {
+  std::vector<size_t> counts(colors.size(), 0);
+  for (const size_t color : colors) counts[color]++;
+
+  std::vector<size_t> cell;
+  for (size_t color = 0; color < counts.size(); color++) {
+    if (counts[color] <= 1) continue;
+    for (size_t v = 0; v < colors.size(); v++) {
+      if (colors[v] == color) cell.push_back(v);
+    }
+    break;
+  }
+  return cell;
+}
+
+/**
+ * Gives the vertex a unique color and refines the coloring.
+ */
+void Individualize(const Neighbors& neighbors, size_t v,
+                   std::vector<size_t>* colors) {
+  (*colors)[v] = colors->size();
+  Refine(neighbors, colors);
+}
+
+struct Level {
+  std::vector<size_t> colors;
+  std::vector<size_t> cell;
+};
+
+/**
+ * Individualizes the first vertex of the target cell until the coloring is
+ * discrete, optionally recording the levels of the path.
+ */
+void Descend(const Neighbors& neighbors, std::vector<size_t>* colors,
+             std::vector<Level>* path = nullptr) {
+  while (true) {
+    std::vector<size_t> cell = FindTargetCell(*colors);
+    if (cell.empty()) break;
+
+    const size_t v = cell.front();
+    if (path != nullptr) path->push_back({*colors, std::move(cell)});
+    Individualize(neighbors, v, colors);
+  }
+}
+
+size_t FindRoot(std::vector<size_t>& parents, size_t v) {
+  while (parents[v] != v) {
+    parents[v] = parents[parents[v]];
+    v = parents[v];
+  }
+  return v;
+}
+
+/**
+ * Adds a vertex for the atom connected to its arguments.
+ */
+template <typename ColorFunction>
+size_t AddAtom(const std::unordered_map<std::string, size_t>& idx_objects,
+               const std::string& label, const Proposition& prop,
+               const ColorFunction& Color, ColoredGraph* graph) {
+  const size_t atom = graph->AddVertex(Color(label + prop.name()));
+  for (size_t i = 0; i < prop.arguments().size(); i++) {
+    const auto it = idx_objects.find(prop.arguments()[i].name());
+    if (it == idx_objects.end()) {
+      throw std::runtime_error("ObjectSymmetries::ObjectSymmetries(): " +
+                               prop.to_string() + " has an unknown argument.");
+    }
+    const size_t arg = graph->AddVertex(Color("argument " + std::to_string(i)));
+    graph->AddEdge(atom, arg);
+    graph->AddEdge(arg, it->second);
+  }
+  return atom;
+}
+
+}  // namespace
+
+namespace symbolic {
+
+size_t ColoredGraph::AddVertex(size_t color) {
+  colors_.push_back(color);
+  neighbors_.emplace_back();
+  return colors_.size() - 1;
+}
+
+void ColoredGraph::AddEdge(size_t u, size_t v) {
+  const auto Insert = [](std::vector<size_t>& neighbors, size_t v) {
+    const auto it = std::lower_bound(neighbors.begin(), neighbors.end(), v);
+    if (it == neighbors.end() || *it != v) neighbors.insert(it, v);
+  };
+  Insert(neighbors_[u], v);
+  Insert(neighbors_[v], u);
+}
+
+bool ColoredGraph::IsAutomorphism(const Permutation& perm) const {
+  if (perm.size() != num_vertices()) return false;
+
+  std::vector<bool> is_image(num_vertices(), false);
+  for (size_t v = 0; v < num_vertices(); v++) {
+    const size_t image = perm[v];
+    if (image >= num_vertices() || is_image[image]) return false;
+    is_image[image] = true;
+
+    if (colors_[image] != colors_[v]) return false;
+    const std::vector<size_t>& neighbors = neighbors_[image];
+    if (neighbors.size() != neighbors_[v].size()) return false;
+    for (const size_t u : neighbors_[v]) {
+      if (!std::binary_search(neighbors.begin(), neighbors.end(), perm[u])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::vector<Permutation> ColoredGraph::FindAutomorphisms() const {
+  const size_t n = num_vertices();
+
+  // Follow the leftmost path to the first leaf.
+  std::vector<size_t> colors = colors_;
+  Refine(neighbors_, &colors);
+  std::vector<Level> path;
+  Descend(neighbors_, &colors, &path);
+  std::vector<size_t> first_leaf(n);
+  for (size_t v = 0; v < n; v++) first_leaf[colors[v]] = v;
+
+  // Every generator found so far fixes the vertices individualized above the
+  // current level, so vertices in the same orbit lead to equivalent leaves.
+  std::vector<Permutation> generators;
+  std::vector<size_t> orbits(n);
+  std::iota(orbits.begin(), orbits.end(), 0);
+  Permutation perm(n);
+  for (size_t l = path.size(); l-- > 0;) {
+    const Level& level = path[l];
+    const size_t v = level.cell.front();
+    for (size_t i = 1; i < level.cell.size(); i++) {
+      const size_t w = level.cell[i];
+      if (FindRoot(orbits, w) == FindRoot(orbits, v)) continue;
+
+      colors = level.colors;
+      Individualize(neighbors_, w, &colors);
+      Descend(neighbors_, &colors);
+      for (size_t u = 0; u < n; u++) perm[first_leaf[colors[u]]] = u;
+      if (!IsAutomorphism(perm)) continue;
+
+      generators.push_back(perm);
+      for (size_t u = 0; u < n; u++) {
+        orbits[FindRoot(orbits, u)] = FindRoot(orbits, perm[u]);
+      }
+    }
+  }
+  return generators;
+}
+
+ObjectSymmetries::ObjectSymmetries(const Pddl& pddl) : pddl_(pddl) {
+  const std::vector<Object>& objects = pddl.objects();
+  const size_t num_objects = objects.size();
+
+  std::map<std::string, size_t> color_ids;
+  const auto Color = [&color_ids](const std::string& label) {
+    return color_ids.emplace(label, color_ids.size()).first->second;
+  };
+
+  // Color objects by type, and fix the constants of the domain.
+  ColoredGraph graph;
+  std::unordered_map<std::string, size_t> idx_objects;
+  for (size_t i = 0; i < num_objects; i++) {
+    const Object& object = objects[i];
+    const std::vector<Object>& constants = pddl.constants();
+    const bool is_constant =
+        std::find(constants.begin(), constants.end(), object) !=
+        constants.end();
+    graph.AddVertex(Color(is_constant ? "constant " + object.name()
+                                      : "object " + object.type().name()));
+    idx_objects[object.name()] = i;
+  }
+
+  for (const Proposition& prop : pddl.initial_state()) {
+    AddAtom(idx_objects, "init ", prop, Color, &graph);
+  }
+  const std::optional<DisjunctiveFormula> goal =
+      DisjunctiveFormula::NormalizeGoal(pddl);
+  if (goal.has_value()) {
+    for (const PartialState& conj : goal->conjunctions) {
+      const size_t idx_conj = graph.AddVertex(Color("goal"));
+      for (const Proposition& prop : conj.pos()) {
+        graph.AddEdge(idx_conj,
+                      AddAtom(idx_objects, "goal+ ", prop, Color, &graph));
+      }
+      for (const Proposition& prop : conj.neg()) {
+        graph.AddEdge(idx_conj,
+                      AddAtom(idx_objects, "goal- ", prop, Color, &graph));
+      }
+    }
+  }
+
+  // Restrict the automorphisms to the objects.
+  for (const Permutation& perm : graph.FindAutomorphisms()) {
+    Permutation generator(perm.begin(), perm.begin() + num_objects);
+    bool is_identity = true;
+    for (size_t i = 0; i < num_objects; i++) {
+      is_identity &= generator[i] == i;
+    }
+    if (!is_identity) generators_.push_back(std::move(generator));
+  }
+
+  orbits_.resize(num_objects);
+  std::iota(orbits_.begin(), orbits_.end(), 0);
+  for (bool is_changed = true; is_changed;) {
+    is_changed = false;
+    for (const Permutation& generator : generators_) {
+      for (size_t i = 0; i < num_objects; i++) {
+        const size_t orbit = std::min(orbits_[i], orbits_[generator[i]]);
+        is_changed |= orbits_[i] != orbit || orbits_[generator[i]] != orbit;
+        orbits_[i] = orbit;
+        orbits_[generator[i]] = orbit;
+      }
+    }
+  }
+
+  // Permute the arguments of every atom.
+  const StateIndex& state_index = pddl.state_index();
+  for (const Permutation& generator : generators_) {
+    Permutation& atom_generator = atom_generators_.emplace_back();
+    atom_generator.reserve(state_index.size());
+    for (size_t idx = 0; idx < state_index.size(); idx++) {
+      const Proposition prop = state_index.GetProposition(idx);
+      std::vector<Object> args;
+      args.reserve(prop.arguments().size());
+      for (const Object& arg : prop.arguments()) {
+        args.push_back(objects[generator[idx_objects.at(arg.name())]]);
+      }
+      atom_generator.push_back(
+          state_index.GetPropositionIndex(Proposition(prop.name(), args)));
+    }
+  }
+}
+
+void ObjectSymmetries::Canonicalize(std::vector<size_t>* atoms) const {
+  std::vector<size_t> image;
+  for (bool is_improved = true; is_improved;) {
+    is_improved = false;
+    for (const Permutation& atom_generator : atom_generators_) {
+      image.clear();
+      for (const size_t atom : *atoms) image.push_back(atom_generator[atom]);
+      std::sort(image.begin(), image.end());
+      if (image < *atoms) {
+        atoms->swap(image);
+        is_improved = true;
+      }
+    }
+  }
+}
+
+State ObjectSymmetries::Canonicalize(const State& state) const {
+  const StateIndex& state_index = pddl_.state_index();
+  std::vector<size_t> atoms;
+  state_index.GetPropositionIndices(state, &atoms);
+  Canonicalize(&atoms);
+
+  State canonical;
+  canonical.reserve(atoms.size());
+  for (const size_t atom : atoms) {
+    canonical.insert(state_index.GetProposition(atom));
+  }
+  return canonical;
+}
+
+TEST_CASE("ColoredGraph") {
+  // The automorphisms of a 4-cycle are its rotations and reflections.
+  ColoredGraph graph;
+  for (size_t i = 0; i < 4; i++) graph.AddVertex(0);
+  for (size_t i = 0; i < 4; i++) graph.AddEdge(i, (i + 1) % 4);
+
+  const std::vector<Permutation> generators = graph.FindAutomorphisms();
+  REQUIRE(!generators.empty());
+  bool has_reflection = false;
+  for (const Permutation& perm : generators) {
+    REQUIRE(graph.IsAutomorphism(perm));
+    has_reflection |= perm[0] == 0;
+  }
+  REQUIRE(has_reflection);
+
+  // All vertices are in one orbit.
+  std::vector<bool> is_in_orbit = {true, false, false, false};
+  for (size_t k = 0; k < 4; k++) {
+    for (const Permutation& perm : generators) {
+      for (size_t i = 0; i < 4; i++) {
+        if (is_in_orbit[i]) is_in_orbit[perm[i]] = true;
+      }
+    }
+  }
+  REQUIRE(std::find(is_in_orbit.begin(), is_in_orbit.end(), false) ==
+          is_in_orbit.end());
+  REQUIRE(!graph.IsAutomorphism({0, 2, 1, 3}));
+
+  // Colors must be preserved.
+  ColoredGraph colored;
+  colored.AddVertex(0);
+  colored.AddVertex(1);
+  colored.AddEdge(0, 1);
+  REQUIRE(colored.FindAutomorphisms().empty());
+}
+
+TEST_CASE("ObjectSymmetries") {
+  // Stacking two pairs of blocks is symmetric under swapping the pairs.
+  const Pddl pddl(
+      "../resources/blocks_domain.pddl",
+      "(define (problem pairs) (:domain blocks) (:objects a b c d - block) "
+      "(:init (on a table) (on b table) (on c table) (on d table)) "
+      "(:goal (and (on a b) (on c d))))");
+  const ObjectSymmetries symmetries(pddl);
+  REQUIRE(!symmetries.generators().empty());
+
+  const auto FindObject = [&pddl](const std::string& name) {
+    for (size_t i = 0; i < pddl.objects().size(); i++) {
+      if (pddl.objects()[i].name() == name) return i;
+    }
+    return pddl.objects().size();
+  };
+  const std::vector<size_t>& orbits = symmetries.orbits();
+  REQUIRE(orbits[FindObject("a")] == orbits[FindObject("c")]);
+  REQUIRE(orbits[FindObject("b")] == orbits[FindObject("d")]);
+  REQUIRE(orbits[FindObject("a")] != orbits[FindObject("b")]);
+  REQUIRE(orbits[FindObject("table")] == FindObject("table"));
+
+  // Symmetric states collapse to the same canonical state.
+  const State state_a(pddl, {"inhand(a)", "on(b, table)", "on(c, table)",
+                             "on(d, table)"});
+  const State state_c(pddl, {"inhand(c)", "on(a, table)", "on(b, table)",
+                             "on(d, table)"});
+  const State state_b(pddl, {"inhand(b)", "on(a, table)", "on(c, table)",
+                             "on(d, table)"});
+  REQUIRE(symmetries.Canonicalize(state_a) == symmetries.Canonicalize(state_c));
+  REQUIRE(symmetries.Canonicalize(state_a) != symmetries.Canonicalize(state_b));
+
+  // The blocks fixture has no symmetries.
+  const Pddl blocks("../resources/blocks_domain.pddl",
+                    "../resources/blocks_problem.pddl");
+  const ObjectSymmetries no_symmetries(blocks);
+  REQUIRE(no_symmetries.generators().empty());
+  REQUIRE(no_symmetries.Canonicalize(blocks.initial_state()) ==
+          blocks.initial_state());
+}
+
+}  // namespace symbolic
@@ -11,16 +11,30 @@
 #include <pybind11/eigen.h>
 #include <pybind11/functional.h>
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <chrono>     // std::chrono
 #include <exception>  // std::out_of_range
+#include <limits>     // std::numeric_limits
 #include <sstream>    // std::stringstream
+#include <stdexcept>  // std::invalid_argument
 
+#include "symbolic/indexed_partial_state.h"
 #include "symbolic/normal_form.h"
 #include "symbolic/pddl.h"
+#include "symbolic/planning/beam_search.h"
+#include "symbolic/planning/bitstate_search.h"
 #include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/causal_graph.h"
+#include "symbolic/planning/landmarks.h"
+#include "symbolic/planning/parallel_search.h"
+#include "symbolic/planning/pattern_database.h"
 #include "symbolic/planning/planner.h"
+#include "symbolic/planning/portfolio.h"
+#include "symbolic/planning/stubborn_sets.h"
+#include "symbolic/planning/symmetries.h"
 
 namespace {
 
@@ -63,6 +77,35 @@ struct BreadthFirstSearch {
   bool initialized = false;
 };
 
+template <template <typename> class SearchT>
+struct BeamIterator {
+  using ScoreFunction = typename SearchT<Planner::Node>::ScoreFunction;
+
+  BeamIterator(const Planner::Node& root, const ScoreFunction& score,
+               size_t beam_width, size_t max_depth, bool verbose)
+      : beam(root, score, beam_width, max_depth, verbose) {}
+
+  SearchT<Planner::Node> beam;
+  typename SearchT<Planner::Node>::iterator it;
+  bool initialized = false;
+};
+
+template <typename SearchT>
+std::vector<Planner::Node> NextPlan(SearchT& it) {
+  if (!it.initialized) {
+    it.it = it.beam.begin();
+    it.initialized = true;
+  } else {
+    ++it.it;
+  }
+
+  if (it.it == it.beam.end()) {
+    throw pybind11::stop_iteration();
+  }
+
+  return *it.it;
+}
+
 }  // namespace
 
 namespace symbolic {
@@ -511,6 +554,60 @@ PYBIND11_MODULE(pysymbolic, m) {
              return state_index.GetIndexedState(
                  ParseState(state_index.pddl(), str_state));
            })
+      .def(
+          "get_indexed_partial_state",
+          [](const StateIndex& state_index,
+             const std::unordered_set<std::string>& state_pos,
+             const std::unordered_set<std::string>& state_neg) {
+            const IndexedPartialState indexed_state(
+                state_index,
+                PartialState(state_index.pddl(), state_pos, state_neg));
+            using Words = py::array_t<IndexedPartialState::Word>;
+            return py::make_tuple(
+                Words(indexed_state.pos().size(), indexed_state.pos().data()),
+                Words(indexed_state.neg().size(), indexed_state.neg().data()));
+          },
+          "state_pos"_a, "state_neg"_a, R"pbdoc(
+            Packs the partial state into positive and negative bit arrays.
+
+            Proposition i is stored in bit (i % 64) of word (i // 64).
+
+            Args:
+                state_pos: Positive propositions in partial state.
+                state_neg: Negative propositions in partial state.
+            Returns:
+                (pos, neg) tuple of uint64 arrays.
+
+            .. seealso:: C++: :symbolic:`symbolic::IndexedPartialState`.
+          )pbdoc")
+      .def(
+          "get_partial_state",
+          [](const StateIndex& state_index,
+             const py::array_t<IndexedPartialState::Word,
+                               py::array::c_style | py::array::forcecast>&
+                 pos,
+             const py::array_t<IndexedPartialState::Word,
+                               py::array::c_style | py::array::forcecast>&
+                 neg) {
+            const IndexedPartialState indexed_state(
+                std::vector<IndexedPartialState::Word>(pos.data(),
+                                                       pos.data() + pos.size()),
+                std::vector<IndexedPartialState::Word>(neg.data(),
+                                                       neg.data() + neg.size()),
+                state_index.size());
+            return indexed_state.GetPartialState(state_index).Stringify();
+          },
+          "pos"_a, "neg"_a, R"pbdoc(
+            Unpacks positive and negative bit arrays into a partial state.
+
+            Args:
+                pos: Positive uint64 bit array.
+                neg: Negative uint64 bit array.
+            Returns:
+                (pos, neg) tuple of proposition sets.
+
+            .. seealso:: C++: :symbolic:`symbolic::IndexedPartialState`.
+          )pbdoc")
       .def("__len__", &StateIndex::size, R"pbdoc(
           Size of the state index.
 
@@ -548,6 +645,54 @@ PYBIND11_MODULE(pysymbolic, m) {
         return ss.str();
       });
 
+  // StubbornSets
+  py::class_<StubbornSets>(m, "StubbornSets", R"pbdoc(
+        Strong stubborn set pruning of the planner successors.
+
+        Pass to :class:`Planner` to enable the pruning.
+
+        .. seealso:: C++: :symbolic:`symbolic::StubbornSets`.
+       )pbdoc")
+      .def(py::init<const Pddl&>(), "pddl"_a, py::keep_alive<1, 2>())
+      .def_property_readonly("num_expanded", &StubbornSets::num_expanded)
+      .def_property_readonly("num_generated", &StubbornSets::num_generated)
+      .def_property_readonly("num_pruned", &StubbornSets::num_pruned)
+      .def("reset_statistics", &StubbornSets::ResetStatistics);
+
+  // ObjectSymmetries
+  py::class_<ObjectSymmetries>(m, "ObjectSymmetries", R"pbdoc(
+        Symmetries between interchangeable objects of the problem.
+
+        .. seealso:: C++: :symbolic:`symbolic::ObjectSymmetries`.
+       )pbdoc")
+      .def(py::init<const Pddl&>(), "pddl"_a, py::keep_alive<1, 2>())
+      .def_property_readonly(
+          "generators",
+          [](const ObjectSymmetries& symmetries) {
+            const std::vector<Object>& objects = symmetries.pddl().objects();
+            std::vector<StringVector> generators;
+            for (const auto& generator : symmetries.generators()) {
+              StringVector& str_generator = generators.emplace_back();
+              for (const size_t idx_object : generator) {
+                str_generator.push_back(objects[idx_object].name());
+              }
+            }
+            return generators;
+          },
+          R"pbdoc(
+        Generators as the images of the objects in `Pddl.objects`.
+       )pbdoc")
+      .def(
+          "canonicalize",
+          [](const ObjectSymmetries& symmetries, const StringSet& state) {
+            return symmetries
+                .Canonicalize(ParseState(symmetries.pddl(), state))
+                .Stringify();
+          },
+          "state"_a, R"pbdoc(
+        Canonical state symmetric to the given state.
+       )pbdoc");
+
   // Planner
   py::class_<Planner>(m, "Planner")
       .def(py::init<const Pddl&>(), "pddl"_a, R"pbdoc(
@@ -568,6 +713,21 @@ PYBIND11_MODULE(pysymbolic, m) {
           pddl: Pddl instance.
           state: State from which to search.
 
+        .. seealso:: C++: :symbolic:`symbolic::Planner::Planner`.
+       )pbdoc")
+      .def(py::init([](const Pddl& pddl, const StringSet& state,
+                       const StubbornSets& stubborn_sets) {
+             return Planner(pddl, ParseState(pddl, state), &stubborn_sets);
+           }),
+           "pddl"_a, "state"_a, "stubborn_sets"_a, py::keep_alive<1, 4>(),
+           R"pbdoc(
+        Planner class that prunes successors with strong stubborn sets.
+
+        Args:
+          pddl: Pddl instance.
+          state: State from which to search.
+          stubborn_sets: StubbornSets instance.
+
         .. seealso:: C++: :symbolic:`symbolic::Planner::Planner`.
        )pbdoc")
       .def_property_readonly("root", &Planner::root);
@@ -607,6 +767,204 @@ PYBIND11_MODULE(pysymbolic, m) {
         return *it.it;
       });
 
+  using BeamSearch = ::BeamIterator<::symbolic::BeamSearch>;
+  py::class_<BeamSearch>(m, "BeamSearch", R"pbdoc(
+      Beam search that keeps the `beam_width` lowest-scoring nodes per layer.
+
+      Args:
+          root: Root planner node.
+          score: Function `score(node) -> float`, where lower is better.
+          beam_width: Number of nodes kept per layer.
+          max_depth: Maximum plan length.
+          verbose: Print search progress.
+    )pbdoc")
+      .def(py::init<const Planner::Node&, const BeamSearch::ScoreFunction&,
+                    size_t, size_t, bool>(),
+           "root"_a, "score"_a, "beam_width"_a, "max_depth"_a,
+           "verbose"_a = false)
+      .def("__iter__", [](BeamSearch& it) { return it; })
+      .def("__next__", &NextPlan<BeamSearch>);
+
+  using BeamStackSearch = ::BeamIterator<::symbolic::BeamStackSearch>;
+  py::class_<BeamStackSearch>(m, "BeamStackSearch", R"pbdoc(
+      Beam search that backtracks over its layers until the search space is
+      exhausted. Plans are returned with strictly decreasing length, so the last
+      plan is a shortest plan within `max_depth`.
+
+      Args:
+          root: Root planner node.
+          score: Function `score(node) -> float`, where lower is better.
+          beam_width: Number of nodes kept per layer.
+          max_depth: Maximum plan length.
+          verbose: Print search progress.
+    )pbdoc")
+      .def(py::init<const Planner::Node&,
+                    const BeamStackSearch::ScoreFunction&, size_t, size_t,
+                    bool>(),
+           "root"_a, "score"_a, "beam_width"_a, "max_depth"_a,
+           "verbose"_a = false)
+      .def("__iter__", [](BeamStackSearch& it) { return it; })
+      .def("__next__", &NextPlan<BeamStackSearch>);
+
+  py::class_<BitstateSearch>(m, "BitstateSearch", R"pbdoc(
+      Depth-first search with bitstate hashing, which stores no states and
+      estimates the fraction of states omitted by hash collisions.
+
+      Args:
+          pddl: Pddl object.
+          log2_num_bits: Base 2 logarithm of the size of the bit array.
+          num_hashes: Number of bits set per state.
+    )pbdoc")
+      .def(py::init<const Pddl&, size_t, size_t>(), "pddl"_a,
+           "log2_num_bits"_a = BitstateSearch::kDefaultLog2NumBits,
+           "num_hashes"_a = BitstateSearch::kDefaultNumHashes,
+           py::keep_alive<1, 2>())
+      .def("search", &BitstateSearch::Search,
+           "max_depth"_a = std::numeric_limits<size_t>::max(),
+           "verbose"_a = false, R"pbdoc(
+          Returns a list of action calls to the goal, or None.
+        )pbdoc")
+      .def_property_readonly(
+          "num_stored",
+          [](const BitstateSearch& search) {
+            return search.statistics().num_stored;
+          })
+      .def_property_readonly(
+          "omission_probability",
+          [](const BitstateSearch& search) {
+            return search.statistics().omission_probability;
+          })
+      .def_property_readonly("coverage", [](const BitstateSearch& search) {
+        return search.statistics().coverage;
+      });
+
+  py::class_<HashDistributedAStar>(m, "HashDistributedAStar", R"pbdoc(
+      Hash-distributed A* with the blind heuristic over worker threads, which
+      returns optimal plans.
+
+      Args:
+          pddl: Pddl object.
+          num_threads: Number of workers, or the number of hardware threads if
+              0.
+    )pbdoc")
+      .def(py::init<const Pddl&, size_t>(), "pddl"_a, "num_threads"_a = 0,
+           py::keep_alive<1, 2>())
+      .def("search", &HashDistributedAStar::Search,
+           "max_depth"_a = std::numeric_limits<size_t>::max(),
+           "verbose"_a = false, py::call_guard<py::gil_scoped_release>(),
+           R"pbdoc(
+          Returns a list of action calls to the goal, or None.
+        )pbdoc")
+      .def_property_readonly("num_threads", &HashDistributedAStar::num_threads)
+      .def_property_readonly("num_expanded",
+                             &HashDistributedAStar::num_expanded)
+      .def_property_readonly("num_sent", &HashDistributedAStar::num_sent);
+
+  py::class_<Portfolio>(m, "Portfolio", R"pbdoc(
+      Portfolio of search engines run concurrently in threads on the same Pddl.
+      Without a deadline, the first plan cancels the other engines. With a
+      deadline, the shortest plan found before it is returned.
+
+      Args:
+          pddl: Pddl object.
+          memory_budget: Maximum resident memory of the process in bytes, or 0
+              for no limit.
+    )pbdoc")
+      .def(py::init<const Pddl&, size_t>(), "pddl"_a, "memory_budget"_a = 0,
+           py::keep_alive<1, 2>())
+      .def_property_readonly_static(
+          "builtin_engines",
+          [](const py::object&) { return Portfolio::BuiltinEngines(); })
+      .def(
+          "add",
+          [](Portfolio& portfolio, const std::string& name) {
+            portfolio.Add(name);
+          },
+          "name"_a, R"pbdoc(
+          Adds a built-in engine: "bfs", "dfs", "iw", or "bfws".
+        )pbdoc")
+      .def(
+          "search",
+          [](Portfolio& portfolio, size_t max_depth, double deadline,
+             bool verbose) {
+            if (!(deadline >= 0.)) {
+              throw std::invalid_argument(
+                  "Portfolio.search(): Deadline must be nonnegative.");
+            }
+            // Round up so that deadlines under 1 ms are not treated as 0.
+            const std::chrono::duration<double> s_deadline(deadline);
+            return portfolio.Search(
+                max_depth,
+                std::chrono::ceil<std::chrono::milliseconds>(s_deadline),
+                verbose);
+          },
+          "max_depth"_a = std::numeric_limits<size_t>::max(),
+          "deadline"_a = 0., "verbose"_a = false,
+          py::call_guard<py::gil_scoped_release>(), R"pbdoc(
+          Returns a list of action calls to the goal, or None. The deadline is
+          in seconds, rounded up to the next millisecond, or 0 to return the
+          first plan.
+        )pbdoc")
+      .def_property_readonly("num_engines", &Portfolio::num_engines)
+      .def_property_readonly("winner", &Portfolio::winner)
+      .def_property_readonly("is_out_of_memory",
+                             &Portfolio::is_out_of_memory);
+
+  py::class_<LandmarkCountHeuristic>(m, "LandmarkCountHeuristic", R"pbdoc(
+      LM-count heuristic over the fact landmarks of the delete relaxation.
+
+      Calling the heuristic on a planner node returns the number of landmarks
+      still to be achieved on the path to the node. It can be passed as the
+      `score` of the beam search engines.
+    )pbdoc")
+      .def(py::init<const Pddl&>(), "pddl"_a, py::keep_alive<1, 2>())
+      .def_property_readonly("num_landmarks",
+                             [](const LandmarkCountHeuristic& lm_count) {
+                               return lm_count.graph().size();
+                             })
+      .def("__call__", &LandmarkCountHeuristic::operator(), "node"_a);
+
+  py::class_<ContextEnhancedAdditiveHeuristic>(
+      m, "ContextEnhancedAdditiveHeuristic", R"pbdoc(
+      Context-enhanced additive heuristic over the domain transition graphs of
+      the finite-domain encoding.
+
+      Calling the heuristic on a planner node returns the estimated number of
+      actions to the goal. It can be passed as the `score` of the beam search
+      engines.
+    )pbdoc")
+      .def(py::init<const Pddl&>(), "pddl"_a, py::keep_alive<1, 2>())
+      .def_property_readonly(
+          "num_variables",
+          [](const ContextEnhancedAdditiveHeuristic& h_cea) {
+            return h_cea.causal_graph().num_variables();
+          })
+      .def("__call__", &ContextEnhancedAdditiveHeuristic::operator(),
+           "node"_a);
+
+  py::class_<PatternDatabaseHeuristic>(m, "PatternDatabaseHeuristic", R"pbdoc(
+      Canonical combination of projection pattern databases.
+
+      Args:
+          pddl: Pddl object.
+          max_pattern_size: Maximum number of atoms per generated pattern.
+    )pbdoc")
+      .def(py::init<const Pddl&, size_t>(), "pddl"_a, "max_pattern_size"_a,
+           py::keep_alive<1, 2>())
+      .def_static("load", &PatternDatabaseHeuristic::Load, "pddl"_a,
+                  "filename"_a, py::keep_alive<0, 1>(), R"pbdoc(
+          Map pattern databases saved with `save()` read-only into memory.
+        )pbdoc")
+      .def("save", &PatternDatabaseHeuristic::Save, "filename"_a)
+      .def_property_readonly("num_patterns",
+                             &PatternDatabaseHeuristic::num_patterns)
+      .def("evaluate",
+           [](const PatternDatabaseHeuristic& pdb, const StringSet& str_state) {
+             return pdb.Evaluate(ParseState(pdb.pddl(), str_state));
+           },
+           "state"_a)
+      .def("__call__", &PatternDatabaseHeuristic::operator(), "node"_a);
+
   py::class_<DisjunctiveFormula>(m, "DisjunctiveFormula")
       .def_readonly("conjunctions", &DisjunctiveFormula::conjunctions)
       .def_static("normalize_goal", &DisjunctiveFormula::NormalizeGoal,
@@ -205,6 +205,14 @@ size_t StateIndex::GetPropositionIndex(const Proposition& prop) const {
   return idx_proposition;
 }
 
+int StateIndex::GetPredicateIndex(const std::string& name_predicate) const {
+  const auto it = idx_predicates_.find(name_predicate);
+  if (it == idx_predicates_.end()) return -1;
+  return static_cast<int>(it->second);
+}
+
+size_t StateIndex::num_predicates() const { return predicates_.size(); }
+
 // NOLINTNEXTLINE(performance-unnecessary-value-param)
 State StateIndex::GetState(Eigen::Ref<const IndexedState> indexed_state) const {
   assert(indexed_state.size() == size());
@@ -219,6 +227,20 @@ State StateIndex::GetState(Eigen::Ref<const IndexedState> indexed_state) const {
   return state;
 }
 
+void StateIndex::GetPropositionIndices(
+    const State& state, std::vector<size_t>* idx_propositions) const {
+  idx_propositions->clear();
+  idx_propositions->reserve(state.size());
+  for (const Proposition& prop : state) {
+    const size_t idx_pred = idx_predicates_.at(prop.name());
+    const ParameterGenerator& param_gen =
+        predicates_[idx_pred].parameter_generator();
+    idx_propositions->push_back(idx_predicate_group_[idx_pred] +
+                                param_gen.find(prop.arguments()));
+  }
+  std::sort(idx_propositions->begin(), idx_propositions->end());
+}
+
 StateIndex::IndexedState StateIndex::GetIndexedState(const State& state) const {
   IndexedState indexed_state = IndexedState::Zero(size());
 
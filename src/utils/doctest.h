@@ -17,7 +17,13 @@
 
 #include <doctest/doctest.h>
 
+#include <limits>  // std::numeric_limits
+#include <string>  // std::string
+#include <vector>  // std::vector
+
 #include "symbolic/pddl.h"
+#include "symbolic/planning/breadth_first_search.h"
+#include "symbolic/planning/planner.h"
 
 namespace symbolic {
 namespace testing {
@@ -26,6 +32,59 @@ struct Fixture {
   Pddl pddl = Pddl("../resources/domain.pddl", "../resources/problem.pddl");
 };
 
+struct BlocksFixture {
+  Pddl pddl =
+      Pddl("../resources/blocks_domain.pddl", "../resources/blocks_problem.pddl");
+};
+
+struct AxiomsFixture {
+  Pddl pddl =
+      Pddl("../resources/axioms_domain.pddl", "../resources/axioms_problem.pddl");
+};
+
+/**
+ * Whether the action calls are valid from the initial state and reach the
+ * goal.
+ */
+inline bool IsValidPlan(const Pddl& pddl,
+                        const std::vector<std::string>& plan) {
+  State state = pddl.initial_state();
+  for (const std::string& action : plan) {
+    if (!pddl.IsValidAction(state, action)) return false;
+    state = pddl.NextState(state, action);
+  }
+  return pddl.IsGoalSatisfied(state);
+}
+
+/**
+ * Whether every node of the search plan follows from the previous one with a
+ * valid action, and the last node reaches the goal.
+ */
+inline bool IsValidPlan(const Pddl& pddl,
+                        const std::vector<Planner::Node>& plan) {
+  if (plan.empty()) return false;
+  for (size_t i = 1; i < plan.size(); i++) {
+    const State& state = plan[i - 1].state();
+    if (!pddl.IsValidAction(state, plan[i].action()) ||
+        pddl.NextState(state, plan[i].action()) != plan[i].state()) {
+      return false;
+    }
+  }
+  return pddl.IsGoalSatisfied(plan.back().state());
+}
+
+/**
+ * Number of actions in the shortest plan found by breadth-first search, or
+ * the max size_t if there is no plan within the maximum depth.
+ */
+inline size_t OptimalPlanLength(const Pddl& pddl, size_t max_depth = 10) {
+  const Planner planner(pddl);
+  BreadthFirstSearch<Planner::Node> bfs(planner.root(), max_depth);
+  const auto it = bfs.begin();
+  if (it == bfs.end()) return std::numeric_limits<size_t>::max();
+  return (*it).size() - 1;
+}
+
 }  // namespace testing
 }  // namespace symbolic
 
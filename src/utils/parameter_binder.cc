@@ -0,0 +1,207 @@
+/**
+ * parameter_binder.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/utils/parameter_binder.h"
+
+#include <VAL/ptree.h>
+
+#include <algorithm>  // std::max, std::stable_sort
+
+#include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Object;
+using ::symbolic::Pddl;
+
+/**
+ * Conjunct of the condition before its formula is created.
+ */
+struct ConjunctSymbol {
+  const VAL::goal* symbol;
+  bool is_negated;
+};
+
+/**
+ * Splits the condition (or its negation) into conjuncts.
+ */
+void SplitConjuncts(const VAL::goal* symbol, bool is_negated,
+                    std::vector<ConjunctSymbol>* conjuncts) {
+  const auto* neg_goal = dynamic_cast<const VAL::neg_goal*>(symbol);
+  if (neg_goal != nullptr) {
+    SplitConjuncts(neg_goal->getGoal(), !is_negated, conjuncts);
+    return;
+  }
+
+  // Conjunctions split when positive, disjunctions when negated.
+  const VAL::goal_list* goals = nullptr;
+  if (!is_negated) {
+    const auto* conj_goal = dynamic_cast<const VAL::conj_goal*>(symbol);
+    if (conj_goal != nullptr) goals = conj_goal->getGoals();
+  } else {
+    const auto* disj_goal = dynamic_cast<const VAL::disj_goal*>(symbol);
+    if (disj_goal != nullptr) goals = disj_goal->getGoals();
+  }
+  if (goals == nullptr) {
+    conjuncts->push_back({symbol, is_negated});
+    return;
+  }
+
+  for (const VAL::goal* goal : *goals) {
+    SplitConjuncts(goal, is_negated, conjuncts);
+  }
+}
+
+/**
+ * Computes the number of leading parameters that must be bound to evaluate the
+ * goal, along with a rough evaluation cost.
+ *
+ * Quantified variables that shadow a parameter name count as references to
+ * the parameter, which only delays the check.
+ */
+void AnalyzeGoal(const Pddl& pddl, const VAL::goal* symbol,
+                 const std::vector<Object>& parameters, size_t* num_required,
+                 size_t* cost) {
+  const auto* simple_goal = dynamic_cast<const VAL::simple_goal*>(symbol);
+  if (simple_goal != nullptr) {
+    const VAL::proposition* prop = simple_goal->getProp();
+    const std::string& name_predicate = prop->head->getNameRef();
+    for (const Object& arg : Object::CreateList(pddl, prop->args)) {
+      for (size_t i = 0; i < parameters.size(); i++) {
+        if (arg == parameters[i]) *num_required = std::max(*num_required, i + 1);
+      }
+    }
+
+    // Static predicates do not look up the state.
+    const bool is_static =
+        name_predicate == "=" ||
+        pddl.object_map().find(name_predicate) != pddl.object_map().end();
+    *cost += is_static ? 1 : 2;
+    return;
+  }
+
+  const VAL::goal_list* goals = nullptr;
+  const auto* conj_goal = dynamic_cast<const VAL::conj_goal*>(symbol);
+  if (conj_goal != nullptr) goals = conj_goal->getGoals();
+  const auto* disj_goal = dynamic_cast<const VAL::disj_goal*>(symbol);
+  if (disj_goal != nullptr) goals = disj_goal->getGoals();
+  if (goals != nullptr) {
+    for (const VAL::goal* goal : *goals) {
+      AnalyzeGoal(pddl, goal, parameters, num_required, cost);
+    }
+    return;
+  }
+
+  const auto* neg_goal = dynamic_cast<const VAL::neg_goal*>(symbol);
+  if (neg_goal != nullptr) {
+    AnalyzeGoal(pddl, neg_goal->getGoal(), parameters, num_required, cost);
+    return;
+  }
+
+  const auto* qfied_goal = dynamic_cast<const VAL::qfied_goal*>(symbol);
+  if (qfied_goal != nullptr) {
+    // Quantifiers loop over their variables.
+    size_t cost_goal = 0;
+    AnalyzeGoal(pddl, qfied_goal->getGoal(), parameters, num_required,
+                &cost_goal);
+    *cost += 16 * cost_goal;
+    return;
+  }
+
+  // Unknown goals are checked once all the parameters are bound.
+  *num_required = parameters.size();
+  *cost += 16;
+}
+
+}  // namespace
+
+namespace symbolic {
+
+ParameterBinder::ParameterBinder(const Pddl& pddl, const VAL::goal* symbol,
+                                 const std::vector<Object>& parameters,
+                                 size_t num_bound, bool is_negated)
+    : num_bound_(num_bound),
+      param_gen_(pddl, std::vector<Object>(parameters.begin() + num_bound,
+                                           parameters.end())),
+      idx_conjuncts_(parameters.size() + 2, 0) {
+  std::vector<ConjunctSymbol> symbols;
+  if (symbol != nullptr) SplitConjuncts(symbol, is_negated, &symbols);
+
+  conjuncts_.reserve(symbols.size());
+  for (const ConjunctSymbol& conjunct : symbols) {
+    size_t num_required = 0;
+    size_t cost = 0;
+    AnalyzeGoal(pddl, conjunct.symbol, parameters, &num_required, &cost);
+    conjuncts_.push_back({Formula(pddl, conjunct.symbol, parameters),
+                          conjunct.is_negated, std::max(num_required, num_bound),
+                          cost});
+  }
+
+  // Order conjuncts by depth and then by cost.
+  std::stable_sort(conjuncts_.begin(), conjuncts_.end(),
+                   [](const Conjunct& lhs, const Conjunct& rhs) {
+                     if (lhs.num_required != rhs.num_required) {
+                       return lhs.num_required < rhs.num_required;
+                     }
+                     return lhs.cost < rhs.cost;
+                   });
+
+  // Compute the start index of the conjuncts at each depth.
+  for (const Conjunct& conjunct : conjuncts_) {
+    idx_conjuncts_[conjunct.num_required + 1]++;
+  }
+  for (size_t i = 1; i < idx_conjuncts_.size(); i++) {
+    idx_conjuncts_[i] += idx_conjuncts_[i - 1];
+  }
+}
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "ParameterBinder") {
+  State state = pddl.initial_state();
+  for (size_t t = 0; t < 3; t++) {
+    for (const Action& action : pddl.actions()) {
+      // The binder should find the same arguments as the full enumeration.
+      std::vector<std::vector<Object>> expected;
+      for (const std::vector<Object>& args : action.parameter_generator()) {
+        if (action.IsValid(state, args)) expected.push_back(args);
+      }
+
+      std::vector<std::vector<Object>> bound;
+      std::vector<Object> args(action.parameters().size());
+      ParameterBinder binder(pddl, action.preconditions().symbol(),
+                             action.parameters());
+      REQUIRE(binder.ForEach(state, &args,
+                             [&bound](const std::vector<Object>& args) {
+                               bound.push_back(args);
+                               return true;
+                             }));
+      REQUIRE(bound == expected);
+
+      // Stepping through the bindings should visit them in both directions.
+      std::vector<std::vector<Object>> stepped;
+      for (size_t idx = binder.FindNext(state, 0, &args); idx < binder.size();
+           idx = binder.FindNext(state, idx + 1, &args)) {
+        stepped.push_back(args);
+      }
+      REQUIRE(stepped == expected);
+      stepped.clear();
+      for (size_t idx = binder.FindPrev(state, binder.size(), &args);
+           idx < binder.size(); idx = binder.FindPrev(state, idx, &args)) {
+        stepped.insert(stepped.begin(), args);
+      }
+      REQUIRE(stepped == expected);
+
+      if (!expected.empty() && t == 0) {
+        state = action.Apply(state, expected.front());
+      }
+    }
+  }
+}
+
+}  // namespace symbolic
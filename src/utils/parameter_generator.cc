@@ -9,10 +9,12 @@
 
 #include "symbolic/utils/parameter_generator.h"
 
+#include <algorithm>  // std::min
 #include <exception>  // std::runtime_error
 #include <iostream>   // std::cerr
 
 #include "symbolic/pddl.h"
+#include "utils/doctest.h"
 
 namespace {
 
@@ -57,20 +59,22 @@ namespace symbolic {
 
 ParameterGenerator::ParameterGenerator(const Pddl& pddl,
                                        const std::vector<Object>& params)
-    : param_types_(ParamTypes(pddl.object_map(), params)) {
+    : pddl_(&pddl), param_types_(ParamTypes(pddl.object_map(), params)) {
   Base::operator=(Base(Options(param_types_)));
 }
 
 // NOLINTNEXTLINE(bugprone-copy-constructor-init)
 ParameterGenerator::ParameterGenerator(const ParameterGenerator& other)
-    : param_types_(other.param_types_) {
+    : pddl_(other.pddl_), param_types_(other.param_types_) {
   Base::operator=(Base(Options(param_types_)));
 }
 
+// Moving param_types_ keeps the inner vectors in place, so the option pointers
+// of the base remain valid and do not need to be rebuilt.
 ParameterGenerator::ParameterGenerator(ParameterGenerator&& other) noexcept
-    : param_types_(std::move(other.param_types_)) {
-  Base::operator=(Base(Options(param_types_)));
-}
+    : Base(std::move(other)),
+      pddl_(other.pddl_),
+      param_types_(std::move(other.param_types_)) {}
 
 ParameterGenerator& ParameterGenerator::operator=(
     const ParameterGenerator& rhs) {
@@ -84,10 +88,40 @@ ParameterGenerator& ParameterGenerator::operator=(
 
 ParameterGenerator& ParameterGenerator::operator=(
     ParameterGenerator&& rhs) noexcept {
+  if (this == &rhs) return *this;
+
+  Base::operator=(std::move(rhs));
   pddl_ = rhs.pddl_;
   param_types_ = std::move(rhs.param_types_);
-  Base::operator=(Base(Options(param_types_)));
   return *this;
 }
 
+TEST_CASE_FIXTURE(testing::BlocksFixture, "ParameterGenerator.ForEachIndex") {
+  for (const Action& action : pddl.actions()) {
+    const ParameterGenerator& gen = action.parameter_generator();
+
+    // Index tuples and in-place combinations should follow the iterator order.
+    auto it = gen.begin();
+    std::vector<Object> buffer(action.parameters().size());
+    REQUIRE(gen.ForEachInPlace(&buffer, 0, [&](const std::vector<Object>& args) {
+      REQUIRE(it != gen.end());
+      REQUIRE(args == *it);
+      ++it;
+      return true;
+    }));
+    REQUIRE(it == gen.end());
+
+    size_t idx = 0;
+    gen.ForEachIndex([&](const std::vector<size_t>& indices) {
+      for (size_t i = 0; i < indices.size(); i++) {
+        REQUIRE(gen.option(i, indices[i]) == gen[idx][i]);
+      }
+      gen.GetInPlace(idx, &buffer, 0);
+      REQUIRE(buffer == gen[idx]);
+      return ++idx < 3;
+    });
+    REQUIRE(idx == std::min<size_t>(3, gen.size()));
+  }
+}
+
 }  // namespace symbolic
@@ -0,0 +1,99 @@
+/**
+ * thread_local_buffer.cc
+ *
+ * Copyright 2021. All Rights Reserved.
+ *
+ * Created: October 18, 2021
+ * Authors: Toki Migimatsu
+ */
+
+#include "symbolic/utils/thread_local_buffer.h"
+
+#include <atomic>  // std::atomic
+#include <mutex>   // std::lock_guard, std::mutex
+#include <thread>  // std::thread
+#include <vector>  // std::vector
+
+#include "symbolic/pddl.h"
+#include "utils/doctest.h"
+
+namespace {
+
+using ::symbolic::Object;
+
+/**
+ * Registry of the slot indices in use by all buffers.
+ */
+class SlotRegistry {
+ public:
+  size_t Acquire() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (free_.empty()) return num_slots_++;
+    const size_t idx = free_.back();
+    free_.pop_back();
+    return idx;
+  }
+
+  void Release(size_t idx) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    free_.push_back(idx);
+  }
+
+ private:
+  std::mutex mtx_;
+  std::vector<size_t> free_;
+  size_t num_slots_ = 0;
+};
+
+SlotRegistry& GetRegistry() {
+  // Never destroyed, since buffers may outlive static destruction.
+  static SlotRegistry* registry = new SlotRegistry();
+  return *registry;
+}
+
+std::atomic<uint64_t> g_serial{1};
+
+}  // namespace
+
+namespace symbolic {
+
+ThreadLocalSlot::ThreadLocalSlot()
+    : idx_(GetRegistry().Acquire()),
+      serial_(g_serial.fetch_add(1, std::memory_order_relaxed)) {}
+
+ThreadLocalSlot::~ThreadLocalSlot() { GetRegistry().Release(idx_); }
+
+TEST_CASE_FIXTURE(testing::BlocksFixture, "ThreadLocalBuffer") {
+  const std::vector<Object>& objects = pddl.objects();
+  REQUIRE(objects.size() >= 4);
+  const std::vector<Object> initial_args = {objects[0], objects[1]};
+  const std::vector<Object> other_args = {objects[2], objects[3]};
+
+  std::vector<Object>* ptr_args = nullptr;
+  {
+    const ThreadLocalBuffer<std::vector<Object>> buffer(initial_args);
+    std::vector<Object>& args = buffer.get();
+    REQUIRE(args == initial_args);
+    REQUIRE(&buffer.get() == &args);
+    args[0] = other_args[0];
+    ptr_args = &args;
+
+    // Other threads should see their own copy.
+    std::vector<Object> thread_args;
+    std::thread thread([&buffer, &thread_args]() {
+      thread_args = buffer.get();
+      buffer.get()[1] = Object();
+    });
+    thread.join();
+    REQUIRE(thread_args == initial_args);
+    REQUIRE(buffer.get()[0] == other_args[0]);
+    REQUIRE(buffer.get()[1] == initial_args[1]);
+  }
+
+  // A new buffer reusing the slot should start from its own arguments.
+  const ThreadLocalBuffer<std::vector<Object>> buffer(other_args);
+  REQUIRE(&buffer.get() == ptr_args);
+  REQUIRE(buffer.get() == other_args);
+}
+
+}  // namespace symbolic